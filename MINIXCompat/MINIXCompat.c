@@ -23,9 +23,17 @@
 #include "MINIXCompat_Emulation.h"
 #include "MINIXCompat_Executable.h"
 #include "MINIXCompat_Filesystem.h"
+#include "MINIXCompat_ImageCache.h"
 #include "MINIXCompat_Messages.h"
+#include "MINIXCompat_Native.h"
 #include "MINIXCompat_Processes.h"
+#include "MINIXCompat_Profile.h"
+#include "MINIXCompat_Replay.h"
+#include "MINIXCompat_Server.h"
+#include "MINIXCompat_Snapshot.h"
+#include "MINIXCompat_Stats.h"
 #include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Trace.h"
 
 
 static MINIXCompat_Execution_State MINIXCompat_State = MINIXCompat_Execution_State_Started;
@@ -41,19 +49,59 @@ int main(int argc, char **argv, char **envp)
         exit(EX_USAGE);
     }
 
-    // Initialize subsystems.
+    // With a warm server to use, just have it run the tool.
+
+    const bool serving = (strcmp(argv[1], "--server") == 0);
+
+    if (!serving) {
+        int server_status;
+        if (MINIXCompat_Server_Client(argc, argv, envp, &server_status)) {
+            return server_status;
+        }
+    } else if (argc != 3) {
+        fprintf(stderr, "%s: Usage: %s --server socket-path\n", argv[0], argv[0]);
+        exit(EX_USAGE);
+    }
+
+    // Initialize subsystems. A server initializes those that don't depend on the tool once, and then the rest in each host process it forks to handle a request.
 
     MINIXCompat_Filesystem_Initialize();
-    MINIXCompat_CPU_Initialize();
+    MINIXCompat_ImageCache_Initialize();
+    int cpu_error = MINIXCompat_CPU_Initialize();
+    if (cpu_error != 0) {
+        fprintf(stderr, "MINIXCompat: can't map emulated RAM: %s\n", strerror(cpu_error));
+        exit(EX_OSERR);
+    }
+    MINIXCompat_Native_Initialize();
+
+    if (serving) {
+        MINIXCompat_Server_Run(argv[2], &argc, &argv, &envp);
+        if (argc == 0) {
+            exit(EX_OSERR);
+        }
+    }
+
+    MINIXCompat_Replay_Initialize();
     MINIXCompat_Processes_Initialize();
     MINIXCompat_SysCall_Initialize();
+    MINIXCompat_Stats_Initialize();
+    MINIXCompat_Profile_Initialize();
+    MINIXCompat_Trace_Initialize();
+    MINIXCompat_Snapshot_Initialize(argc, argv, envp);
 
     // Run the main emulation loop.
 
     while (MINIXCompat_State != MINIXCompat_Execution_State_Finished) {
         switch (MINIXCompat_State) {
             case MINIXCompat_Execution_State_Started: {
-                // Set up the tool to run.
+                // Resume from a snapshot of this same invocation if there is one.
+
+                if (MINIXCompat_Snapshot_Restore()) {
+                    MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Restored);
+                    break;
+                }
+
+                // Otherwise, set up the tool to run.
 
                 int16_t exec_err = MINIXCompat_Processes_ExecuteWithHostParams(argv[1], argc, argv, envp);
                 if (exec_err != 0) {
@@ -69,10 +117,23 @@ int main(int argc, char **argv, char **envp)
                 MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Running);
             } break;
 
+            case MINIXCompat_Execution_State_Restored: {
+                // The CPU was restored along with everything else, so unlike for a new executable, it mustn't be reset.
+
+                MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Running);
+            } break;
+
             case MINIXCompat_Execution_State_Running: {
-                // Run the emulated CPU for a bunch of cycles.
+                // Run the emulated CPU until something needs the main loop, such as an exit, an exec, or a signal.
 
-                (void) MINIXCompat_CPU_Run(10000);
+                MINIXCompat_CPU_Run_Until_Stopped(MINIXCompat_Processes_Quantum());
+                MINIXCompat_Processes_HandleSignal();
+
+                // Under the in-process scheduler, the running process may also have exited, started waiting, or used up its quantum, so another process may need to take its place.
+
+                if (MINIXCompat_State == MINIXCompat_Execution_State_Running) {
+                    MINIXCompat_Processes_Schedule();
+                }
             } break;
 
             case MINIXCompat_Execution_State_Finished: {
@@ -81,7 +142,14 @@ int main(int argc, char **argv, char **envp)
         }
     }
 
-    // Exit with whatever our exit code should be.
+    // Report on what this process did and where it spent its time, now that it's done everything it will.
+
+    MINIXCompat_Stats_Report();
+    MINIXCompat_Profile_Report();
+
+    // Exit with whatever our exit code should be, letting the client know it too if this is handling a request for one.
+
+    MINIXCompat_Server_Finish(MINIXCompat_exit_status);
 
 	return MINIXCompat_exit_status;
 }
@@ -91,23 +159,48 @@ void MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State state)
 {
     // Ensure a valid state transition, only these are allowed:
     // - start -> ready
+    // - start -> restored
     // - ready -> running
+    // - restored -> running
     // - running -> ready
     // - running -> finished
     // - finished -> finished (since exit(2) can be called multiple times before actually exiting)
 
     assert(   ((MINIXCompat_State == MINIXCompat_Execution_State_Started) && (state == MINIXCompat_Execution_State_Ready))
+           || ((MINIXCompat_State == MINIXCompat_Execution_State_Started) && (state == MINIXCompat_Execution_State_Restored))
+           || ((MINIXCompat_State == MINIXCompat_Execution_State_Restored) && (state == MINIXCompat_Execution_State_Running))
            || ((MINIXCompat_State == MINIXCompat_Execution_State_Ready)   && (state == MINIXCompat_Execution_State_Running))
            || ((MINIXCompat_State == MINIXCompat_Execution_State_Running) && (state == MINIXCompat_Execution_State_Ready))
            || ((MINIXCompat_State == MINIXCompat_Execution_State_Running) && (state == MINIXCompat_Execution_State_Finished))
            || ((MINIXCompat_State == MINIXCompat_Execution_State_Finished) && (state == MINIXCompat_Execution_State_Finished)));
 
+    // Leaving the running state has to end the current run, so the CPU doesn't keep executing after an exit or with a new executable loaded.
+
+    if ((MINIXCompat_State == MINIXCompat_Execution_State_Running) && (state != MINIXCompat_Execution_State_Running)) {
+        MINIXCompat_CPU_Stop();
+    }
+
+    MINIXCompat_Trace_State(MINIXCompat_State, state);
+
     MINIXCompat_State = state;
 }
 
 
 void MINIXCompat_exit(int status)
 {
-    MINIXCompat_exit_status = status;
+    // Whatever the process wrote is written by the time it exits, even if it's still buffered.
+
+    MINIXCompat_Filesystem_Flush();
+
+    // Under the in-process scheduler, the host process runs until every MINIX process in it has exited, but exits with the status of the one it was started to run.
+
+    if (MINIXCompat_Processes_IsHostProcess()) {
+        MINIXCompat_exit_status = status;
+    }
+
+    if (MINIXCompat_Processes_exit(status)) {
+        return;
+    }
+
     MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Finished);
 }
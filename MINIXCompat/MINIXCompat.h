@@ -29,6 +29,9 @@ typedef enum MINIXCompat_Execution_State {
 
     /*! The emulator shoud shut down and exit with an appropriate status. */
     MINIXCompat_Execution_State_Finished = 3,
+
+    /*! The emulator has restored a snapshot and is ready to resume running it. */
+    MINIXCompat_Execution_State_Restored = 4,
 } MINIXCompat_Execution_State;
 
 
@@ -6,20 +6,37 @@
 //  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
 //
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1 /* for memfd_create(2) and fallocate(2) */
+#endif
+
 #include "MINIXCompat_Emulation.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
 
 #include <arpa/inet.h> /* for ntohs et al */
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "MINIXCompat_Types.h"
 #include "MINIXCompat_Executable.h"
+#include "MINIXCompat_Native.h"
+#include "MINIXCompat_Predecode.h"
+#include "MINIXCompat_Profile.h"
+#include "MINIXCompat_Snapshot.h"
+#include "MINIXCompat_Stats.h"
 #include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Utilities.h"
 
 #include "m68k.h"
 
@@ -30,20 +47,235 @@ MINIXCOMPAT_SOURCE_BEGIN
 /*!
  The RAM for the emulated CPU. Since all I/O is handled via system calls, there are no I/O devices and there isn't even a bootstrap ROM. Instead, the "bootstrap" is handled by manually setting a PC value and starting execution. This gives us the entire 16MB address space to work with, modulo data structures stored at specific addresses.
 
- Note that everything within this array is in Motorola (network) byte order.
+ Note that everything within this array is in Motorola (network) byte order, or word-swizzled if ``MINIXCOMPAT_RAM_BYTE_XOR`` is set.
  */
-static uint8_t *MINIXCompat_RAM;
+uint8_t *MINIXCompat_RAM;
+
+/*! The size of the RAM mapping, which is ``MINIXCompat_RAM_Size`` plus a page of slack. */
+static size_t MINIXCompat_RAM_Mapping_Size = 0;
+
+/*! The host page size, to which all resets of RAM are rounded. */
+static size_t MINIXCompat_RAM_Page_Size = 0;
+
+/*!
+ The first address above everything in the low part of RAM (vectors, executable image, and heap) that may have been written since the last reset.
+
+ Loading an executable and growing the break raise this directly. Nothing stops a program from storing past its break, though, so stores are tracked by page in ``MINIXCompat_RAM_Dirty_Pages`` and folded into this whenever it's used. The stack region from ``MINIXCompat_Stack_Limit`` to the top of the address space is always treated as dirty, so it isn't tracked.
+ */
+static m68k_address_t MINIXCompat_RAM_High_Water = 0;
+
+/*! The size of the pages in which stores are tracked, independent of the host page size. */
+#define MINIXCompat_RAM_Dirty_Page_Shift 12
+
+/*! Whether each page of RAM has been stored to since it was last folded into ``MINIXCompat_RAM_High_Water``; marking a page is a single store, so it costs the CPU loop much less than comparing every store against the mark. */
+static uint8_t MINIXCompat_RAM_Dirty_Pages[(MINIXCompat_RAM_Size >> MINIXCompat_RAM_Dirty_Page_Shift)];
+
+
+/*! How the RAM for the emulated CPU is backed by host memory, as selected by `MINIXCOMPAT_RAM_BACKING`. */
+typedef enum MINIXCompat_RAM_Backing: int {
+    /*! A private anonymous mapping, whose pages are committed as they're touched and copied on write after a `fork(2)`. */
+    MINIXCompat_RAM_Backing_Anonymous = 0,
+
+    /*! A private anonymous mapping aligned to and advised for transparent huge pages where the host supports them, to cut TLB misses. */
+    MINIXCompat_RAM_Backing_HugePage,
+
+    /*! A private anonymous mapping that reserves no swap, so nothing is committed until it's touched. */
+    MINIXCompat_RAM_Backing_NoReserve,
+
+    /*! A shared mapping of an anonymous memory object, which a forked child replaces with a copy of just the parts of RAM that are in use. */
+    MINIXCompat_RAM_Backing_Shared,
+} MINIXCompat_RAM_Backing_t;
+
+/*! The backing store selected for new RAM. */
+static MINIXCompat_RAM_Backing_t MINIXCompat_RAM_Selected_Backing = MINIXCompat_RAM_Backing_Anonymous;
+
+/*! The backing store of the RAM in use, which may differ from the one selected if that wasn't available when it was mapped. */
+static MINIXCompat_RAM_Backing_t MINIXCompat_RAM_Backing = MINIXCompat_RAM_Backing_Anonymous;
+
+/*! The flags used for private mappings of RAM, including any fresh pages mapped over it on reset. */
+static int MINIXCompat_RAM_Map_Flags = MAP_PRIVATE | MAP_ANON;
+
+/*! The memory object backing RAM for ``MINIXCompat_RAM_Backing_Shared``, or `-1`. */
+static int MINIXCompat_RAM_Shared_FD = -1;
+
+/*! The memory object holding a copy of shared RAM for a child about to be forked, or `-1`. */
+static int MINIXCompat_RAM_Fork_FD = -1;
+
+/*! The alignment to use for RAM backed by huge pages; 2MB is the smallest huge page size on common hosts. */
+static const size_t MINIXCompat_RAM_Huge_Page_Size = 0x200000;
+
+
+/*! Run the emulated CPU for up to \a cycles, through the predecoded instruction cache if it's built in. */
+#if MINIXCOMPAT_PREDECODE
+#define MINIXCompat_CPU_Execute(cycles) MINIXCompat_Predecode_Execute(cycles)
+#else
+#define MINIXCompat_CPU_Execute(cycles) m68k_execute(cycles)
+#endif
+
+
+/*! The number of cycles run by completed calls to ``MINIXCompat_CPU_Run``. */
+static uint64_t MINIXCompat_CPU_Cycles_Completed = 0;
+
+/*! Whether the CPU is inside a call to ``MINIXCompat_CPU_Run``, since that's the only time Musashi's count of cycles run is current; host signal handlers may look at this. */
+static volatile sig_atomic_t MINIXCompat_CPU_Running = 0;
+
+/*! Whether something has asked the CPU to stop running, which may be set asynchronously by a host signal handler via ``MINIXCompat_CPU_Stop_Async``. */
+static volatile sig_atomic_t MINIXCompat_CPU_Stop_Requested = 0;
+
+/*!
+ The number of cycles to run at a time when running until stopped.
+
+ Nothing but a stop request needs to end a run, so this only bounds how long a stop requested asynchronously goes unnoticed, since a host signal handler can't safely cut the current timeslice short.
+ */
+static const int MINIXCompat_CPU_Run_Slice = 0x100000;
 
 
 int MINIXCompat_CPU_Trap_Callback(int trap);
 
 
+/*!
+ Create a new anonymous memory object of ``MINIXCompat_RAM_Mapping_Size`` bytes for shared RAM.
+
+ - Returns: Its descriptor, or `-1` with `errno` set on failure.
+ */
+static int MINIXCompat_RAM_Create_Shared_Object(void)
+{
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    int fd = memfd_create("MINIXCompat_RAM", MFD_CLOEXEC);
+#else
+    // Without memfd_create(2), use a POSIX shared memory object with a unique name, which is unlinked immediately since nothing needs to find it by name.
+
+    static unsigned int shm_serial = 0;
+    char shm_name[64];
+    snprintf(shm_name, sizeof(shm_name), "/MINIXCompat_RAM.%ld.%u", (long) getpid(), shm_serial++);
+
+    int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1) {
+        shm_unlink(shm_name);
+        (void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+
+    if (fd == -1) {
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t) MINIXCompat_RAM_Mapping_Size) == -1) {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/*! Select the backing store from `MINIXCOMPAT_RAM_BACKING`, defaulting to an anonymous mapping. */
+static void MINIXCompat_RAM_Select_Backing(void)
+{
+    const char *backing = getenv("MINIXCOMPAT_RAM_BACKING");
+
+    if ((backing == NULL) || (backing[0] == '\0') || (strcmp(backing, "anonymous") == 0)) {
+        MINIXCompat_RAM_Selected_Backing = MINIXCompat_RAM_Backing_Anonymous;
+    } else if (strcmp(backing, "hugepage") == 0) {
+        MINIXCompat_RAM_Selected_Backing = MINIXCompat_RAM_Backing_HugePage;
+    } else if (strcmp(backing, "noreserve") == 0) {
+        MINIXCompat_RAM_Selected_Backing = MINIXCompat_RAM_Backing_NoReserve;
+    } else if (strcmp(backing, "shared") == 0) {
+        MINIXCompat_RAM_Selected_Backing = MINIXCompat_RAM_Backing_Shared;
+    } else {
+        fprintf(stderr, "MINIXCompat: unknown MINIXCOMPAT_RAM_BACKING '%s', using anonymous\n", backing);
+        MINIXCompat_RAM_Selected_Backing = MINIXCompat_RAM_Backing_Anonymous;
+    }
+}
+
+
+/*!
+ Map new RAM for the emulated CPU using the selected backing store.
+
+ Every backing store is lazily committed, so pages only cost anything once they're touched. If a backing store isn't available on this host, fall back to a plain anonymous mapping.
+
+ - Returns: Whether RAM could be mapped, with the mapping in \a out_ram, the backing store it ended up with in \a out_backing, and its memory object or `-1` in \a out_shared_fd; on failure, `errno` is set.
+ */
+static bool MINIXCompat_RAM_Map(uint8_t * _Nullable * _Nonnull out_ram, MINIXCompat_RAM_Backing_t * _Nonnull out_backing, int * _Nonnull out_shared_fd)
+{
+    void *mapping = MAP_FAILED;
+    MINIXCompat_RAM_Backing_t backing = MINIXCompat_RAM_Selected_Backing;
+    int shared_fd = -1;
+
+    switch (backing) {
+        case MINIXCompat_RAM_Backing_Anonymous:
+            break;
+
+        case MINIXCompat_RAM_Backing_HugePage: {
+#if defined(MADV_HUGEPAGE)
+            // Over-allocate so the mapping can be trimmed to huge page alignment; otherwise the ends of RAM, where the executable and stack live, can't use huge pages.
+
+            const size_t padded_size = MINIXCompat_RAM_Mapping_Size + MINIXCompat_RAM_Huge_Page_Size;
+            uint8_t *padded = mmap(NULL, padded_size, PROT_READ | PROT_WRITE, MINIXCompat_RAM_Map_Flags, -1, 0);
+            if (padded != MAP_FAILED) {
+                const uintptr_t huge_mask = MINIXCompat_RAM_Huge_Page_Size - 1;
+                uint8_t *aligned = (uint8_t *)(((uintptr_t)padded + huge_mask) & ~huge_mask);
+                uint8_t *padded_end = padded + padded_size;
+                uint8_t *aligned_end = aligned + MINIXCompat_RAM_Mapping_Size;
+
+                if (aligned > padded) munmap(padded, (size_t)(aligned - padded));
+                if (padded_end > aligned_end) munmap(aligned_end, (size_t)(padded_end - aligned_end));
+
+                (void) madvise(aligned, MINIXCompat_RAM_Mapping_Size, MADV_HUGEPAGE);
+                mapping = aligned;
+            }
+#endif
+        } break;
+
+        case MINIXCompat_RAM_Backing_NoReserve: {
+#if defined(MAP_NORESERVE)
+            MINIXCompat_RAM_Map_Flags |= MAP_NORESERVE;
+#endif
+        } break;
+
+        case MINIXCompat_RAM_Backing_Shared: {
+            shared_fd = MINIXCompat_RAM_Create_Shared_Object();
+            if (shared_fd != -1) {
+                mapping = mmap(NULL, MINIXCompat_RAM_Mapping_Size, PROT_READ | PROT_WRITE, MAP_SHARED, shared_fd, 0);
+                if (mapping == MAP_FAILED) {
+                    close(shared_fd);
+                    shared_fd = -1;
+                }
+            }
+        } break;
+    }
+
+    if (mapping == MAP_FAILED) {
+        mapping = mmap(NULL, MINIXCompat_RAM_Mapping_Size, PROT_READ | PROT_WRITE, MINIXCompat_RAM_Map_Flags, -1, 0);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        if (backing != MINIXCompat_RAM_Backing_NoReserve) {
+            backing = MINIXCompat_RAM_Backing_Anonymous;
+        }
+    }
+
+    *out_ram = mapping;
+    *out_backing = backing;
+    *out_shared_fd = shared_fd;
+    return true;
+}
+
+
 int MINIXCompat_CPU_Initialize(void)
 {
-    // Configure the RAM.
+    // Configure the RAM as a lazily-committed mapping so its pages are only committed as they're touched and can be handed back to the host when an exec resets them. A page of slack past the end keeps accesses at the top of the address space in bounds after masking.
 
-    MINIXCompat_RAM = calloc(16 * 1024 * 1024, sizeof(uint8_t));
-    assert(MINIXCompat_RAM != NULL);
+    long page_size = sysconf(_SC_PAGESIZE);
+    MINIXCompat_RAM_Page_Size = (page_size > 0) ? (size_t) page_size : 4096;
+    MINIXCompat_RAM_Mapping_Size = MINIXCompat_RAM_Size + MINIXCompat_RAM_Page_Size;
+
+    MINIXCompat_RAM_Select_Backing();
+    if (!MINIXCompat_RAM_Map(&MINIXCompat_RAM, &MINIXCompat_RAM_Backing, &MINIXCompat_RAM_Shared_FD)) {
+        return errno;
+    }
 
     // Configure the CPU.
 
@@ -76,7 +308,78 @@ void MINIXCompat_CPU_Reset(void)
 
 int MINIXCompat_CPU_Run(int cycles)
 {
-    return m68k_execute(cycles);
+    int cycles_run = 0;
+    const int profile_interval = MINIXCompat_Profile_Interval();
+
+    MINIXCompat_CPU_Running = 1;
+
+    if (profile_interval == 0) {
+        cycles_run = MINIXCompat_CPU_Execute(cycles);
+    } else {
+        // Run in slices of the profiling interval, sampling after each.
+
+        while ((cycles_run < cycles) && !MINIXCompat_CPU_Stop_Requested) {
+            const int slice = ((cycles - cycles_run) < profile_interval) ? (cycles - cycles_run) : profile_interval;
+            cycles_run += MINIXCompat_CPU_Execute(slice);
+
+            MINIXCompat_Profile_Sample(m68k_get_reg(NULL, M68K_REG_PC), m68k_get_reg(NULL, M68K_REG_A6));
+        }
+    }
+
+    MINIXCompat_CPU_Running = 0;
+
+    MINIXCompat_CPU_Cycles_Completed += (uint64_t) cycles_run;
+    return cycles_run;
+}
+
+
+void MINIXCompat_CPU_Run_Until_Stopped(int quantum)
+{
+    int cycles_run = 0;
+
+    // Only a stop request that ends the loop is consumed; one made as the quantum runs out still stops the next run.
+
+    for (;;) {
+        if (MINIXCompat_CPU_Stop_Requested) {
+            MINIXCompat_CPU_Stop_Requested = 0;
+            break;
+        }
+
+        const int slice = ((quantum > 0) && ((quantum - cycles_run) < MINIXCompat_CPU_Run_Slice)) ? (quantum - cycles_run) : MINIXCompat_CPU_Run_Slice;
+        cycles_run += MINIXCompat_CPU_Run(slice);
+
+        if ((quantum > 0) && (cycles_run >= quantum)) {
+            break;
+        }
+    }
+}
+
+
+void MINIXCompat_CPU_Stop(void)
+{
+    MINIXCompat_CPU_Stop_Requested = 1;
+
+    // End the current timeslice after the current instruction. Unlike m68k_end_timeslice(), shrinking the timeslice to what's been run keeps Musashi's count of cycles run accurate.
+
+    if (MINIXCompat_CPU_Running) {
+        m68k_modify_timeslice(-m68k_cycles_remaining());
+    }
+}
+
+
+void MINIXCompat_CPU_Stop_Async(void)
+{
+    // Musashi's cycle counts are plain ints updated as instructions run, so a signal handler mustn't touch them; just leave the request for the current slice to end on.
+
+    MINIXCompat_CPU_Stop_Requested = 1;
+}
+
+
+uint64_t MINIXCompat_CPU_Cycles(void)
+{
+    // While the CPU is running, also count the cycles run so far by the current call.
+
+    return MINIXCompat_CPU_Cycles_Completed + (MINIXCompat_CPU_Running ? (uint64_t) m68k_cycles_run() : 0);
 }
 
 
@@ -96,6 +399,9 @@ int MINIXCompat_CPU_Trap_Callback(int trap)
             uint16_t src_dest = (uint16_t) D1_l;
             m68k_address_t msg = A0;
 
+            MINIXCompat_Stats_Trap(MINIXCompat_CPU_Cycles());
+            MINIXCompat_Snapshot_System_Call(src_dest);
+
             uint32_t new_D0_l = 0;
             minix_syscall_result_t syscall_result = MINIXCompat_System_Call(func, src_dest, msg, &new_D0_l);
             switch (syscall_result) {
@@ -110,11 +416,21 @@ int MINIXCompat_CPU_Trap_Callback(int trap)
                 case minix_syscall_result_failure:
                     m68k_set_reg(M68K_REG_D0, 0xFFFFFFFF);
                     break;
+
+                case minix_syscall_result_retry:
+                    // Leave the registers alone and back the PC up to the trap, so the call is made again when the process runs next.
+                    m68k_set_reg(M68K_REG_PC, m68k_get_reg(NULL, M68K_REG_PC) - 2);
+                    break;
             }
 
             handled = true;
         } break;
 
+        case 0xE: {
+            // Patched entry points of routines with native implementations.
+            handled = MINIXCompat_Native_Trap();
+        } break;
+
         default: {
             // Let the CPU handle the trap.
             handled = false;
@@ -125,82 +441,560 @@ int MINIXCompat_CPU_Trap_Callback(int trap)
 }
 
 
-uint8_t MINIXCompat_RAM_Read_8(m68k_address_t m68k_address)
+void MINIXCompat_RAM_Copy_Block_From_Host(m68k_address_t m68k_address, void *host_block_address, uint32_t host_block_size)
 {
-    assert(m68k_address < 0x01000000);
-    const uint8_t *RAM = MINIXCompat_RAM + m68k_address;
-    const uint8_t *RAM8 = (const uint8_t *)RAM;
-    return *RAM8;
+    assert(m68k_address < MINIXCompat_RAM_Size);
+    assert((host_block_size + m68k_address) <= MINIXCompat_RAM_Size);
+
+    MINIXCompat_Predecode_Note_Block_Write(m68k_address, host_block_size);
+    MINIXCompat_RAM_Note_Block_Write(m68k_address, host_block_size);
+#if MINIXCOMPAT_RAM_BYTE_XOR
+    // Swizzle each byte into its half of the host-order word containing it.
+
+    const uint8_t *host_block = host_block_address;
+    for (uint32_t i = 0; i < host_block_size; i++) {
+        MINIXCompat_RAM[(m68k_address + i) ^ MINIXCOMPAT_RAM_BYTE_XOR] = host_block[i];
+    }
+#else
+    uint8_t *RAM = MINIXCompat_RAM + m68k_address;
+
+    memcpy(RAM, host_block_address, host_block_size);
+#endif
 }
 
-uint16_t MINIXCompat_RAM_Read_16(m68k_address_t m68k_address)
+
+/*! Note a store that ends with the byte at \a m68k_address; only the highest page written matters, so that's all that's marked. */
+static inline void MINIXCompat_RAM_Note_Store(m68k_address_t m68k_address)
 {
-    assert(m68k_address < 0x01000000);
-    const uint8_t *RAM = MINIXCompat_RAM + m68k_address;
-    const uint16_t *RAM16 = (const uint16_t *)RAM;
-    return ntohs(*RAM16);
+    MINIXCompat_RAM_Dirty_Pages[(m68k_address & MINIXCompat_RAM_Address_Mask) >> MINIXCompat_RAM_Dirty_Page_Shift] = 1;
 }
 
-uint32_t MINIXCompat_RAM_Read_32(m68k_address_t m68k_address)
+
+void MINIXCompat_RAM_Note_Block_Write(m68k_address_t m68k_address, uint32_t m68k_block_size)
 {
-    assert(m68k_address < 0x01000000);
-    const uint8_t *RAM = MINIXCompat_RAM + m68k_address;
-    const uint32_t *RAM32 = (const uint32_t *)RAM;
-    return ntohl(*RAM32);
+    if (m68k_block_size > 0) {
+        MINIXCompat_RAM_Note_Store(m68k_address + m68k_block_size - 1);
+    }
 }
 
 
-void MINIXCompat_RAM_Write_8(m68k_address_t m68k_address, uint8_t value)
+/*! Raise ``MINIXCompat_RAM_High_Water`` above every page stored to below the stack region, and start tracking stores afresh. */
+static void MINIXCompat_RAM_Fold_Dirty_Pages(void)
 {
-    assert(m68k_address < 0x01000000);
-    uint8_t *RAM = MINIXCompat_RAM + m68k_address;
-    uint8_t *RAM8 = (uint8_t *)RAM;
-    *RAM8 = value;
+    const size_t stack_page = (size_t) MINIXCompat_Stack_Limit >> MINIXCompat_RAM_Dirty_Page_Shift;
+
+    for (size_t page = stack_page; page > 0; page--) {
+        if (MINIXCompat_RAM_Dirty_Pages[page - 1]) {
+            MINIXCompat_RAM_Note_High_Water((m68k_address_t) (page << MINIXCompat_RAM_Dirty_Page_Shift));
+            break;
+        }
+    }
+
+    memset(MINIXCompat_RAM_Dirty_Pages, 0, sizeof(MINIXCompat_RAM_Dirty_Pages));
 }
 
-void MINIXCompat_RAM_Write_16(m68k_address_t m68k_address, uint16_t value)
+
+void MINIXCompat_RAM_Note_High_Water(m68k_address_t m68k_address)
 {
-    assert(m68k_address < 0x01000000);
-    uint8_t *RAM = MINIXCompat_RAM + m68k_address;
-    uint16_t *RAM16 = (uint16_t *)RAM;
-    *RAM16 = htons(value);
+    if (m68k_address > MINIXCompat_RAM_Size) {
+        m68k_address = MINIXCompat_RAM_Size;
+    }
+
+    if (m68k_address > MINIXCompat_RAM_High_Water) {
+        MINIXCompat_RAM_High_Water = m68k_address;
+    }
 }
 
-void MINIXCompat_RAM_Write_32(m68k_address_t m68k_address, uint32_t value)
+
+/*!
+ Reset the pages covering \a len bytes of RAM at \a offset to zero.
+
+ For private mappings, mapping fresh anonymous pages over them releases the old ones to the host, so untouched pages cost nothing until they're used again; this works the same everywhere, unlike the zeroing behavior of `madvise(2)`. Huge page mappings are the exception, since new mappings would lose their advice and split them, so those use `madvise(2)` where that's known to zero pages. Shared mappings have holes punched in their memory object where possible. If any of these fails for some reason, just clear the pages.
+ */
+static void MINIXCompat_RAM_Reset_Pages(size_t offset, size_t len)
 {
-    assert(m68k_address < 0x01000000);
-    uint8_t *RAM = MINIXCompat_RAM + m68k_address;
-    uint32_t *RAM32 = (uint32_t *)RAM;
-    *RAM32 = htonl(value);
+    const size_t page_mask = MINIXCompat_RAM_Page_Size - 1;
+    const size_t start = offset & ~page_mask;
+    const size_t end = (offset + len + page_mask) & ~page_mask;
+
+    if (end <= start) return;
+
+    void *pages = MINIXCompat_RAM + start;
+    bool reset = false;
+
+    switch (MINIXCompat_RAM_Backing) {
+        case MINIXCompat_RAM_Backing_HugePage: {
+#if defined(MADV_HUGEPAGE) && defined(MADV_DONTNEED)
+            reset = (madvise(pages, end - start, MADV_DONTNEED) == 0);
+#endif
+        } break;
+
+        case MINIXCompat_RAM_Backing_Shared: {
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+            reset = (fallocate(MINIXCompat_RAM_Shared_FD, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t) start, (off_t)(end - start)) == 0);
+#endif
+        } break;
+
+        case MINIXCompat_RAM_Backing_Anonymous:
+        case MINIXCompat_RAM_Backing_NoReserve: {
+            void *mapping = mmap(pages, end - start, PROT_READ | PROT_WRITE, MINIXCompat_RAM_Map_Flags | MAP_FIXED, -1, 0);
+            reset = (mapping != MAP_FAILED);
+        } break;
+    }
+
+    if (!reset) {
+        memset(pages, 0, end - start);
+    }
 }
 
 
-void MINIXCompat_RAM_Copy_Block_From_Host(m68k_address_t m68k_address, void *host_block_address, uint32_t host_block_size)
+void MINIXCompat_RAM_Reset(void)
 {
-    assert(m68k_address < 0x01000000);
-    assert((host_block_size + m68k_address) <= 0x01000000);
-    uint8_t *RAM = MINIXCompat_RAM + m68k_address;
+    // Only the low part of RAM up to the high-water mark and the stack region can have been written.
 
-    memcpy(RAM, host_block_address, host_block_size);
+    MINIXCompat_RAM_Fold_Dirty_Pages();
+    MINIXCompat_RAM_Reset_Pages(0, MINIXCompat_RAM_High_Water);
+    MINIXCompat_RAM_Reset_Pages(MINIXCompat_Stack_Limit, MINIXCompat_RAM_Mapping_Size - MINIXCompat_Stack_Limit);
+
+    MINIXCompat_RAM_High_Water = 0;
 }
 
 
-void *MINIXCompat_RAM_Copy_Block_To_Host(m68k_address_t m68k_address, uint32_t m68k_block_size)
+bool MINIXCompat_RAM_Map_File(int fd, off_t file_offset, m68k_address_t m68k_address, uint32_t len)
 {
-    assert(m68k_address < 0x01000000);
-    assert((m68k_block_size + m68k_address) <= 0x01000000);
+    const size_t page_mask = MINIXCompat_RAM_Page_Size - 1;
+
+    if (   ((m68k_address & page_mask) != 0)
+        || (((size_t) file_offset & page_mask) != 0)
+        || ((len & page_mask) != 0)
+        || (m68k_address > MINIXCompat_RAM_Size)
+        || (len > (MINIXCompat_RAM_Size - m68k_address)))
+    {
+        return false;
+    }
 
-    const uint8_t *RAM = MINIXCompat_RAM + m68k_address;
+    if (len == 0) {
+        return true;
+    }
+
+    // A private file mapping only stands in for anonymous memory, since resetting huge pages or shared memory wouldn't discard it.
+
+    if ((MINIXCompat_RAM_Backing != MINIXCompat_RAM_Backing_Anonymous) && (MINIXCompat_RAM_Backing != MINIXCompat_RAM_Backing_NoReserve)) {
+        return false;
+    }
+
+    void *mapping = mmap(MINIXCompat_RAM + m68k_address, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, file_offset);
+    return (mapping != MAP_FAILED);
+}
+
+
+/*! Write all of \a len bytes of RAM at \a offset to the same offset in \a fd, returning whether that succeeded. */
+static bool MINIXCompat_RAM_Write_Pages(int fd, size_t offset, size_t len)
+{
+    while (len > 0) {
+        ssize_t written = pwrite(fd, MINIXCompat_RAM + offset, len, (off_t) offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        offset += (size_t) written;
+        len -= (size_t) written;
+    }
+
+    return true;
+}
+
+
+int MINIXCompat_RAM_Fork_Prepare(void)
+{
+    if (MINIXCompat_RAM_Backing != MINIXCompat_RAM_Backing_Shared) {
+        return 0;
+    }
+
+    // Copy only the parts of RAM that can be in use into a new memory object for the child, before forking, so anything that goes wrong fails the fork rather than the child. Everything else is a hole that reads as zero, so the cost of the copy is proportional to what the executable has used rather than to the whole address space, and neither process takes copy-on-write faults afterwards.
 
+    MINIXCompat_RAM_Fold_Dirty_Pages();
+
+    const size_t page_mask = MINIXCompat_RAM_Page_Size - 1;
+    const size_t low_len = ((size_t) MINIXCompat_RAM_High_Water + page_mask) & ~page_mask;
+    const size_t stack_start = (size_t) MINIXCompat_Stack_Limit & ~page_mask;
+
+    int new_fd = MINIXCompat_RAM_Create_Shared_Object();
+    if (new_fd == -1) {
+        return errno;
+    }
+
+    if (   !MINIXCompat_RAM_Write_Pages(new_fd, 0, low_len)
+        || !MINIXCompat_RAM_Write_Pages(new_fd, stack_start, MINIXCompat_RAM_Mapping_Size - stack_start))
+    {
+        int saved_errno = errno;
+        close(new_fd);
+        return saved_errno;
+    }
+
+    MINIXCompat_RAM_Fork_FD = new_fd;
+    return 0;
+}
+
+
+void MINIXCompat_RAM_Fork_Parent(void)
+{
+    if (MINIXCompat_RAM_Backing != MINIXCompat_RAM_Backing_Shared) {
+        return;
+    }
+
+    // The child has its own copy of RAM already, so the parent can carry on changing its own.
+
+    close(MINIXCompat_RAM_Fork_FD);
+    MINIXCompat_RAM_Fork_FD = -1;
+}
+
+
+void MINIXCompat_RAM_Fork_Child(void)
+{
+    if (MINIXCompat_RAM_Backing != MINIXCompat_RAM_Backing_Shared) {
+        return;
+    }
+
+    // Map the copy made before forking in place of the memory object shared with the parent. If that fails, the old mapping is still shared with the parent, so the child must not run at all.
+
+    void *mapping = mmap(MINIXCompat_RAM, MINIXCompat_RAM_Mapping_Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, MINIXCompat_RAM_Fork_FD, 0);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "MINIXCompat: can't map emulated RAM for a forked process: %s\n", strerror(errno));
+        _exit(EX_OSERR);
+    }
+
+    close(MINIXCompat_RAM_Shared_FD);
+    MINIXCompat_RAM_Shared_FD = MINIXCompat_RAM_Fork_FD;
+    MINIXCompat_RAM_Fork_FD = -1;
+}
+
+
+/*! The CPU state and RAM of a switched-out process. */
+struct MINIXCompat_CPU_Context {
+    /*! Musashi's context, of `m68k_context_size()` bytes. */
+    void *cpu;
+
+    uint64_t cycles_completed;
+
+    uint8_t *ram;
+    MINIXCompat_RAM_Backing_t ram_backing;
+    int ram_shared_fd;
+    m68k_address_t ram_high_water;
+};
+
+
+MINIXCompat_CPU_Context_t *MINIXCompat_CPU_Context_Fork(void)
+{
+    MINIXCompat_CPU_Context_t *context = calloc(1, sizeof(MINIXCompat_CPU_Context_t));
+    void *cpu = malloc(m68k_context_size());
+    if ((context == NULL) || (cpu == NULL)) {
+        free(context);
+        free(cpu);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    // The child starts at the trap, so that it retries the system call in progress.
+
+    const uint32_t pc = m68k_get_reg(NULL, M68K_REG_PC);
+    m68k_set_reg(M68K_REG_PC, pc - 2);
+    m68k_get_context(cpu);
+    m68k_set_reg(M68K_REG_PC, pc);
+
+    // Map new RAM with the selected backing store, which it keeps track of for itself since it may not get the same one as the parent, and copy only the parts of RAM that can be in use into it, the same way a host fork(2) of shared RAM does. Everything else is untouched and reads as zero, so the cost is proportional to what the executable has used, and a child that just execs something else throws little away.
+
+    if (!MINIXCompat_RAM_Map(&context->ram, &context->ram_backing, &context->ram_shared_fd)) {
+        free(context);
+        free(cpu);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    MINIXCompat_RAM_Fold_Dirty_Pages();
+
+    context->cpu = cpu;
+    context->cycles_completed = MINIXCompat_CPU_Cycles();
+    context->ram_high_water = MINIXCompat_RAM_High_Water;
+
+    uint8_t * const parent_ram = MINIXCompat_RAM;
+
+    const size_t page_mask = MINIXCompat_RAM_Page_Size - 1;
+    const size_t low_len = ((size_t) MINIXCompat_RAM_High_Water + page_mask) & ~page_mask;
+    const size_t stack_start = (size_t) MINIXCompat_Stack_Limit & ~page_mask;
+
+    memcpy(context->ram, parent_ram, low_len);
+    memcpy(context->ram + stack_start, parent_ram + stack_start, MINIXCompat_RAM_Mapping_Size - stack_start);
+
+    return context;
+}
+
+
+MINIXCompat_CPU_Context_t *MINIXCompat_CPU_Context_Save(void)
+{
+    assert(!MINIXCompat_CPU_Running);
+
+    MINIXCompat_CPU_Context_t *context = calloc(1, sizeof(MINIXCompat_CPU_Context_t));
+    assert(context != NULL);
+    context->cpu = malloc(m68k_context_size());
+    assert(context->cpu != NULL);
+
+    m68k_get_context(context->cpu);
+    context->cycles_completed = MINIXCompat_CPU_Cycles_Completed;
+
+    context->ram = MINIXCompat_RAM;
+    context->ram_backing = MINIXCompat_RAM_Backing;
+    context->ram_shared_fd = MINIXCompat_RAM_Shared_FD;
+    MINIXCompat_RAM_Fold_Dirty_Pages();
+    context->ram_high_water = MINIXCompat_RAM_High_Water;
+
+    MINIXCompat_RAM = NULL;
+    MINIXCompat_RAM_Shared_FD = -1;
+    MINIXCompat_RAM_High_Water = 0;
+
+    return context;
+}
+
+
+void MINIXCompat_CPU_Context_Restore(MINIXCompat_CPU_Context_t *context)
+{
+    assert(context != NULL);
+    assert(!MINIXCompat_CPU_Running);
+
+    m68k_set_context(context->cpu);
+    MINIXCompat_CPU_Cycles_Completed = context->cycles_completed;
+
+    MINIXCompat_RAM = context->ram;
+    MINIXCompat_RAM_Backing = context->ram_backing;
+    MINIXCompat_RAM_Shared_FD = context->ram_shared_fd;
+    MINIXCompat_RAM_High_Water = context->ram_high_water;
+
+    // Anything predecoded was from the other process's RAM.
+
+    MINIXCompat_Predecode_Flush();
+
+    free(context->cpu);
+    free(context);
+}
+
+
+void MINIXCompat_CPU_Context_Free(MINIXCompat_CPU_Context_t *context)
+{
+    if (context == NULL) {
+        return;
+    }
+
+    if (context->ram != NULL) {
+        munmap(context->ram, MINIXCompat_RAM_Mapping_Size);
+    }
+    if (context->ram_shared_fd != -1) {
+        close(context->ram_shared_fd);
+    }
+
+    free(context->cpu);
+    free(context);
+}
+
+
+/*! The registers saved in a snapshot, with the status register first since it selects which stack pointer `A7` is. */
+static const m68k_register_t MINIXCompat_CPU_Snapshot_Registers[] = {
+    M68K_REG_SR,
+    M68K_REG_D0, M68K_REG_D1, M68K_REG_D2, M68K_REG_D3, M68K_REG_D4, M68K_REG_D5, M68K_REG_D6, M68K_REG_D7,
+    M68K_REG_A0, M68K_REG_A1, M68K_REG_A2, M68K_REG_A3, M68K_REG_A4, M68K_REG_A5, M68K_REG_A6, M68K_REG_A7,
+    M68K_REG_USP, M68K_REG_ISP,
+    M68K_REG_PC,
+};
+
+/*! The number of registers saved in a snapshot. */
+#define MINIXCOMPAT_CPU_SNAPSHOT_REGISTERS (sizeof(MINIXCompat_CPU_Snapshot_Registers) / sizeof(MINIXCompat_CPU_Snapshot_Registers[0]))
+
+/*! The part of a snapshot holding the CPU's state, which is followed by RAM starting at the next page boundary. */
+typedef struct minix_cpu_snapshot {
+    uint32_t registers[MINIXCOMPAT_CPU_SNAPSHOT_REGISTERS];
+    uint32_t ram_high_water;
+    uint32_t page_size;
+} minix_cpu_snapshot_t;
+
+/*! Get the offset \a fd is at, rounded up to the next page boundary. */
+static off_t MINIXCompat_CPU_Snapshot_RAM_Offset(int fd)
+{
+    const off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset == -1) {
+        return -1;
+    }
+
+    const off_t page_mask = (off_t) MINIXCompat_RAM_Page_Size - 1;
+    return (offset + page_mask) & ~page_mask;
+}
+
+bool MINIXCompat_CPU_Snapshot_Write(int fd)
+{
+    // Only registers are saved rather than Musashi's whole context, which holds host pointers that may not be the same in a later run. The PC is backed up to the trap, so the system call being made is made again after a restore.
+
+    minix_cpu_snapshot_t snapshot;
+    for (size_t i = 0; i < MINIXCOMPAT_CPU_SNAPSHOT_REGISTERS; i++) {
+        snapshot.registers[i] = m68k_get_reg(NULL, MINIXCompat_CPU_Snapshot_Registers[i]);
+        if (MINIXCompat_CPU_Snapshot_Registers[i] == M68K_REG_PC) {
+            snapshot.registers[i] -= 2;
+        }
+    }
+    MINIXCompat_RAM_Fold_Dirty_Pages();
+    snapshot.ram_high_water = MINIXCompat_RAM_High_Water;
+    snapshot.page_size = (uint32_t) MINIXCompat_RAM_Page_Size;
+
+    if (!MINIXCompat_Host_Write_Bytes(fd, &snapshot, sizeof(snapshot))) {
+        return false;
+    }
+
+    // Only the low part of RAM up to the high-water mark and the stack region can be in use, just like for a fork.
+
+    const off_t ram_offset = MINIXCompat_CPU_Snapshot_RAM_Offset(fd);
+    if ((ram_offset == -1) || (ftruncate(fd, ram_offset) == -1) || (lseek(fd, ram_offset, SEEK_SET) == -1)) {
+        return false;
+    }
+
+    const size_t page_mask = MINIXCompat_RAM_Page_Size - 1;
+    const size_t low_len = ((size_t) MINIXCompat_RAM_High_Water + page_mask) & ~page_mask;
+    const size_t stack_start = (size_t) MINIXCompat_Stack_Limit & ~page_mask;
+
+    return MINIXCompat_Host_Write_Bytes(fd, MINIXCompat_RAM, low_len)
+        && MINIXCompat_Host_Write_Bytes(fd, MINIXCompat_RAM + stack_start, MINIXCompat_RAM_Mapping_Size - stack_start);
+}
+
+/*! Restore \a len bytes of RAM at \a ram_offset from \a file_offset in the snapshot \a fd, mapping them copy-on-write where the backing store allows. */
+static bool MINIXCompat_CPU_Snapshot_Read_RAM(int fd, off_t file_offset, size_t ram_offset, size_t len)
+{
+    if (len == 0) {
+        return true;
+    }
+
+    if (MINIXCompat_RAM_Map_File(fd, file_offset, (m68k_address_t) ram_offset, (uint32_t) len)) {
+        return true;
+    }
+
+    return (lseek(fd, file_offset, SEEK_SET) != -1) && MINIXCompat_Host_Read_Bytes(fd, MINIXCompat_RAM + ram_offset, len);
+}
+
+bool MINIXCompat_CPU_Snapshot_Read(int fd)
+{
+    minix_cpu_snapshot_t snapshot;
+    if (!MINIXCompat_Host_Read_Bytes(fd, &snapshot, sizeof(snapshot))
+        || (snapshot.page_size != (uint32_t) MINIXCompat_RAM_Page_Size)
+        || (snapshot.ram_high_water > MINIXCompat_Stack_Limit))
+    {
+        return false;
+    }
+
+    const off_t ram_offset = MINIXCompat_CPU_Snapshot_RAM_Offset(fd);
+    if (ram_offset == -1) {
+        return false;
+    }
+
+    const size_t page_mask = MINIXCompat_RAM_Page_Size - 1;
+    const size_t low_len = ((size_t) snapshot.ram_high_water + page_mask) & ~page_mask;
+    const size_t stack_start = (size_t) MINIXCompat_Stack_Limit & ~page_mask;
+    const size_t stack_len = MINIXCompat_RAM_Mapping_Size - stack_start;
+
+    struct stat snapshot_stat;
+    if ((fstat(fd, &snapshot_stat) == -1) || (snapshot_stat.st_size < (ram_offset + (off_t)(low_len + stack_len)))) {
+        return false;
+    }
+
+    MINIXCompat_RAM_Reset();
+
+    if (!MINIXCompat_CPU_Snapshot_Read_RAM(fd, ram_offset, 0, low_len)
+        || !MINIXCompat_CPU_Snapshot_Read_RAM(fd, ram_offset + (off_t) low_len, stack_start, stack_len))
+    {
+        return false;
+    }
+
+    MINIXCompat_RAM_High_Water = snapshot.ram_high_water;
+    MINIXCompat_Predecode_Flush();
+
+    // Reset the CPU from the restored vectors, and then put its registers back.
+
+    m68k_pulse_reset();
+
+    for (size_t i = 0; i < MINIXCOMPAT_CPU_SNAPSHOT_REGISTERS; i++) {
+        m68k_set_reg(MINIXCompat_CPU_Snapshot_Registers[i], snapshot.registers[i]);
+    }
+
+    return true;
+}
+
+
+void MINIXCompat_RAM_Clear_Block(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
+    assert(m68k_address <= MINIXCompat_RAM_Size);
+    assert(m68k_block_size <= (MINIXCompat_RAM_Size - m68k_address));
+
+    MINIXCompat_Predecode_Note_Block_Write(m68k_address, m68k_block_size);
+    // Zero is zero in any byte order, so this doesn't care whether RAM is swizzled.
+
+    memset(MINIXCompat_RAM + m68k_address, 0, m68k_block_size);
+}
+
+
+void *MINIXCompat_RAM_Copy_Block_To_Host(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
     uint8_t *host_block = malloc(m68k_block_size);
     assert(host_block != NULL);
 
-    memcpy(host_block, RAM, m68k_block_size);
+    MINIXCompat_RAM_Copy_Block_To_Buffer(m68k_address, host_block, m68k_block_size);
 
     return host_block;
 }
 
 
+void MINIXCompat_RAM_Copy_Block_To_Buffer(m68k_address_t m68k_address, void * _Nonnull host_buffer, uint32_t m68k_block_size)
+{
+    assert(m68k_address < MINIXCompat_RAM_Size);
+    assert((m68k_block_size + m68k_address) <= MINIXCompat_RAM_Size);
+    assert(host_buffer != NULL);
+
+#if MINIXCOMPAT_RAM_BYTE_XOR
+    // Unswizzle each byte from its half of the host-order word containing it.
+
+    uint8_t *host_block = host_buffer;
+    for (uint32_t i = 0; i < m68k_block_size; i++) {
+        host_block[i] = MINIXCompat_RAM[(m68k_address + i) ^ MINIXCOMPAT_RAM_BYTE_XOR];
+    }
+#else
+    const uint8_t *RAM = MINIXCompat_RAM + m68k_address;
+
+    memcpy(host_buffer, RAM, m68k_block_size);
+#endif
+}
+
+
+#if MINIXCOMPAT_RAM_BYTE_XOR
+
+void MINIXCompat_RAM_Swizzle_Range(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
+    assert(m68k_address <= MINIXCompat_RAM_Size);
+    assert(m68k_block_size <= (MINIXCompat_RAM_Size - m68k_address));
+
+    if (m68k_block_size == 0) return;
+
+    // Cover every word the block touches. A misaligned end can reach one byte past the top of the address space, which the slack in the allocation covers.
+
+    const m68k_address_t start = m68k_address & ~1U;
+    const m68k_address_t end = (m68k_address + m68k_block_size + 1) & ~1U;
+
+    for (m68k_address_t a = start; a < end; a += sizeof(uint16_t)) {
+        uint8_t byte = MINIXCompat_RAM[a];
+        MINIXCompat_RAM[a] = MINIXCompat_RAM[a + 1];
+        MINIXCompat_RAM[a + 1] = byte;
+    }
+}
+
+#endif
+
+
+/*
+ The Musashi memory interface. These are called for every instruction fetch and data access, so they just mask to the 24-bit bus and go straight to RAM.
+ */
+
 unsigned int m68k_read_memory_8(unsigned int address)
 {
     return MINIXCompat_RAM_Read_8(address);
@@ -216,6 +1010,31 @@ unsigned int m68k_read_memory_32(unsigned int address)
     return MINIXCompat_RAM_Read_32(address);
 }
 
+unsigned int m68k_read_immediate_16(unsigned int address)
+{
+    return MINIXCompat_RAM_Read_16(address);
+}
+
+unsigned int m68k_read_immediate_32(unsigned int address)
+{
+    return MINIXCompat_RAM_Read_32(address);
+}
+
+unsigned int m68k_read_pcrelative_8(unsigned int address)
+{
+    return MINIXCompat_RAM_Read_8(address);
+}
+
+unsigned int m68k_read_pcrelative_16(unsigned int address)
+{
+    return MINIXCompat_RAM_Read_16(address);
+}
+
+unsigned int m68k_read_pcrelative_32(unsigned int address)
+{
+    return MINIXCompat_RAM_Read_32(address);
+}
+
 unsigned int m68k_read_disassembler_8  (unsigned int address)
 {
     return MINIXCompat_RAM_Read_8(address);
@@ -233,18 +1052,22 @@ unsigned int m68k_read_disassembler_32 (unsigned int address)
 
 void m68k_write_memory_8(unsigned int address, unsigned int value)
 {
-    assert(value < 0x00000100);
-    MINIXCompat_RAM_Write_8(address, value);
+    MINIXCompat_Predecode_Note_Write(address, 1);
+    MINIXCompat_RAM_Note_Store(address);
+    MINIXCompat_RAM_Write_8(address, (uint8_t) value);
 }
 
 void m68k_write_memory_16(unsigned int address, unsigned int value)
 {
-    assert(value < 0x00010000);
-    MINIXCompat_RAM_Write_16(address, value);
+    MINIXCompat_Predecode_Note_Write(address, 2);
+    MINIXCompat_RAM_Note_Store(address + 1);
+    MINIXCompat_RAM_Write_16(address, (uint16_t) value);
 }
 
 void m68k_write_memory_32(unsigned int address, unsigned int value)
 {
+    MINIXCompat_Predecode_Note_Write(address, 4);
+    MINIXCompat_RAM_Note_Store(address + 3);
     MINIXCompat_RAM_Write_32(address, value);
 }
 
@@ -9,13 +9,20 @@
 #ifndef MINIXCompat_Emulation_h
 #define MINIXCompat_Emulation_h
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <arpa/inet.h> /* for ntohs et al */
+#include <sys/types.h>
+
 #include "MINIXCompat_Types.h"
 
 
 MINIXCOMPAT_HEADER_BEGIN
 
 
-/*! Initialize the CPU emulation. */
+/*! Initialize the CPU emulation, returning `0` or the host error that kept emulated RAM from being mapped. */
 MINIXCOMPAT_EXTERN int MINIXCompat_CPU_Initialize(void);
 
 /*! Reste the CPU emulation, necessary after everything is initialized and configred but before running. */
@@ -24,23 +31,246 @@ MINIXCOMPAT_EXTERN void MINIXCompat_CPU_Reset(void);
 /*! Run the CPU emulation. */
 MINIXCOMPAT_EXTERN int MINIXCompat_CPU_Run(int cycles);
 
+/*!
+ Run the CPU emulation until ``MINIXCompat_CPU_Stop`` is called, such as by a system call that changes the execution state, or until it has run for at least \a quantum cycles if that's positive.
+
+ Since there are no interrupts, devices, or timers to service, there's no reason to return any sooner, except to let the in-process scheduler share the CPU between processes.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_CPU_Run_Until_Stopped(int quantum);
+
+/*!
+ Stop running the CPU emulation after the current instruction.
+
+ This must only be called synchronously, such as from a system call, and never from a host signal handler; use ``MINIXCompat_CPU_Stop_Async`` there.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_CPU_Stop(void);
+
+/*!
+ Ask the CPU emulation to stop running, without disturbing it. This is safe to call from a host signal handler.
+
+ The CPU notices the request between the bounded slices that ``MINIXCompat_CPU_Run_Until_Stopped`` runs in.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_CPU_Stop_Async(void);
+
+/*! The total number of cycles the CPU emulation has run, including those run so far if it's running now. */
+MINIXCOMPAT_EXTERN uint64_t MINIXCompat_CPU_Cycles(void);
+
+
+/*!
+ The emulated CPU and RAM of a MINIX process that isn't running, for the in-process scheduler.
+
+ The running process's state lives in the CPU emulation itself, so a context only exists for processes that are switched out.
+ */
+typedef struct MINIXCompat_CPU_Context MINIXCompat_CPU_Context_t;
+
+/*!
+ Create a context for the child of a `fork(2)` by the running process, with its own copy of the parts of RAM in use.
+
+ This must be called from within the trap for the system call, since the child's PC is left at the trap so that it retries the call when it first runs; that's how a child gets its own result from `fork(2)`.
+
+ - Returns: The new context, or `NULL` with `errno` set if there isn't memory for it.
+ */
+MINIXCOMPAT_EXTERN MINIXCompat_CPU_Context_t * _Nullable MINIXCompat_CPU_Context_Fork(void);
+
+/*!
+ Switch the running process out, moving its CPU state and RAM into a new context.
+
+ This must not be called while the CPU is running, and must be followed by ``MINIXCompat_CPU_Context_Restore`` before it runs again.
+ */
+MINIXCOMPAT_EXTERN MINIXCompat_CPU_Context_t * _Nonnull MINIXCompat_CPU_Context_Save(void);
+
+/*!
+ Switch in the process whose state is in \a context, which is consumed.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_CPU_Context_Restore(MINIXCompat_CPU_Context_t * _Nonnull context);
+
+/*!
+ Release \a context along with the RAM it holds, such as when its process has exited.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_CPU_Context_Free(MINIXCompat_CPU_Context_t * _Nullable context);
+
+/*!
+ Write the CPU state and the parts of RAM in use to the snapshot \a fd, which must be the last thing written to it.
+
+ This must be called from within the trap for a system call, since the PC is left at the trap so that the call is made again after a restore.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_CPU_Snapshot_Write(int fd);
+
+/*! Restore the CPU state and RAM from the snapshot \a fd, mapping RAM from it where possible. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_CPU_Snapshot_Read(int fd);
+
+/*! The size of the emulated CPU's address space, which is the full 24-bit 68000 bus. */
+#define MINIXCompat_RAM_Size 0x01000000
+
+/*! The mask applied to every emulated address, since the 68000 only drives 24 address lines. */
+#define MINIXCompat_RAM_Address_Mask 0x00FFFFFF
+
+/*!
+ Whether RAM is kept word-swizzled rather than in Motorola byte order.
+
+ Building with `MINIXCOMPAT_RAM_SWIZZLED` defined to `1` on a little-endian host stores each 16-bit word of RAM in host byte order, so aligned word accesses need no swap and longword accesses only need their two words exchanged. Byte accesses XOR their address with ``MINIXCOMPAT_RAM_BYTE_XOR`` to find their half of a word, and the block copy routines convert at the boundary. On big-endian hosts Motorola byte order already is host byte order, so the layout is never swizzled.
+ */
+#if !defined(__BYTE_ORDER__) || ((__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__) && (__BYTE_ORDER__ != __ORDER_BIG_ENDIAN__))
+#error The host byte order must be known from __BYTE_ORDER__ to lay out RAM.
+#endif
+
+#if defined(MINIXCOMPAT_RAM_SWIZZLED) && MINIXCOMPAT_RAM_SWIZZLED && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define MINIXCOMPAT_RAM_BYTE_XOR 1
+#else
+#define MINIXCOMPAT_RAM_BYTE_XOR 0
+#endif
+
+/*!
+ The RAM for the emulated CPU, exported so the accessors below can be inlined into their callers.
+
+ Everything within it is in Motorola (network) byte order, or word-swizzled if ``MINIXCOMPAT_RAM_BYTE_XOR`` is nonzero; only the accessors and block copy routines below should touch it directly. It's allocated with a few bytes of slack past ``MINIXCompat_RAM_Size`` so a word or longword access at the very top of the address space doesn't need a separate bounds check.
+ */
+MINIXCOMPAT_EXTERN uint8_t *MINIXCompat_RAM;
+
+#if MINIXCOMPAT_RAM_BYTE_XOR
+
+/*! Read the 8-bit byte at \a m68k_address from RAM. */
+static inline uint8_t MINIXCompat_RAM_Read_8(m68k_address_t m68k_address)
+{
+    return MINIXCompat_RAM[(m68k_address & MINIXCompat_RAM_Address_Mask) ^ MINIXCOMPAT_RAM_BYTE_XOR];
+}
+
+/*! Read the 16-bit word at \a m68k_address from RAM, which is already in host byte order unless the access is misaligned. */
+static inline uint16_t MINIXCompat_RAM_Read_16(m68k_address_t m68k_address)
+{
+    if (m68k_address & 1) {
+        return (uint16_t) ((MINIXCompat_RAM_Read_8(m68k_address) << 8) | MINIXCompat_RAM_Read_8(m68k_address + 1));
+    }
+
+    uint16_t value;
+    memcpy(&value, MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), sizeof(uint16_t));
+    return value;
+}
+
+/*! Read the 32-bit longword at \a m68k_address from RAM, which only needs its two host-order words exchanged unless the access is misaligned. */
+static inline uint32_t MINIXCompat_RAM_Read_32(m68k_address_t m68k_address)
+{
+    if (m68k_address & 1) {
+        return ((uint32_t) MINIXCompat_RAM_Read_8(m68k_address) << 24) | ((uint32_t) MINIXCompat_RAM_Read_16(m68k_address + 1) << 8) | MINIXCompat_RAM_Read_8(m68k_address + 3);
+    }
+
+    uint32_t value;
+    memcpy(&value, MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), sizeof(uint32_t));
+    return (value << 16) | (value >> 16);
+}
+
+/*! Write the 8-bit byte \a value to \a m68k_address in RAM. */
+static inline void MINIXCompat_RAM_Write_8(m68k_address_t m68k_address, uint8_t value)
+{
+    MINIXCompat_RAM[(m68k_address & MINIXCompat_RAM_Address_Mask) ^ MINIXCOMPAT_RAM_BYTE_XOR] = value;
+}
+
+/*! Write the 16-bit word \a value to \a m68k_address in RAM, which needs no conversion unless the access is misaligned. */
+static inline void MINIXCompat_RAM_Write_16(m68k_address_t m68k_address, uint16_t value)
+{
+    if (m68k_address & 1) {
+        MINIXCompat_RAM_Write_8(m68k_address, (uint8_t) (value >> 8));
+        MINIXCompat_RAM_Write_8(m68k_address + 1, (uint8_t) value);
+        return;
+    }
+
+    memcpy(MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), &value, sizeof(uint16_t));
+}
+
+/*! Write the 32-bit longword \a value to \a m68k_address in RAM, which only needs its two words exchanged unless the access is misaligned. */
+static inline void MINIXCompat_RAM_Write_32(m68k_address_t m68k_address, uint32_t value)
+{
+    if (m68k_address & 1) {
+        MINIXCompat_RAM_Write_8(m68k_address, (uint8_t) (value >> 24));
+        MINIXCompat_RAM_Write_16(m68k_address + 1, (uint16_t) (value >> 8));
+        MINIXCompat_RAM_Write_8(m68k_address + 3, (uint8_t) value);
+        return;
+    }
+
+    uint32_t value_s = (value << 16) | (value >> 16);
+    memcpy(MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), &value_s, sizeof(uint32_t));
+}
+
+#else
+
 /*! Read the 8-bit byte at \a m68k_address from RAM. */
-MINIXCOMPAT_EXTERN uint8_t MINIXCompat_RAM_Read_8(m68k_address_t m68k_address);
+static inline uint8_t MINIXCompat_RAM_Read_8(m68k_address_t m68k_address)
+{
+    return MINIXCompat_RAM[m68k_address & MINIXCompat_RAM_Address_Mask];
+}
 
 /*! Read the 16-bit word at \a m68k_address from RAM, converting to host byte order. */
-MINIXCOMPAT_EXTERN uint16_t MINIXCompat_RAM_Read_16(m68k_address_t m68k_address);
+static inline uint16_t MINIXCompat_RAM_Read_16(m68k_address_t m68k_address)
+{
+    uint16_t value;
+    memcpy(&value, MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), sizeof(uint16_t));
+    return ntohs(value);
+}
 
 /*! Read the 32-bit longword at \a m68k_address from RAM, converting to host byte order. */
-MINIXCOMPAT_EXTERN uint32_t MINIXCompat_RAM_Read_32(m68k_address_t m68k_address);
+static inline uint32_t MINIXCompat_RAM_Read_32(m68k_address_t m68k_address)
+{
+    uint32_t value;
+    memcpy(&value, MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), sizeof(uint32_t));
+    return ntohl(value);
+}
 
-/*! Read the 8-bit byte \a value to \a m68k_address in RAM. */
-MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Write_8(m68k_address_t m68k_address, uint8_t value);
+/*! Write the 8-bit byte \a value to \a m68k_address in RAM. */
+static inline void MINIXCompat_RAM_Write_8(m68k_address_t m68k_address, uint8_t value)
+{
+    MINIXCompat_RAM[m68k_address & MINIXCompat_RAM_Address_Mask] = value;
+}
 
-/*! Read the 16-bit word \a value to \a m68k_address in RAM, converting from host byte order. */
-MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Write_16(m68k_address_t m68k_address, uint16_t value);
+/*! Write the 16-bit word \a value to \a m68k_address in RAM, converting from host byte order. */
+static inline void MINIXCompat_RAM_Write_16(m68k_address_t m68k_address, uint16_t value)
+{
+    uint16_t value_n = htons(value);
+    memcpy(MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), &value_n, sizeof(uint16_t));
+}
 
-/*! Read the 32-bit longword \a value to \a m68k_address in RAM, converting from host byte order. */
-MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Write_32(m68k_address_t m68k_address, uint32_t value);
+/*! Write the 32-bit longword \a value to \a m68k_address in RAM, converting from host byte order. */
+static inline void MINIXCompat_RAM_Write_32(m68k_address_t m68k_address, uint32_t value)
+{
+    uint32_t value_n = htonl(value);
+    memcpy(MINIXCompat_RAM + (m68k_address & MINIXCompat_RAM_Address_Mask), &value_n, sizeof(uint32_t));
+}
+
+#endif
+
+
+/*!
+ Get a host pointer to the \a m68k_block_size bytes of RAM at \a m68k_address, so host I/O can be done on them directly, or `NULL` if the block doesn't lie entirely within the 16MB address space.
+
+ If ``MINIXCOMPAT_RAM_BYTE_XOR`` is nonzero the bytes there are swizzled, so bracket any host I/O on them with ``MINIXCompat_RAM_Swizzle_Range``.
+ */
+static inline uint8_t * _Nullable MINIXCompat_RAM_Host_Address(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
+    if ((m68k_address > MINIXCompat_RAM_Size) || (m68k_block_size > (MINIXCompat_RAM_Size - m68k_address))) {
+        return NULL;
+    }
+
+    return MINIXCompat_RAM + m68k_address;
+}
+
+#if MINIXCOMPAT_RAM_BYTE_XOR
+
+/*!
+ Toggle the \a m68k_block_size bytes of RAM at \a m68k_address between the swizzled layout and Motorola byte order, in place.
+
+ Whole words are exchanged, so a misaligned block also toggles the neighboring byte that shares a word with each end. Since toggling twice restores the original, calling this once before and once after host I/O on the same block is always safe, no matter how much of the block the I/O touches.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Swizzle_Range(m68k_address_t m68k_address, uint32_t m68k_block_size);
+
+#else
+
+/*! Nothing to do when RAM isn't swizzled. */
+static inline void MINIXCompat_RAM_Swizzle_Range(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
+    (void) m68k_address;
+    (void) m68k_block_size;
+}
+
+#endif
 
 
 /*!
@@ -50,6 +280,62 @@ MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Write_32(m68k_address_t m68k_address, ui
  */
 MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Copy_Block_From_Host(m68k_address_t m68k_address, void *host_block_address, uint32_t host_block_size);
 
+/*!
+ Note that RAM below \a m68k_address may have been written, so the next ``MINIXCompat_RAM_Reset`` needs to clear it.
+
+ Stores by the CPU and block copies into RAM are tracked on their own, so only what sets how much of the low part of RAM is in use, such as loading an executable or growing the break, must call this.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Note_High_Water(m68k_address_t m68k_address);
+
+/*! Note that the host is writing the \a m68k_block_size bytes at \a m68k_address other than through the accessors or block copy routines, such as by reading into RAM, so the next ``MINIXCompat_RAM_Reset`` clears them. */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Note_Block_Write(m68k_address_t m68k_address, uint32_t m68k_block_size);
+
+/*!
+ Reset all of RAM to zero in preparation for loading a new executable, releasing the pages that were in use back to the host.
+
+ Only the pages below the high-water mark and those of the stack region are actually reset, so the cost is proportional to what the previous executable used rather than to the whole address space.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Reset(void);
+
+/*!
+ Map the \a len bytes of the host file \a fd at \a file_offset copy-on-write over RAM at \a m68k_address, so RAM shares the host's cached pages of the file until they're written. The file must already hold those bytes in the layout of RAM, swizzled or not.
+
+ The address, offset, and length must all be multiples of the host page size. Only RAM with an anonymous backing can be mapped this way, since resetting huge pages or shared memory wouldn't discard the mapping; \a fd may be closed once this returns.
+
+ - Returns: `true` if the file was mapped, `false` if RAM is untouched and must be filled some other way.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_RAM_Map_File(int fd, off_t file_offset, m68k_address_t m68k_address, uint32_t len);
+
+/*!
+ Prepare RAM for a host `fork(2)`, which must be followed by ``MINIXCompat_RAM_Fork_Parent`` in the parent and ``MINIXCompat_RAM_Fork_Child`` in the child.
+
+ When RAM is shared, this makes the child's private copy of the parts in use, so that a failure to do so fails the fork.
+
+ - Returns: `0` on success, or a host `errno` value if the fork must not proceed.
+ */
+MINIXCOMPAT_EXTERN int MINIXCompat_RAM_Fork_Prepare(void);
+
+/*!
+ Finish a host `fork(2)` in the parent, whether or not a child was actually created.
+
+ When RAM is shared, this releases the parent's hold on the child's copy.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Fork_Parent(void);
+
+/*!
+ Finish a host `fork(2)` in the child.
+
+ When RAM is shared, this maps the copy made by ``MINIXCompat_RAM_Fork_Prepare`` in its place, so that it's no longer shared with the parent; if that can't be done, the child exits with `EX_OSERR` rather than run on RAM the parent is still using.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Fork_Child(void);
+
+/*!
+ Clear a block of memory in the emulated CPU to zero.
+
+ The `m68k_block_size` plus the `m68k_address` must not extend past the end of the 16MB address space.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Clear_Block(m68k_address_t m68k_address, uint32_t m68k_block_size);
+
 /*!
  Copy a block of memory from the emulated CPU to the host address space. The copied block is a new allocation created with `calloc` that must be freed using `free`.
 
@@ -57,6 +343,13 @@ MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Copy_Block_From_Host(m68k_address_t m68k
  */
 MINIXCOMPAT_EXTERN void *MINIXCompat_RAM_Copy_Block_To_Host(m68k_address_t m68k_address, uint32_t m68k_block_size);
 
+/*!
+ Copy a block of memory from the emulated CPU into an existing host buffer of at least `m68k_block_size` bytes, without allocating.
+
+ The `m68k_block_size` plus the `m68k_address` must not extend past the end of the 16MB address space.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Copy_Block_To_Buffer(m68k_address_t m68k_address, void * _Nonnull host_buffer, uint32_t m68k_block_size);
+
 
 MINIXCOMPAT_HEADER_END
 
@@ -14,10 +14,14 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <arpa/inet.h> /* for ntohs et al */
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
 #include "MINIXCompat_Errors.h"
 
 
@@ -53,6 +57,22 @@ const uint32_t minix_exec_flags = 0x00000020;
 const uint32_t minix_exec_no_entry = 0x00000000;
 
 
+/*! A symbol table entry, as in MINIX's `<a.out.h>`. */
+struct minix_nlist {
+    char n_name[8];
+    uint32_t n_value;
+    uint8_t n_sclass;
+    uint8_t n_numaux;
+    uint16_t n_type;
+} __attribute__((packed));
+
+/*! The mask for the section of a symbol in `n_sclass`. */
+const uint8_t minix_nlist_sclass_section = 0007;
+
+/*! The section of a text symbol. */
+const uint8_t minix_nlist_sclass_text = 0002;
+
+
 /*! The full version of the MINIXExecutable structure. */
 struct MINIXCompat_Executable {
 
@@ -61,85 +81,113 @@ struct MINIXCompat_Executable {
 };
 
 
-static int MINIXExecutableLoadHeader(FILE *pef, struct MINIXCompat_Executable *peh);
-static void MINIXExecutableRelocateLongAtOffset(uint8_t *buf, uint32_t relocation_base, uint32_t relocation_offset);
-static int MINIXExecutableRelocate(FILE *pef, struct MINIXCompat_Executable *peh, uint8_t *buf);
+static int MINIXExecutableLoadHeader(const uint8_t *file, size_t file_len, struct MINIXCompat_Executable *peh);
+static int MINIXExecutableRelocate(const uint8_t *relocs, size_t relocs_len, uint32_t image_len, bool apply);
 
 
-int MINIXCompat_Executable_Load(FILE *pef, struct MINIXCompat_Executable * _Nullable * _Nonnull out_peh, uint8_t * _Nullable * _Nonnull out_buf, uint32_t *out_buf_len)
+int MINIXCompat_Executable_Load(int fd, uint32_t * _Nonnull out_image_len, uint32_t * _Nonnull out_text_len)
 {
-    assert(pef != NULL);
-    assert((out_peh != NULL) && (*out_peh == NULL));
-    assert((out_buf != NULL) && (*out_buf == NULL));
-    assert(out_buf_len != NULL);
+    assert(fd >= 0);
+    assert(out_image_len != NULL);
+    assert(out_text_len != NULL);
+
+    // Map the whole executable, so everything below is just loops over its bytes rather than calls to read it.
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    if (file_stat.st_size < (off_t) sizeof(struct minix_exec)) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
+
+    const size_t file_len = (size_t) file_stat.st_size;
+    void *mapping = mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+
+    const uint8_t *file = mapping;
+    int err = 0;
 
     // Load and validate the executable header.
 
-    struct MINIXCompat_Executable *peh = calloc(sizeof(struct MINIXCompat_Executable), 1);
-    if (peh == NULL) return -ENOMEM;
-    *out_peh = peh;
+    struct MINIXCompat_Executable executable;
+    err = MINIXExecutableLoadHeader(file, file_len, &executable);
 
-    int header_err = MINIXExecutableLoadHeader(pef, peh);
-    if (header_err != 0) return header_err;
+    if (err == 0) {
+        // Compute the layout of the image: text, then data starting at the next click, then bss and the rest of the allocation.
 
-    // Compute the size of buffer to allocate for the program.
+        const struct minix_exec *exec_h = &executable.exec_h;
 
-    struct minix_exec *exec_h = &peh->exec_h;
+        const uint32_t text_clicks = MINIX_CLICK_ROUND(exec_h->a_text);
+        const uint32_t total_clicks = MINIX_CLICK_ROUND(exec_h->a_total);
 
-    uint32_t text_clicks = MINIX_CLICK_ROUND(exec_h->a_text);
-    uint32_t total_clicks = MINIX_CLICK_ROUND(exec_h->a_total);
+        const uint32_t text_base = 0;
+        const uint32_t data_base = text_base + (text_clicks * MINIX_CLICK_SIZE);
+        const uint32_t data_end = data_base + exec_h->a_data;
+        const uint32_t image_len = total_clicks * MINIX_CLICK_SIZE;
 
-    uint8_t *buf = calloc(total_clicks * MINIX_CLICK_SIZE, 1);
-    if (buf == NULL) return -ENOMEM;
-    *out_buf = buf;
-    *out_buf_len = total_clicks * MINIX_CLICK_SIZE;
+        const uint64_t text_offset = sizeof(struct minix_exec);
+        const uint64_t data_offset = text_offset + exec_h->a_text;
+        const uint64_t relocs_offset = data_offset + exec_h->a_data + (uint64_t) exec_h->a_syms;
 
-    // Seek past the header, then load the data and text into the blob at the appropriate offsets.
+        if (   (exec_h->a_text > (MINIXCompat_Executable_Limit - MINIXCompat_Executable_Base))
+            || (exec_h->a_data > (MINIXCompat_Executable_Limit - MINIXCompat_Executable_Base))
+            || (image_len > (MINIXCompat_Executable_Limit - MINIXCompat_Executable_Base))
+            || (data_end > image_len))
+        {
+            err = -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
+        } else if ((data_offset + exec_h->a_data) > file_len) {
+            err = -MINIXCompat_Errors_MINIXErrorForHostError(ENODATA);
+        } else {
+            // Check the relocation information, which is after any symbol table, before touching emulated RAM so a bad executable leaves the current one intact.
 
-    int seek_err = fseek(pef, sizeof(struct minix_exec), SEEK_SET);
-    if (seek_err != 0) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+            const uint8_t *relocs = (relocs_offset < file_len) ? (file + relocs_offset) : NULL;
+            const size_t relocs_len = (relocs != NULL) ? (file_len - (size_t) relocs_offset) : 0;
 
-    uint32_t text_base = 0;
-    uint32_t data_base = text_base + (text_clicks * MINIX_CLICK_SIZE);
+            if (relocs != NULL) {
+                err = MINIXExecutableRelocate(relocs, relocs_len, image_len, false);
+            }
 
-    if (text_clicks > 0) {
-        size_t text_read = fread(buf + text_base, exec_h->a_text, 1, pef);
-        if (text_read < 1) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
-    }
+            if (err == 0) {
+                // Past this point the new executable replaces the old one, so start from clean RAM.
 
-    size_t data_read = fread(buf + data_base, exec_h->a_data, 1, pef);
-    if (data_read < 1) return -MINIXCompat_Errors_MINIXErrorForHostError(ENODATA);
+                MINIXCompat_RAM_Reset();
+                MINIXCompat_RAM_Note_High_Water(MINIXCompat_Executable_Base + image_len);
 
-    // Relocation information is after any symbol table, so skip that.
+                // Copy the text and data straight into emulated RAM. Only what lies between and after them needs to be zero, which the reset ensures.
 
-    if (exec_h->a_syms) {
-        int skip_err = fseek(pef, exec_h->a_syms, SEEK_CUR);
-        if (skip_err != 0) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
-    }
+                const m68k_address_t base = MINIXCompat_Executable_Base;
 
-    // Do any necessary relocation.
+                MINIXCompat_RAM_Copy_Block_From_Host(base + text_base, (void *)(file + text_offset), exec_h->a_text);
+                MINIXCompat_RAM_Copy_Block_From_Host(base + data_base, (void *)(file + data_offset), exec_h->a_data);
 
-    int relocate_err = MINIXExecutableRelocate(pef, peh, buf);
-    if (relocate_err != 0) return -relocate_err;
+                // Relocate in place in emulated RAM.
 
-    return 0;
+                if (relocs != NULL) {
+                    err = MINIXExecutableRelocate(relocs, relocs_len, image_len, true);
+                    assert(err == 0);
+                }
+
+                // Loading combined I&D moved the text into the data, so only separate I&D has text that stays untouched from here on.
+
+                *out_image_len = image_len;
+                *out_text_len = exec_h->a_text;
+            }
+        }
+    }
+
+    munmap(mapping, file_len);
+
+    return err;
 }
 
 
-static int MINIXExecutableLoadHeader(FILE *pef, struct MINIXCompat_Executable *peh)
+static int MINIXExecutableLoadHeader(const uint8_t *file, size_t file_len, struct MINIXCompat_Executable *peh)
 {
-    assert(pef != NULL);
+    assert(file != NULL);
+    assert(file_len >= sizeof(struct minix_exec));
     assert(peh != NULL);
 
     // Get the network byte order header at the head of the file.
 
     struct minix_exec exec_n;
-
-    int seek_err = fseek(pef, 0, SEEK_SET);
-    if (seek_err != 0) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
-
-    size_t read_count = fread(&exec_n, sizeof(struct minix_exec), 1, pef);
-    if (read_count < 1) return -MINIXCompat_Errors_MINIXErrorForHostError(EIO);
+    memcpy(&exec_n, file, sizeof(struct minix_exec));
 
     // Copy the network byte order header to the header in host byte order.
 
@@ -158,15 +206,16 @@ static int MINIXExecutableLoadHeader(FILE *pef, struct MINIXCompat_Executable *p
 
     if (   (exec_h->a_magic != minix_exec_magic_combined)
         && (exec_h->a_magic != minix_exec_magic_separate)) {
-        return -ENOEXEC;
+        return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
     }
 
-    if (exec_h->a_flags != minix_exec_flags) return -ENOEXEC;
-    if (exec_h->a_no_entry != minix_exec_no_entry) return -ENOEXEC;
-    if (exec_h->a_total == 0) return -ENOEXEC;
+    if (exec_h->a_flags != minix_exec_flags) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
+    if (exec_h->a_no_entry != minix_exec_no_entry) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
+    if (exec_h->a_total == 0) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
 
     if (exec_h->a_magic == minix_exec_magic_combined) {
         // Combined I&D is considered all data, so adjust.
+        if (exec_h->a_data > (UINT32_MAX - exec_h->a_text)) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
         exec_h->a_data += exec_h->a_text;
         exec_h->a_text = 0;
     } else {
@@ -177,73 +226,148 @@ static int MINIXExecutableLoadHeader(FILE *pef, struct MINIXCompat_Executable *p
 }
 
 
-/*!
- Relocate!
+/*! Order symbols by address, and then by name so the order is stable. */
+static int MINIXExecutableCompareSymbols(const void *a, const void *b)
+{
+    const minix_symbol_t *sa = a;
+    const minix_symbol_t *sb = b;
 
- Change the longword at \a relocation_offset so it's relative to \a relocation_base rather than `0`.
+    if (sa->address < sb->address) return -1;
+    if (sa->address > sb->address) return 1;
+    return strcmp(sa->name, sb->name);
+}
 
- - NOTE: The values in _buf_  are always in network byte order so we have to swap back and forth.
- */
-static void MINIXExecutableRelocateLongAtOffset(uint8_t *buf, uint32_t relocation_base, uint32_t relocation_offset)
+
+int MINIXCompat_Executable_Load_Symbols(int fd, minix_symbol_t * _Nullable * _Nonnull out_symbols, size_t * _Nonnull out_count)
 {
-    uint8_t *pb = buf + relocation_offset;
-    uint32_t *pl = (uint32_t *)pb;
-    uint32_t l = ntohl(*pl);
-    uint32_t rl = l + relocation_base;
-    *pl = htonl(rl);
+    assert(fd >= 0);
+    assert(out_symbols != NULL);
+    assert(out_count != NULL);
+
+    *out_symbols = NULL;
+    *out_count = 0;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    if (file_stat.st_size < (off_t) sizeof(struct minix_exec)) return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
+
+    const size_t file_len = (size_t) file_stat.st_size;
+    void *mapping = mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+
+    const uint8_t *file = mapping;
+
+    struct MINIXCompat_Executable executable;
+    int err = MINIXExecutableLoadHeader(file, file_len, &executable);
+
+    if (err == 0) {
+        // The symbol table follows the text and data, and text symbol values are relative to the start of the image whether or not I&D are combined.
+
+        const struct minix_exec *exec_h = &executable.exec_h;
+        const uint64_t syms_offset = sizeof(struct minix_exec) + (uint64_t) exec_h->a_text + exec_h->a_data;
+        const size_t nlist_count = exec_h->a_syms / sizeof(struct minix_nlist);
+
+        if ((syms_offset + exec_h->a_syms) > file_len) {
+            err = -MINIXCompat_Errors_MINIXErrorForHostError(ENODATA);
+        } else if (nlist_count > 0) {
+            minix_symbol_t *symbols = calloc(nlist_count, sizeof(minix_symbol_t));
+            size_t count = 0;
+
+            if (symbols == NULL) {
+                err = -MINIXCompat_Errors_MINIXErrorForHostError(ENOMEM);
+            } else {
+                for (size_t i = 0; i < nlist_count; i++) {
+                    struct minix_nlist nlist;
+                    memcpy(&nlist, file + syms_offset + (i * sizeof(struct minix_nlist)), sizeof(struct minix_nlist));
+
+                    if ((nlist.n_sclass & minix_nlist_sclass_section) != minix_nlist_sclass_text) continue;
+                    if (nlist.n_name[0] == '\0') continue;
+
+                    symbols[count].address = MINIXCompat_Executable_Base + ntohl(nlist.n_value);
+                    memcpy(symbols[count].name, nlist.n_name, sizeof(nlist.n_name));
+                    symbols[count].name[sizeof(nlist.n_name)] = '\0';
+                    count += 1;
+                }
+
+                if (count > 0) {
+                    qsort(symbols, count, sizeof(minix_symbol_t), MINIXExecutableCompareSymbols);
+                    *out_symbols = symbols;
+                    *out_count = count;
+                } else {
+                    free(symbols);
+                }
+            }
+        }
+    }
+
+    munmap(mapping, file_len);
+
+    return err;
 }
 
 
-static int MINIXExecutableRelocate(FILE *pef, struct MINIXCompat_Executable *peh, uint8_t *buf)
-{
-    assert(pef != NULL);
-    assert(peh != NULL);
-    assert(buf != NULL);
+/*!
+ Relocate!
 
-    // At this point pef should be set to the point in the file where relocation information lives.
+ Walk the relocation stream at \a relocs, adding ``MINIXCompat_Executable_Base`` to each longword it identifies in the image of \a image_len bytes already in emulated RAM, so it's relative to that base rather than `0`. If \a apply is `false`, just check that the stream is valid for the image without changing anything.
 
-    int32_t relocation_initial_offset_n;
+ The stream is a longword offset of the first longword to relocate (with `0` meaning there's nothing to relocate), followed by a byte per subsequent relocation: `0` ends the stream, `1` advances the offset by 254 without relocating, and any other even value advances the offset by that much and relocates.
+ */
+static int MINIXExecutableRelocate(const uint8_t *relocs, size_t relocs_len, uint32_t image_len, bool apply)
+{
+    assert(relocs != NULL);
 
-    size_t read_count = fread(&relocation_initial_offset_n, sizeof(int32_t), 1, pef);
-    if (read_count < 1) {
+    if (relocs_len < sizeof(uint32_t)) {
         // No relocation information, just return success.
         return 0;
     }
 
-    uint32_t relocation_offset = ntohl(relocation_initial_offset_n);
-    bool done = (relocation_offset == 0);
+    uint32_t relocation_offset_n;
+    memcpy(&relocation_offset_n, relocs, sizeof(uint32_t));
+    uint32_t relocation_offset = ntohl(relocation_offset_n);
+    if (relocation_offset == 0) {
+        // Nothing to relocate.
+        return 0;
+    }
+
+    const uint8_t *p = relocs + sizeof(uint32_t);
+    const uint8_t *end = relocs + relocs_len;
+    const m68k_address_t base = MINIXCompat_Executable_Base;
+
+    for (;;) {
+        // Relocate the longword at the current offset, which must lie entirely within the image.
 
-    if (!done) {
-        // Do the first relocation.
+        if ((image_len < sizeof(uint32_t)) || (relocation_offset > (image_len - sizeof(uint32_t)))) {
+            return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
+        }
 
-        MINIXExecutableRelocateLongAtOffset(buf, MINIXCompat_Executable_Base, relocation_offset);
+        if (apply) {
+            const m68k_address_t address = base + relocation_offset;
+            MINIXCompat_RAM_Write_32(address, MINIXCompat_RAM_Read_32(address) + base);
+        }
 
-        // Do the rest of the relocations one at a time.
+        // Find the next offset to relocate, if any.
 
+        uint8_t b;
         do {
-            uint8_t b;
-            size_t relo_read_count = fread(&b, sizeof(uint8_t), 1, pef);
-            if (relo_read_count < 1) return -EIO;
+            if (p == end) return -MINIXCompat_Errors_MINIXErrorForHostError(EIO);
+            b = *p++;
 
             if (b == 0x00) {
                 // Relocation done.
-                done = true;
+                return 0;
             } else if (b == 0x01) {
                 // Don't relocate, just bump the relocation offset by 254.
                 relocation_offset += 254;
-            } else if ((b & 0x01) == 0x00) {
-                // Bump the offset by the value encoded into b.
-
-                relocation_offset += b;
-
-                MINIXExecutableRelocateLongAtOffset(buf, MINIXCompat_Executable_Base, relocation_offset);
             } else if ((b & 0x01) == 0x01) {
-                return -ENOEXEC;
+                return -MINIXCompat_Errors_MINIXErrorForHostError(ENOEXEC);
             }
-        } while (!done);
-    }
+        } while (b == 0x01);
 
-    return 0;
+        // Bump the offset by the value encoded into b.
+
+        relocation_offset += b;
+    }
 }
 
 
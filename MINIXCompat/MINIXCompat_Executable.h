@@ -9,8 +9,8 @@
 #ifndef MINIXCompat_Executable_h
 #define MINIXCompat_Executable_h
 
+#include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
 
 #include "MINIXCompat_Types.h"
 
@@ -36,23 +36,42 @@ MINIXCOMPAT_EXTERN const m68k_address_t MINIXCompat_Stack_Limit;
 
 
 /*!
- Loads a MINIX executable.
+ Loads a MINIX executable directly into emulated RAM.
 
- Loads a MINIX executable's text (code) and data from \a pef into host RAM, with proper alignment to the MINIX 256-byte "click" size, and performs any relocation the file indicates is necessary.
+ Maps the MINIX executable open on \a fd and validates it, then resets emulated RAM, copies its text (code) and data into emulated RAM at ``MINIXCompat_Executable_Base`` with proper alignment to the MINIX 256-byte "click" size, and performs in place any relocation the file indicates is necessary.
 
  - Parameters:
-   - pef: pointer to `FILE` from which to load the executable
-   - out_peh: where to place the pointer to the new `struct MINIXCompat_Executable` representing the executable, which should be `NULL` on entry
-   - out_buf: where to place the pointer to the buffer containing the executable, which should be `NULL` on entry
-   - out_buf_len: where to place the length of the buffer containing the executable
+   - fd: host file descriptor from which to load the executable, which remains open
+   - out_image_len: where to place the length of the image in emulated RAM, including its bss and the rest of its allocation
+   - out_text_len: where to place the length of the text at the start of the image for a separate I&D executable, which is never written once relocated, or `0` for a combined I&D executable
 
  - Returns:
-   - `0` on success, `-errno` on error; if `out_pef` or `out_buf` points to a non-`NULL` pointer, those must be freed by the caller with `free(3)`, even if an error has occurred.
+   - `0` on success, `-errno` on error. Emulated RAM is untouched upon error.
+ */
+MINIXCOMPAT_EXTERN int MINIXCompat_Executable_Load(int fd, uint32_t * _Nonnull out_image_len, uint32_t * _Nonnull out_text_len);
+
+
+/*! A text symbol from a MINIX executable's symbol table. */
+typedef struct minix_symbol {
+    /*! The address of the symbol in emulated RAM, once the executable is loaded at ``MINIXCompat_Executable_Base``. */
+    m68k_address_t address;
 
- - Warning: Allocation of both `out_peh` and `out_buf` is performed with `calloc()` and is the caller's responsibility to `free()`.
-            These should explicitly point to `NULL` pointers before a call, and may still need to be freed upon error.
+    /*! The `NUL`-terminated name of the symbol; MINIX symbol names are at most 8 characters. */
+    char name[9];
+} minix_symbol_t;
+
+/*!
+ Loads the text symbols from the symbol table of a MINIX executable, which ``MINIXCompat_Executable_Load`` skips.
+
+ - Parameters:
+   - fd: host file descriptor from which to load the symbols, which remains open
+   - out_symbols: where to place a new array of the symbols sorted by address, which must be freed using `free`, or `NULL` if there are none
+   - out_count: where to place the number of symbols
+
+ - Returns:
+   - `0` on success, `-errno` on error.
  */
-MINIXCOMPAT_EXTERN int MINIXCompat_Executable_Load(FILE *pef, struct MINIXCompat_Executable * _Nullable * _Nonnull out_peh, uint8_t * _Nullable * _Nonnull out_buf, uint32_t *out_buf_len);
+MINIXCOMPAT_EXTERN int MINIXCompat_Executable_Load_Symbols(int fd, minix_symbol_t * _Nullable * _Nonnull out_symbols, size_t * _Nonnull out_count);
 
 
 MINIXCOMPAT_HEADER_END
@@ -12,18 +12,24 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <arpa/inet.h> /* for ntohs et al */
+#include <poll.h>
 #include <sys/stat.h>
 
 #include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
 #include "MINIXCompat_Errors.h"
+#include "MINIXCompat_Predecode.h"
+#include "MINIXCompat_Utilities.h"
 
 #ifndef HTONS
 #define HTONS(x) ((x) = htons(x))
@@ -33,8 +39,7 @@
 MINIXCOMPAT_SOURCE_BEGIN
 
 
-/*! Default directory of MINIX installation. */
-static const char * const MINIXCOMPAT_DIR_default = "/opt/minix";
+const char * const MINIXCOMPAT_DIR_default = "/opt/minix";
 
 /*! Actual directory of MINIX installation. */
 static const char *MINIXCOMPAT_DIR = NULL;
@@ -54,6 +59,124 @@ static char *MINIXCOMPAT_PWD_Host = NULL;
 /*! Cached length of ``MINIXCOMPAT_PWD_Host``. */
 static size_t MINIXCOMPAT_PWD_Host_len = 0;
 
+/*! Host descriptor open on ``MINIXCOMPAT_DIR``, which absolute MINIX paths are resolved relative to. */
+static int MINIXCOMPAT_DIR_fd = -1;
+
+/*! Host descriptor open on ``MINIXCOMPAT_PWD_Host``, which relative MINIX paths are resolved relative to. */
+static int MINIXCOMPAT_PWD_Host_fd = -1;
+
+
+/*! The most MINIX directories that can be overlaid. */
+#define MINIXCompat_Overlay_Max 8
+
+/*!
+ A MINIX directory, like `/tmp`, whose contents live in a host directory outside ``MINIXCOMPAT_DIR`` instead of the one within it, such as one on a memory-backed filesystem for files that never need to reach the disk.
+ */
+typedef struct minix_overlay {
+    /*! The absolute MINIX path of the directory, without a trailing slash. */
+    char *minix_dir;
+
+    /*! The length of ``minix_dir``. */
+    size_t minix_dir_len;
+
+    /*! The host path of the directory its contents live in. */
+    char *host_dir;
+
+    /*! A host descriptor open on ``host_dir``. */
+    int host_fd;
+} minix_overlay_t;
+
+/*! The overlaid MINIX directories. */
+static minix_overlay_t MINIXCompat_Overlays[MINIXCompat_Overlay_Max];
+
+/*! The number of entries in ``MINIXCompat_Overlays`` in use. */
+static size_t MINIXCompat_Overlay_Count = 0;
+
+
+/*! The number of MINIX directories whose host descriptors are kept open for resolving absolute paths within them. */
+#define MINIXCompat_DirCache_Count 16
+
+/*!
+ A MINIX directory whose host descriptor is kept open, so a path within it can be resolved without walking the whole path again.
+
+ Tools like `cpp` look up many files in the same few directories like `/usr/include`, so those are what end up here. Looking one up costs no system calls. A directory that's removed, even by another process, is noticed when a call relative to its descriptor finds nothing, and then opened again for one more try; a directory this process unlinks is forgotten right away.
+ */
+typedef struct minix_dircache_entry {
+    /*! The absolute MINIX path of the directory, or `NULL` if this entry is unused. */
+    char *minix_dir;
+
+    /*! The length of ``minix_dir``. */
+    size_t minix_dir_len;
+
+    /*! A host descriptor open on the directory. */
+    int host_fd;
+} minix_dircache_entry_t;
+
+/*! The open MINIX directories. */
+static minix_dircache_entry_t MINIXCompat_DirCache[MINIXCompat_DirCache_Count];
+
+/*! The next entry in ``MINIXCompat_DirCache`` to replace. */
+static size_t MINIXCompat_DirCache_Next = 0;
+
+
+/*! The number of paths whose `stat(2)` and `access(2)` results can be cached at once. */
+#define MINIXCompat_StatCache_Count 256
+
+/*!
+ The cached `stat(2)` and `access(2)` results for a MINIX path.
+
+ Only successes and `ENOENT` are cached, since those are what repeated searches like `cpp`'s through its include directories see; any other error is always checked again.
+ */
+typedef struct minix_statcache_entry {
+    /*! The absolute MINIX path, or `NULL` if this entry is unused. */
+    char *minix_path;
+
+    /*! When the `stat(2)` result was cached, or `0` if it isn't. */
+    uint64_t stat_cached_ns;
+
+    /*! The `stat(2)` result, either `0` or `-ENOENT`. */
+    int16_t stat_result;
+
+    /*! The `stat(2)` buffer, in host byte order. */
+    minix_stat_t stat_buf;
+
+    /*! When the `access(2)` result for each mode was cached, or `0` if it isn't. */
+    uint64_t access_cached_ns[8];
+
+    /*! The `access(2)` result for each mode, either `0` or `-errno`. */
+    int16_t access_results[8];
+} minix_statcache_entry_t;
+
+/*! How long a cached result stays valid in nanoseconds, to pick up changes made outside this process, or `0` if results aren't cached. */
+static uint64_t MINIXCompat_StatCache_TTL = 0;
+
+/*! The cached results, indexed by a hash of the path. */
+static minix_statcache_entry_t MINIXCompat_StatCache[MINIXCompat_StatCache_Count];
+
+/*! The number of `stat(2)` and `access(2)` calls answered from the cache. */
+static uint32_t MINIXCompat_StatCache_Hits = 0;
+
+/*! The number of `stat(2)` and `access(2)` calls that had to ask the host, while the cache is enabled. */
+static uint32_t MINIXCompat_StatCache_Misses = 0;
+
+
+/*!
+ A MINIX path resolved for the host's `*at(2)` calls.
+ */
+typedef struct minix_host_path {
+    /*! The host directory descriptor ``path`` is relative to. */
+    int dir_fd;
+
+    /*! The host path relative to ``dir_fd``, which usually points into the MINIX path that was resolved. */
+    const char *path;
+
+    /*! Storage for ``path`` if it had to be constructed, which must be freed. */
+    char *storage;
+
+    /*! The held directory ``dir_fd`` belongs to, or `NULL` if it isn't one. */
+    minix_dircache_entry_t *dircache_entry;
+} minix_host_path_t;
+
 
 /*!
  A MINIX directory entry within a directory file.
@@ -70,9 +193,93 @@ struct minix_dirent  {
 typedef struct minix_dirent minix_dirent_t;
 
 
+/*! The number of directory entries in one MINIX block, which is how many are generated at a time. */
+#define MINIXCompat_Dir_BlockEntries 32
+
+/*!
+ The synthesized contents of a host directory.
+
+ An image is shared by every open of the directory until it changes, and its entries are only generated a block at a time as they're read, so scanning a huge directory doesn't cost a full pass over it on every open. Once all of its entries are generated, the image is complete and its size is a multiple of the block size, with empty entries having a 0 inode.
+ */
+typedef struct minix_dirimage {
+    /*! The host directory's device, inode, and modification time as of when the image was made, which identify it. */
+    dev_t dev;
+    ino_t ino;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+
+    /*! The number of open MINIX descriptors and cache slots referring to this image. */
+    uint32_t refcount;
+
+    /*! The blocks generated so far, each of ``MINIXCompat_Dir_BlockEntries`` entries. */
+    minix_dirent_t * _Nonnull * _Nullable blocks;
+
+    /*! The number of blocks generated so far. */
+    size_t block_count;
+
+    /*! The number of blocks there's room for in ``blocks``. */
+    size_t block_capacity;
+
+    /*! The host directory being read to generate more blocks, or `NULL` once the image is complete. */
+    DIR * _Nullable dir;
+
+    /*! The host process that opened ``dir``. */
+    pid_t dir_pid;
+
+    /*! The number of host entries read from ``dir`` so far. */
+    size_t dir_position;
+
+    /*! Whether all of the directory's entries have been generated. */
+    bool complete;
+} minix_dirimage_t;
+
+/*! The number of directory images kept around for reuse after they're closed. */
+#define MINIXCompat_DirImage_Count 16
+
+/*! The directory images kept around for reuse. */
+static minix_dirimage_t *MINIXCompat_DirImages[MINIXCompat_DirImage_Count];
+
+/*! The next slot in ``MINIXCompat_DirImages`` to replace. */
+static size_t MINIXCompat_DirImage_Next = 0;
+
+
 /*! The number of open files MINIX can have at one time. */
 #define MINIXCompat_fd_count 20
 
+
+/*! What a descriptor's buffer holds. */
+typedef enum minix_fdbuffer_mode {
+    /*! Nothing. */
+    minix_fdbuffer_mode_empty,
+
+    /*! Bytes read ahead from the host file that MINIX hasn't read yet. */
+    minix_fdbuffer_mode_reading,
+
+    /*! Bytes MINIX has written that haven't been written to the host file yet. */
+    minix_fdbuffer_mode_writing,
+} minix_fdbuffer_mode_t;
+
+/*!
+ The buffer for a regular file, so that MINIX's small reads and writes become fewer, larger host ones.
+
+ The host file's offset is past everything in the buffer when reading and before everything in it when writing, so it has to be synchronized before anything else depends on that offset.
+ */
+typedef struct minix_fdbuffer {
+    minix_fdbuffer_mode_t mode;
+
+    /*! The range of ``bytes`` holding data; when writing, ``start`` is always `0`. */
+    size_t start;
+    size_t end;
+
+    uint8_t bytes[];
+} minix_fdbuffer_t;
+
+/*! The size of each descriptor's buffer in bytes, or `0` if descriptors aren't buffered. */
+static size_t MINIXCompat_fd_BufferSize = 0;
+
+/*! The size in bytes of the largest regular file opened read-only that the host is asked to read ahead in full, or `0` if files aren't prefetched. */
+static off_t MINIXCompat_fd_PrefetchThreshold = 0;
+
 /*!
  A mapping between MINIX file descriptors and host file descriptors.
 
@@ -85,17 +292,27 @@ typedef struct minix_fdmap {
     /*! The MINIX file descriptor (also currently used as the index. */
     minix_fd_t minix_fd;
 
-    /*! Whether the fd represents a file or a directory (or hasn't been checked). */
-    enum { f_unchecked, f_file, f_directory } f_type;
-
-    /*! If this is a directory, the synthetic directory contents. */
-    minix_dirent_t *dir_entries;
+    /*! Whether the fd represents a file, a directory, or a pipe (or hasn't been checked). */
+    enum { f_unchecked, f_file, f_directory, f_pipe } f_type;
 
-    /*! If this is a directory, the number of entries it contains, rounded up to the next multiple of 32; empty entries have a 0 inode. */
-    int16_t dir_count;
+    /*! If this is a directory, a reference to its synthetic contents. */
+    minix_dirimage_t *dir_image;
 
     /*! If this is a directory, the current directory read offset. */
     minix_off_t dir_offset;
+
+    /*! If this was opened for writing while the stat cache is enabled, the absolute MINIX path to invalidate as it's written. */
+    char *stat_cache_path;
+
+    /*! Whether this is a regular file that only this process has open, so it can be buffered. */
+    bool bufferable;
+
+    /*! If this is a regular file, its host device and inode, so the buffers of every descriptor open on it can be kept consistent. */
+    dev_t host_dev;
+    ino_t host_ino;
+
+    /*! The buffer, if this is bufferable and has been read or written. */
+    minix_fdbuffer_t *buffer;
 } minix_fdmap_t;
 
 /*!
@@ -111,6 +328,16 @@ static minix_fdmap_t MINIXCompat_fd_table[MINIXCompat_fd_count];
 // MARK: - Forward Declarations
 
 static void MINIXCompat_CWD_Initialize(void);
+static void MINIXCompat_Overlay_Initialize(void);
+static const minix_overlay_t * _Nullable MINIXCompat_Overlay_Find(const char * _Nonnull path, size_t path_len);
+
+static minix_host_path_t MINIXCompat_Filesystem_ResolvePath(const char * _Nonnull path);
+static void MINIXCompat_Filesystem_FreeResolvedPath(minix_host_path_t * _Nonnull resolved);
+static bool MINIXCompat_Filesystem_ReresolvePath(minix_host_path_t * _Nonnull resolved, const char * _Nonnull path, int error);
+
+static minix_statcache_entry_t * _Nullable MINIXCompat_StatCache_Lookup(const char * _Nonnull minix_path, bool create);
+static void MINIXCompat_StatCache_Invalidate(const char * _Nonnull minix_path);
+static bool MINIXCompat_StatCache_AbsolutePath(const char * _Nonnull minix_path, char * _Nonnull out_path, size_t out_path_size);
 
 static void MINIXCompat_fd_ClearDescriptorEntry(minix_fd_t minix_fd);
 
@@ -118,9 +345,10 @@ static void MINIXCompat_File_MINIXStatBufForHostStatBuf(minix_stat_t * _Nonnull
 static minix_ino_t MINIXCompat_File_MINIXInodeForHostInode(ino_t host_inode);
 static int MINIXCompat_File_HostWhenceForMINIXWhence(minix_whence_t minix_whence);
 
-static int16_t MINIXCompat_Dir_Precache(const char * _Nullable host_path, minix_fd_t minix_fd);
-static int16_t MINIXCompat_Dir_CheckIfDirAndCache(const char * _Nonnull host_path, minix_fd_t minix_fd);
-static int16_t MINIXCompat_Dir_Read(minix_fd_t minix_fd, void *host_buf, int16_t host_buf_size);
+static minix_dirimage_t * _Nonnull MINIXCompat_DirImage_Retain(minix_dirimage_t * _Nonnull image);
+static void MINIXCompat_DirImage_Release(minix_dirimage_t * _Nullable image);
+static int16_t MINIXCompat_Dir_CheckIfDirAndCache(int host_fd, minix_fd_t minix_fd);
+static int16_t MINIXCompat_Dir_Read(minix_fd_t minix_fd, m68k_address_t minix_buf, int16_t minix_buf_size);
 static int16_t MINIXCompat_Dir_Seek(minix_fd_t minix_fd, minix_off_t minix_offset, minix_whence_t minix_whence);
 
 
@@ -142,6 +370,38 @@ void MINIXCompat_Filesystem_Initialize(void)
 
     MINIXCOMPAT_DIR_len = strlen(MINIXCOMPAT_DIR);
 
+    // Keep the MINIX root directory open so absolute paths don't have to be resolved from the host root every time.
+
+    MINIXCOMPAT_DIR_fd = open(MINIXCOMPAT_DIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    // Set up any directories whose contents live elsewhere on the host, before anything is resolved.
+
+    MINIXCompat_Overlay_Initialize();
+
+    // Cache stat(2) and access(2) results if asked to, for the given number of milliseconds.
+
+    const char *stat_cache = getenv("MINIXCOMPAT_STAT_CACHE");
+    if (stat_cache != NULL) {
+        const long ttl_ms = strtol(stat_cache, NULL, 10);
+        MINIXCompat_StatCache_TTL = (ttl_ms > 0) ? ((uint64_t) ttl_ms * 1000000ULL) : 0;
+    }
+
+    // Buffer reads and writes of regular files if asked to, using buffers of the given size.
+
+    const char *fd_buffer = getenv("MINIXCOMPAT_FD_BUFFER");
+    if (fd_buffer != NULL) {
+        const long buffer_size = strtol(fd_buffer, NULL, 10);
+        MINIXCompat_fd_BufferSize = (buffer_size > 0) ? (size_t) buffer_size : 0;
+    }
+
+    // Prefetch files opened read-only if asked to, as long as they're no bigger than the given number of bytes.
+
+    const char *prefetch = getenv("MINIXCOMPAT_PREFETCH");
+    if (prefetch != NULL) {
+        const long long prefetch_threshold = strtoll(prefetch, NULL, 10);
+        MINIXCompat_fd_PrefetchThreshold = (prefetch_threshold > 0) ? (off_t) prefetch_threshold : 0;
+    }
+
     // Set up the CWD for MINIX and this process.
 
     MINIXCompat_CWD_Initialize();
@@ -168,17 +428,102 @@ void MINIXCompat_Filesystem_Initialize(void)
 }
 
 
+// MARK: - Overlays
+
+/*!
+ Set up an overlay for each MINIX directory in the colon-separated list `MINIXCOMPAT_OVERLAY` (by default just `/tmp`), if `MINIXCOMPAT_OVERLAY_DIR` names the host directory to put them in.
+
+ Each one's contents live at the same path within that directory, which is created as needed. Nothing is ever removed, so the same directory can be shared by successive tools, like a real `/tmp`.
+ */
+static void MINIXCompat_Overlay_Initialize(void)
+{
+    const char *overlay_dir = getenv("MINIXCOMPAT_OVERLAY_DIR");
+    if ((overlay_dir == NULL) || (overlay_dir[0] == '\0')) {
+        return;
+    }
+
+    const char *overlay_list = getenv("MINIXCOMPAT_OVERLAY");
+    if ((overlay_list == NULL) || (overlay_list[0] == '\0')) {
+        overlay_list = "/tmp";
+    }
+
+    char *list = strdup(overlay_list);
+    assert(list != NULL);
+
+    char *saveptr = NULL;
+    for (char *minix_dir = strtok_r(list, ":", &saveptr); minix_dir != NULL; minix_dir = strtok_r(NULL, ":", &saveptr)) {
+        // Only absolute paths can be overlaid, and not the root itself, and trailing slashes don't matter.
+
+        size_t minix_dir_len = strlen(minix_dir);
+        while ((minix_dir_len > 1) && (minix_dir[minix_dir_len - 1] == '/')) {
+            minix_dir_len -= 1;
+        }
+        minix_dir[minix_dir_len] = '\0';
+
+        if ((minix_dir[0] != '/') || (minix_dir_len < 2)) {
+            fprintf(stderr, "MINIXCompat: can't overlay MINIX directory '%s'\n", minix_dir);
+            continue;
+        }
+
+        if (MINIXCompat_Overlay_Count == MINIXCompat_Overlay_Max) {
+            fprintf(stderr, "MINIXCompat: too many MINIXCOMPAT_OVERLAY directories, ignoring '%s'\n", minix_dir);
+            continue;
+        }
+
+        const size_t host_dir_size = strlen(overlay_dir) + minix_dir_len + 1;
+        char *host_dir = calloc(host_dir_size, sizeof(char));
+        assert(host_dir != NULL);
+        snprintf(host_dir, host_dir_size, "%s%s", overlay_dir, minix_dir);
+
+        // Create each directory leading to it in turn, since the overlay directory may be brand new.
+
+        for (char *slash = strchr(host_dir + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+            *slash = '\0';
+            (void) mkdir(host_dir, 0755);
+            *slash = '/';
+        }
+        (void) mkdir(host_dir, 0755);
+
+        int host_fd = open(host_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (host_fd == -1) {
+            fprintf(stderr, "MINIXCompat: can't overlay MINIX directory '%s' with %s: %s\n", minix_dir, host_dir, strerror(errno));
+            free(host_dir);
+            continue;
+        }
+
+        minix_overlay_t *overlay = &MINIXCompat_Overlays[MINIXCompat_Overlay_Count++];
+        overlay->minix_dir = strdup(minix_dir);
+        assert(overlay->minix_dir != NULL);
+        overlay->minix_dir_len = minix_dir_len;
+        overlay->host_dir = host_dir;
+        overlay->host_fd = host_fd;
+    }
+
+    free(list);
+}
+
+
 // MARK: - Conversion to Host Paths
 
 char *MINIXCompat_Filesystem_CopyHostPathForPath(const char *path)
 {
     assert(MINIXCOMPAT_DIR != NULL);
 
-    const size_t path_len = strlen(path);
+    size_t path_len = strlen(path);
     bool path_is_absolute = ((path_len > 0) && (path[0] == '/'));
 
     const char *base = path_is_absolute ? MINIXCOMPAT_DIR : MINIXCOMPAT_PWD_Host;
-    const size_t base_len = path_is_absolute ? MINIXCOMPAT_DIR_len : MINIXCOMPAT_PWD_Host_len;
+    size_t base_len = path_is_absolute ? MINIXCOMPAT_DIR_len : MINIXCOMPAT_PWD_Host_len;
+
+    // An absolute path within an overlaid directory is within its host directory instead.
+
+    const minix_overlay_t *overlay = path_is_absolute ? MINIXCompat_Overlay_Find(path, path_len) : NULL;
+    if (overlay != NULL) {
+        base = overlay->host_dir;
+        base_len = strlen(overlay->host_dir);
+        path += overlay->minix_dir_len;
+        path_len -= overlay->minix_dir_len;
+    }
 
     const size_t out_path_len = base_len + 1 /* trailing slash */ + path_len;
     char *out_path = calloc(out_path_len + 1 /* trailing NUL */, sizeof(char));
@@ -194,6 +539,177 @@ char *MINIXCompat_Filesystem_CopyHostPathForPath(const char *path)
     return out_path;
 }
 
+/*! Find the overlay that the MINIX absolute path \a path of length \a path_len, which needn't be `NUL`-terminated, is within, if any. */
+static const minix_overlay_t * _Nullable MINIXCompat_Overlay_Find(const char * _Nonnull path, size_t path_len)
+{
+    for (size_t i = 0; i < MINIXCompat_Overlay_Count; i++) {
+        const minix_overlay_t *overlay = &MINIXCompat_Overlays[i];
+        if ((path_len >= overlay->minix_dir_len)
+            && (memcmp(path, overlay->minix_dir, overlay->minix_dir_len) == 0)
+            && ((path_len == overlay->minix_dir_len) || (path[overlay->minix_dir_len] == '/')))
+        {
+            return overlay;
+        }
+    }
+
+    return NULL;
+}
+
+/*! Get the host directory descriptor and path relative to it for the MINIX absolute path \a path of length \a path_len, which is either within an overlay or relative to the MINIX root, in \a out_relative_path. */
+static int MINIXCompat_Overlay_Resolve(const char * _Nonnull path, size_t path_len, const char * _Nonnull * _Nonnull out_relative_path)
+{
+    const minix_overlay_t *overlay = MINIXCompat_Overlay_Find(path, path_len);
+    if (overlay != NULL) {
+        path += overlay->minix_dir_len;
+    }
+
+    const char *relative_path = path + strspn(path, "/");
+    *out_relative_path = relative_path;
+
+    return (overlay != NULL) ? overlay->host_fd : MINIXCOMPAT_DIR_fd;
+}
+
+/*! Close and forget the directory \a entry holds. */
+static void MINIXCompat_DirCache_Clear(minix_dircache_entry_t * _Nonnull entry)
+{
+    free(entry->minix_dir);
+    (void) close(entry->host_fd);
+    entry->minix_dir = NULL;
+    entry->minix_dir_len = 0;
+    entry->host_fd = -1;
+}
+
+/*! Get the held directory for the MINIX directory at absolute path \a minix_dir of length \a minix_dir_len, which needn't be `NUL`-terminated, opening it if necessary, or `NULL` if it can't be opened. */
+static minix_dircache_entry_t * _Nullable MINIXCompat_DirCache_Lookup(const char * _Nonnull minix_dir, size_t minix_dir_len)
+{
+    for (size_t i = 0; i < MINIXCompat_DirCache_Count; i++) {
+        minix_dircache_entry_t *entry = &MINIXCompat_DirCache[i];
+        if ((entry->minix_dir != NULL)
+            && (entry->minix_dir_len == minix_dir_len)
+            && (memcmp(entry->minix_dir, minix_dir, minix_dir_len) == 0))
+        {
+            return entry;
+        }
+    }
+
+    // Open the directory relative to the MINIX root or its overlay, and replace the oldest entry with it.
+
+    char *dir = strndup(minix_dir, minix_dir_len);
+    assert(dir != NULL);
+
+    const char *relative_dir = NULL;
+    const int base_fd = MINIXCompat_Overlay_Resolve(dir, minix_dir_len, &relative_dir);
+    int host_fd = openat(base_fd, (relative_dir[0] != '\0') ? relative_dir : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (host_fd == -1) {
+        free(dir);
+        return NULL;
+    }
+
+    minix_dircache_entry_t *entry = &MINIXCompat_DirCache[MINIXCompat_DirCache_Next];
+    MINIXCompat_DirCache_Next = (MINIXCompat_DirCache_Next + 1) % MINIXCompat_DirCache_Count;
+
+    if (entry->minix_dir != NULL) {
+        MINIXCompat_DirCache_Clear(entry);
+    }
+
+    entry->minix_dir = dir;
+    entry->minix_dir_len = minix_dir_len;
+    entry->host_fd = host_fd;
+
+    return entry;
+}
+
+/*! Forget any held directory at or within the MINIX path \a minix_path, which this process is about to remove. */
+static void MINIXCompat_DirCache_Invalidate(const char * _Nonnull minix_path)
+{
+    char path[PATH_MAX];
+    if (!MINIXCompat_StatCache_AbsolutePath(minix_path, path, sizeof(path))) {
+        return;
+    }
+
+    size_t path_len = strlen(path);
+    if ((path_len > 1) && (path[path_len - 1] == '/')) {
+        path[--path_len] = '\0';
+    }
+
+    for (size_t i = 0; i < MINIXCompat_DirCache_Count; i++) {
+        minix_dircache_entry_t *entry = &MINIXCompat_DirCache[i];
+        if (entry->minix_dir == NULL) continue;
+
+        // Held directories are kept as they were spelled, so compare them the way the path was.
+
+        char dir[PATH_MAX];
+        if (!MINIXCompat_StatCache_AbsolutePath(entry->minix_dir, dir, sizeof(dir))) {
+            MINIXCompat_DirCache_Clear(entry);
+            continue;
+        }
+
+        if ((strncmp(dir, path, path_len) == 0) && ((dir[path_len] == '\0') || (dir[path_len] == '/') || (path_len == 1))) {
+            MINIXCompat_DirCache_Clear(entry);
+        }
+    }
+}
+
+/*!
+ Resolve the MINIX path \a path for use with the host's `*at(2)` calls, relative to an open host directory.
+
+ An absolute path is resolved relative to its directory if that's open, or to the MINIX root, and a relative path is resolved relative to the working directory. If those couldn't be opened, the full host path is used instead.
+ */
+static minix_host_path_t MINIXCompat_Filesystem_ResolvePath(const char * _Nonnull path)
+{
+    assert(path != NULL);
+
+    minix_host_path_t resolved = { .dir_fd = -1, .path = path, .storage = NULL, .dircache_entry = NULL };
+
+    if (path[0] != '/') {
+        resolved.dir_fd = MINIXCOMPAT_PWD_Host_fd;
+    } else if (MINIXCOMPAT_DIR_fd != -1) {
+        const char *leaf = strrchr(path, '/');
+        minix_dircache_entry_t *entry = (leaf != path) ? MINIXCompat_DirCache_Lookup(path, (size_t) (leaf - path)) : NULL;
+        if (entry != NULL) {
+            resolved.dir_fd = entry->host_fd;
+            resolved.dircache_entry = entry;
+            resolved.path = (leaf[1] != '\0') ? &leaf[1] : ".";
+        } else {
+            const char *relative_path = NULL;
+            resolved.dir_fd = MINIXCompat_Overlay_Resolve(path, strlen(path), &relative_path);
+            resolved.path = (relative_path[0] != '\0') ? relative_path : ".";
+        }
+    }
+
+    if (resolved.dir_fd == -1) {
+        resolved.storage = MINIXCompat_Filesystem_CopyHostPathForPath(path);
+        resolved.dir_fd = AT_FDCWD;
+        resolved.path = resolved.storage;
+    }
+
+    return resolved;
+}
+
+/*! Free anything a path \a resolved by ``MINIXCompat_Filesystem_ResolvePath`` holds on to. */
+static void MINIXCompat_Filesystem_FreeResolvedPath(minix_host_path_t * _Nonnull resolved)
+{
+    free(resolved->storage);
+    resolved->storage = NULL;
+}
+
+/*!
+ Resolve \a path into \a resolved again after a call relative to it failed with the host error \a error, if that may be because its held directory was removed, such as by a build that made it again.
+
+ - Returns: `true` if the call should be retried with the newly \a resolved path, `false` if its result stands.
+ */
+static bool MINIXCompat_Filesystem_ReresolvePath(minix_host_path_t * _Nonnull resolved, const char * _Nonnull path, int error)
+{
+    if ((resolved->dircache_entry == NULL) || ((error != ENOENT) && (error != ESTALE))) {
+        return false;
+    }
+
+    MINIXCompat_DirCache_Clear(resolved->dircache_entry);
+    MINIXCompat_Filesystem_FreeResolvedPath(resolved);
+    *resolved = MINIXCompat_Filesystem_ResolvePath(path);
+    return true;
+}
+
 
 // MARK: - Working Directory
 
@@ -225,9 +741,21 @@ void MINIXCompat_Filesystem_SetWorkingDirectory(const char *mwd)
     free(old_host_pwd);
     MINIXCOMPAT_PWD_Host_len = strlen(MINIXCOMPAT_PWD_Host);
 
+    if (MINIXCOMPAT_PWD_Host_fd != -1) {
+        (void) close(MINIXCOMPAT_PWD_Host_fd);
+    }
+    MINIXCOMPAT_PWD_Host_fd = open(MINIXCOMPAT_PWD_Host, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
     (void) chdir(MINIXCOMPAT_PWD_Host);
 }
 
+void MINIXCompat_Filesystem_ResetWorkingDirectory(void)
+{
+    assert(MINIXCOMPAT_DIR != NULL);
+
+    MINIXCompat_CWD_Initialize();
+}
+
 static bool MINIXCompat_PathContains(const char *path, const char *subpath)
 {
     const size_t path_len = (path == MINIXCOMPAT_DIR) ? MINIXCOMPAT_DIR_len : strlen(path);
@@ -261,6 +789,162 @@ void MINIXCompat_CWD_Initialize(void)
 }
 
 
+// MARK: - Stat Cache
+
+/*! The current host time, in nanoseconds since an arbitrary point. */
+static uint64_t MINIXCompat_StatCache_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/*!
+ Normalize the absolute path \a path in place, dropping `.` components and repeated `/` and resolving `..` against the component before it, so different spellings of a path share one cache entry.
+
+ A trailing `/` is kept, since it makes a difference to what a path can name.
+ */
+static void MINIXCompat_StatCache_NormalizePath(char * _Nonnull path)
+{
+    const size_t path_len = strlen(path);
+    const bool trailing_slash = (path_len > 1) && (path[path_len - 1] == '/');
+
+    // The normalized path is never longer than the original, so it can be built over it.
+
+    size_t out = 0;
+    const char *component = path;
+    while (*component != '\0') {
+        while (*component == '/') component++;
+        if (*component == '\0') break;
+
+        const char *component_end = strchr(component, '/');
+        const size_t component_len = (component_end != NULL) ? (size_t)(component_end - component) : strlen(component);
+
+        if ((component_len == 1) && (component[0] == '.')) {
+            // Nothing to add for the current directory.
+        } else if ((component_len == 2) && (component[0] == '.') && (component[1] == '.')) {
+            while ((out > 0) && (path[out - 1] != '/')) out--;
+            if (out > 0) out--;
+        } else {
+            path[out++] = '/';
+            memmove(&path[out], component, component_len);
+            out += component_len;
+        }
+
+        component += component_len;
+    }
+
+    if (out == 0) {
+        path[out++] = '/';
+    } else if (trailing_slash) {
+        path[out++] = '/';
+    }
+    path[out] = '\0';
+}
+
+/*! Make the normalized absolute MINIX path for \a minix_path in \a out_path, which holds \a out_path_size characters, returning whether it fit. */
+static bool MINIXCompat_StatCache_AbsolutePath(const char * _Nonnull minix_path, char * _Nonnull out_path, size_t out_path_size)
+{
+    int len;
+    if (minix_path[0] == '/') {
+        len = snprintf(out_path, out_path_size, "%s", minix_path);
+    } else {
+        const bool pwd_has_slash = (MINIXCOMPAT_PWD_len > 0) && (MINIXCOMPAT_PWD[MINIXCOMPAT_PWD_len - 1] == '/');
+        len = snprintf(out_path, out_path_size, "%s%s%s", MINIXCOMPAT_PWD, pwd_has_slash ? "" : "/", minix_path);
+    }
+    if ((len <= 0) || ((size_t) len >= out_path_size)) {
+        return false;
+    }
+
+    MINIXCompat_StatCache_NormalizePath(out_path);
+    return true;
+}
+
+/*!
+ Find the cache entry for \a minix_path, replacing whatever entry has the same hash if \a create is `true`.
+
+ - Returns: The entry, or `NULL` if there isn't one or the cache isn't enabled.
+ */
+static minix_statcache_entry_t * _Nullable MINIXCompat_StatCache_Lookup(const char * _Nonnull minix_path, bool create)
+{
+    if (MINIXCompat_StatCache_TTL == 0) {
+        return NULL;
+    }
+
+    char path[PATH_MAX];
+    if (!MINIXCompat_StatCache_AbsolutePath(minix_path, path, sizeof(path))) {
+        return NULL;
+    }
+
+    const uint64_t hash = MINIXCompat_Hash_Bytes(MINIXCOMPAT_HASH_BASIS, path, strlen(path));
+
+    minix_statcache_entry_t *entry = &MINIXCompat_StatCache[hash % MINIXCompat_StatCache_Count];
+    if ((entry->minix_path != NULL) && (strcmp(entry->minix_path, path) == 0)) {
+        return entry;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    free(entry->minix_path);
+    memset(entry, 0, sizeof(minix_statcache_entry_t));
+    entry->minix_path = strdup(path);
+    assert(entry->minix_path != NULL);
+
+    return entry;
+}
+
+/*! Whether a result cached at \a cached_ns is still valid. */
+static bool MINIXCompat_StatCache_IsFresh(uint64_t cached_ns)
+{
+    return (cached_ns != 0) && ((MINIXCompat_StatCache_Now() - cached_ns) < MINIXCompat_StatCache_TTL);
+}
+
+/*! Forget anything cached about \a minix_path. */
+static void MINIXCompat_StatCache_Forget(const char * _Nonnull minix_path)
+{
+    minix_statcache_entry_t *entry = MINIXCompat_StatCache_Lookup(minix_path, false);
+    if (entry != NULL) {
+        free(entry->minix_path);
+        memset(entry, 0, sizeof(minix_statcache_entry_t));
+    }
+}
+
+/*! Forget anything cached about \a minix_path, and about the directory containing it, since this process changed them. */
+static void MINIXCompat_StatCache_Invalidate(const char * _Nonnull minix_path)
+{
+    if (MINIXCompat_StatCache_TTL == 0) {
+        return;
+    }
+
+    MINIXCompat_StatCache_Forget(minix_path);
+
+    char dir_path[PATH_MAX];
+    if (MINIXCompat_StatCache_AbsolutePath(minix_path, dir_path, sizeof(dir_path))) {
+        const size_t dir_path_len = strlen(dir_path);
+        if ((dir_path_len > 1) && (dir_path[dir_path_len - 1] == '/')) {
+            dir_path[dir_path_len - 1] = '\0';
+        }
+
+        char *leaf = strrchr(dir_path, '/');
+        if ((leaf != NULL) && (leaf != dir_path)) {
+            *leaf = '\0';
+            MINIXCompat_StatCache_Forget(dir_path);
+        }
+    }
+}
+
+void MINIXCompat_Filesystem_GetStatCacheCounters(uint32_t * _Nonnull out_hits, uint32_t * _Nonnull out_misses)
+{
+    assert(out_hits != NULL);
+    assert(out_misses != NULL);
+
+    *out_hits = MINIXCompat_StatCache_Hits;
+    *out_misses = MINIXCompat_StatCache_Misses;
+}
+
+
 // MARK: - File Descriptors
 
 static bool MINIXCompat_fd_IsInRange(minix_fd_t minix_fd)
@@ -285,47 +969,516 @@ static int MINIXCompat_fd_GetHostDescriptor(minix_fd_t minix_fd)
     return MINIXCompat_fd_table[minix_fd].host_fd;
 }
 
-static void MINIXCompat_fd_SetHostDescriptor(minix_fd_t minix_fd, int host_fd)
+static void MINIXCompat_fd_SetHostDescriptor(minix_fd_t minix_fd, int host_fd)
+{
+    assert(MINIXCompat_fd_IsInRange(minix_fd));
+
+    MINIXCompat_fd_table[minix_fd].host_fd = host_fd;
+    MINIXCompat_fd_table[minix_fd].minix_fd = minix_fd;
+    MINIXCompat_fd_table[minix_fd].f_type = f_unchecked;
+}
+
+static void MINIXCompat_fd_ClearDescriptorEntry(minix_fd_t minix_fd)
+{
+    assert(MINIXCompat_fd_IsInRange(minix_fd));
+
+    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+
+    entry->host_fd = -1;
+    entry->minix_fd = -1;
+    entry->f_type = f_unchecked;
+    MINIXCompat_DirImage_Release(entry->dir_image);
+    entry->dir_image = NULL;
+    entry->dir_offset = -1;
+    free(entry->stat_cache_path);
+    entry->stat_cache_path = NULL;
+    entry->bufferable = false;
+    free(entry->buffer);
+    entry->buffer = NULL;
+}
+
+static bool MINIXCompat_fd_IsDirectory(minix_fd_t minix_fd)
+{
+    assert(MINIXCompat_fd_IsInRange(minix_fd));
+    assert(MINIXCompat_fd_IsOpen(minix_fd));
+
+    return (MINIXCompat_fd_table[minix_fd].f_type == f_directory);
+}
+
+static minix_fd_t MINIXCompat_fd_FindNextAvailable(void)
+{
+    for (int minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        if (MINIXCompat_fd_GetHostDescriptor(minix_fd) == -1) {
+            return minix_fd;
+        }
+    }
+
+    return -ENFILE;
+}
+
+
+// MARK: - Buffering
+
+/*! Get the buffer for \a entry, creating it if needed, or `NULL` if it isn't to be buffered. */
+static minix_fdbuffer_t * _Nullable MINIXCompat_fdbuffer_Get(minix_fdmap_t * _Nonnull entry)
+{
+    if (!entry->bufferable) {
+        return NULL;
+    }
+
+    if (entry->buffer == NULL) {
+        entry->buffer = calloc(1, sizeof(minix_fdbuffer_t) + MINIXCompat_fd_BufferSize);
+        assert(entry->buffer != NULL);
+    }
+
+    return entry->buffer;
+}
+
+/*!
+ Synchronize the host file open on \a entry with its buffer, writing out anything written and giving back anything read ahead, so the host file's offset is where MINIX thinks it is.
+
+ - Returns: `0` on success or `-errno`; anything that couldn't be written is dropped either way, like a failed write.
+ */
+static int16_t MINIXCompat_fdbuffer_Sync(minix_fdmap_t * _Nonnull entry)
+{
+    minix_fdbuffer_t *buffer = entry->buffer;
+    if (buffer == NULL) {
+        return 0;
+    }
+
+    int16_t result = 0;
+
+    if (buffer->mode == minix_fdbuffer_mode_writing) {
+        while (buffer->start < buffer->end) {
+            ssize_t byteswritten = write(entry->host_fd, &buffer->bytes[buffer->start], buffer->end - buffer->start);
+            if (byteswritten < 0) {
+                if (errno == EINTR) continue;
+                result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+                break;
+            }
+            buffer->start += (size_t) byteswritten;
+        }
+    } else if (buffer->mode == minix_fdbuffer_mode_reading) {
+        const off_t unread = (off_t) (buffer->end - buffer->start);
+        if ((unread > 0) && (lseek(entry->host_fd, -unread, SEEK_CUR) == -1)) {
+            result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+        }
+    }
+
+    buffer->mode = minix_fdbuffer_mode_empty;
+    buffer->start = 0;
+    buffer->end = 0;
+
+    return result;
+}
+
+/*!
+ Ask the host to start reading the file open on \a host_fd into memory, if it's a regular file of no more than ``MINIXCompat_fd_PrefetchThreshold`` bytes, so that reads of it don't each wait on the disk or the network.
+
+ This doesn't wait for anything to be read, so it's harmless if the file is never read. Bigger files are left to the host's usual read-ahead, so one huge file can't push everything else out of memory, and devices like the terminal are left alone.
+ */
+static void MINIXCompat_File_Prefetch(int host_fd)
+{
+    struct stat host_stat;
+    if ((fstat(host_fd, &host_stat) == -1) || !S_ISREG(host_stat.st_mode) || (host_stat.st_size == 0) || (host_stat.st_size > MINIXCompat_fd_PrefetchThreshold)) {
+        return;
+    }
+
+#if defined(__APPLE__)
+    // Darwin has no posix_fadvise(2), but F_RDADVISE is the same thing.
+
+    struct radvisory advisory = {
+        .ra_offset = 0,
+        .ra_count = (host_stat.st_size < INT_MAX) ? (int) host_stat.st_size : INT_MAX,
+    };
+    (void) fcntl(host_fd, F_RDADVISE, &advisory);
+#elif defined(POSIX_FADV_WILLNEED)
+    // The tools that open files read-only nearly always read them start to finish, so also let the host read ahead more aggressively than it would.
+
+    (void) posix_fadvise(host_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    (void) posix_fadvise(host_fd, 0, host_stat.st_size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+/*! Read \a minix_buf_size bytes into \a minix_buf straight from the host descriptor \a host_fd. */
+static int16_t MINIXCompat_File_ReadDirect(int host_fd, m68k_address_t minix_buf, int16_t minix_buf_size)
+{
+    uint8_t *host_buf = MINIXCompat_RAM_Host_Address(minix_buf, minix_buf_size);
+    assert(host_buf != NULL);
+
+    // What's read may replace code that's been predecoded, as when a program loads an overlay.
+
+    MINIXCompat_Predecode_Note_Block_Write(minix_buf, (uint32_t) minix_buf_size);
+    MINIXCompat_RAM_Note_Block_Write(minix_buf, (uint32_t) minix_buf_size);
+
+    // Read straight into emulated RAM, which only needs to be in Motorola byte order while the host is touching it.
+
+    MINIXCompat_RAM_Swizzle_Range(minix_buf, minix_buf_size);
+    ssize_t bytesread = read(host_fd, host_buf, minix_buf_size);
+    int read_errno = errno;
+    MINIXCompat_RAM_Swizzle_Range(minix_buf, minix_buf_size);
+
+    if (bytesread < 0) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(read_errno);
+    } else {
+        return (int16_t) bytesread;
+    }
+}
+
+/*! Write \a minix_buf_size bytes from \a minix_buf straight to the host descriptor \a host_fd. */
+static int16_t MINIXCompat_File_WriteDirect(int host_fd, m68k_address_t minix_buf, int16_t minix_buf_size)
+{
+    uint8_t *host_buf = MINIXCompat_RAM_Host_Address(minix_buf, minix_buf_size);
+    assert(host_buf != NULL);
+
+    // Write straight from emulated RAM, which only needs to be in Motorola byte order while the host is touching it.
+
+    MINIXCompat_RAM_Swizzle_Range(minix_buf, minix_buf_size);
+    ssize_t byteswritten = write(host_fd, host_buf, minix_buf_size);
+    int write_errno = errno;
+    MINIXCompat_RAM_Swizzle_Range(minix_buf, minix_buf_size);
+
+    if (byteswritten < 0) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(write_errno);
+    } else {
+        return (int16_t) byteswritten;
+    }
+}
+
+/*! Read \a minix_buf_size bytes into \a minix_buf from the file open on \a entry, through \a buffer, reading ahead a buffer at a time. */
+static int16_t MINIXCompat_fdbuffer_Read(minix_fdmap_t * _Nonnull entry, minix_fdbuffer_t * _Nonnull buffer, m68k_address_t minix_buf, int16_t minix_buf_size)
+{
+    if (buffer->mode == minix_fdbuffer_mode_writing) {
+        int16_t sync_result = MINIXCompat_fdbuffer_Sync(entry);
+        if (sync_result < 0) {
+            return sync_result;
+        }
+    }
+
+    // Like a host read of a regular file, this only comes up short at the end of the file.
+
+    int16_t copied = 0;
+    while (copied < minix_buf_size) {
+        const size_t wanted = (size_t) (minix_buf_size - copied);
+
+        if (buffer->start < buffer->end) {
+            const size_t chunk = ((buffer->end - buffer->start) < wanted) ? (buffer->end - buffer->start) : wanted;
+            MINIXCompat_RAM_Copy_Block_From_Host(minix_buf + copied, &buffer->bytes[buffer->start], (uint32_t) chunk);
+            buffer->start += chunk;
+            copied += (int16_t) chunk;
+            continue;
+        }
+
+        // A read at least as big as the buffer gains nothing from going through it.
+
+        if (wanted >= MINIXCompat_fd_BufferSize) {
+            buffer->mode = minix_fdbuffer_mode_empty;
+            int16_t direct_result = MINIXCompat_File_ReadDirect(entry->host_fd, minix_buf + copied, (int16_t) wanted);
+            if (direct_result < 0) {
+                return (copied > 0) ? copied : direct_result;
+            }
+            copied += direct_result;
+            break;
+        }
+
+        ssize_t bytesread = read(entry->host_fd, buffer->bytes, MINIXCompat_fd_BufferSize);
+        if (bytesread < 0) {
+            if (errno == EINTR) continue;
+            return (copied > 0) ? copied : -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+        }
+
+        buffer->mode = minix_fdbuffer_mode_reading;
+        buffer->start = 0;
+        buffer->end = (size_t) bytesread;
+
+        if (bytesread == 0) {
+            break;
+        }
+    }
+
+    return copied;
+}
+
+/*! Write \a minix_buf_size bytes from \a minix_buf to the file open on \a entry, through \a buffer, writing it out once it fills. */
+static int16_t MINIXCompat_fdbuffer_Write(minix_fdmap_t * _Nonnull entry, minix_fdbuffer_t * _Nonnull buffer, m68k_address_t minix_buf, int16_t minix_buf_size)
+{
+    if ((buffer->mode == minix_fdbuffer_mode_reading)
+        || ((buffer->mode == minix_fdbuffer_mode_writing) && ((buffer->end + (size_t) minix_buf_size) > MINIXCompat_fd_BufferSize)))
+    {
+        int16_t sync_result = MINIXCompat_fdbuffer_Sync(entry);
+        if (sync_result < 0) {
+            return sync_result;
+        }
+    }
+
+    // A write at least as big as the buffer gains nothing from going through it.
+
+    if ((size_t) minix_buf_size >= MINIXCompat_fd_BufferSize) {
+        return MINIXCompat_File_WriteDirect(entry->host_fd, minix_buf, minix_buf_size);
+    }
+
+    MINIXCompat_RAM_Copy_Block_To_Buffer(minix_buf, &buffer->bytes[buffer->end], (uint32_t) minix_buf_size);
+    buffer->mode = minix_fdbuffer_mode_writing;
+    buffer->end += (size_t) minix_buf_size;
+
+    return minix_buf_size;
+}
+
+/*!
+ Synchronize the buffers of every other descriptor open on the same file as \a entry before it's read from or written to, so nothing read through \a entry misses what was written through another one, and, if \a writing, nothing read ahead through another one misses what's written through \a entry.
+
+ Two descriptors just reading the same file keep their read-ahead.
+ */
+static void MINIXCompat_fdbuffer_SyncSharing(minix_fdmap_t * _Nonnull entry, bool writing)
+{
+    if ((MINIXCompat_fd_BufferSize == 0) || (entry->f_type != f_file)) {
+        return;
+    }
+
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        minix_fdmap_t *other = &MINIXCompat_fd_table[minix_fd];
+        if ((other == entry) || (other->buffer == NULL) || (other->host_dev != entry->host_dev) || (other->host_ino != entry->host_ino)) continue;
+
+        if ((other->buffer->mode == minix_fdbuffer_mode_writing) || (writing && (other->buffer->mode == minix_fdbuffer_mode_reading))) {
+            (void) MINIXCompat_fdbuffer_Sync(other);
+        }
+    }
+}
+
+/*! Write out everything written to files this process has open that hasn't been yet, so that other paths to them see it. */
+static void MINIXCompat_fdbuffer_SyncWrites(void)
+{
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+        if ((entry->buffer != NULL) && (entry->buffer->mode == minix_fdbuffer_mode_writing)) {
+            (void) MINIXCompat_fdbuffer_Sync(entry);
+        }
+    }
+}
+
+void MINIXCompat_Filesystem_Flush(void)
+{
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        (void) MINIXCompat_fdbuffer_Sync(&MINIXCompat_fd_table[minix_fd]);
+    }
+}
+
+void MINIXCompat_Filesystem_Fork_Prepare(void)
+{
+    // Parent and child share each descriptor's offset from now on, so neither can buffer it.
+
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+        (void) MINIXCompat_fdbuffer_Sync(entry);
+        free(entry->buffer);
+        entry->buffer = NULL;
+        entry->bufferable = false;
+    }
+}
+
+
+// MARK: - Process Contexts
+
+struct MINIXCompat_Filesystem_Context {
+    minix_fdmap_t fd_table[MINIXCompat_fd_count];
+
+    char *pwd;
+    size_t pwd_len;
+    char *pwd_host;
+    size_t pwd_host_len;
+    int pwd_host_fd;
+};
+
+
+MINIXCompat_Filesystem_Context_t *MINIXCompat_Filesystem_Context_Fork(void)
+{
+    MINIXCompat_Filesystem_Context_t *context = calloc(1, sizeof(MINIXCompat_Filesystem_Context_t));
+    assert(context != NULL);
+
+    // Like a host fork(2), the child gets duplicates of the open descriptors that share their offsets; directory offsets are its own, but their contents are shared.
+
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        const minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+        minix_fdmap_t *copy = &context->fd_table[minix_fd];
+
+        *copy = *entry;
+
+        if (entry->host_fd != -1) {
+            copy->host_fd = dup(entry->host_fd);
+        }
+
+        if (entry->dir_image != NULL) {
+            copy->dir_image = MINIXCompat_DirImage_Retain(entry->dir_image);
+        }
+
+        if (entry->stat_cache_path != NULL) {
+            copy->stat_cache_path = strdup(entry->stat_cache_path);
+            assert(copy->stat_cache_path != NULL);
+        }
+
+        // Buffering already stopped for the fork.
+
+        assert(entry->buffer == NULL);
+        copy->bufferable = false;
+    }
+
+    context->pwd = strdup(MINIXCOMPAT_PWD);
+    context->pwd_len = MINIXCOMPAT_PWD_len;
+    context->pwd_host = strdup(MINIXCOMPAT_PWD_Host);
+    context->pwd_host_len = MINIXCOMPAT_PWD_Host_len;
+    context->pwd_host_fd = (MINIXCOMPAT_PWD_Host_fd != -1) ? fcntl(MINIXCOMPAT_PWD_Host_fd, F_DUPFD_CLOEXEC, 0) : -1;
+
+    return context;
+}
+
+
+MINIXCompat_Filesystem_Context_t *MINIXCompat_Filesystem_Context_Save(void)
+{
+    // The process switched to may read files this one has written but not yet written out.
+
+    MINIXCompat_fdbuffer_SyncWrites();
+
+    MINIXCompat_Filesystem_Context_t *context = calloc(1, sizeof(MINIXCompat_Filesystem_Context_t));
+    assert(context != NULL);
+
+    memcpy(context->fd_table, MINIXCompat_fd_table, sizeof(MINIXCompat_fd_table));
+
+    context->pwd = MINIXCOMPAT_PWD;
+    context->pwd_len = MINIXCOMPAT_PWD_len;
+    context->pwd_host = MINIXCOMPAT_PWD_Host;
+    context->pwd_host_len = MINIXCOMPAT_PWD_Host_len;
+    context->pwd_host_fd = MINIXCOMPAT_PWD_Host_fd;
+
+    // The context owns all of this now.
+
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        MINIXCompat_fd_table[minix_fd].dir_image = NULL;
+        MINIXCompat_fd_table[minix_fd].stat_cache_path = NULL;
+        MINIXCompat_fd_table[minix_fd].buffer = NULL;
+        MINIXCompat_fd_ClearDescriptorEntry(minix_fd);
+    }
+
+    MINIXCOMPAT_PWD = NULL;
+    MINIXCOMPAT_PWD_len = 0;
+    MINIXCOMPAT_PWD_Host = NULL;
+    MINIXCOMPAT_PWD_Host_len = 0;
+    MINIXCOMPAT_PWD_Host_fd = -1;
+
+    return context;
+}
+
+
+void MINIXCompat_Filesystem_Context_Restore(MINIXCompat_Filesystem_Context_t *context)
 {
-    assert(MINIXCompat_fd_IsInRange(minix_fd));
+    assert(context != NULL);
+    assert(MINIXCOMPAT_PWD == NULL);
 
-    MINIXCompat_fd_table[minix_fd].host_fd = host_fd;
-    MINIXCompat_fd_table[minix_fd].minix_fd = minix_fd;
-    MINIXCompat_fd_table[minix_fd].f_type = f_unchecked;
+    memcpy(MINIXCompat_fd_table, context->fd_table, sizeof(MINIXCompat_fd_table));
+
+    MINIXCOMPAT_PWD = context->pwd;
+    MINIXCOMPAT_PWD_len = context->pwd_len;
+    MINIXCOMPAT_PWD_Host = context->pwd_host;
+    MINIXCOMPAT_PWD_Host_len = context->pwd_host_len;
+    MINIXCOMPAT_PWD_Host_fd = context->pwd_host_fd;
+
+    (void) chdir(MINIXCOMPAT_PWD_Host);
+
+    free(context);
 }
 
-static void MINIXCompat_fd_ClearDescriptorEntry(minix_fd_t minix_fd)
+
+void MINIXCompat_Filesystem_Context_Free(MINIXCompat_Filesystem_Context_t *context)
 {
-    assert(MINIXCompat_fd_IsInRange(minix_fd));
+    if (context == NULL) {
+        return;
+    }
 
-    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+    for (minix_fd_t minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+        minix_fdmap_t *entry = &context->fd_table[minix_fd];
+        if (entry->host_fd != -1) {
+            close(entry->host_fd);
+        }
+        MINIXCompat_DirImage_Release(entry->dir_image);
+        free(entry->stat_cache_path);
+        free(entry->buffer);
+    }
 
-    entry->host_fd = -1;
-    entry->minix_fd = -1;
-    entry->f_type = f_unchecked;
-    free(entry->dir_entries);
-    entry->dir_entries = NULL;
-    entry->dir_count = -1;
-    entry->dir_offset = -1;
+    free(context->pwd);
+    free(context->pwd_host);
+    if (context->pwd_host_fd != -1) {
+        close(context->pwd_host_fd);
+    }
+    free(context);
 }
 
-static bool MINIXCompat_fd_IsDirectory(minix_fd_t minix_fd)
+
+/*! The part of a snapshot holding the open files, which is followed by the `NUL`-terminated working directory. */
+typedef struct minix_filesystem_snapshot {
+    /*! The host descriptor each MINIX descriptor is open on, which is always standard input, output, or error, or `-1` if it's closed. */
+    int32_t host_fds[MINIXCompat_fd_count];
+
+    uint32_t pwd_len;
+} minix_filesystem_snapshot_t;
+
+bool MINIXCompat_Filesystem_Snapshot_Write(int fd)
 {
-    assert(MINIXCompat_fd_IsInRange(minix_fd));
-    assert(MINIXCompat_fd_IsOpen(minix_fd));
+    minix_filesystem_snapshot_t snapshot;
 
-    return (MINIXCompat_fd_table[minix_fd].f_type == f_directory);
+    for (minix_fd_t i = 0; i < MINIXCompat_fd_count; i++) {
+        if (MINIXCompat_fd_IsClosed(i)) {
+            snapshot.host_fds[i] = -1;
+        } else if (MINIXCompat_fd_IsDirectory(i)
+                   || (MINIXCompat_fd_table[i].host_fd < STDIN_FILENO)
+                   || (MINIXCompat_fd_table[i].host_fd > STDERR_FILENO))
+        {
+            return false;
+        } else {
+            snapshot.host_fds[i] = MINIXCompat_fd_table[i].host_fd;
+        }
+    }
+
+    snapshot.pwd_len = (uint32_t) MINIXCOMPAT_PWD_len + 1;
+
+    return MINIXCompat_Host_Write_Bytes(fd, &snapshot, sizeof(snapshot))
+        && MINIXCompat_Host_Write_Bytes(fd, MINIXCOMPAT_PWD, snapshot.pwd_len);
 }
 
-static minix_fd_t MINIXCompat_fd_FindNextAvailable(void)
+bool MINIXCompat_Filesystem_Snapshot_Read(int fd)
 {
-    for (int minix_fd = 0; minix_fd < MINIXCompat_fd_count; minix_fd++) {
-        if (MINIXCompat_fd_GetHostDescriptor(minix_fd) == -1) {
-            return minix_fd;
+    minix_filesystem_snapshot_t snapshot;
+    if (!MINIXCompat_Host_Read_Bytes(fd, &snapshot, sizeof(snapshot)) || (snapshot.pwd_len == 0) || (snapshot.pwd_len > PATH_MAX)) {
+        return false;
+    }
+
+    char *pwd = calloc(snapshot.pwd_len, sizeof(char));
+    if ((pwd == NULL) || !MINIXCompat_Host_Read_Bytes(fd, pwd, snapshot.pwd_len) || (pwd[snapshot.pwd_len - 1] != '\0')) {
+        free(pwd);
+        return false;
+    }
+
+    for (minix_fd_t i = 0; i < MINIXCompat_fd_count; i++) {
+        const int32_t host_fd = snapshot.host_fds[i];
+        if ((host_fd != -1) && ((host_fd < STDIN_FILENO) || (host_fd > STDERR_FILENO))) {
+            free(pwd);
+            return false;
         }
     }
 
-    return -ENFILE;
+    // Only the standard descriptors can be open so far, so there's nothing to close.
+
+    for (minix_fd_t i = 0; i < MINIXCompat_fd_count; i++) {
+        MINIXCompat_fd_ClearDescriptorEntry(i);
+        if (snapshot.host_fds[i] != -1) {
+            MINIXCompat_fd_table[i].host_fd = snapshot.host_fds[i];
+            MINIXCompat_fd_table[i].minix_fd = i;
+            MINIXCompat_fd_table[i].f_type = f_file;
+        }
+    }
+
+    MINIXCompat_Filesystem_SetWorkingDirectory(pwd);
+    free(pwd);
+
+    return true;
 }
 
 
@@ -431,16 +1584,31 @@ minix_fd_t MINIXCompat_File_Open(const char *minix_path, int16_t minix_flags, mi
     int16_t result;
 
     assert(minix_path != NULL);
+
+    // The file may be one this process is writing, and the new descriptor has to see everything written so far.
+
+    MINIXCompat_fdbuffer_SyncWrites();
+
     int host_flags = MINIXCompat_File_HostOpenFlagsForMINIXOpenFlags(minix_flags);
     int host_mode = MINIXCompat_File_HostOpenModeForMINIXOpenMode(minix_mode);
 
+    // Creating or truncating the file changes it along with its directory, and writing it will too.
+
+    const bool is_write = ((minix_flags & (minix_O_WRONLY | minix_O_RDWR)) != 0);
+    if ((minix_flags & (minix_O_CREAT | minix_O_TRUNC)) != 0) {
+        MINIXCompat_StatCache_Invalidate(minix_path);
+    }
+
     minix_fd_t minix_fd = MINIXCompat_fd_FindNextAvailable();
     if (minix_fd >= 0) {
-        char *host_path = MINIXCompat_Filesystem_CopyHostPathForPath(minix_path);
+        minix_host_path_t host_path = MINIXCompat_Filesystem_ResolvePath(minix_path);
 
         // Open the file.
 
-        int host_fd = open(host_path, host_flags, host_mode);
+        int host_fd = openat(host_path.dir_fd, host_path.path, host_flags, host_mode);
+        if ((host_fd == -1) && MINIXCompat_Filesystem_ReresolvePath(&host_path, minix_path, errno)) {
+            host_fd = openat(host_path.dir_fd, host_path.path, host_flags, host_mode);
+        }
         if (host_fd >= 0) {
             // Save the association.
 
@@ -449,15 +1617,24 @@ minix_fd_t MINIXCompat_File_Open(const char *minix_path, int16_t minix_flags, mi
             // Check and record whether the newly-opened file is a directory, and do any necessary bookkeeping if so.
             // That will only fail if the open itself should fail.
 
-            int16_t diropen_result = MINIXCompat_Dir_CheckIfDirAndCache(host_path, minix_fd);
+            int16_t diropen_result = MINIXCompat_Dir_CheckIfDirAndCache(host_fd, minix_fd);
             if (diropen_result < 0) {
-                minix_fd = diropen_result;
                 (void) close(host_fd);
                 MINIXCompat_fd_ClearDescriptorEntry(minix_fd);
+                minix_fd = diropen_result;
+            } else if (is_write && (MINIXCompat_StatCache_TTL != 0)) {
+                char stat_cache_path[PATH_MAX];
+                if (MINIXCompat_StatCache_AbsolutePath(minix_path, stat_cache_path, sizeof(stat_cache_path))) {
+                    MINIXCompat_fd_table[minix_fd].stat_cache_path = strdup(stat_cache_path);
+                }
+            } else if (!is_write && (MINIXCompat_fd_PrefetchThreshold > 0) && (MINIXCompat_fd_table[minix_fd].f_type == f_file)) {
+                MINIXCompat_File_Prefetch(host_fd);
             }
+        } else {
+            minix_fd = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
         }
 
-        free(host_path);
+        MINIXCompat_Filesystem_FreeResolvedPath(&host_path);
 
         result = minix_fd;
     } else {
@@ -476,9 +1653,20 @@ int16_t MINIXCompat_File_Close(minix_fd_t minix_fd)
 
     int host_fd = MINIXCompat_fd_GetHostDescriptor(minix_fd);
 
+    const char *stat_cache_path = MINIXCompat_fd_table[minix_fd].stat_cache_path;
+    if (stat_cache_path != NULL) {
+        MINIXCompat_StatCache_Invalidate(stat_cache_path);
+    }
+
+    // Anything still buffered has to be written first, and if it can't be, that's reported by the close.
+
+    int16_t sync_result = MINIXCompat_fdbuffer_Sync(&MINIXCompat_fd_table[minix_fd]);
+
     int close_result = close(host_fd);
     if (close_result == -1) {
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    } else if (sync_result < 0) {
+        result = sync_result;
     } else {
         result = close_result;
     }
@@ -488,28 +1676,34 @@ int16_t MINIXCompat_File_Close(minix_fd_t minix_fd)
     return result;
 }
 
-int16_t MINIXCompat_File_Read(minix_fd_t minix_fd, void *host_buf, int16_t host_buf_size)
+int16_t MINIXCompat_File_Read(minix_fd_t minix_fd, m68k_address_t minix_buf, int16_t minix_buf_size)
 {
     int16_t result;
 
     assert(MINIXCompat_fd_IsInRange(minix_fd));
     assert(MINIXCompat_fd_IsOpen(minix_fd));
-    assert(host_buf != NULL);
-    assert(host_buf_size > 0);
+
+    if (minix_buf_size < 0) {
+        return -minix_EINVAL;
+    }
+
+    uint8_t *host_buf = MINIXCompat_RAM_Host_Address(minix_buf, minix_buf_size);
+    if (host_buf == NULL) {
+        return -minix_EFAULT;
+    }
 
     if (MINIXCompat_fd_IsDirectory(minix_fd)) {
         // Handle directories specially, since readdir et al are userspace on MINIX.
 
-        result = MINIXCompat_Dir_Read(minix_fd, host_buf, host_buf_size);
+        result = MINIXCompat_Dir_Read(minix_fd, minix_buf, minix_buf_size);
     } else {
         int host_fd = MINIXCompat_fd_GetHostDescriptor(minix_fd);
-        if (host_fd >= 0) {
-            ssize_t bytesread = read(host_fd, host_buf, host_buf_size);
-            if (bytesread < 0) {
-                result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
-            } else {
-                result = bytesread;
-            }
+        MINIXCompat_fdbuffer_SyncSharing(&MINIXCompat_fd_table[minix_fd], false);
+        minix_fdbuffer_t *buffer = MINIXCompat_fdbuffer_Get(&MINIXCompat_fd_table[minix_fd]);
+        if ((host_fd >= 0) && (buffer != NULL)) {
+            result = MINIXCompat_fdbuffer_Read(&MINIXCompat_fd_table[minix_fd], buffer, minix_buf, minix_buf_size);
+        } else if (host_fd >= 0) {
+            result = MINIXCompat_File_ReadDirect(host_fd, minix_buf, minix_buf_size);
         } else {
             result = -MINIXCompat_Errors_MINIXErrorForHostError(ENFILE);
         }
@@ -518,23 +1712,36 @@ int16_t MINIXCompat_File_Read(minix_fd_t minix_fd, void *host_buf, int16_t host_
     return result;
 }
 
-int16_t MINIXCompat_File_Write(minix_fd_t minix_fd, void *host_buf, int16_t host_buf_size)
+int16_t MINIXCompat_File_Write(minix_fd_t minix_fd, m68k_address_t minix_buf, int16_t minix_buf_size)
 {
     int16_t result;
 
     assert(MINIXCompat_fd_IsInRange(minix_fd));
     assert(MINIXCompat_fd_IsOpen(minix_fd));
     assert(!MINIXCompat_fd_IsDirectory(minix_fd));
-    assert(host_buf != NULL);
-    assert(host_buf_size >= 0);
+
+    if (minix_buf_size < 0) {
+        return -minix_EINVAL;
+    }
+
+    uint8_t *host_buf = MINIXCompat_RAM_Host_Address(minix_buf, minix_buf_size);
+    if (host_buf == NULL) {
+        return -minix_EFAULT;
+    }
 
     int host_fd = MINIXCompat_fd_GetHostDescriptor(minix_fd);
     if (host_fd >= 0) {
-        ssize_t byteswritten = write(host_fd, host_buf, host_buf_size);
-        if (byteswritten < 0) {
-            result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+        MINIXCompat_fdbuffer_SyncSharing(&MINIXCompat_fd_table[minix_fd], true);
+        minix_fdbuffer_t *buffer = MINIXCompat_fdbuffer_Get(&MINIXCompat_fd_table[minix_fd]);
+        if (buffer != NULL) {
+            result = MINIXCompat_fdbuffer_Write(&MINIXCompat_fd_table[minix_fd], buffer, minix_buf, minix_buf_size);
         } else {
-            result = byteswritten;
+            result = MINIXCompat_File_WriteDirect(host_fd, minix_buf, minix_buf_size);
+        }
+
+        const char *stat_cache_path = MINIXCompat_fd_table[minix_fd].stat_cache_path;
+        if ((stat_cache_path != NULL) && (result > 0)) {
+            MINIXCompat_StatCache_Invalidate(stat_cache_path);
         }
     } else {
         result = -MINIXCompat_Errors_MINIXErrorForHostError(ENFILE);
@@ -555,6 +1762,11 @@ int16_t MINIXCompat_File_Seek(minix_fd_t minix_fd, minix_off_t minix_offset, int
 
         return MINIXCompat_Dir_Seek(minix_fd, minix_offset, minix_whence);
     } else {
+        int16_t sync_result = MINIXCompat_fdbuffer_Sync(&MINIXCompat_fd_table[minix_fd]);
+        if (sync_result < 0) {
+            return sync_result;
+        }
+
         int host_fd = MINIXCompat_fd_GetHostDescriptor(minix_fd);
         off_t host_offset = minix_offset;
         int host_whence = MINIXCompat_File_HostWhenceForMINIXWhence(minix_whence);
@@ -570,6 +1782,135 @@ int16_t MINIXCompat_File_Seek(minix_fd_t minix_fd, minix_off_t minix_offset, int
     return result;
 }
 
+int16_t MINIXCompat_File_Pipe(minix_fd_t * _Nonnull out_read_fd, minix_fd_t * _Nonnull out_write_fd)
+{
+    assert(out_read_fd != NULL);
+    assert(out_write_fd != NULL);
+
+    // Both ends need a MINIX descriptor, so find them before creating anything.
+
+    minix_fd_t read_fd = MINIXCompat_fd_FindNextAvailable();
+    minix_fd_t write_fd = -1;
+    if (read_fd >= 0) {
+        for (minix_fd_t minix_fd = read_fd + 1; minix_fd < MINIXCompat_fd_count; minix_fd++) {
+            if (MINIXCompat_fd_GetHostDescriptor(minix_fd) == -1) {
+                write_fd = minix_fd;
+                break;
+            }
+        }
+    }
+    if ((read_fd < 0) || (write_fd < 0)) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(EMFILE);
+    }
+
+    int host_fds[2];
+    if (pipe(host_fds) == -1) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    }
+
+    // Neither end can be buffered, since whatever's at the other end has to see data as soon as it's written.
+
+    MINIXCompat_fd_SetHostDescriptor(read_fd, host_fds[0]);
+    MINIXCompat_fd_table[read_fd].f_type = f_pipe;
+
+    MINIXCompat_fd_SetHostDescriptor(write_fd, host_fds[1]);
+    MINIXCompat_fd_table[write_fd].f_type = f_pipe;
+
+    *out_read_fd = read_fd;
+    *out_write_fd = write_fd;
+
+    return 0;
+}
+
+minix_fd_t MINIXCompat_File_Dup(minix_fd_t minix_fd, minix_fd_t minix_fd2)
+{
+    if (!MINIXCompat_fd_IsInRange(minix_fd) || MINIXCompat_fd_IsClosed(minix_fd)) {
+        return -minix_EBADF;
+    }
+
+    if (minix_fd2 == -1) {
+        minix_fd2 = MINIXCompat_fd_FindNextAvailable();
+        if (minix_fd2 < 0) {
+            return -MINIXCompat_Errors_MINIXErrorForHostError(EMFILE);
+        }
+    } else if (!MINIXCompat_fd_IsInRange(minix_fd2)) {
+        return -minix_EBADF;
+    } else if (minix_fd2 == minix_fd) {
+        return minix_fd2;
+    }
+
+    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+
+    // Both descriptors share an offset from now on, so neither can be buffered.
+
+    int16_t sync_result = MINIXCompat_fdbuffer_Sync(entry);
+    if (sync_result < 0) {
+        return sync_result;
+    }
+    free(entry->buffer);
+    entry->buffer = NULL;
+    entry->bufferable = false;
+
+    int host_fd = dup(entry->host_fd);
+    if (host_fd == -1) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    }
+
+    // Like dup2(2), anything already open on the second descriptor is closed first, quietly.
+
+    if (MINIXCompat_fd_IsOpen(minix_fd2)) {
+        (void) MINIXCompat_File_Close(minix_fd2);
+    }
+
+    minix_fdmap_t *copy = &MINIXCompat_fd_table[minix_fd2];
+
+    *copy = *entry;
+    copy->host_fd = host_fd;
+    copy->minix_fd = minix_fd2;
+
+    if (entry->dir_image != NULL) {
+        copy->dir_image = MINIXCompat_DirImage_Retain(entry->dir_image);
+    }
+
+    if (entry->stat_cache_path != NULL) {
+        copy->stat_cache_path = strdup(entry->stat_cache_path);
+        assert(copy->stat_cache_path != NULL);
+    }
+
+    return minix_fd2;
+}
+
+bool MINIXCompat_File_IsPipe(minix_fd_t minix_fd)
+{
+    return MINIXCompat_fd_IsInRange(minix_fd) && MINIXCompat_fd_IsOpen(minix_fd) && (MINIXCompat_fd_table[minix_fd].f_type == f_pipe);
+}
+
+bool MINIXCompat_File_PipeIsReady(minix_fd_t minix_fd, bool for_write, bool wait)
+{
+    if (!MINIXCompat_File_IsPipe(minix_fd)) {
+        return true;
+    }
+
+    // A hangup or error counts as ready too, since the read or write won't block either, it'll just see the end of the pipe or fail.
+
+    struct pollfd pfd = {
+        .fd = MINIXCompat_fd_GetHostDescriptor(minix_fd),
+        .events = for_write ? POLLOUT : POLLIN,
+        .revents = 0,
+    };
+
+    for (;;) {
+        int poll_result = poll(&pfd, 1, wait ? -1 : 0);
+        if (poll_result > 0) {
+            return true;
+        } else if (poll_result == 0) {
+            return false;
+        } else if (errno != EINTR) {
+            return true;
+        }
+    }
+}
+
 void MINIXCompat_File_StatSwap(minix_stat_t * _Nonnull minix_stat_buf)
 {
     HTONS(minix_stat_buf->st_dev);
@@ -648,20 +1989,50 @@ int16_t MINIXCompat_File_Stat(const char * _Nonnull minix_path, minix_stat_t * _
     assert(minix_path != NULL);
     assert(minix_stat_buf != NULL);
 
-    char *host_path = MINIXCompat_Filesystem_CopyHostPathForPath(minix_path);
+    // The file may be one this process is writing.
+
+    MINIXCompat_fdbuffer_SyncWrites();
+
+    minix_statcache_entry_t *cached = MINIXCompat_StatCache_Lookup(minix_path, false);
+    if ((cached != NULL) && MINIXCompat_StatCache_IsFresh(cached->stat_cached_ns)) {
+        MINIXCompat_StatCache_Hits += 1;
+
+        *minix_stat_buf = cached->stat_buf;
+        MINIXCompat_File_StatSwap(minix_stat_buf);
+        return cached->stat_result;
+    }
+
+    minix_host_path_t host_path = MINIXCompat_Filesystem_ResolvePath(minix_path);
 
     struct stat host_stat_buf;
-    int stat_err = stat(host_path, &host_stat_buf);
+    int stat_err = fstatat(host_path.dir_fd, host_path.path, &host_stat_buf, 0);
+    if ((stat_err == -1) && MINIXCompat_Filesystem_ReresolvePath(&host_path, minix_path, errno)) {
+        stat_err = fstatat(host_path.dir_fd, host_path.path, &host_stat_buf, 0);
+    }
     if (stat_err == 0) {
         MINIXCompat_File_MINIXStatBufForHostStatBuf(minix_stat_buf, &host_stat_buf);
-
-        // Swap for passing back to MINIX.
-        MINIXCompat_File_StatSwap(minix_stat_buf);
         result = 0;
     } else {
+        memset(minix_stat_buf, 0, sizeof(minix_stat_t));
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     }
 
+    MINIXCompat_Filesystem_FreeResolvedPath(&host_path);
+
+    if ((MINIXCompat_StatCache_TTL != 0) && ((result == 0) || (result == -minix_ENOENT))) {
+        MINIXCompat_StatCache_Misses += 1;
+
+        cached = MINIXCompat_StatCache_Lookup(minix_path, true);
+        if (cached != NULL) {
+            cached->stat_cached_ns = MINIXCompat_StatCache_Now();
+            cached->stat_result = result;
+            cached->stat_buf = *minix_stat_buf;
+        }
+    }
+
+    // Swap for passing back to MINIX.
+    MINIXCompat_File_StatSwap(minix_stat_buf);
+
     return result;
 }
 
@@ -675,6 +2046,16 @@ int16_t MINIXCompat_File_StatOpen(minix_fd_t minix_fd, minix_stat_t * _Nonnull m
 
     int host_fd = MINIXCompat_fd_GetHostDescriptor(minix_fd);
 
+    // The size and modification time have to reflect everything written so far.
+
+    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+    if ((entry->buffer != NULL) && (entry->buffer->mode == minix_fdbuffer_mode_writing)) {
+        int16_t sync_result = MINIXCompat_fdbuffer_Sync(entry);
+        if (sync_result < 0) {
+            return sync_result;
+        }
+    }
+
     struct stat host_stat_buf;
     int stat_err = fstat(host_fd, &host_stat_buf);
     if (stat_err == 0) {
@@ -696,16 +2077,22 @@ int16_t MINIXCompat_File_Unlink(const char *minix_path)
 
     assert(minix_path != NULL);
 
-    char *host_path = MINIXCompat_Filesystem_CopyHostPathForPath(minix_path);
+    MINIXCompat_StatCache_Invalidate(minix_path);
+    MINIXCompat_DirCache_Invalidate(minix_path);
 
-    int unlink_err = unlink(host_path);
+    minix_host_path_t host_path = MINIXCompat_Filesystem_ResolvePath(minix_path);
+
+    int unlink_err = unlinkat(host_path.dir_fd, host_path.path, 0);
+    if ((unlink_err == -1) && MINIXCompat_Filesystem_ReresolvePath(&host_path, minix_path, errno)) {
+        unlink_err = unlinkat(host_path.dir_fd, host_path.path, 0);
+    }
     if (unlink_err == 0) {
         result = 0;
     } else {
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     }
 
-    free(host_path);
+    MINIXCompat_Filesystem_FreeResolvedPath(&host_path);
 
     return result;
 }
@@ -716,17 +2103,44 @@ minix_fd_t MINIXCompat_File_Access(const char *minix_path, minix_mode_t minix_mo
 
     assert(minix_path != NULL);
 
-    char *host_path = MINIXCompat_Filesystem_CopyHostPathForPath(minix_path);
+    // A cached stat(2) that found nothing answers access(2) for any mode too.
+
+    const size_t access_index = minix_mode & 07;
+    minix_statcache_entry_t *cached = MINIXCompat_StatCache_Lookup(minix_path, false);
+    if (cached != NULL) {
+        if (MINIXCompat_StatCache_IsFresh(cached->access_cached_ns[access_index])) {
+            MINIXCompat_StatCache_Hits += 1;
+            return cached->access_results[access_index];
+        } else if (MINIXCompat_StatCache_IsFresh(cached->stat_cached_ns) && (cached->stat_result == -minix_ENOENT)) {
+            MINIXCompat_StatCache_Hits += 1;
+            return -minix_ENOENT;
+        }
+    }
+
+    minix_host_path_t host_path = MINIXCompat_Filesystem_ResolvePath(minix_path);
     mode_t host_mode = MINIXCompat_File_HostOpenModeForMINIXOpenMode(minix_mode);
 
-    int access_err = access(host_path, host_mode);
+    int access_err = faccessat(host_path.dir_fd, host_path.path, host_mode, 0);
+    if ((access_err == -1) && MINIXCompat_Filesystem_ReresolvePath(&host_path, minix_path, errno)) {
+        access_err = faccessat(host_path.dir_fd, host_path.path, host_mode, 0);
+    }
     if (access_err == -1) {
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     } else {
         result = 0;
     }
 
-    free(host_path);
+    MINIXCompat_Filesystem_FreeResolvedPath(&host_path);
+
+    if ((MINIXCompat_StatCache_TTL != 0) && ((result == 0) || (result == -minix_ENOENT))) {
+        MINIXCompat_StatCache_Misses += 1;
+
+        cached = MINIXCompat_StatCache_Lookup(minix_path, true);
+        if (cached != NULL) {
+            cached->access_cached_ns[access_index] = MINIXCompat_StatCache_Now();
+            cached->access_results[access_index] = result;
+        }
+    }
 
     return result;
 }
@@ -734,141 +2148,284 @@ minix_fd_t MINIXCompat_File_Access(const char *minix_path, minix_mode_t minix_mo
 
 // MARK: - Directories
 
-/*! Pre-cache a directory for reading. */
-static int16_t MINIXCompat_Dir_Precache(const char * _Nullable host_path, minix_fd_t minix_fd)
+/*! The key of a directory image, as of the host `stat(2)` \a sbuf. */
+static void MINIXCompat_DirImage_KeyForStat(minix_dirimage_t * _Nonnull image, const struct stat * _Nonnull sbuf)
 {
-    // Open the directory for iteration.
+    image->dev = sbuf->st_dev;
+    image->ino = sbuf->st_ino;
+    image->mtime_sec = (int64_t) sbuf->st_mtime;
+    image->mtime_nsec = (int64_t) MINIXCOMPAT_ST_MTIME_NSEC(sbuf);
+}
 
-    DIR *dir = opendir(host_path);
-    if (dir == NULL) {
+/*! Take a reference to \a image. */
+static minix_dirimage_t * _Nonnull MINIXCompat_DirImage_Retain(minix_dirimage_t * _Nonnull image)
+{
+    image->refcount += 1;
+    return image;
+}
+
+/*! Give up a reference to \a image, freeing it if that was the last one. */
+static void MINIXCompat_DirImage_Release(minix_dirimage_t * _Nullable image)
+{
+    if (image == NULL) {
+        return;
+    }
+
+    assert(image->refcount > 0);
+    image->refcount -= 1;
+    if (image->refcount > 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < image->block_count; i++) {
+        free(image->blocks[i]);
+    }
+    free(image->blocks);
+
+    if (image->dir != NULL) {
+        closedir(image->dir);
+    }
+
+    free(image);
+}
+
+/*!
+ Get the image of the directory open on \a host_fd, whose host `stat(2)` is \a sbuf, sharing an existing one if the directory hasn't changed since it was made.
+
+ - Returns: `0` and a reference to the image in \a out_image, or `-errno` if the directory couldn't be opened for iteration.
+ */
+static int16_t MINIXCompat_DirImage_Get(int host_fd, const struct stat * _Nonnull sbuf, minix_dirimage_t * _Nullable * _Nonnull out_image)
+{
+    minix_dirimage_t key;
+    MINIXCompat_DirImage_KeyForStat(&key, sbuf);
+
+    for (size_t i = 0; i < MINIXCompat_DirImage_Count; i++) {
+        minix_dirimage_t *image = MINIXCompat_DirImages[i];
+        if ((image != NULL)
+            && (image->dev == key.dev) && (image->ino == key.ino)
+            && (image->mtime_sec == key.mtime_sec) && (image->mtime_nsec == key.mtime_nsec))
+        {
+            *out_image = MINIXCompat_DirImage_Retain(image);
+            return 0;
+        }
+    }
+
+    // Iterate via a separate open of the directory, so nothing else shares its offset.
+
+    int dir_fd = openat(host_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
         return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     }
 
-    // Create a minix_dirent_t for every corresponding struct dirent, resizing our table as needed.
+    DIR *dir = fdopendir(dir_fd);
+    if (dir == NULL) {
+        int host_errno = errno;
+        (void) close(dir_fd);
+        return -MINIXCompat_Errors_MINIXErrorForHostError(host_errno);
+    }
+
+    minix_dirimage_t *image = calloc(1, sizeof(minix_dirimage_t));
+    assert(image != NULL);
+
+    MINIXCompat_DirImage_KeyForStat(image, sbuf);
+    image->dir = dir;
+    image->dir_pid = getpid();
+
+    // The cache holds a reference too, and replaces its oldest image.
+
+    minix_dirimage_t **slot = &MINIXCompat_DirImages[MINIXCompat_DirImage_Next];
+    MINIXCompat_DirImage_Next = (MINIXCompat_DirImage_Next + 1) % MINIXCompat_DirImage_Count;
+
+    MINIXCompat_DirImage_Release(*slot);
+    *slot = MINIXCompat_DirImage_Retain(image);
+
+    *out_image = MINIXCompat_DirImage_Retain(image);
+    return 0;
+}
+
+/*!
+ Generate the next block of \a image from the host directory.
+
+ - Returns: `0` on success, including when the directory turns out to have no more entries, or `-errno`.
+ */
+static int16_t MINIXCompat_DirImage_GenerateBlock(minix_dirimage_t * _Nonnull image)
+{
+    assert(!image->complete);
+
+    // A host fork(2) child shares the directory's offset with its parent, so it continues from the same place in its own open of the directory.
 
-    bool done_reading = false;
-    size_t entry_count = 0;
-    size_t dircache_count = 32; // start at 32 since most directories have fewer entries, and 32 are one MINIX block
+    if (image->dir_pid != getpid()) {
+        int dir_fd = openat(dirfd(image->dir), ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd == -1) {
+            return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+        }
+
+        DIR *dir = fdopendir(dir_fd);
+        if (dir == NULL) {
+            int host_errno = errno;
+            (void) close(dir_fd);
+            return -MINIXCompat_Errors_MINIXErrorForHostError(host_errno);
+        }
+
+        closedir(image->dir);
+        image->dir = dir;
+        image->dir_pid = getpid();
+
+        for (size_t i = 0; i < image->dir_position; i++) {
+            if (readdir(image->dir) == NULL) break;
+        }
+    }
 
-    minix_dirent_t *dircache = calloc(dircache_count, sizeof(minix_dirent_t));
+    minix_dirent_t *block = calloc(MINIXCompat_Dir_BlockEntries, sizeof(minix_dirent_t));
+    assert(block != NULL);
 
-    do {
+    size_t block_entries = 0;
+    while (block_entries < MINIXCompat_Dir_BlockEntries) {
         errno = 0;  // errno will be unchanged for end-of-directory
-        struct dirent *entry = readdir(dir);
+        struct dirent *entry = readdir(image->dir);
         if (entry == NULL) {
             int host_errno = errno;
-            if (host_errno != 0) { // errno is unchanged for end-of-directory
+            if (host_errno != 0) {
+                free(block);
                 return -MINIXCompat_Errors_MINIXErrorForHostError(host_errno);
-            } else {
-                // Read has finished successfully. Close the directory.
-                closedir(dir);
-                dir = NULL;
             }
-            done_reading = true;
-        } else {
-            // Expand the cache if needed.
 
-            if (entry_count >= dircache_count) {
-                // Always increase size by one block's worth so it doesn't grow too quickly.
-                size_t new_dircache_count = (dircache_count + 32);
-                dircache = realloc(dircache, new_dircache_count * sizeof(minix_dirent_t));
+            // Read has finished successfully, so nothing more needs the directory.
 
-                // Zero-fill new entries.
-                memset(&dircache[dircache_count], 0, 32);
+            closedir(image->dir);
+            image->dir = NULL;
+            image->complete = true;
+            break;
+        }
 
-                // Update number of available entries.
-                dircache_count = new_dircache_count;
-            }
+        image->dir_position += 1;
 
-            // MINIX just wants inode and 14-character name.
+        // MINIX just wants inode and 14-character name.
 
-            dircache[entry_count].d_ino = htons(MINIXCompat_File_MINIXInodeForHostInode(entry->d_ino));
-            strncpy(dircache[entry_count].d_name, entry->d_name, 14);
+        block[block_entries].d_ino = htons(MINIXCompat_File_MINIXInodeForHostInode(entry->d_ino));
+        strncpy(block[block_entries].d_name, entry->d_name, 14);
 
-            entry_count += 1;
-        }
-    } while (!done_reading);
+        block_entries += 1;
+    }
+
+    if (block_entries == 0) {
+        free(block);
+        return 0;
+    }
+
+    // Add the block, growing the list of blocks geometrically.
 
-    // Save the MINIX directory entries in the descriptor map.
+    if (image->block_count == image->block_capacity) {
+        image->block_capacity = (image->block_capacity > 0) ? (image->block_capacity * 2) : 4;
+        image->blocks = realloc(image->blocks, image->block_capacity * sizeof(minix_dirent_t *));
+        assert(image->blocks != NULL);
+    }
 
-    MINIXCompat_fd_table[minix_fd].dir_entries = dircache;
-    MINIXCompat_fd_table[minix_fd].dir_count = dircache_count;
-    MINIXCompat_fd_table[minix_fd].dir_offset = 0;
+    image->blocks[image->block_count] = block;
+    image->block_count += 1;
 
     return 0;
 }
 
-/*! A version of `stat(2)` that handles `EINTR` and returns `-errno` instead of just `-1` on error. */
-static int stat_without_EINTR(const char * _Nonnull path, struct stat * _Nonnull sbuf)
+/*!
+ Generate \a image through the block containing byte offset \a offset, or completely if \a offset is `-1`.
+
+ - Returns: `0` on success, even if the directory isn't that long, or `-errno`.
+ */
+static int16_t MINIXCompat_DirImage_GenerateThrough(minix_dirimage_t * _Nonnull image, minix_off_t offset)
 {
-    int result;
-    bool stat_done = false;
+    const size_t block_size = MINIXCompat_Dir_BlockEntries * sizeof(minix_dirent_t);
 
-    do {
-        result = stat(path, sbuf);
-        if (result == -1) {
-            if (errno != EINTR) {
-                result = -EINTR;
-                stat_done = true;
-            } else {
-                // Just loop until success or a real failure. Thanks, UNIX.
-            }
-        } else {
-            stat_done = true;
+    while (!image->complete && ((offset < 0) || ((size_t) offset >= (image->block_count * block_size)))) {
+        int16_t generate_result = MINIXCompat_DirImage_GenerateBlock(image);
+        if (generate_result < 0) {
+            return generate_result;
         }
-    } while (!stat_done);
+    }
 
-    return result;
+    return 0;
+}
+
+/*! The size of what's been generated of \a image, in bytes; this is only the size of the whole directory once it's complete. */
+static minix_off_t MINIXCompat_DirImage_Size(const minix_dirimage_t * _Nonnull image)
+{
+    return (minix_off_t) (image->block_count * MINIXCompat_Dir_BlockEntries * sizeof(minix_dirent_t));
 }
 
-static int16_t MINIXCompat_Dir_CheckIfDirAndCache(const char * _Nonnull host_path, minix_fd_t minix_fd)
+static int16_t MINIXCompat_Dir_CheckIfDirAndCache(int host_fd, minix_fd_t minix_fd)
 {
     int16_t result;
 
     bool is_directory;
     struct stat sbuf;
-    int stat_result = stat_without_EINTR(host_path, &sbuf);
+    int stat_result = fstat(host_fd, &sbuf);
     if (stat_result == 0) {
         // Indicate whether the fd corresponds to a directory.
         is_directory = S_ISDIR(sbuf.st_mode);
-        MINIXCompat_fd_table[minix_fd].f_type = is_directory ? f_directory : f_file;
+        MINIXCompat_fd_table[minix_fd].f_type = is_directory ? f_directory : S_ISFIFO(sbuf.st_mode) ? f_pipe : f_file;
+        MINIXCompat_fd_table[minix_fd].bufferable = S_ISREG(sbuf.st_mode) && (MINIXCompat_fd_BufferSize > 0);
+        MINIXCompat_fd_table[minix_fd].host_dev = sbuf.st_dev;
+        MINIXCompat_fd_table[minix_fd].host_ino = sbuf.st_ino;
         result = 0;
     } else {
         is_directory = false;
-        result = MINIXCompat_Errors_MINIXErrorForHostError(-stat_result);
+        result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     }
 
-    // If that was successful, and the file is a directory, also pre-cache its entries at open(2) time.
+    // If that was successful, and the file is a directory, also get its image at open(2) time, though its entries are only generated as they're read.
     // NOTE: Since we're in the middle of opening, don't use IsOpen, IsDirectory, etc.
 
     if ((result == 0) && is_directory) {
-        // If the fd is a directory, pre-cache its entries, failing the open if that fails.
-        int16_t precache_result = MINIXCompat_Dir_Precache(host_path, minix_fd);
-        result = precache_result;
+        minix_dirimage_t *image = NULL;
+        result = MINIXCompat_DirImage_Get(host_fd, &sbuf, &image);
+        if (result == 0) {
+            MINIXCompat_fd_table[minix_fd].dir_image = image;
+            MINIXCompat_fd_table[minix_fd].dir_offset = 0;
+        }
     }
 
     return result;
 }
 
-/*! Read and return many entries from the directory into \a host_buf as are appropriate for \a host_buf_size. */
-static int16_t MINIXCompat_Dir_Read(minix_fd_t minix_fd, void *host_buf, int16_t host_buf_size)
+/*! Read and return as many entries from the directory into \a minix_buf as are appropriate for \a minix_buf_size, or `0` at its end. */
+static int16_t MINIXCompat_Dir_Read(minix_fd_t minix_fd, m68k_address_t minix_buf, int16_t minix_buf_size)
 {
-    int16_t result;
     minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+    minix_dirimage_t *image = entry->dir_image;
+    assert(image != NULL);
+
+    if (minix_buf_size == 0) {
+        return 0;
+    }
+
+    int16_t generate_result = MINIXCompat_DirImage_GenerateThrough(image, entry->dir_offset + minix_buf_size - 1);
+    if (generate_result < 0) {
+        return generate_result;
+    }
 
-    const minix_off_t max_off_plus_one = entry->dir_count * sizeof(minix_dirent_t);
-    const minix_off_t cur_off = entry->dir_offset;
+    // The entries are synthesized on the host, so copy them into emulated RAM directly from the image, a block at a time.
 
-    if ((cur_off + host_buf_size) <= max_off_plus_one) {
-        uint8_t *raw_dir_entries = (uint8_t *)entry->dir_entries;
-        memcpy(host_buf, raw_dir_entries + cur_off, host_buf_size);
-        entry->dir_offset += host_buf_size;
-        result = host_buf_size;
-    } else {
-        result = MINIXCompat_Errors_MINIXErrorForHostError(EIO);
+    const size_t block_size = MINIXCompat_Dir_BlockEntries * sizeof(minix_dirent_t);
+    const minix_off_t image_size = MINIXCompat_DirImage_Size(image);
+
+    int16_t copied = 0;
+    while ((copied < minix_buf_size) && (entry->dir_offset < image_size)) {
+        const size_t block_index = (size_t) entry->dir_offset / block_size;
+        const size_t block_offset = (size_t) entry->dir_offset % block_size;
+
+        size_t chunk = block_size - block_offset;
+        if (chunk > (size_t) (minix_buf_size - copied)) {
+            chunk = (size_t) (minix_buf_size - copied);
+        }
+
+        uint8_t *raw_block = (uint8_t *) image->blocks[block_index];
+        MINIXCompat_RAM_Copy_Block_From_Host(minix_buf + copied, raw_block + block_offset, (uint32_t) chunk);
+
+        entry->dir_offset += (minix_off_t) chunk;
+        copied += (int16_t) chunk;
     }
 
-    return result;
+    return copied;
 }
 
 /*! Seek within a directory. */
@@ -881,14 +2438,14 @@ static int16_t MINIXCompat_Dir_Seek(minix_fd_t minix_fd, minix_off_t minix_offse
     assert(MINIXCompat_fd_IsDirectory(minix_fd));
 
     minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+    minix_dirimage_t *image = entry->dir_image;
+    assert(image != NULL);
 
-    const minix_off_t min_off = 0;
-    const minix_off_t max_off = entry->dir_count * sizeof(minix_dirent_t) - 1;
     minix_off_t new_off;
 
     switch (minix_whence) {
         case minix_SEEK_SET: {
-            new_off = min_off + minix_offset;
+            new_off = minix_offset;
         } break;
 
         case minix_SEEK_CUR: {
@@ -896,11 +2453,26 @@ static int16_t MINIXCompat_Dir_Seek(minix_fd_t minix_fd, minix_off_t minix_offse
         } break;
 
         case minix_SEEK_END: {
-            new_off = max_off + minix_offset;
+            // Only a complete image knows where the end is.
+
+            int16_t generate_result = MINIXCompat_DirImage_GenerateThrough(image, -1);
+            if (generate_result < 0) {
+                return generate_result;
+            }
+            new_off = MINIXCompat_DirImage_Size(image) + minix_offset;
         } break;
+
+        default: {
+            return -minix_EINVAL;
+        }
     }
 
-    if ((new_off < 0) || (new_off > max_off)) {
+    // Seeking up to the end is fine, but not past it or before the start.
+
+    int16_t generate_result = (new_off > 0) ? MINIXCompat_DirImage_GenerateThrough(image, new_off - 1) : 0;
+    if (generate_result < 0) {
+        result = generate_result;
+    } else if ((new_off < 0) || (new_off > MINIXCompat_DirImage_Size(image))) {
         result = -minix_EINVAL;
     } else {
         entry->dir_offset = new_off;
@@ -910,5 +2482,4 @@ static int16_t MINIXCompat_Dir_Seek(minix_fd_t minix_fd, minix_off_t minix_offse
     return result;
 }
 
-
 MINIXCOMPAT_SOURCE_END
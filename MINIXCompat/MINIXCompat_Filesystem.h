@@ -9,12 +9,17 @@
 #ifndef MINIXCompat_Filesystem_h
 #define MINIXCompat_Filesystem_h
 
+#include <stdbool.h>
+
 #include "MINIXCompat_Types.h"
 
 
 MINIXCOMPAT_HEADER_BEGIN
 
 
+/*! Default directory of MINIX installation, used when `MINIXCOMPAT_DIR` isn't set. */
+MINIXCOMPAT_EXTERN const char * const MINIXCOMPAT_DIR_default;
+
 /*! Initialize the "filesystem" subsystem. */
 MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_Initialize(void);
 
@@ -33,6 +38,41 @@ MINIXCOMPAT_EXTERN const char *MINIXCompat_Filesystem_CopyWorkingDirectory(void)
 /*! Set the current MINIX working directory. */
 MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_SetWorkingDirectory(const char *mwd);
 
+/*! Reset the current MINIX working directory from `MINIXCOMPAT_PWD` or the host working directory, just as at initialization. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_ResetWorkingDirectory(void);
+
+/*!
+ Write out everything buffered for the running process's open files and give back anything read ahead, such as when it exits or executes a new program.
+
+ Reads and writes of regular files the process opened itself are only buffered if `MINIXCOMPAT_FD_BUFFER` gives the size of the buffer to use for each, in bytes.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_Flush(void);
+
+/*! Get the running process's open files ready for it to fork, after which it shares their offsets with its child so neither can buffer them. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_Fork_Prepare(void);
+
+
+/*! The open files and working directory of a MINIX process that isn't running, for the in-process scheduler. */
+typedef struct MINIXCompat_Filesystem_Context MINIXCompat_Filesystem_Context_t;
+
+/*! Create a context for the child of a `fork(2)` by the running process, with duplicates of its open files and a copy of its working directory. */
+MINIXCOMPAT_EXTERN MINIXCompat_Filesystem_Context_t * _Nonnull MINIXCompat_Filesystem_Context_Fork(void);
+
+/*! Switch the running process out, moving its open files and working directory into a new context. */
+MINIXCOMPAT_EXTERN MINIXCompat_Filesystem_Context_t * _Nonnull MINIXCompat_Filesystem_Context_Save(void);
+
+/*! Switch in the process whose open files and working directory are in \a context, which is consumed. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_Context_Restore(MINIXCompat_Filesystem_Context_t * _Nonnull context);
+
+/*! Release \a context, closing the files it holds, such as when its process has exited; anything still buffered for them is dropped, so use ``MINIXCompat_Filesystem_Flush`` first if it should be written. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_Context_Free(MINIXCompat_Filesystem_Context_t * _Nullable context);
+
+/*! Write the working directory and open files to the snapshot \a fd; only standard input, output, and error may be open, since nothing else can be reopened as it was. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Filesystem_Snapshot_Write(int fd);
+
+/*! Restore the working directory and open files from the snapshot \a fd. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Filesystem_Snapshot_Read(int fd);
+
 
 /*! A MINIX file descriptor, which must always be positive; a negative value represents `-errno`. */
 typedef int16_t minix_fd_t;
@@ -124,6 +164,8 @@ MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Create(const char *minix_path, mi
 /*!
  Open the file at the given MINIX relative or absolute path, with the given MINIX flags (and mode, if appropriate).
 
+ If `MINIXCOMPAT_PREFETCH` gives a number of bytes, the host is asked to start reading a regular file opened read-only that's no bigger than that into memory right away, since the tools that do that nearly always read the whole file.
+
  - Returns: A MINIX file descriptor, or `-errno` upon error.
  */
 MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Open(const char *minix_path, int16_t minix_flags, minix_mode_t minix_mode);
@@ -131,13 +173,36 @@ MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Open(const char *minix_path, int1
 /*! Close the file with the given MINIX file descriptor. */
 MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Close(minix_fd_t fd);
 
-/*! Reads the specified amount of data from the given file descriptor into the given host-side buffer. Returns the number of bytes read or `-errno` on error. */
-MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Read(minix_fd_t fd, void * _Nonnull buf, int16_t buf_size);
+/*! Reads the specified amount of data from the given file descriptor directly into the buffer at \a buf in emulated RAM. Returns the number of bytes read or `-errno` on error, including `-EFAULT` if the buffer isn't within the address space. */
+MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Read(minix_fd_t fd, m68k_address_t buf, int16_t buf_size);
 
-MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Write(minix_fd_t fd, void * _Nonnull buf, int16_t buf_size);
+/*! Writes the specified amount of data to the given file descriptor directly from the buffer at \a buf in emulated RAM. Returns the number of bytes written or `-errno` on error, including `-EFAULT` if the buffer isn't within the address space. */
+MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Write(minix_fd_t fd, m68k_address_t buf, int16_t buf_size);
 
 MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Seek(minix_fd_t fd, minix_off_t offset, minix_whence_t minix_whence);
 
+/*!
+ Create a host pipe and open MINIX file descriptors on its ends, in \a out_read_fd and \a out_write_fd.
+
+ - Returns: `0` on success or `-errno` upon error.
+ */
+MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Pipe(minix_fd_t * _Nonnull out_read_fd, minix_fd_t * _Nonnull out_write_fd);
+
+/*!
+ Duplicate the MINIX file descriptor \a fd onto \a fd2, closing whatever that had open, or onto the lowest one available if \a fd2 is `-1`.
+
+ - Returns: The new MINIX file descriptor, or `-errno` upon error.
+ */
+MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Dup(minix_fd_t fd, minix_fd_t fd2);
+
+/*! Whether the given MINIX file descriptor is open on a pipe. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_File_IsPipe(minix_fd_t fd);
+
+/*!
+ Whether a read from (or, if \a for_write, a write of up to `PIPE_BUF` bytes to) the given MINIX file descriptor can be done without blocking, which is always the case unless it's a pipe. If \a wait, block until it can be, and return `true`.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_File_PipeIsReady(minix_fd_t fd, bool for_write, bool wait);
+
 MINIXCOMPAT_EXTERN void MINIXCompat_File_StatSwap(minix_stat_t * _Nonnull minix_stat_buf);
 
 MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Stat(const char * _Nonnull minix_path, minix_stat_t * _Nonnull minix_stat_buf);
@@ -149,6 +214,14 @@ MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Unlink(const char *minix_path);
 MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Access(const char *minix_path, minix_mode_t minix_mode);
 
 
+/*!
+ Get the number of `stat(2)` and `access(2)` calls this process has answered from its cache and had to ask the host about; both are `0` if the cache isn't enabled.
+
+ The cache is enabled by setting `MINIXCOMPAT_STAT_CACHE` to the number of milliseconds a result stays valid, which bounds how long a change made outside this process can go unseen; changes made by this process are seen right away.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Filesystem_GetStatCacheCounters(uint32_t * _Nonnull out_hits, uint32_t * _Nonnull out_misses);
+
+
 MINIXCOMPAT_HEADER_END
 
 
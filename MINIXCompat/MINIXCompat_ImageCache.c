@@ -0,0 +1,450 @@
+//
+//  MINIXCompat_ImageCache.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_ImageCache.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Executable.h"
+#include "MINIXCompat_Utilities.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The directory containing cache files, or `NULL` if the cache is disabled. */
+static const char *MINIXCOMPAT_CACHE_DIR = NULL;
+
+/*! The number of executable loads satisfied by the cache. */
+static uint32_t MINIXCompat_ImageCache_Hits = 0;
+
+/*! The number of executable loads the cache couldn't satisfy. */
+static uint32_t MINIXCompat_ImageCache_Misses = 0;
+
+
+/*! The magic number identifying a cache file, `MXIC`. */
+static const uint32_t minix_image_cache_magic = 0x4d584943;
+
+/*! The version of the cache file format; bump it whenever the format or the relocation performed changes. */
+static const uint32_t minix_image_cache_version = 2;
+
+
+/*!
+ The header of a cache file, in host byte order since cache files are never shared between hosts.
+
+ The header is followed by the `NUL`-terminated host path of the executable, and then by the first `stored_len` bytes of its relocated image. The rest of the image, up to `image_len`, is all zero and isn't stored. The first `text_len` bytes of the image are text that's never written, or `0` if the executable has combined I&D.
+ */
+typedef struct minix_image_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t executable_base;
+    uint32_t path_len;
+    uint64_t dev;
+    uint64_t ino;
+    int64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t ctime_sec;
+    uint32_t image_len;
+    uint32_t stored_len;
+    uint32_t text_len;
+} minix_image_cache_header_t;
+
+
+/*!
+ The trailer of a shared text file, in host byte order.
+
+ A shared text file holds the whole host pages of an executable's text, exactly as they appear in emulated RAM so they can be mapped straight into it, starting at offset `0` so the mapping is page-aligned. It's followed by this trailer and then the `NUL`-terminated host path of the executable, which identify it just like the header of its cache file.
+ */
+typedef struct minix_image_cache_text_trailer {
+    minix_image_cache_header_t header;
+    uint32_t page_size;
+    uint32_t byte_xor;
+} minix_image_cache_text_trailer_t;
+
+
+void MINIXCompat_ImageCache_Initialize(void)
+{
+    const char *cache_dir = getenv("MINIXCOMPAT_CACHE_DIR");
+    if ((cache_dir == NULL) || (cache_dir[0] == '\0')) {
+        return;
+    }
+
+    if (!MINIXCompat_Host_EnsureDirectory(cache_dir)) {
+        return;
+    }
+
+    MINIXCOMPAT_CACHE_DIR = cache_dir;
+}
+
+
+/*! Fill in the key fields of \a header for the executable at \a host_path with status \a host_stat. */
+static void MINIXCompat_ImageCache_InitializeHeader(minix_image_cache_header_t * _Nonnull header, const char * _Nonnull host_path, const struct stat * _Nonnull host_stat)
+{
+    memset(header, 0, sizeof(minix_image_cache_header_t));
+
+    header->magic = minix_image_cache_magic;
+    header->version = minix_image_cache_version;
+    header->executable_base = MINIXCompat_Executable_Base;
+    header->path_len = (uint32_t) strlen(host_path) + 1;
+    header->dev = (uint64_t) host_stat->st_dev;
+    header->ino = (uint64_t) host_stat->st_ino;
+    header->size = (int64_t) host_stat->st_size;
+    header->mtime_sec = (int64_t) host_stat->st_mtime;
+    header->mtime_nsec = (int64_t) MINIXCOMPAT_ST_MTIME_NSEC(host_stat);
+    header->ctime_sec = (int64_t) host_stat->st_ctime;
+}
+
+
+/*! Whether the key fields of two headers match. */
+static bool MINIXCompat_ImageCache_HeaderKeysMatch(const minix_image_cache_header_t * _Nonnull a, const minix_image_cache_header_t * _Nonnull b)
+{
+    return (a->magic == b->magic)
+        && (a->version == b->version)
+        && (a->executable_base == b->executable_base)
+        && (a->path_len == b->path_len)
+        && (a->dev == b->dev)
+        && (a->ino == b->ino)
+        && (a->size == b->size)
+        && (a->mtime_sec == b->mtime_sec)
+        && (a->mtime_nsec == b->mtime_nsec)
+        && (a->ctime_sec == b->ctime_sec);
+}
+
+
+/*!
+ Construct the path of the cache file for the given key, with the extension \a extension, in \a cache_path, which must hold `PATH_MAX` bytes.
+
+ The name is a 64-bit FNV-1a hash of the key fields and host path. Since the full key is also stored in the file and checked on load, a collision just results in a miss.
+
+ - Returns: `true` on success, `false` if the path would be too long.
+ */
+static bool MINIXCompat_ImageCache_GetCachePath(char * _Nonnull cache_path, const minix_image_cache_header_t * _Nonnull header, const char * _Nonnull host_path, const char * _Nonnull extension)
+{
+    uint64_t hash = MINIXCompat_Hash_Bytes(MINIXCOMPAT_HASH_BASIS, header, offsetof(minix_image_cache_header_t, image_len));
+    hash = MINIXCompat_Hash_Bytes(hash, host_path, strlen(host_path));
+
+    int len = snprintf(cache_path, PATH_MAX, "%s/%016llx.%s", MINIXCOMPAT_CACHE_DIR, (unsigned long long) hash, extension);
+    return (len > 0) && (len < PATH_MAX);
+}
+
+
+/*!
+ Work out how the text of the executable identified by \a header, at \a host_path, would be shared: the path of its shared text file in \a text_path, which must hold `PATH_MAX` bytes, the trailer identifying that file in \a trailer, and the whole host pages of emulated RAM the text covers.
+
+ - Returns: `true` if the text covers any whole pages and so can be shared, `false` otherwise.
+ */
+static bool MINIXCompat_ImageCache_GetText(const minix_image_cache_header_t * _Nonnull header, const char * _Nonnull host_path, char * _Nonnull text_path, minix_image_cache_text_trailer_t * _Nonnull trailer, m68k_address_t * _Nonnull out_start, uint32_t * _Nonnull out_len)
+{
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if ((page_size <= 0) || (header->text_len == 0)) {
+        return false;
+    }
+
+    // Only the pages entirely within the text can be shared, since the data that follows it is private to each process.
+
+    const uint32_t page_mask = (uint32_t) page_size - 1;
+    const m68k_address_t start = (MINIXCompat_Executable_Base + page_mask) & ~page_mask;
+    const m68k_address_t end = (MINIXCompat_Executable_Base + header->text_len) & ~page_mask;
+    if (end <= start) {
+        return false;
+    }
+
+    if (!MINIXCompat_ImageCache_GetCachePath(text_path, header, host_path, (MINIXCOMPAT_RAM_BYTE_XOR != 0) ? "stext" : "text")) {
+        return false;
+    }
+
+    memset(trailer, 0, sizeof(minix_image_cache_text_trailer_t));
+    trailer->header = *header;
+    trailer->page_size = (uint32_t) page_size;
+    trailer->byte_xor = MINIXCOMPAT_RAM_BYTE_XOR;
+
+    *out_start = start;
+    *out_len = end - start;
+    return true;
+}
+
+
+/*! Map the shared text file at \a text_path over the \a len bytes of emulated RAM at \a start, if it's the one identified by \a expected for the executable at \a host_path. */
+static bool MINIXCompat_ImageCache_MapText(const char * _Nonnull text_path, const minix_image_cache_text_trailer_t * _Nonnull expected, const char * _Nonnull host_path, m68k_address_t start, uint32_t len)
+{
+    const size_t path_len = expected->header.path_len;
+    if (path_len > PATH_MAX) {
+        return false;
+    }
+
+    int text_fd = open(text_path, O_RDONLY);
+    if (text_fd == -1) {
+        return false;
+    }
+
+    // Validate the trailer and path before mapping anything, since the file may be from a hash collision or built with a different page size or RAM layout.
+
+    bool mapped = false;
+    struct stat text_stat;
+    minix_image_cache_text_trailer_t trailer;
+    char cached_path[PATH_MAX];
+
+    if (   (fstat(text_fd, &text_stat) == 0)
+        && (text_stat.st_size == (off_t)((size_t) len + sizeof(trailer) + path_len))
+        && (pread(text_fd, &trailer, sizeof(trailer), (off_t) len) == (ssize_t) sizeof(trailer))
+        && (pread(text_fd, cached_path, path_len, (off_t)((size_t) len + sizeof(trailer))) == (ssize_t) path_len)
+        && MINIXCompat_ImageCache_HeaderKeysMatch(&trailer.header, &expected->header)
+        && (trailer.header.text_len == expected->header.text_len)
+        && (trailer.page_size == expected->page_size)
+        && (trailer.byte_xor == expected->byte_xor)
+        && (memcmp(cached_path, host_path, path_len) == 0))
+    {
+        mapped = MINIXCompat_RAM_Map_File(text_fd, 0, start, len);
+    }
+
+    close(text_fd);
+    return mapped;
+}
+
+
+/*! Write the \a len bytes of emulated RAM at \a start to a new shared text file at \a text_path identified by \a trailer, for the executable at \a host_path. */
+static bool MINIXCompat_ImageCache_CreateText(const char * _Nonnull text_path, const minix_image_cache_text_trailer_t * _Nonnull trailer, const char * _Nonnull host_path, m68k_address_t start, uint32_t len)
+{
+    const uint8_t *pages = MINIXCompat_RAM_Host_Address(start, len);
+    assert(pages != NULL);
+
+    char temp_path[PATH_MAX];
+    int temp_len = snprintf(temp_path, PATH_MAX, "%s.%ld", text_path, (long) getpid());
+    if ((temp_len <= 0) || (temp_len >= PATH_MAX)) {
+        return false;
+    }
+
+    int temp_fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (temp_fd == -1) {
+        return false;
+    }
+
+    // The pages are written exactly as RAM holds them, swizzled or not, so they can later be mapped without any conversion.
+
+    bool written = MINIXCompat_Host_Write_Bytes(temp_fd, pages, len)
+        && MINIXCompat_Host_Write_Bytes(temp_fd, trailer, sizeof(minix_image_cache_text_trailer_t))
+        && MINIXCompat_Host_Write_Bytes(temp_fd, host_path, trailer->header.path_len);
+
+    if ((close(temp_fd) != 0) || !written || (rename(temp_path, text_path) != 0)) {
+        unlink(temp_path);
+        return false;
+    }
+
+    return true;
+}
+
+
+/*! Share the text of the executable identified by \a header, at \a host_path, which is already in emulated RAM, creating its shared text file from RAM if there isn't one yet. */
+static bool MINIXCompat_ImageCache_ShareLoadedText(const minix_image_cache_header_t * _Nonnull header, const char * _Nonnull host_path)
+{
+    char text_path[PATH_MAX];
+    minix_image_cache_text_trailer_t trailer;
+    m68k_address_t start;
+    uint32_t len;
+
+    if (!MINIXCompat_ImageCache_GetText(header, host_path, text_path, &trailer, &start, &len)) {
+        return false;
+    }
+
+    if (MINIXCompat_ImageCache_MapText(text_path, &trailer, host_path, start, len)) {
+        return true;
+    }
+
+    return MINIXCompat_ImageCache_CreateText(text_path, &trailer, host_path, start, len)
+        && MINIXCompat_ImageCache_MapText(text_path, &trailer, host_path, start, len);
+}
+
+
+bool MINIXCompat_ImageCache_Load(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat)
+{
+    assert(host_path != NULL);
+    assert(host_stat != NULL);
+
+    if (MINIXCOMPAT_CACHE_DIR == NULL) {
+        return false;
+    }
+
+    minix_image_cache_header_t expected;
+    MINIXCompat_ImageCache_InitializeHeader(&expected, host_path, host_stat);
+
+    char cache_path[PATH_MAX];
+    if (!MINIXCompat_ImageCache_GetCachePath(cache_path, &expected, host_path, "img")) {
+        MINIXCompat_ImageCache_Misses += 1;
+        return false;
+    }
+
+    int cache_fd = open(cache_path, O_RDONLY);
+    if (cache_fd == -1) {
+        MINIXCompat_ImageCache_Misses += 1;
+        return false;
+    }
+
+    bool loaded = false;
+    struct stat cache_stat;
+
+    if ((fstat(cache_fd, &cache_stat) == 0) && (cache_stat.st_size >= (off_t) sizeof(minix_image_cache_header_t))) {
+        const size_t cache_len = (size_t) cache_stat.st_size;
+
+        void *mapping = mmap(NULL, cache_len, PROT_READ, MAP_PRIVATE, cache_fd, 0);
+        if (mapping != MAP_FAILED) {
+            const minix_image_cache_header_t *header = mapping;
+            const char *cached_path = (const char *)mapping + sizeof(minix_image_cache_header_t);
+            const uint8_t *cached_image = (const uint8_t *)cached_path + header->path_len;
+
+            // Validate everything before touching emulated RAM, since the file may be stale or from a hash collision.
+
+            const bool valid = MINIXCompat_ImageCache_HeaderKeysMatch(header, &expected)
+                && (header->stored_len <= header->image_len)
+                && (header->text_len <= header->image_len)
+                && (header->image_len <= (MINIXCompat_Executable_Limit - MINIXCompat_Executable_Base))
+                && ((sizeof(minix_image_cache_header_t) + header->path_len + (size_t) header->stored_len) <= cache_len)
+                && (memcmp(cached_path, host_path, header->path_len) == 0);
+
+            if (valid) {
+                // The whole exec is now just a reset of emulated RAM, which leaves the rest of the image zero, and one copy into it.
+
+                MINIXCompat_RAM_Reset();
+                MINIXCompat_RAM_Note_High_Water(MINIXCompat_Executable_Base + header->image_len);
+
+                // If the whole pages of text can be mapped from the shared text file, only what's around them needs to be copied.
+
+                char text_path[PATH_MAX];
+                minix_image_cache_text_trailer_t trailer;
+                m68k_address_t text_start;
+                uint32_t text_len;
+
+                const bool shareable = MINIXCompat_ImageCache_GetText(header, host_path, text_path, &trailer, &text_start, &text_len);
+
+                if (shareable && MINIXCompat_ImageCache_MapText(text_path, &trailer, host_path, text_start, text_len)) {
+                    const uint32_t before_len = text_start - MINIXCompat_Executable_Base;
+                    const uint32_t after_offset = before_len + text_len;
+
+                    MINIXCompat_RAM_Copy_Block_From_Host(MINIXCompat_Executable_Base, (void *)cached_image, (before_len < header->stored_len) ? before_len : header->stored_len);
+                    if (after_offset < header->stored_len) {
+                        MINIXCompat_RAM_Copy_Block_From_Host(MINIXCompat_Executable_Base + after_offset, (void *)(cached_image + after_offset), header->stored_len - after_offset);
+                    }
+                } else {
+                    MINIXCompat_RAM_Copy_Block_From_Host(MINIXCompat_Executable_Base, (void *)cached_image, header->stored_len);
+                    if (shareable) {
+                        (void) MINIXCompat_ImageCache_ShareLoadedText(header, host_path);
+                    }
+                }
+
+                loaded = true;
+            }
+
+            munmap(mapping, cache_len);
+        }
+    }
+
+    close(cache_fd);
+
+    if (loaded) {
+        MINIXCompat_ImageCache_Hits += 1;
+    } else {
+        MINIXCompat_ImageCache_Misses += 1;
+    }
+
+    return loaded;
+}
+
+
+void MINIXCompat_ImageCache_Store(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat, const uint8_t * _Nonnull image, uint32_t image_len, uint32_t text_len)
+{
+    assert(host_path != NULL);
+    assert(host_stat != NULL);
+    assert(image != NULL);
+
+    if (MINIXCOMPAT_CACHE_DIR == NULL) {
+        return;
+    }
+
+    minix_image_cache_header_t header;
+    MINIXCompat_ImageCache_InitializeHeader(&header, host_path, host_stat);
+
+    // The tail of an image is its bss and is all zero, so don't bother storing it.
+
+    uint32_t stored_len = image_len;
+    while ((stored_len > 0) && (image[stored_len - 1] == 0)) {
+        stored_len -= 1;
+    }
+
+    header.image_len = image_len;
+    header.stored_len = stored_len;
+    header.text_len = text_len;
+
+    char cache_path[PATH_MAX];
+    if (!MINIXCompat_ImageCache_GetCachePath(cache_path, &header, host_path, "img")) {
+        return;
+    }
+
+    char temp_path[PATH_MAX];
+    int temp_len = snprintf(temp_path, PATH_MAX, "%s.%ld", cache_path, (long) getpid());
+    if ((temp_len <= 0) || (temp_len >= PATH_MAX)) {
+        return;
+    }
+
+    int temp_fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (temp_fd == -1) {
+        return;
+    }
+
+    bool written = MINIXCompat_Host_Write_Bytes(temp_fd, &header, sizeof(header))
+        && MINIXCompat_Host_Write_Bytes(temp_fd, host_path, header.path_len)
+        && MINIXCompat_Host_Write_Bytes(temp_fd, image, stored_len);
+
+    if ((close(temp_fd) != 0) || !written || (rename(temp_path, cache_path) != 0)) {
+        unlink(temp_path);
+    }
+}
+
+
+bool MINIXCompat_ImageCache_ShareText(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat, uint32_t text_len)
+{
+    assert(host_path != NULL);
+    assert(host_stat != NULL);
+
+    if (MINIXCOMPAT_CACHE_DIR == NULL) {
+        return false;
+    }
+
+    minix_image_cache_header_t header;
+    MINIXCompat_ImageCache_InitializeHeader(&header, host_path, host_stat);
+    header.text_len = text_len;
+
+    return MINIXCompat_ImageCache_ShareLoadedText(&header, host_path);
+}
+
+
+void MINIXCompat_ImageCache_GetCounters(uint32_t * _Nonnull out_hits, uint32_t * _Nonnull out_misses)
+{
+    assert(out_hits != NULL);
+    assert(out_misses != NULL);
+
+    *out_hits = MINIXCompat_ImageCache_Hits;
+    *out_misses = MINIXCompat_ImageCache_Misses;
+}
+
+
+MINIXCOMPAT_SOURCE_END
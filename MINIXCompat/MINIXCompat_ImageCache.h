@@ -0,0 +1,62 @@
+//
+//  MINIXCompat_ImageCache.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_ImageCache_h
+#define MINIXCompat_ImageCache_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Initialize the executable image cache.
+
+ The cache is only enabled if `MINIXCOMPAT_CACHE_DIR` names a host directory, which is created if necessary. Each cache file there holds one fully relocated executable image, keyed by its host path, device, inode, size, and modification and change times, so it can be shared by every MINIXCompat process that uses the same directory, whether in the same process tree or not.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_ImageCache_Initialize(void);
+
+/*!
+ Load the cached image of the executable at \a host_path, whose current status is \a host_stat, into emulated RAM at ``MINIXCompat_Executable_Base``, resetting the rest of emulated RAM first.
+
+ The text of a separate I&D executable is shared as ``MINIXCompat_ImageCache_ShareText`` describes, so its whole pages aren't copied at all.
+
+ - Returns: `true` if a valid cached image was found and loaded, `false` if the executable must be loaded normally.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_ImageCache_Load(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat);
+
+/*!
+ Add the relocated image \a image of \a image_len bytes, the first \a text_len of which are never-written text, loaded from the executable at \a host_path whose status is \a host_stat, to the cache.
+
+ Caching is best-effort: any failure just leaves the cache without the image. Cache files are written under a temporary name and then renamed into place, so concurrent processes never see a partial image.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_ImageCache_Store(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat, const uint8_t * _Nonnull image, uint32_t image_len, uint32_t text_len);
+
+/*!
+ Share the \a text_len bytes of text of the separate I&D executable just loaded into emulated RAM from \a host_path, whose status is \a host_stat, with every other process running it.
+
+ The whole host pages of the text are replaced by a copy-on-write mapping of a shared text file in the cache, written from RAM by whichever process gets there first, so every process running the executable uses the same host memory for them. This only happens when RAM has an anonymous backing.
+
+ - Returns: `true` if the text is now shared, `false` if it stays private to this process.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_ImageCache_ShareText(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat, uint32_t text_len);
+
+/*! Get the number of cache hits and misses this process has seen; both are `0` if the cache isn't enabled. */
+MINIXCOMPAT_EXTERN void MINIXCompat_ImageCache_GetCounters(uint32_t * _Nonnull out_hits, uint32_t * _Nonnull out_misses);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_ImageCache_h */
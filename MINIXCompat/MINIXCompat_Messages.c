@@ -9,106 +9,183 @@
 #include "MINIXCompat_Messages.h"
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
-#include <arpa/inet.h> /* for ntohs et al */
-
 #include "MINIXCompat_Types.h"
-
-#ifndef HTONS
-#define HTONS(x) ((x) = htons(x))
-#define HTONL(x) ((x) = htonl(x))
-#endif
+#include "MINIXCompat_Emulation.h"
 
 MINIXCOMPAT_SOURCE_BEGIN
 
 
-#if defined(__LITTLE_ENDIAN__)
-
-static void MINIXCompat_Message_Swap_header(minix_message_t * _Nonnull msg)
+void MINIXCompat_Message_Clear(minix_message_t * _Nonnull msg)
 {
     assert(msg != NULL);
 
-    HTONS(msg->m_source);
-    HTONS(msg->m_type);
+    memset(msg, 0, sizeof(minix_message_t));
 }
 
-void MINIXCompat_Message_Swap_mess1(minix_message_t * _Nonnull msg)
-{
-    MINIXCompat_Message_Swap_header(msg);
-    HTONS(msg->m1_i1);
-    HTONS(msg->m1_i2);
-    HTONS(msg->m1_i3);
-    HTONL(msg->m1_p1);
-    HTONL(msg->m1_p2);
-    HTONL(msg->m1_p3);
-}
 
-void MINIXCompat_Message_Swap_mess2(minix_message_t * _Nonnull msg)
+// MARK: - Decoding & Encoding
+
+/*! The location and size of one field of a message. */
+typedef struct minix_message_field {
+    uint8_t offset;
+    uint8_t size;
+} minix_message_field_t;
+
+#define MINIX_MESSAGE_FIELD(f) { offsetof(minix_message_t, f), sizeof(((minix_message_t *)0)->f) }
+
+static const minix_message_field_t minix_message_header_fields[] = {
+    MINIX_MESSAGE_FIELD(m_source),
+    MINIX_MESSAGE_FIELD(m_type),
+};
+
+static const minix_message_field_t minix_message_mess1_fields[] = {
+    MINIX_MESSAGE_FIELD(m1_i1),
+    MINIX_MESSAGE_FIELD(m1_i2),
+    MINIX_MESSAGE_FIELD(m1_i3),
+    MINIX_MESSAGE_FIELD(m1_p1),
+    MINIX_MESSAGE_FIELD(m1_p2),
+    MINIX_MESSAGE_FIELD(m1_p3),
+};
+
+static const minix_message_field_t minix_message_mess2_fields[] = {
+    MINIX_MESSAGE_FIELD(m2_i1),
+    MINIX_MESSAGE_FIELD(m2_i2),
+    MINIX_MESSAGE_FIELD(m2_i3),
+    MINIX_MESSAGE_FIELD(m2_l1),
+    MINIX_MESSAGE_FIELD(m2_l2),
+    MINIX_MESSAGE_FIELD(m2_p1),
+};
+
+static const minix_message_field_t minix_message_mess3_fields[] = {
+    MINIX_MESSAGE_FIELD(m3_i1),
+    MINIX_MESSAGE_FIELD(m3_i2),
+    MINIX_MESSAGE_FIELD(m3_p1),
+    MINIX_MESSAGE_FIELD(m3_ca1),
+};
+
+static const minix_message_field_t minix_message_mess4_fields[] = {
+    MINIX_MESSAGE_FIELD(m4_l1),
+    MINIX_MESSAGE_FIELD(m4_l2),
+    MINIX_MESSAGE_FIELD(m4_l3),
+    MINIX_MESSAGE_FIELD(m4_l4),
+};
+
+static const minix_message_field_t minix_message_mess5_fields[] = {
+    MINIX_MESSAGE_FIELD(m5_c1),
+    MINIX_MESSAGE_FIELD(m5_c2),
+    MINIX_MESSAGE_FIELD(m5_i1),
+    MINIX_MESSAGE_FIELD(m5_i2),
+    MINIX_MESSAGE_FIELD(m5_l1),
+    MINIX_MESSAGE_FIELD(m5_l2),
+    MINIX_MESSAGE_FIELD(m5_l3),
+};
+
+static const minix_message_field_t minix_message_mess6_fields[] = {
+    MINIX_MESSAGE_FIELD(m6_i1),
+    MINIX_MESSAGE_FIELD(m6_i2),
+    MINIX_MESSAGE_FIELD(m6_i3),
+    MINIX_MESSAGE_FIELD(m6_l1),
+    MINIX_MESSAGE_FIELD(m6_f1),
+};
+
+#undef MINIX_MESSAGE_FIELD
+
+/*! The fields of each layout, indexed by ``minix_message_layout_t``. */
+static const struct {
+    const minix_message_field_t * _Nullable fields;
+    size_t count;
+} minix_message_layouts[7] = {
+    { NULL, 0 },
+    { minix_message_mess1_fields, sizeof(minix_message_mess1_fields) / sizeof(minix_message_field_t) },
+    { minix_message_mess2_fields, sizeof(minix_message_mess2_fields) / sizeof(minix_message_field_t) },
+    { minix_message_mess3_fields, sizeof(minix_message_mess3_fields) / sizeof(minix_message_field_t) },
+    { minix_message_mess4_fields, sizeof(minix_message_mess4_fields) / sizeof(minix_message_field_t) },
+    { minix_message_mess5_fields, sizeof(minix_message_mess5_fields) / sizeof(minix_message_field_t) },
+    { minix_message_mess6_fields, sizeof(minix_message_mess6_fields) / sizeof(minix_message_field_t) },
+};
+
+static void MINIXCompat_Message_ReadFields(m68k_address_t msg, const minix_message_field_t * _Nullable fields, size_t count, minix_message_t * _Nonnull message)
 {
-    MINIXCompat_Message_Swap_header(msg);
-
-    HTONS(msg->m2_i1);
-    HTONS(msg->m2_i2);
-    HTONS(msg->m2_i3);
-    HTONL(msg->m2_l1);
-    HTONL(msg->m2_l2);
-    HTONL(msg->m2_p1);
+    uint8_t *bytes = (uint8_t *)message;
+
+    for (size_t i = 0; i < count; i++) {
+        const m68k_address_t address = msg + fields[i].offset;
+        uint8_t *field = bytes + fields[i].offset;
+
+        switch (fields[i].size) {
+            case sizeof(uint16_t): {
+                uint16_t value = MINIXCompat_RAM_Read_16(address);
+                memcpy(field, &value, sizeof(value));
+            } break;
+
+            case sizeof(uint32_t): {
+                uint32_t value = MINIXCompat_RAM_Read_32(address);
+                memcpy(field, &value, sizeof(value));
+            } break;
+
+            default: {
+                // Bytes and character arrays need no swapping.
+                MINIXCompat_RAM_Copy_Block_To_Buffer(address, field, fields[i].size);
+            } break;
+        }
+    }
 }
 
-void MINIXCompat_Message_Swap_mess3(minix_message_t * _Nonnull msg)
+static void MINIXCompat_Message_WriteFields(m68k_address_t msg, const minix_message_field_t * _Nullable fields, size_t count, const minix_message_t * _Nonnull message)
 {
-    MINIXCompat_Message_Swap_header(msg);
-
-    HTONS(msg->m3_i1);
-    HTONS(msg->m3_i2);
-    HTONL(msg->m3_p1);
-    // m3_ca1 doesn't need any swapping
+    const uint8_t *bytes = (const uint8_t *)message;
+
+    MINIXCompat_RAM_Note_Block_Write(msg, sizeof(minix_message_t));
+
+    for (size_t i = 0; i < count; i++) {
+        const m68k_address_t address = msg + fields[i].offset;
+        const uint8_t *field = bytes + fields[i].offset;
+
+        switch (fields[i].size) {
+            case sizeof(uint16_t): {
+                uint16_t value;
+                memcpy(&value, field, sizeof(value));
+                MINIXCompat_RAM_Write_16(address, value);
+            } break;
+
+            case sizeof(uint32_t): {
+                uint32_t value;
+                memcpy(&value, field, sizeof(value));
+                MINIXCompat_RAM_Write_32(address, value);
+            } break;
+
+            default: {
+                // Bytes and character arrays need no swapping.
+                MINIXCompat_RAM_Copy_Block_From_Host(address, (void *)field, fields[i].size);
+            } break;
+        }
+    }
 }
 
-void MINIXCompat_Message_Swap_mess4(minix_message_t * _Nonnull msg)
+void MINIXCompat_Message_Read(m68k_address_t msg, minix_message_layout_t layout, minix_message_t * _Nonnull message)
 {
-    MINIXCompat_Message_Swap_header(msg);
+    assert(message != NULL);
+    assert((layout >= minix_message_layout_none) && (layout <= minix_message_layout_mess6));
 
-    HTONL(msg->m4_l1);
-    HTONL(msg->m4_l2);
-    HTONL(msg->m4_l3);
-    HTONL(msg->m4_l4);
-}
+    if (layout == minix_message_layout_none) return;
 
-void MINIXCompat_Message_Swap_mess5(minix_message_t * _Nonnull msg)
-{
-    MINIXCompat_Message_Swap_header(msg);
-
-    // m5_c1 needs no swapping
-    // m5_c2 needs no swapping
-    HTONS(msg->m5_i1);
-    HTONS(msg->m5_i2);
-    HTONL(msg->m5_l1);
-    HTONL(msg->m5_l2);
-    HTONL(msg->m5_l3);
+    MINIXCompat_Message_ReadFields(msg, minix_message_header_fields, 2, message);
+    MINIXCompat_Message_ReadFields(msg, minix_message_layouts[layout].fields, minix_message_layouts[layout].count, message);
 }
 
-void MINIXCompat_Message_Swap_mess6(minix_message_t * _Nonnull msg)
+void MINIXCompat_Message_Write(m68k_address_t msg, minix_message_layout_t layout, const minix_message_t * _Nonnull message)
 {
-    MINIXCompat_Message_Swap_header(msg);
-
-    HTONS(msg->m6_i1);
-    HTONS(msg->m6_i2);
-    HTONS(msg->m6_i3);
-    HTONL(msg->m6_l1);
-    HTONL(msg->m6_f1);
-}
+    assert(message != NULL);
+    assert((layout >= minix_message_layout_none) && (layout <= minix_message_layout_mess6));
 
-#endif
+    if (layout == minix_message_layout_none) return;
 
-
-void MINIXCompat_Message_Clear(minix_message_t * _Nonnull msg)
-{
-    assert(msg != NULL);
-
-    memset(msg, 0, sizeof(minix_message_t));
+    MINIXCompat_Message_WriteFields(msg, minix_message_header_fields, 2, message);
+    MINIXCompat_Message_WriteFields(msg, minix_message_layouts[layout].fields, minix_message_layouts[layout].count, message);
 }
 
 
@@ -51,31 +51,41 @@ struct minix_message {
 typedef struct minix_message minix_message_t;
 
 
-#if defined(__LITTLE_ENDIAN__)
+/*! Clear a message prior to filling it out, to prevent any garbage from being present. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Message_Clear(minix_message_t * _Nonnull msg);
 
-/*! Swap a message's content to host byte order given its type and a pointer to it. */
-#define MINIXCompat_Message_Swap(t,m) MINIXCompat_Message_Swap_##t(m)
 
-/* For little-endian systems each message type has a swap function. */
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Swap_mess1(minix_message_t * _Nonnull msg);
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Swap_mess2(minix_message_t * _Nonnull msg);
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Swap_mess3(minix_message_t * _Nonnull msg);
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Swap_mess4(minix_message_t * _Nonnull msg);
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Swap_mess5(minix_message_t * _Nonnull msg);
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Swap_mess6(minix_message_t * _Nonnull msg);
+/*!
+ Which of the message structures a message uses, so it can be decoded from and encoded to emulated RAM field by field.
+ */
+typedef enum minix_message_layout: int16_t {
+    /*! Nothing at all is transferred, not even the header. */
+    minix_message_layout_none = -1,
 
-#elif defined(__BIG_ENDIAN__)
+    /*! Only the header (`m_source` and `m_type`) is transferred. */
+    minix_message_layout_header = 0,
 
-/*! Swap a message's content to host byte order given its type and a pointer to it. */
-#define MINIXCompat_Message_Swap(t,m) /* Do nothing on big-endian. */
+    minix_message_layout_mess1 = 1,
+    minix_message_layout_mess2 = 2,
+    minix_message_layout_mess3 = 3,
+    minix_message_layout_mess4 = 4,
+    minix_message_layout_mess5 = 5,
+    minix_message_layout_mess6 = 6,
+} minix_message_layout_t;
 
-#else
-#error One of __LITTLE_ENDIAN__ or __BIG_ENDIAN__ must be defined.
-#endif
+/*!
+ Decode the header and the fields of \a layout from the message at \a msg in emulated RAM into \a message, in host byte order.
 
+ Fields not part of \a layout are left untouched, so callers that need them zeroed should clear \a message first.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Message_Read(m68k_address_t msg, minix_message_layout_t layout, minix_message_t * _Nonnull message);
 
-/*! Clear a message prior to filling it out, to prevent any garbage from being present. */
-MINIXCOMPAT_EXTERN void MINIXCompat_Message_Clear(minix_message_t * _Nonnull msg);
+/*!
+ Encode the header and the fields of \a layout from \a message, in host byte order, into the message at \a msg in emulated RAM.
+
+ Only the bytes belonging to those fields are written.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Message_Write(m68k_address_t msg, minix_message_layout_t layout, const minix_message_t * _Nonnull message);
 
 
 /* The following defines provide names for useful members. */
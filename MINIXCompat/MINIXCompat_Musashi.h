@@ -24,6 +24,10 @@
 
 #define M68K_TRAP_HAS_CALLBACK M68K_OPT_ON
 
+/* Use separate immediate and PC-relative reads, so opcode and operand fetches go straight to RAM. */
+
+#define M68K_SEPARATE_READS M68K_OPT_ON
+
 /* Disable PMMU emulation. */
 
 #define M68K_EMULATE_PMMU M68K_OPT_OFF
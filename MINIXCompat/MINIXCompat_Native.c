@@ -0,0 +1,695 @@
+//
+//  MINIXCompat_Native.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Native.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Executable.h"
+#include "MINIXCompat_Predecode.h"
+#include "MINIXCompat_Utilities.h"
+
+#include "m68k.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*!
+ The `TRAP #14` instruction patched over the first word of each routine run natively.
+
+ MINIX doesn't use `TRAP #14` itself, and a trap at an address that isn't patched is left to the CPU.
+ */
+static const uint16_t minix_native_trap_instruction = 0x4E4E;
+
+/*! The most bytes a native routine will handle; anything larger is left to the 68000 code. */
+#define MINIXCOMPAT_NATIVE_BUFFER_SIZE 0x10000
+
+
+/*!
+ The effects of a call to a routine, computed without changing any emulated state so they can either be applied or compared against what the 68000 code does.
+ */
+typedef struct minix_native_effect {
+    /*! Whether the routine returns a value in `d0`, whether that's only a word, and whether only its sign is significant. */
+    bool sets_d0;
+    bool d0_is_word;
+    bool d0_sign_only;
+    uint32_t d0;
+
+    /*! The bytes the routine writes, if any, which are in ``MINIXCompat_Native_Buffer``. */
+    m68k_address_t dst;
+    uint32_t len;
+} minix_native_effect_t;
+
+
+/*!
+ A native implementation of a routine, which computes its effects given the stack pointer \a sp at its entry.
+
+ MINIX's C compiler passes arguments on the stack above the return address, with `int` and `size_t` arguments and results as 16-bit words and pointers as 32-bit longwords, and returns results in `d0`.
+
+ - Returns: `true` if \a effect was filled in, `false` if the call can't be handled natively and the 68000 code should run instead.
+ */
+typedef bool (*minix_native_impl_t)(m68k_address_t sp, minix_native_effect_t * _Nonnull effect);
+
+
+/*! Scratch space for native routines, since the results of a call must be computed before emulated RAM is touched. */
+static uint8_t MINIXCompat_Native_Buffer[MINIXCOMPAT_NATIVE_BUFFER_SIZE];
+
+
+/*! Whether the \a len bytes at \a a and at \a b overlap. */
+static bool MINIXCompat_Native_Overlaps(m68k_address_t a, m68k_address_t b, uint32_t len)
+{
+    return (len > 0) && (a < (b + len)) && (b < (a + len));
+}
+
+
+/*! Native `memcpy(dst, src, n)`. Overlapping copies are left to the 68000 code, whose behavior for them is what callers actually rely on. */
+static bool MINIXCompat_Native_memcpy(m68k_address_t sp, minix_native_effect_t * _Nonnull effect)
+{
+    const m68k_address_t dst = MINIXCompat_RAM_Read_32(sp + 4);
+    const m68k_address_t src = MINIXCompat_RAM_Read_32(sp + 8);
+    const uint16_t n = MINIXCompat_RAM_Read_16(sp + 12);
+
+    if ((MINIXCompat_RAM_Host_Address(dst, n) == NULL) || (MINIXCompat_RAM_Host_Address(src, n) == NULL)) return false;
+    if (MINIXCompat_Native_Overlaps(dst, src, n)) return false;
+
+    MINIXCompat_RAM_Copy_Block_To_Buffer(src, MINIXCompat_Native_Buffer, n);
+
+    effect->sets_d0 = true;
+    effect->d0 = dst;
+    effect->dst = dst;
+    effect->len = n;
+    return true;
+}
+
+
+/*! Native `bcopy(src, dst, n)`, which returns nothing. */
+static bool MINIXCompat_Native_bcopy(m68k_address_t sp, minix_native_effect_t * _Nonnull effect)
+{
+    const m68k_address_t src = MINIXCompat_RAM_Read_32(sp + 4);
+    const m68k_address_t dst = MINIXCompat_RAM_Read_32(sp + 8);
+    const uint16_t n = MINIXCompat_RAM_Read_16(sp + 12);
+
+    if ((MINIXCompat_RAM_Host_Address(dst, n) == NULL) || (MINIXCompat_RAM_Host_Address(src, n) == NULL)) return false;
+    if (MINIXCompat_Native_Overlaps(dst, src, n)) return false;
+
+    MINIXCompat_RAM_Copy_Block_To_Buffer(src, MINIXCompat_Native_Buffer, n);
+
+    effect->dst = dst;
+    effect->len = n;
+    return true;
+}
+
+
+/*! Native `memset(s, c, n)`. */
+static bool MINIXCompat_Native_memset(m68k_address_t sp, minix_native_effect_t * _Nonnull effect)
+{
+    const m68k_address_t s = MINIXCompat_RAM_Read_32(sp + 4);
+    const uint16_t c = MINIXCompat_RAM_Read_16(sp + 8);
+    const uint16_t n = MINIXCompat_RAM_Read_16(sp + 10);
+
+    if (MINIXCompat_RAM_Host_Address(s, n) == NULL) return false;
+
+    memset(MINIXCompat_Native_Buffer, (uint8_t) c, n);
+
+    effect->sets_d0 = true;
+    effect->d0 = s;
+    effect->dst = s;
+    effect->len = n;
+    return true;
+}
+
+
+/*!
+ Find the length of the string at \a s, not counting its `NUL`.
+
+ - Returns: `true` on success, `false` if it runs off the end of RAM or is too long to handle natively.
+ */
+static bool MINIXCompat_Native_String_Length(m68k_address_t s, uint32_t * _Nonnull out_len)
+{
+    for (uint32_t len = 0; len < (MINIXCOMPAT_NATIVE_BUFFER_SIZE - 1); len++) {
+        if ((s + len) >= MINIXCompat_RAM_Size) return false;
+        if (MINIXCompat_RAM_Read_8(s + len) == 0) {
+            *out_len = len;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*! Native `strlen(s)`. */
+static bool MINIXCompat_Native_strlen(m68k_address_t sp, minix_native_effect_t * _Nonnull effect)
+{
+    const m68k_address_t s = MINIXCompat_RAM_Read_32(sp + 4);
+
+    uint32_t len;
+    if (!MINIXCompat_Native_String_Length(s, &len)) return false;
+
+    effect->sets_d0 = true;
+    effect->d0_is_word = true;
+    effect->d0 = len;
+    return true;
+}
+
+
+/*! Native `strcmp(s1, s2)`, comparing characters as signed just as MINIX's compiler does. */
+static bool MINIXCompat_Native_strcmp(m68k_address_t sp, minix_native_effect_t * _Nonnull effect)
+{
+    const m68k_address_t s1 = MINIXCompat_RAM_Read_32(sp + 4);
+    const m68k_address_t s2 = MINIXCompat_RAM_Read_32(sp + 8);
+
+    for (uint32_t i = 0; i < MINIXCOMPAT_NATIVE_BUFFER_SIZE; i++) {
+        if (((s1 + i) >= MINIXCompat_RAM_Size) || ((s2 + i) >= MINIXCompat_RAM_Size)) return false;
+
+        const int8_t c1 = (int8_t) MINIXCompat_RAM_Read_8(s1 + i);
+        const int8_t c2 = (int8_t) MINIXCompat_RAM_Read_8(s2 + i);
+
+        if ((c1 != c2) || (c1 == 0)) {
+            effect->sets_d0 = true;
+            effect->d0_is_word = true;
+            effect->d0_sign_only = true;
+            effect->d0 = (uint16_t)(int16_t)(c1 - c2);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*! Native `strcpy(dst, src)`. */
+static bool MINIXCompat_Native_strcpy(m68k_address_t sp, minix_native_effect_t * _Nonnull effect)
+{
+    const m68k_address_t dst = MINIXCompat_RAM_Read_32(sp + 4);
+    const m68k_address_t src = MINIXCompat_RAM_Read_32(sp + 8);
+
+    uint32_t len;
+    if (!MINIXCompat_Native_String_Length(src, &len)) return false;
+    len += 1;
+
+    if (MINIXCompat_RAM_Host_Address(dst, len) == NULL) return false;
+    if (MINIXCompat_Native_Overlaps(dst, src, len)) return false;
+
+    MINIXCompat_RAM_Copy_Block_To_Buffer(src, MINIXCompat_Native_Buffer, len);
+
+    effect->sets_d0 = true;
+    effect->d0 = dst;
+    effect->dst = dst;
+    effect->len = len;
+    return true;
+}
+
+
+/*! A routine that can be run natively, and where it's patched in the current executable. */
+typedef struct minix_native_routine {
+    /*! The routine's C name, as used in `MINIXCOMPAT_NATIVE`. */
+    const char *name;
+
+    /*! The routine's symbol, which has the leading underscore added by MINIX's compiler. */
+    const char *symbol;
+
+    minix_native_impl_t impl;
+
+    /*! Whether the routine is enabled; it's disabled again if verification finds a difference. */
+    bool enabled;
+
+    /*! Whether the routine is patched in the current executable, at what entry point, and the first word of its code there. */
+    bool patched;
+    m68k_address_t entry;
+    uint16_t entry_word;
+} minix_native_routine_t;
+
+static minix_native_routine_t minix_native_routines[] = {
+    { "memcpy", "_memcpy", MINIXCompat_Native_memcpy },
+    { "bcopy",  "_bcopy",  MINIXCompat_Native_bcopy  },
+    { "memset", "_memset", MINIXCompat_Native_memset },
+    { "strlen", "_strlen", MINIXCompat_Native_strlen },
+    { "strcmp", "_strcmp", MINIXCompat_Native_strcmp },
+    { "strcpy", "_strcpy", MINIXCompat_Native_strcpy },
+};
+
+#define MINIXCOMPAT_NATIVE_ROUTINES (sizeof(minix_native_routines) / sizeof(minix_native_routines[0]))
+
+
+/*!
+ A call that's running as 68000 code, either because the native routine declined it or to verify the native routine.
+
+ The routine's entry point is unpatched for the duration of the call, and its return address is patched instead, so the return traps back here to put things back.
+ */
+typedef struct minix_native_pending {
+    bool active;
+    minix_native_routine_t *routine;
+
+    m68k_address_t return_address;
+    uint16_t return_word;
+
+    /*! Whether to compare the effects of the 68000 code against \a expected, whose bytes are in \a expected_bytes. */
+    bool verify;
+    minix_native_effect_t expected;
+    uint8_t *expected_bytes;
+} minix_native_pending_t;
+
+/*! The calls running as 68000 code; the routines are all leaves, so there's more room than needed. */
+#define MINIXCOMPAT_NATIVE_PENDING 4
+static minix_native_pending_t minix_native_pending[MINIXCOMPAT_NATIVE_PENDING];
+
+
+/*! Patch the code word at \a address with \a word, making sure no stale predecoded copy of it is run. */
+static void MINIXCompat_Native_Patch(m68k_address_t address, uint16_t word)
+{
+    MINIXCompat_Predecode_Note_Write(address, sizeof(uint16_t));
+    MINIXCompat_RAM_Write_16(address, word);
+}
+
+
+/*! Whether any routine is enabled. */
+static bool MINIXCompat_Native_Enabled = false;
+
+/*! Whether to verify every native call against the 68000 code. */
+static bool MINIXCompat_Native_Verify = false;
+
+
+void MINIXCompat_Native_Initialize(void)
+{
+    const char *native = getenv("MINIXCOMPAT_NATIVE");
+    if ((native == NULL) || (native[0] == '\0')) {
+        return;
+    }
+
+    // Enable each routine named in the list.
+
+    const char *p = native;
+    while (*p != '\0') {
+        const char *comma = strchr(p, ',');
+        const size_t len = (comma != NULL) ? (size_t)(comma - p) : strlen(p);
+
+        bool found = false;
+        for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+            minix_native_routine_t *routine = &minix_native_routines[r];
+            const bool all = (len == 3) && (strncmp(p, "all", 3) == 0);
+            if (all || ((strlen(routine->name) == len) && (strncmp(p, routine->name, len) == 0))) {
+                routine->enabled = true;
+                MINIXCompat_Native_Enabled = true;
+                found = true;
+            }
+        }
+
+        if (!found && (len > 0)) {
+            fprintf(stderr, "MINIXCompat: unknown MINIXCOMPAT_NATIVE routine '%.*s'\n", (int) len, p);
+        }
+
+        p += len;
+        if (*p == ',') p++;
+    }
+
+    const char *verify = getenv("MINIXCOMPAT_NATIVE_VERIFY");
+    MINIXCompat_Native_Verify = (verify != NULL) && (strcmp(verify, "1") == 0);
+}
+
+
+void MINIXCompat_Native_Executable_Loaded(const char * _Nonnull host_path)
+{
+    assert(host_path != NULL);
+
+    if (!MINIXCompat_Native_Enabled) {
+        return;
+    }
+
+    // Everything from the previous executable is gone along with its RAM.
+
+    for (size_t i = 0; i < MINIXCOMPAT_NATIVE_PENDING; i++) {
+        free(minix_native_pending[i].expected_bytes);
+    }
+    memset(minix_native_pending, 0, sizeof(minix_native_pending));
+
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        minix_native_routines[r].patched = false;
+    }
+
+    // Find each enabled routine in the executable's symbol table and patch its entry point.
+
+    int fd = open(host_path, O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+
+    minix_symbol_t *symbols = NULL;
+    size_t symbol_count = 0;
+    (void) MINIXCompat_Executable_Load_Symbols(fd, &symbols, &symbol_count);
+    close(fd);
+
+    for (size_t s = 0; s < symbol_count; s++) {
+        const minix_symbol_t *symbol = &symbols[s];
+        if (((symbol->address & 1) != 0) || (symbol->address >= MINIXCompat_Executable_Limit)) continue;
+
+        for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+            minix_native_routine_t *routine = &minix_native_routines[r];
+            if (!routine->enabled || routine->patched || (strcmp(symbol->name, routine->symbol) != 0)) continue;
+
+            routine->patched = true;
+            routine->entry = symbol->address;
+            routine->entry_word = MINIXCompat_RAM_Read_16(symbol->address);
+            MINIXCompat_Native_Patch(symbol->address, minix_native_trap_instruction);
+        }
+    }
+
+    free(symbols);
+}
+
+
+/*! Return from a routine called with stack pointer \a sp, as its `rts` would. */
+static void MINIXCompat_Native_Return(m68k_address_t sp)
+{
+    m68k_set_reg(M68K_REG_PC, MINIXCompat_RAM_Read_32(sp));
+    m68k_set_reg(M68K_REG_A7, sp + 4);
+}
+
+
+/*! Apply \a effect to emulated state. */
+static void MINIXCompat_Native_Apply(const minix_native_effect_t * _Nonnull effect)
+{
+    if (effect->len > 0) {
+        MINIXCompat_RAM_Copy_Block_From_Host(effect->dst, MINIXCompat_Native_Buffer, effect->len);
+    }
+
+    if (effect->sets_d0) {
+        if (effect->d0_is_word) {
+            const uint32_t d0 = m68k_get_reg(NULL, M68K_REG_D0);
+            m68k_set_reg(M68K_REG_D0, (d0 & 0xFFFF0000) | (effect->d0 & 0x0000FFFF));
+        } else {
+            m68k_set_reg(M68K_REG_D0, effect->d0);
+        }
+    }
+}
+
+
+/*! Compare what the 68000 code did for \a pending against what the native routine would have done, disabling the routine if they differ. */
+static void MINIXCompat_Native_Compare(minix_native_pending_t * _Nonnull pending)
+{
+    const minix_native_effect_t *expected = &pending->expected;
+    minix_native_routine_t *routine = pending->routine;
+
+    bool d0_matches = true;
+    const uint32_t d0 = m68k_get_reg(NULL, M68K_REG_D0);
+
+    if (expected->sets_d0) {
+        if (expected->d0_sign_only) {
+            const int16_t actual = (int16_t)(uint16_t) d0;
+            const int16_t wanted = (int16_t)(uint16_t) expected->d0;
+            d0_matches = ((actual < 0) == (wanted < 0)) && ((actual == 0) == (wanted == 0));
+        } else if (expected->d0_is_word) {
+            d0_matches = ((d0 & 0xFFFF) == (expected->d0 & 0xFFFF));
+        } else {
+            d0_matches = (d0 == expected->d0);
+        }
+    }
+
+    bool bytes_match = true;
+    if (expected->len > 0) {
+        MINIXCompat_RAM_Copy_Block_To_Buffer(expected->dst, MINIXCompat_Native_Buffer, expected->len);
+        bytes_match = (memcmp(MINIXCompat_Native_Buffer, pending->expected_bytes, expected->len) == 0);
+    }
+
+    if (!d0_matches || !bytes_match) {
+        fprintf(stderr, "MINIXCompat: native %s differs from 68000 code (d0 0x%08x, expected 0x%08x; %u bytes at 0x%08x %s), disabling it\n",
+                routine->name, d0, expected->d0, expected->len, expected->dst, bytes_match ? "match" : "differ");
+        routine->enabled = false;
+    }
+}
+
+
+bool MINIXCompat_Native_Trap(void)
+{
+    if (!MINIXCompat_Native_Enabled) {
+        return false;
+    }
+
+    // The PC is just past the trap instruction.
+
+    const m68k_address_t trap_address = m68k_get_reg(NULL, M68K_REG_PC) - 2;
+    const m68k_address_t sp = m68k_get_reg(NULL, M68K_REG_A7);
+
+    // A routine run as 68000 code is returning: put its patches back, and check its results if it's being verified.
+
+    for (size_t i = 0; i < MINIXCOMPAT_NATIVE_PENDING; i++) {
+        minix_native_pending_t *pending = &minix_native_pending[i];
+        if (!pending->active || (pending->return_address != trap_address)) continue;
+
+        MINIXCompat_Native_Patch(pending->return_address, pending->return_word);
+
+        if (pending->verify) {
+            MINIXCompat_Native_Compare(pending);
+        }
+
+        if (pending->routine->enabled) {
+            MINIXCompat_Native_Patch(pending->routine->entry, minix_native_trap_instruction);
+        } else {
+            pending->routine->patched = false;
+        }
+
+        free(pending->expected_bytes);
+        memset(pending, 0, sizeof(minix_native_pending_t));
+
+        m68k_set_reg(M68K_REG_PC, trap_address);
+        return true;
+    }
+
+    // Otherwise it must be a call to a patched routine.
+
+    minix_native_routine_t *routine = NULL;
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        if (minix_native_routines[r].patched && (minix_native_routines[r].entry == trap_address)) {
+            routine = &minix_native_routines[r];
+            break;
+        }
+    }
+    if (routine == NULL) {
+        return false;
+    }
+
+    // A routine disabled while this executable was switched out is still patched here, so just put its code back and run it.
+
+    if (!routine->enabled) {
+        MINIXCompat_Native_Patch(routine->entry, routine->entry_word);
+        routine->patched = false;
+        m68k_set_reg(M68K_REG_PC, routine->entry);
+        return true;
+    }
+
+    minix_native_effect_t effect;
+    memset(&effect, 0, sizeof(effect));
+    const bool handled = routine->impl(sp, &effect);
+
+    minix_native_pending_t *pending = NULL;
+    if (!handled || MINIXCompat_Native_Verify) {
+        for (size_t i = 0; i < MINIXCOMPAT_NATIVE_PENDING; i++) {
+            if (!minix_native_pending[i].active) {
+                pending = &minix_native_pending[i];
+                break;
+            }
+        }
+    }
+
+    if (handled && (pending == NULL)) {
+        // Just run the routine natively.
+
+        MINIXCompat_Native_Apply(&effect);
+        MINIXCompat_Native_Return(sp);
+        return true;
+    }
+
+    if (pending == NULL) {
+        // There's no way to run the 68000 code, which can only happen with nested calls that can't occur for leaf routines.
+
+        return false;
+    }
+
+    // Run the 68000 code by restoring the routine's first word and restarting it, with its return address patched so it traps back when it's done.
+
+    const m68k_address_t return_address = MINIXCompat_RAM_Read_32(sp);
+    if (((return_address & 1) != 0) || (return_address >= MINIXCompat_Executable_Limit)) {
+        if (!handled) return false;
+
+        MINIXCompat_Native_Apply(&effect);
+        MINIXCompat_Native_Return(sp);
+        return true;
+    }
+
+    pending->active = true;
+    pending->routine = routine;
+    pending->return_address = return_address;
+    pending->return_word = MINIXCompat_RAM_Read_16(return_address);
+    pending->verify = handled;
+
+    if (handled) {
+        pending->expected = effect;
+        if (effect.len > 0) {
+            pending->expected_bytes = malloc(effect.len);
+            if (pending->expected_bytes == NULL) {
+                pending->verify = false;
+            } else {
+                memcpy(pending->expected_bytes, MINIXCompat_Native_Buffer, effect.len);
+            }
+        }
+    }
+
+    MINIXCompat_Native_Patch(routine->entry, routine->entry_word);
+    MINIXCompat_Native_Patch(return_address, minix_native_trap_instruction);
+
+    m68k_set_reg(M68K_REG_PC, routine->entry);
+    return true;
+}
+
+
+// MARK: - Process Contexts
+
+/*! Where a routine is patched in one process's executable. */
+typedef struct minix_native_patch {
+    bool patched;
+    m68k_address_t entry;
+    uint16_t entry_word;
+} minix_native_patch_t;
+
+struct MINIXCompat_Native_Context {
+    minix_native_patch_t patches[MINIXCOMPAT_NATIVE_ROUTINES];
+    minix_native_pending_t pending[MINIXCOMPAT_NATIVE_PENDING];
+};
+
+
+MINIXCompat_Native_Context_t *MINIXCompat_Native_Context_Fork(void)
+{
+    MINIXCompat_Native_Context_t *context = calloc(1, sizeof(MINIXCompat_Native_Context_t));
+    assert(context != NULL);
+
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        context->patches[r].patched = minix_native_routines[r].patched;
+        context->patches[r].entry = minix_native_routines[r].entry;
+        context->patches[r].entry_word = minix_native_routines[r].entry_word;
+    }
+
+    memcpy(context->pending, minix_native_pending, sizeof(minix_native_pending));
+
+    for (size_t i = 0; i < MINIXCOMPAT_NATIVE_PENDING; i++) {
+        minix_native_pending_t *pending = &context->pending[i];
+        if (pending->expected_bytes != NULL) {
+            pending->expected_bytes = malloc(pending->expected.len);
+            if (pending->expected_bytes == NULL) {
+                pending->verify = false;
+            } else {
+                memcpy(pending->expected_bytes, minix_native_pending[i].expected_bytes, pending->expected.len);
+            }
+        }
+    }
+
+    return context;
+}
+
+
+MINIXCompat_Native_Context_t *MINIXCompat_Native_Context_Save(void)
+{
+    MINIXCompat_Native_Context_t *context = calloc(1, sizeof(MINIXCompat_Native_Context_t));
+    assert(context != NULL);
+
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        context->patches[r].patched = minix_native_routines[r].patched;
+        context->patches[r].entry = minix_native_routines[r].entry;
+        context->patches[r].entry_word = minix_native_routines[r].entry_word;
+        minix_native_routines[r].patched = false;
+    }
+
+    memcpy(context->pending, minix_native_pending, sizeof(minix_native_pending));
+    memset(minix_native_pending, 0, sizeof(minix_native_pending));
+
+    return context;
+}
+
+
+void MINIXCompat_Native_Context_Restore(MINIXCompat_Native_Context_t *context)
+{
+    assert(context != NULL);
+
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        minix_native_routines[r].patched = context->patches[r].patched;
+        minix_native_routines[r].entry = context->patches[r].entry;
+        minix_native_routines[r].entry_word = context->patches[r].entry_word;
+    }
+
+    memcpy(minix_native_pending, context->pending, sizeof(minix_native_pending));
+
+    free(context);
+}
+
+
+void MINIXCompat_Native_Context_Free(MINIXCompat_Native_Context_t *context)
+{
+    if (context == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < MINIXCOMPAT_NATIVE_PENDING; i++) {
+        free(context->pending[i].expected_bytes);
+    }
+
+    free(context);
+}
+
+
+bool MINIXCompat_Native_Snapshot_Write(int fd)
+{
+    for (size_t i = 0; i < MINIXCOMPAT_NATIVE_PENDING; i++) {
+        if (minix_native_pending[i].active) {
+            return false;
+        }
+    }
+
+    minix_native_patch_t patches[MINIXCOMPAT_NATIVE_ROUTINES];
+    memset(patches, 0, sizeof(patches));
+
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        patches[r].patched = minix_native_routines[r].patched;
+        patches[r].entry = minix_native_routines[r].entry;
+        patches[r].entry_word = minix_native_routines[r].entry_word;
+    }
+
+    return MINIXCompat_Host_Write_Bytes(fd, patches, sizeof(patches));
+}
+
+
+bool MINIXCompat_Native_Snapshot_Read(int fd)
+{
+    minix_native_patch_t patches[MINIXCOMPAT_NATIVE_ROUTINES];
+    if (!MINIXCompat_Host_Read_Bytes(fd, patches, sizeof(patches))) {
+        return false;
+    }
+
+    // A routine that isn't enabled now is unpatched the first time it's called.
+
+    for (size_t r = 0; r < MINIXCOMPAT_NATIVE_ROUTINES; r++) {
+        minix_native_routines[r].patched = patches[r].patched;
+        minix_native_routines[r].entry = patches[r].entry;
+        minix_native_routines[r].entry_word = patches[r].entry_word;
+    }
+
+    memset(minix_native_pending, 0, sizeof(minix_native_pending));
+
+    return true;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,65 @@
+//
+//  MINIXCompat_Native.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Native_h
+#define MINIXCompat_Native_h
+
+#include <stdbool.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Initialize native implementations of MINIX libc routines.
+
+ Native implementations are opt-in per routine: `MINIXCOMPAT_NATIVE` is a comma-separated list of the routines to run natively, from `memcpy`, `bcopy`, `memset`, `strlen`, `strcmp`, and `strcpy`, or `all` for all of them. If `MINIXCOMPAT_NATIVE_VERIFY` is set to `1`, every native call is also run as 68000 code and any difference in results is reported.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Native_Initialize(void);
+
+/*!
+ Patch the entry points of the enabled routines in the executable just loaded into emulated RAM from \a host_path, using its symbol table to find them.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Native_Executable_Loaded(const char * _Nonnull host_path);
+
+/*!
+ Handle a `TRAP #14` instruction, which is how patched entry points reach their native implementations.
+
+ - Returns: `true` if the trap was at a patched address and has been handled, `false` if the CPU should handle it.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Native_Trap(void);
+
+
+/*! Where native routines are patched into the executable of a MINIX process that isn't running, for the in-process scheduler. */
+typedef struct MINIXCompat_Native_Context MINIXCompat_Native_Context_t;
+
+/*! Create a context for the child of a `fork(2)` by the running process, whose RAM has the same patches. */
+MINIXCOMPAT_EXTERN MINIXCompat_Native_Context_t * _Nonnull MINIXCompat_Native_Context_Fork(void);
+
+/*! Switch the running process out, moving its patches into a new context. */
+MINIXCOMPAT_EXTERN MINIXCompat_Native_Context_t * _Nonnull MINIXCompat_Native_Context_Save(void);
+
+/*! Switch in the process whose patches are in \a context, which is consumed. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Native_Context_Restore(MINIXCompat_Native_Context_t * _Nonnull context);
+
+/*! Release \a context, such as when its process has exited. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Native_Context_Free(MINIXCompat_Native_Context_t * _Nullable context);
+
+/*! Write where native routines are patched into the running executable to the snapshot \a fd; no call may be running as 68000 code, since it would have to be run again. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Native_Snapshot_Write(int fd);
+
+/*! Restore where native routines are patched into the running executable from the snapshot \a fd, whose RAM has the patches. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Native_Snapshot_Read(int fd);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Native_h */
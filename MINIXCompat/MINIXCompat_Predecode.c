@@ -0,0 +1,167 @@
+//
+//  MINIXCompat_Predecode.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Predecode.h"
+
+#if MINIXCOMPAT_PREDECODE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+
+#include "m68kcpu.h"
+#include "m68kops.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*!
+ A predecoded instruction: its opcode and the Musashi handler for it, plus a link to the instruction that followed it the last time it ran.
+
+ Following the links lets a basic block that runs again dispatch from one handler to the next without looking anything up, since only a branch or trap changes where the next instruction is.
+ */
+typedef struct minix_predecoded {
+    /*! The address of the instruction, and the cache generation in which it was decoded. */
+    uint32_t pc;
+    uint32_t generation;
+
+    /*! The instruction's opcode and its handler. */
+    uint32_t ir;
+    void (*handler)(void);
+
+    /*! The instruction that followed this one, which is only valid if it's from the same generation and at the address the PC actually reaches. */
+    struct minix_predecoded *next;
+} minix_predecoded_t;
+
+
+/*! The number of predecoded instructions cached, which is a power of two since the cache is direct-mapped on the PC. */
+#define MINIXCOMPAT_PREDECODE_ENTRIES 0x10000
+
+static minix_predecoded_t MINIXCompat_Predecode_Cache[MINIXCOMPAT_PREDECODE_ENTRIES];
+
+/*! The current cache generation; bumping it invalidates everything at once. Generation `0` is never current, so the empty cache is invalid. */
+static uint32_t MINIXCompat_Predecode_Generation = 1;
+
+uint8_t MINIXCompat_Predecode_Code_Pages[(MINIXCompat_RAM_Size >> MINIXCompat_Predecode_Page_Shift)];
+
+
+void MINIXCompat_Predecode_Flush(void)
+{
+    MINIXCompat_Predecode_Generation += 1;
+
+    if (MINIXCompat_Predecode_Generation == 0) {
+        // The generation wrapped, so old entries might look valid again.
+        memset(MINIXCompat_Predecode_Cache, 0, sizeof(MINIXCompat_Predecode_Cache));
+        MINIXCompat_Predecode_Generation = 1;
+    }
+
+    memset(MINIXCompat_Predecode_Code_Pages, 0, sizeof(MINIXCompat_Predecode_Code_Pages));
+}
+
+
+/*! Get the predecoded instruction at the current PC, decoding and caching it if necessary. The PC is left past the opcode either way. */
+static inline minix_predecoded_t *MINIXCompat_Predecode_Lookup(void)
+{
+    const uint32_t pc = REG_PC;
+    minix_predecoded_t *entry = &MINIXCompat_Predecode_Cache[(pc >> 1) & (MINIXCOMPAT_PREDECODE_ENTRIES - 1)];
+
+    if ((entry->pc == pc) && (entry->generation == MINIXCompat_Predecode_Generation)) {
+        REG_PC += 2;
+        return entry;
+    }
+
+    // Decode the instruction exactly as Musashi would, which also takes care of odd PCs and the like.
+
+    const uint32_t ir = m68ki_read_imm_16();
+
+    entry->pc = pc;
+    entry->generation = MINIXCompat_Predecode_Generation;
+    entry->ir = ir;
+    entry->handler = m68ki_instruction_jump_table[ir];
+    entry->next = NULL;
+
+    // Any write to this page, or the next if the instruction's operands extend into it, must now invalidate the cache.
+
+    const uint32_t page = (pc & 0x00FFFFFF) >> MINIXCompat_Predecode_Page_Shift;
+    MINIXCompat_Predecode_Code_Pages[page] = 1;
+    if ((page + 1) < sizeof(MINIXCompat_Predecode_Code_Pages)) {
+        MINIXCompat_Predecode_Code_Pages[page + 1] = 1;
+    }
+
+    return entry;
+}
+
+
+int MINIXCompat_Predecode_Execute(int cycles)
+{
+    // Leave anything unusual, like a pending reset or a stopped CPU, to Musashi itself.
+
+    if (CPU_STOPPED || RESET_CYCLES) {
+        return m68k_execute(cycles);
+    }
+
+    SET_CYCLES(cycles);
+    m68ki_initial_cycles = cycles;
+
+    m68ki_set_address_error_trap(); /* auto-disable (see m68kcpu.h) */
+
+    minix_predecoded_t *entry = NULL;
+
+    // This is Musashi's main loop, except that instructions come from the cache rather than being fetched and looked up each time.
+
+    do {
+        m68ki_trace_t1(); /* auto-disable (see m68kcpu.h) */
+        m68ki_use_data_space(); /* auto-disable (see m68kcpu.h) */
+        m68ki_instr_hook(REG_PC); /* auto-disable (see m68kcpu.h) */
+
+        REG_PPC = REG_PC;
+
+        for (int i = 15; i >= 0; i--) {
+            REG_DA_SAVE[i] = REG_DA[i];
+        }
+
+        // Follow the link from the previous instruction if it still leads here; code writes and flushes invalidate links along with entries.
+
+        minix_predecoded_t *next = (entry != NULL) ? entry->next : NULL;
+        if ((next != NULL) && (next->pc == REG_PC) && (next->generation == MINIXCompat_Predecode_Generation)) {
+            REG_PC += 2;
+        } else {
+            next = MINIXCompat_Predecode_Lookup();
+            if (entry != NULL) {
+                entry->next = next;
+            }
+        }
+        entry = next;
+
+        REG_IR = entry->ir;
+        entry->handler();
+        USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+        m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+
+        // If the handler changed the cache, such as by writing code or loading a new executable in a trap, don't trust the previous entry.
+
+        if (entry->generation != MINIXCompat_Predecode_Generation) {
+            entry = NULL;
+        }
+    } while (GET_CYCLES() > 0);
+
+    REG_PPC = REG_PC;
+
+    return m68ki_initial_cycles - GET_CYCLES();
+}
+
+
+MINIXCOMPAT_SOURCE_END
+
+
+#endif /* MINIXCOMPAT_PREDECODE */
@@ -0,0 +1,98 @@
+//
+//  MINIXCompat_Predecode.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Predecode_h
+#define MINIXCompat_Predecode_h
+
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Whether to execute through a cache of predecoded instructions rather than straight through Musashi's own loop.
+
+ This is off by default since it depends on Musashi's internals rather than just its public interface. Turn it on by defining `MINIXCOMPAT_PREDECODE=1` when building.
+ */
+#ifndef MINIXCOMPAT_PREDECODE
+#define MINIXCOMPAT_PREDECODE 0
+#endif
+
+
+/*! The size of the pages in which writes to code are tracked. */
+#define MINIXCompat_Predecode_Page_Shift 12
+
+
+#if MINIXCOMPAT_PREDECODE
+
+/*! Whether each page of emulated RAM holds any predecoded instruction, so a write there must invalidate the cache. */
+MINIXCOMPAT_EXTERN uint8_t MINIXCompat_Predecode_Code_Pages[];
+
+/*!
+ Invalidate every predecoded instruction, such as when a new executable is loaded or code is written.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Predecode_Flush(void);
+
+/*!
+ Run the emulated CPU for \a cycles using predecoded instructions, just as `m68k_execute` would.
+
+ - Returns: The number of cycles actually run.
+ */
+MINIXCOMPAT_EXTERN int MINIXCompat_Predecode_Execute(int cycles);
+
+/*!
+ Note that \a size bytes at \a m68k_address are about to be written, invalidating the cache if that may change predecoded code.
+
+ Separate I&D executables never write their text, and combined I&D executables rarely write the pages their code is in, so this is almost always just a check.
+ */
+static inline void MINIXCompat_Predecode_Note_Write(m68k_address_t m68k_address, uint32_t size)
+{
+    const uint32_t first_page = (m68k_address & 0x00FFFFFF) >> MINIXCompat_Predecode_Page_Shift;
+    const uint32_t last_page = ((m68k_address + size - 1) & 0x00FFFFFF) >> MINIXCompat_Predecode_Page_Shift;
+
+    if (MINIXCompat_Predecode_Code_Pages[first_page] | MINIXCompat_Predecode_Code_Pages[last_page]) {
+        MINIXCompat_Predecode_Flush();
+    }
+}
+
+/*! Note that \a size bytes at \a m68k_address are about to be written all at once by the host, such as by a read into RAM, checking every page they cover. */
+static inline void MINIXCompat_Predecode_Note_Block_Write(m68k_address_t m68k_address, uint32_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    const uint32_t first_page = (m68k_address & 0x00FFFFFF) >> MINIXCompat_Predecode_Page_Shift;
+    const uint32_t last_page = ((m68k_address + size - 1) & 0x00FFFFFF) >> MINIXCompat_Predecode_Page_Shift;
+
+    for (uint32_t page = first_page; page <= last_page; page++) {
+        if (MINIXCompat_Predecode_Code_Pages[page]) {
+            MINIXCompat_Predecode_Flush();
+            return;
+        }
+    }
+}
+
+#else
+
+static inline void MINIXCompat_Predecode_Flush(void) { }
+
+static inline void MINIXCompat_Predecode_Note_Write(m68k_address_t m68k_address, uint32_t size) { }
+
+static inline void MINIXCompat_Predecode_Note_Block_Write(m68k_address_t m68k_address, uint32_t size) { }
+
+#endif
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Predecode_h */
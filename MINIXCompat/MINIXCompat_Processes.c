@@ -10,15 +10,19 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sysexits.h>
 #include <unistd.h>
 
 #include <arpa/inet.h> /* for ntohs et al */
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 
@@ -28,6 +32,16 @@
 #include "MINIXCompat_Errors.h"
 #include "MINIXCompat_Executable.h"
 #include "MINIXCompat_Filesystem.h"
+#include "MINIXCompat_ImageCache.h"
+#include "MINIXCompat_Native.h"
+#include "MINIXCompat_Predecode.h"
+#include "MINIXCompat_Profile.h"
+#include "MINIXCompat_Replay.h"
+#include "MINIXCompat_Snapshot.h"
+#include "MINIXCompat_Stats.h"
+#include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Trace.h"
+#include "MINIXCompat_Utilities.h"
 
 
 #if DEBUG
@@ -44,27 +58,47 @@
 
 MINIXCOMPAT_SOURCE_BEGIN
 
-/*!
- A mapping between MINIX and host process IDs.
+/*! The number of MINIX process IDs, which MINIX wraps around at. */
+#define MINIXCompat_ProcessTable_PIDs 30000
 
- MINIX uses 16-bit PIDs while the host may use 32-bit or even 64-bit PIDs, so we need to maintain a mapping.
-*/
-typedef struct minix_process_mapping {
-    pid_t host_pid;
-    minix_pid_t minix_pid;
-} minix_process_mapping_t;
+/*! The first MINIX process ID to allocate, and the one to wrap around to; the lower ones belong to the processes MINIX would have started before ours. */
+#define MINIXCompat_ProcessTable_FirstPID 8
+
+/*! The number of slots for looking up MINIX process IDs by host process ID, a power of two with plenty of room for every MINIX process ID. */
+#define MINIXCompat_ProcessTable_HostSlots 65536
+
+/*! The host process ID of a MINIX process ID that's in use, but not by a host process of its own, like one run by the in-process scheduler. */
+#define MINIXCompat_ProcessTable_NoHost ((pid_t) -1)
+
+/*! A host slot that was in use and has slots in use after it, which lookups must probe past but an insertion can reuse. */
+#define MINIXCompat_ProcessTable_Removed UINT64_MAX
 
 /*!
  The table that maps between MINIX and host process IDs.
 
- There are unlikely to be enough entries in the table for search speed to matter, so we just maintain it unordered.
+ MINIX uses 16-bit PIDs while the host may use 32-bit or even 64-bit PIDs, so we need to maintain a mapping. It's in memory shared by every host process running MINIX processes for the same tool, so that they all allocate MINIX process IDs from the same space and see each other's mappings.
 
  Note that MINIX process IDs start at 3, since 0 is MM, 1 is FS, and 2 is init.
  */
-static minix_process_mapping_t *MINIXCompat_ProcessTable = NULL;
+typedef struct minix_process_table {
+    /*! The next MINIX process ID to try to allocate, before wrapping around. */
+    _Atomic uint32_t next_pid;
 
-/*! Maximum number of entries in the MINIX process table. */
-static size_t MINIXCompat_ProcessTable_Size = 0;
+    /*! The host process ID of each MINIX process ID, indexed by it: `0` if it's free, or ``MINIXCompat_ProcessTable_NoHost``. */
+    _Atomic pid_t host_pids[MINIXCompat_ProcessTable_PIDs];
+
+    /*! An open-addressed hash from host process ID to MINIX process ID, each slot holding the former in its upper 32 bits and the latter in its lower 16; `0` if empty or ``MINIXCompat_ProcessTable_Removed``. */
+    _Atomic uint64_t host_slots[MINIXCompat_ProcessTable_HostSlots];
+
+    /*! `1` while a host process is changing ``host_slots``, which lookups can read at any time since a change never breaks a probe sequence another entry is on. */
+    _Atomic uint32_t host_slots_lock;
+} minix_process_table_t;
+
+/*! The process table, shared with every host process forked from this one. */
+static minix_process_table_t *MINIXCompat_ProcessTable = NULL;
+
+/*! The MINIX process this host process was started to run, whose exit status is the host process's. */
+static minix_pid_t MINIXCompat_Processes_HostPID = 0;
 
 
 /*! The MINIX process ID equivalent to the host's. */
@@ -73,9 +107,6 @@ static minix_pid_t minix_self_pid = 0;
 /*! The MINIX parent process ID equivalent to the host's. */
 static minix_pid_t minix_self_ppid = 0;
 
-/*! The next process ID to allocate. */
-static minix_pid_t minix_next_pid = 0;
-
 
 /*! The signal handler table. */
 static minix_sighandler_t minix_signal_handlers[16] = { 0x00000000 /* SIG_DFL */ };
@@ -86,12 +117,213 @@ minix_sighandler_t minix_SIG_IGN = 0x00000001;
 minix_sighandler_t minix_SIG_ERR = 0xFFFFFFFF;
 
 
+/*! The scheduling state of a MINIX process run by the in-process scheduler. */
+typedef enum minix_process_state: int {
+    /*! The process can run. */
+    minix_process_state_runnable = 0,
+
+    /*! The process is in `wait(2)` until one of its children exits. */
+    minix_process_state_waiting,
+
+    /*! The process has exited, but is still running until it's switched out for the last time. */
+    minix_process_state_exiting,
+
+    /*! The process has exited and is only waiting for its parent to collect its status. */
+    minix_process_state_zombie,
+
+    /*! The process was moved to a host process of its own, and is only here for its parent to wait for. */
+    minix_process_state_elsewhere,
+} minix_process_state_t;
+
+/*!
+ A MINIX process run by the in-process scheduler.
+
+ The running process's state is in each subsystem, so its contexts are all `NULL`; every other live process holds its state in its contexts.
+ */
+typedef struct minix_process {
+    minix_pid_t pid;
+    minix_pid_t ppid;
+    minix_process_state_t state;
+
+    /*! The status for the parent's `wait(2)` once the process has exited. */
+    int16_t stat;
+
+    /*! Whether `fork(2)` has yet to return `0` to this child, which it does when the child makes the call again on first running. */
+    bool fork_pending;
+
+    /*! Whether the process was killed while switched out, so it must exit with ``stat`` when it's next switched in. */
+    bool kill_pending;
+
+    /*! The host process running the process, if it was moved elsewhere. */
+    pid_t host_pid;
+
+    minix_sighandler_t signal_handlers[16];
+
+    MINIXCompat_CPU_Context_t *cpu;
+    MINIXCompat_Filesystem_Context_t *files;
+    MINIXCompat_SysCall_Context_t *syscalls;
+    MINIXCompat_Native_Context_t *native;
+    MINIXCompat_Profile_Context_t *profile;
+    MINIXCompat_Stats_Context_t *stats;
+
+    struct minix_process *next;
+} minix_process_t;
+
+/*! Whether MINIX processes are run by the in-process scheduler, as selected by `MINIXCOMPAT_SCHEDULER`. */
+static bool MINIXCompat_Processes_Scheduler = false;
+
+/*! Every process run by the in-process scheduler, in the order in which they take turns. */
+static minix_process_t *MINIXCompat_Processes_List = NULL;
+
+/*! The process run by the in-process scheduler that's running now. */
+static minix_process_t *MINIXCompat_Processes_Current = NULL;
+
+/*! The number of cycles a process may run while others are waiting to, which is about a tenth of a second on an 8MHz 68000. */
+static const int MINIXCompat_Processes_Quantum_Cycles = 0xC0000;
+
+/*! The most host processes, including this one, that processes run by the in-process scheduler may be spread across, as selected by `MINIXCOMPAT_WORKERS`. */
+static long MINIXCompat_Processes_Workers = 1;
+
+
+/*! The first host slot to probe for \a host_pid. */
+static size_t MINIXCompat_ProcessTable_HostSlot(pid_t host_pid)
+{
+    return ((uint32_t) host_pid * 2654435761U) & (MINIXCompat_ProcessTable_HostSlots - 1);
+}
+
+/*! Take the lock that serializes changes to the host slots among every host process sharing the table; lookups don't need it. */
+static void MINIXCompat_ProcessTable_LockHostSlots(void)
+{
+    uint32_t expected = 0;
+    while (!atomic_compare_exchange_weak(&MINIXCompat_ProcessTable->host_slots_lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+/*! Release the lock taken by ``MINIXCompat_ProcessTable_LockHostSlots``. */
+static void MINIXCompat_ProcessTable_UnlockHostSlots(void)
+{
+    atomic_store(&MINIXCompat_ProcessTable->host_slots_lock, 0);
+}
+
+/*!
+ Record that \a host_pid is running \a minix_pid, which must already be allocated or be one of those MINIX would have started before ours.
+
+ - Returns: Whether there was room to record \a host_pid; \a minix_pid is recorded as running somewhere either way.
+ */
+static bool MINIXCompat_ProcessTable_Insert(pid_t host_pid, minix_pid_t minix_pid)
+{
+    assert((minix_pid > 0) && (minix_pid < MINIXCompat_ProcessTable_PIDs));
+
+    atomic_store(&MINIXCompat_ProcessTable->host_pids[minix_pid], host_pid);
+
+    const uint64_t entry = ((uint64_t) (uint32_t) host_pid << 32) | (uint16_t) minix_pid;
+    bool inserted = false;
+
+    MINIXCompat_ProcessTable_LockHostSlots();
+
+    size_t slot = MINIXCompat_ProcessTable_HostSlot(host_pid);
+    for (size_t probes = 0; probes < MINIXCompat_ProcessTable_HostSlots; probes++) {
+        const uint64_t existing = atomic_load(&MINIXCompat_ProcessTable->host_slots[slot]);
+        if ((existing == 0) || (existing == MINIXCompat_ProcessTable_Removed)) {
+            atomic_store(&MINIXCompat_ProcessTable->host_slots[slot], entry);
+            inserted = true;
+            break;
+        }
+        slot = (slot + 1) & (MINIXCompat_ProcessTable_HostSlots - 1);
+    }
+
+    MINIXCompat_ProcessTable_UnlockHostSlots();
+
+    return inserted;
+}
+
+/*! Find the host slot recording \a host_pid, or `-1` if there isn't one. */
+static ssize_t MINIXCompat_ProcessTable_FindHostSlot(pid_t host_pid)
+{
+    size_t slot = MINIXCompat_ProcessTable_HostSlot(host_pid);
+    for (size_t probes = 0; probes < MINIXCompat_ProcessTable_HostSlots; probes++) {
+        const uint64_t entry = atomic_load(&MINIXCompat_ProcessTable->host_slots[slot]);
+        if (entry == 0) {
+            break;
+        }
+        if ((entry != MINIXCompat_ProcessTable_Removed) && ((pid_t) (uint32_t) (entry >> 32) == host_pid)) {
+            return (ssize_t) slot;
+        }
+        slot = (slot + 1) & (MINIXCompat_ProcessTable_HostSlots - 1);
+    }
+
+    return -1;
+}
+
+/*! Forget that \a host_pid is running a MINIX process, though its MINIX process ID stays allocated. */
+static void MINIXCompat_ProcessTable_RemoveHost(pid_t host_pid)
+{
+    MINIXCompat_ProcessTable_LockHostSlots();
+
+    const ssize_t slot = MINIXCompat_ProcessTable_FindHostSlot(host_pid);
+    if (slot != -1) {
+        const uint64_t entry = atomic_load(&MINIXCompat_ProcessTable->host_slots[slot]);
+
+        // No entry past an empty slot can have been probed for through this one, so if the next slot is empty, this one and any removed ones just before it can be emptied too. That keeps removed slots from piling up until every miss probes the whole table.
+
+        const size_t next_slot = ((size_t) slot + 1) & (MINIXCompat_ProcessTable_HostSlots - 1);
+        if (atomic_load(&MINIXCompat_ProcessTable->host_slots[next_slot]) == 0) {
+            size_t empty_slot = (size_t) slot;
+            do {
+                atomic_store(&MINIXCompat_ProcessTable->host_slots[empty_slot], 0);
+                empty_slot = (empty_slot - 1) & (MINIXCompat_ProcessTable_HostSlots - 1);
+            } while (atomic_load(&MINIXCompat_ProcessTable->host_slots[empty_slot]) == MINIXCompat_ProcessTable_Removed);
+        } else {
+            atomic_store(&MINIXCompat_ProcessTable->host_slots[slot], MINIXCompat_ProcessTable_Removed);
+        }
+
+        pid_t expected = host_pid;
+        (void) atomic_compare_exchange_strong(&MINIXCompat_ProcessTable->host_pids[(minix_pid_t) (entry & 0xFFFF)], &expected, MINIXCompat_ProcessTable_NoHost);
+    }
+
+    MINIXCompat_ProcessTable_UnlockHostSlots();
+}
+
+/*! Allocate a MINIX process ID that no other process is using, returning `-1` if they all are. */
+static minix_pid_t MINIXCompat_ProcessTable_Allocate(void)
+{
+    for (size_t tries = 0; tries < MINIXCompat_ProcessTable_PIDs; tries++) {
+        uint32_t candidate = atomic_fetch_add(&MINIXCompat_ProcessTable->next_pid, 1) % MINIXCompat_ProcessTable_PIDs;
+        if (candidate < MINIXCompat_ProcessTable_FirstPID) {
+            continue;
+        }
+
+        pid_t expected = 0;
+        if (atomic_compare_exchange_strong(&MINIXCompat_ProcessTable->host_pids[candidate], &expected, MINIXCompat_ProcessTable_NoHost)) {
+            return (minix_pid_t) candidate;
+        }
+    }
+
+    return -1;
+}
+
+/*! Release \a minix_pid for reuse, along with any host process recorded as running it, once its process has been waited for. */
+static void MINIXCompat_ProcessTable_Release(minix_pid_t minix_pid)
+{
+    const pid_t host_pid = atomic_load(&MINIXCompat_ProcessTable->host_pids[minix_pid]);
+    if ((host_pid != 0) && (host_pid != MINIXCompat_ProcessTable_NoHost)) {
+        MINIXCompat_ProcessTable_RemoveHost(host_pid);
+    }
+
+    atomic_store(&MINIXCompat_ProcessTable->host_pids[minix_pid], 0);
+}
+
 /*! Initialize the processes subsystem. */
 void MINIXCompat_Processes_Initialize(void)
 {
-    // We probably won't need any more than this, since MINIX sets `NR_PROCS` to this value.
-    MINIXCompat_ProcessTable_Size = 32;
-    MINIXCompat_ProcessTable = calloc(MINIXCompat_ProcessTable_Size, sizeof(minix_process_mapping_t));
+    // The table is shared with host processes that are forked later, though if that's not possible each can still manage on its own.
+
+    MINIXCompat_ProcessTable = mmap(NULL, sizeof(minix_process_table_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+    if (MINIXCompat_ProcessTable == MAP_FAILED) {
+        MINIXCompat_ProcessTable = calloc(1, sizeof(minix_process_table_t));
+        assert(MINIXCompat_ProcessTable != NULL);
+    }
 
     pid_t host_self_pid = getpid();
     pid_t host_self_ppid = getppid();
@@ -111,60 +343,68 @@ void MINIXCompat_Processes_Initialize(void)
     const minix_pid_t pseudoparent = 6;
     const minix_pid_t ourselves = 7;
 
-    // An entry for ourselves, first for fastest access by linear search.
-    MINIXCompat_ProcessTable[0].minix_pid = ourselves;
-    MINIXCompat_ProcessTable[0].host_pid = host_self_pid;
+    // An entry for ourselves, in a table that's empty so there's room.
+    (void) MINIXCompat_ProcessTable_Insert(host_self_pid, ourselves);
 
     // An entry for our parent, since it may actually be used by MINIX.
-    MINIXCompat_ProcessTable[1].minix_pid = pseudoparent;
-    MINIXCompat_ProcessTable[1].host_pid = host_self_ppid; // pretending that it's sh
+    (void) MINIXCompat_ProcessTable_Insert(host_self_ppid, pseudoparent); // pretending that it's sh
 
-    minix_next_pid = 8;
-}
+    atomic_store(&MINIXCompat_ProcessTable->next_pid, MINIXCompat_ProcessTable_FirstPID);
 
-/*! Get the MINIX process corresponding to the given host-side process.. */
-static minix_pid_t MINIXCompat_Processes_MINIXProcessForHostProcess(pid_t host_pid)
-{
-    for (size_t i = 0; i < MINIXCompat_ProcessTable_Size; i++) {
-        if (MINIXCompat_ProcessTable[i].host_pid == host_pid) {
-            return MINIXCompat_ProcessTable[i].minix_pid;
+    minix_self_pid = ourselves;
+    minix_self_ppid = pseudoparent;
+    MINIXCompat_Processes_HostPID = ourselves;
+
+    // Under the in-process scheduler, the host process starts out running just the one MINIX process. Recording or replaying system calls needs the processes to take turns the same way every time, so it always uses the scheduler, and keeps them all here.
+
+    const char *scheduler = getenv("MINIXCOMPAT_SCHEDULER");
+    if (((scheduler != NULL) && (strcmp(scheduler, "1") == 0)) || MINIXCompat_Replay_IsActive()) {
+        minix_process_t *process = calloc(1, sizeof(minix_process_t));
+        assert(process != NULL);
+
+        process->pid = ourselves;
+        process->ppid = pseudoparent;
+        process->state = minix_process_state_runnable;
+
+        MINIXCompat_Processes_List = process;
+        MINIXCompat_Processes_Current = process;
+        MINIXCompat_Processes_Scheduler = true;
+
+        const char *workers = getenv("MINIXCOMPAT_WORKERS");
+        if ((workers != NULL) && !MINIXCompat_Replay_IsActive()) {
+            if (strcmp(workers, "all") == 0) {
+                MINIXCompat_Processes_Workers = sysconf(_SC_NPROCESSORS_ONLN);
+            } else {
+                MINIXCompat_Processes_Workers = strtol(workers, NULL, 10);
+            }
+            if (MINIXCompat_Processes_Workers < 1) {
+                MINIXCompat_Processes_Workers = 1;
+            }
         }
     }
-
-    return -1;
 }
 
-/*! Get the host process corresponding to the given MINIX-side process. */
-static pid_t MINIXCompat_Processes_HostProcessForMINIXProcess(minix_pid_t minix_pid)
+/*! Get the MINIX process corresponding to the given host-side process.. */
+static minix_pid_t MINIXCompat_Processes_MINIXProcessForHostProcess(pid_t host_pid)
 {
-    for (size_t i = 0; i < MINIXCompat_ProcessTable_Size; i++) {
-        if (MINIXCompat_ProcessTable[i].minix_pid == minix_pid) {
-            return MINIXCompat_ProcessTable[i].host_pid;
-        }
+    const ssize_t slot = MINIXCompat_ProcessTable_FindHostSlot(host_pid);
+    if (slot == -1) {
+        return -1;
     }
 
-    return -1;
+    return (minix_pid_t) (atomic_load(&MINIXCompat_ProcessTable->host_slots[slot]) & 0xFFFF);
 }
 
-/*! Get the next free entry number in the process table. **/
-static size_t MINIXCompat_Processes_NextFreeTableEntry(void)
+/*! Get the host process corresponding to the given MINIX-side process, or `-1` if it doesn't have one of its own. */
+static pid_t MINIXCompat_Processes_HostProcessForMINIXProcess(minix_pid_t minix_pid)
 {
-    for (size_t i = 2; i < MINIXCompat_ProcessTable_Size; i++) {
-        if (MINIXCompat_ProcessTable[i].host_pid == 0) {
-            return i;
-        }
+    if ((minix_pid <= 0) || (minix_pid >= MINIXCompat_ProcessTable_PIDs)) {
+        return -1;
     }
 
-    // If we got here, there are no free entries. Reallocate the table with half again the size, making sure all the new entries are zeroed, and return the first of the new entries (which will correspond to the size of the old table).
+    const pid_t host_pid = atomic_load(&MINIXCompat_ProcessTable->host_pids[minix_pid]);
 
-    minix_process_mapping_t *old_table = MINIXCompat_ProcessTable;
-    const size_t old_table_size = MINIXCompat_ProcessTable_Size;
-    const size_t new_table_size = old_table_size + (old_table_size/2);
-    const size_t first_new_entry = old_table_size;
-    MINIXCompat_ProcessTable = calloc(new_table_size, sizeof(minix_process_mapping_t));
-    memcpy(MINIXCompat_ProcessTable, old_table, MINIXCompat_ProcessTable_Size * sizeof(minix_process_mapping_t));
-    MINIXCompat_ProcessTable_Size = new_table_size;
-    return first_new_entry;
+    return (host_pid != 0) ? host_pid : -1;
 }
 
 void MINIXCompat_Processes_GetProcessIDs(minix_pid_t * _Nonnull minix_pid, minix_pid_t * _Nonnull minix_ppid)
@@ -172,26 +412,91 @@ void MINIXCompat_Processes_GetProcessIDs(minix_pid_t * _Nonnull minix_pid, minix
     assert(minix_pid != NULL);
     assert(minix_ppid != NULL);
 
-    if ((minix_self_pid == 0) && (minix_self_ppid == 0)) {
-        minix_self_pid = MINIXCompat_ProcessTable[0].minix_pid;
-        minix_self_ppid = MINIXCompat_ProcessTable[1].minix_pid;
-    }
-
     *minix_pid = minix_self_pid;
     *minix_ppid = minix_self_ppid;
 
     return;
 }
 
+/*!
+ Fork the running process under the in-process scheduler, giving the child a copy of everything in each subsystem.
+
+ Nothing about the parent changes, and the child doesn't run until it's scheduled.
+ */
+static minix_pid_t MINIXCompat_Processes_fork_InProcess(void)
+{
+    minix_process_t *current = MINIXCompat_Processes_Current;
+
+    // The child is making its fork call again, this time to get its own result.
+
+    if (current->fork_pending) {
+        current->fork_pending = false;
+        return 0;
+    }
+
+    minix_process_t *child = calloc(1, sizeof(minix_process_t));
+    if (child == NULL) {
+        return -minix_EAGAIN;
+    }
+
+    child->pid = MINIXCompat_ProcessTable_Allocate();
+    if (child->pid == -1) {
+        free(child);
+        return -minix_EAGAIN;
+    }
+
+    child->cpu = MINIXCompat_CPU_Context_Fork();
+    if (child->cpu == NULL) {
+        MINIXCompat_ProcessTable_Release(child->pid);
+        free(child);
+        return -minix_EAGAIN;
+    }
+
+    MINIXCompat_Filesystem_Fork_Prepare();
+    child->files = MINIXCompat_Filesystem_Context_Fork();
+    child->syscalls = MINIXCompat_SysCall_Context_Fork();
+    child->native = MINIXCompat_Native_Context_Fork();
+    child->profile = MINIXCompat_Profile_Context_Fork();
+    child->stats = MINIXCompat_Stats_Context_Fork();
+    memcpy(child->signal_handlers, minix_signal_handlers, sizeof(minix_signal_handlers));
+
+    child->ppid = current->pid;
+    child->state = minix_process_state_runnable;
+    child->fork_pending = true;
+
+    // Give the child the next turn.
+
+    child->next = current->next;
+    current->next = child;
+
+    MINIXCompat_Trace_Fork(child->pid);
+
+    return child->pid;
+}
+
 minix_pid_t MINIXCompat_Processes_fork(void)
 {
     minix_pid_t result;
 
-    // Get a free entry in the process table prior to forking, so that both processes can have a similar table.
-    size_t new_process_entry = MINIXCompat_Processes_NextFreeTableEntry();
+    if (MINIXCompat_Processes_Scheduler) {
+        return MINIXCompat_Processes_fork_InProcess();
+    }
+
+    // Allocate the child's PID before forking, so both parent and child have a coherent view of the world.
+    minix_pid_t new_minix_process = MINIXCompat_ProcessTable_Allocate();
+    if (new_minix_process == -1) {
+        return -minix_EAGAIN;
+    }
+
+    // Get open files ready to be shared with the child.
+    MINIXCompat_Filesystem_Fork_Prepare();
 
-    // Get the child PID to use and bump the next MINIX pid to use, so both parent and child have a coherent view of the world.
-    minix_pid_t new_minix_process = minix_next_pid++;
+    // Get RAM ready to be forked, since how it's shared with the child depends on its backing store.
+    int prepare_error = MINIXCompat_RAM_Fork_Prepare();
+    if (prepare_error != 0) {
+        MINIXCompat_ProcessTable_Release(new_minix_process);
+        return -MINIXCompat_Errors_MINIXErrorForHostError(prepare_error);
+    }
 
     // Actually fork the host.
     pid_t new_host_process = fork();
@@ -201,10 +506,14 @@ minix_pid_t MINIXCompat_Processes_fork(void)
 
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
 
-        // Reset minix_next_pid.
+        MINIXCompat_RAM_Fork_Parent();
+
+        // Release the child's PID.
 
-        minix_next_pid -= 1;
+        MINIXCompat_ProcessTable_Release(new_minix_process);
     } else if (new_host_process != 0) {
+        MINIXCompat_RAM_Fork_Parent();
+
 #if DEBUG_FORK
         volatile int continue_parent = 0;
         do {
@@ -212,15 +521,28 @@ minix_pid_t MINIXCompat_Processes_fork(void)
         } while (!continue_parent);
 #endif
 
-        // This is the parent. Fill in the new entry in the process table. At this point the tables diverge.
+        // This is the parent. Record the child in the process table, which every host process shares; if there's no room, the child couldn't be waited for, so it's stopped before it gets anywhere.
+
+        if (MINIXCompat_ProcessTable_Insert(new_host_process, new_minix_process)) {
+            MINIXCompat_Trace_Fork(new_minix_process);
+
+            // Return the MINIX child PID.
 
-        MINIXCompat_ProcessTable[new_process_entry].host_pid = new_host_process;
-        MINIXCompat_ProcessTable[new_process_entry].minix_pid = new_minix_process;
+            result = new_minix_process;
+        } else {
+            kill(new_host_process, SIGKILL);
+            while ((waitpid(new_host_process, NULL, 0) == -1) && (errno == EINTR)) continue;
 
-        // Return the MINIX child PID.
+            MINIXCompat_ProcessTable_Release(new_minix_process);
 
-        result = new_minix_process;
+            result = -minix_EAGAIN;
+        }
     } else {
+        MINIXCompat_RAM_Fork_Child();
+        MINIXCompat_Stats_Reset();
+        MINIXCompat_Profile_Reset();
+        MINIXCompat_Trace_Fork_Child();
+
 #if DEBUG_FORK
         volatile int continue_child = 0;
         do {
@@ -228,18 +550,15 @@ minix_pid_t MINIXCompat_Processes_fork(void)
         } while (!continue_child);
 #endif
 
-        // This is the child put the old parent in the slot that the parent uses for this child, just in case. (That way there's no information lost in the fork(2) call.)
-
-        MINIXCompat_ProcessTable[new_process_entry].host_pid = MINIXCompat_ProcessTable[1].host_pid;
-        MINIXCompat_ProcessTable[new_process_entry].minix_pid = MINIXCompat_ProcessTable[1].minix_pid;
+        // This is the child. The parent records it in the process table, but it may need its own entry before the parent gets to that.
 
-        // Now adjust the parent and self entries in the process table.
+        atomic_store(&MINIXCompat_ProcessTable->host_pids[new_minix_process], getpid());
 
-        MINIXCompat_ProcessTable[1].host_pid = MINIXCompat_ProcessTable[0].host_pid;
-        MINIXCompat_ProcessTable[1].minix_pid = MINIXCompat_ProcessTable[0].minix_pid;
+        // Now adjust who this process and its parent are.
 
-        MINIXCompat_ProcessTable[0].host_pid = getpid();
-        MINIXCompat_ProcessTable[0].minix_pid = new_minix_process;
+        minix_self_ppid = minix_self_pid;
+        minix_self_pid = new_minix_process;
+        MINIXCompat_Processes_HostPID = new_minix_process;
 
         // Return 0 here, because if the new process needs its own ID it can always use getpid(2) to get that.
 
@@ -265,11 +584,11 @@ static int16_t MINIXCompat_Processes_MINIXStatForHostStat(int host_stat)
     // Portably construct this using the matching info in the host status.
 
     if (WIFEXITED(host_stat)) {
-        minix_stat = WEXITSTATUS(host_stat);
+        minix_stat = (int16_t)((WEXITSTATUS(host_stat) & 0377) << 8);
     } else if (WIFSTOPPED(host_stat)) {
         minix_stat = (WSTOPSIG(host_stat) << 8) | 0177;
     } else if (WIFSIGNALED(host_stat)) {
-        minix_stat = WTERMSIG(host_stat) << 8;
+        minix_stat = WTERMSIG(host_stat) & 0177;
     } else {
         // Unsupported case on MINIX, just treat as killed by SIGKILL:
         // MSB == 0, LSB == 0x09.
@@ -279,10 +598,126 @@ static int16_t MINIXCompat_Processes_MINIXStatForHostStat(int host_stat)
     return minix_stat;
 }
 
+/*! Find the process run by the in-process scheduler with \a minix_pid, or `NULL`. */
+static minix_process_t *MINIXCompat_Processes_Find(minix_pid_t minix_pid)
+{
+    for (minix_process_t *process = MINIXCompat_Processes_List; process != NULL; process = process->next) {
+        if (process->pid == minix_pid) {
+            return process;
+        }
+    }
+
+    return NULL;
+}
+
+/*! Remove \a process from the processes run by the in-process scheduler and release it, without releasing its MINIX process ID; it must not be running. */
+static void MINIXCompat_Processes_Forget(minix_process_t *process)
+{
+    assert(process != MINIXCompat_Processes_Current);
+
+    for (minix_process_t **link = &MINIXCompat_Processes_List; *link != NULL; link = &(*link)->next) {
+        if (*link == process) {
+            *link = process->next;
+            break;
+        }
+    }
+
+    MINIXCompat_CPU_Context_Free(process->cpu);
+    MINIXCompat_Filesystem_Context_Free(process->files);
+    MINIXCompat_SysCall_Context_Free(process->syscalls);
+    MINIXCompat_Native_Context_Free(process->native);
+    MINIXCompat_Profile_Context_Free(process->profile);
+    MINIXCompat_Stats_Context_Free(process->stats);
+    free(process);
+}
+
+/*! Remove \a process from the processes run by the in-process scheduler and release it along with its MINIX process ID, once it's been waited for or has nobody to wait for it; it must not be running. */
+static void MINIXCompat_Processes_Remove(minix_process_t *process)
+{
+    MINIXCompat_ProcessTable_Release(process->pid);
+    MINIXCompat_Processes_Forget(process);
+}
+
+/*!
+ Collect a process that was moved to a host process of its own and has since exited, leaving it a zombie for its parent. If \a block is set, wait for one to exit.
+
+ - Returns: Whether a process was collected.
+ */
+static bool MINIXCompat_Processes_CollectElsewhere(bool block)
+{
+    int host_stat = 0;
+    pid_t host_pid;
+    do {
+        host_pid = waitpid(-1, &host_stat, block ? 0 : WNOHANG);
+    } while ((host_pid == -1) && (errno == EINTR));
+
+    if (host_pid <= 0) {
+        return false;
+    }
+
+    for (minix_process_t *process = MINIXCompat_Processes_List; process != NULL; process = process->next) {
+        if ((process->state != minix_process_state_elsewhere) || (process->host_pid != host_pid)) continue;
+
+        process->state = minix_process_state_zombie;
+        process->stat = MINIXCompat_Processes_MINIXStatForHostStat(host_stat);
+        MINIXCompat_ProcessTable_RemoveHost(host_pid);
+
+        minix_process_t *parent = MINIXCompat_Processes_Find(process->ppid);
+        if (parent == NULL) {
+            MINIXCompat_Processes_Remove(process);
+        } else if (parent->state == minix_process_state_waiting) {
+            parent->state = minix_process_state_runnable;
+        }
+        break;
+    }
+
+    return true;
+}
+
+/*! Wait for a child of the running process under the in-process scheduler. */
+static minix_pid_t MINIXCompat_Processes_wait_InProcess(int16_t * _Nonnull minix_stat_loc)
+{
+    minix_process_t *current = MINIXCompat_Processes_Current;
+    bool has_children = false;
+
+    while (MINIXCompat_Processes_CollectElsewhere(false)) {
+        // Children that were moved elsewhere may have exited meanwhile.
+    }
+
+    for (minix_process_t *process = MINIXCompat_Processes_List; process != NULL; process = process->next) {
+        if ((process == current) || (process->ppid != current->pid)) continue;
+
+        has_children = true;
+
+        if (process->state == minix_process_state_zombie) {
+            const minix_pid_t minix_pid = process->pid;
+            *minix_stat_loc = process->stat;
+            MINIXCompat_Processes_Remove(process);
+            MINIXCompat_Trace_Wait(minix_pid, *minix_stat_loc);
+            return minix_pid;
+        }
+    }
+
+    if (!has_children) {
+        return -minix_ECHILD;
+    }
+
+    // Let the children run until one of them exits.
+
+    current->state = minix_process_state_waiting;
+    MINIXCompat_CPU_Stop();
+
+    return MINIXCompat_Processes_Blocked;
+}
+
 minix_pid_t MINIXCompat_Processes_wait(int16_t * _Nonnull minix_stat_loc)
 {
     assert(minix_stat_loc != NULL);
 
+    if (MINIXCompat_Processes_Scheduler) {
+        return MINIXCompat_Processes_wait_InProcess(minix_stat_loc);
+    }
+
     minix_pid_t minix_pid;
 
     int host_stat = 0;
@@ -293,6 +728,13 @@ minix_pid_t MINIXCompat_Processes_wait(int16_t * _Nonnull minix_stat_loc)
         minix_pid = MINIXCompat_Processes_MINIXProcessForHostProcess(host_pid);
         int16_t minix_stat = MINIXCompat_Processes_MINIXStatForHostStat(host_stat);
 
+        // The child's PID can be reused now that it's been waited for.
+
+        if (minix_pid > 0) {
+            MINIXCompat_ProcessTable_Release(minix_pid);
+            MINIXCompat_Trace_Wait(minix_pid, minix_stat);
+        }
+
         *minix_stat_loc = minix_stat;
     }
 
@@ -321,20 +763,58 @@ static int MINIXCompat_Processes_HostSignalForMINIXSignal(minix_signal_t minix_s
     }
 }
 
-static int minix_current_signal = 0;
+static minix_signal_t MINIXCompat_Processes_MINIXSignalForHostSignal(int host_signal)
+{
+    switch (host_signal) {
+        case SIGHUP: return minix_SIGHUP;
+        case SIGINT: return minix_SIGINT;
+        case SIGQUIT: return minix_SIGQUIT;
+        case SIGILL: return minix_SIGILL;
+        case SIGTRAP: return minix_SIGTRAP;
+        case SIGABRT: return minix_SIGABRT;
+        case SIGXFSZ: return minix_SIGUNUSED;
+        case SIGFPE: return minix_SIGFPE;
+        case SIGKILL: return minix_SIGKILL;
+        case SIGUSR1: return minix_SIGUSR1;
+        case SIGSEGV: return minix_SIGSEGV;
+        case SIGUSR2: return minix_SIGUSR2;
+        case SIGPIPE: return minix_SIGPIPE;
+        case SIGALRM: return minix_SIGALRM;
+        case SIGTERM: return minix_SIGTERM;
+        case SIGXCPU: return minix_SIGSTKFLT;
+        default: return 0;
+    }
+}
+
+static volatile sig_atomic_t minix_current_signal = 0;
 
 static void MINIXCompat_Processes_SignalHandler_DFL(int sig)
 {
-    // TODO: Implement handling for MINIX signals.
-    // This should just set a flag that a signal needs to be handled MINIX-side, and then handle that signal when the emulation loop returns.
+    // Only note the signal and stop the CPU, since almost nothing is safe to do here; the main loop handles the signal once the CPU has stopped.
     minix_current_signal = sig;
+    MINIXCompat_CPU_Stop_Async();
 }
 
 static void MINIXCompat_Processes_SignalHandler_Other(int sig)
 {
-    // TODO: Implement handling for MINIX signals.
-    // This should just set a flag that a signal needs to be handled MINIX-side, and then handle that signal when the emulation loop returns.
+    // Only note the signal and stop the CPU, since almost nothing is safe to do here; the main loop handles the signal once the CPU has stopped.
     minix_current_signal = sig;
+    MINIXCompat_CPU_Stop_Async();
+}
+
+void MINIXCompat_Processes_HandleSignal(void)
+{
+    const int host_signal = minix_current_signal;
+    if (host_signal == 0) {
+        return;
+    }
+    minix_current_signal = 0;
+
+    minix_pid_t minix_pid, minix_ppid;
+    MINIXCompat_Processes_GetProcessIDs(&minix_pid, &minix_ppid);
+    MINIXCompat_Trace_Signal(MINIXCompat_Processes_MINIXSignalForHostSignal(host_signal), minix_pid);
+
+    // TODO: Implement handling for MINIX signals, by running the process's handler for the signal.
 }
 
 static void *MINIXCompat_Processes_HostSignalHandlerForMINIXSignalHandler(minix_sighandler_t minix_handler)
@@ -391,6 +871,36 @@ int16_t MINIXCompat_Processes_kill(minix_pid_t minix_pid, minix_signal_t minix_s
         return -minix_EINVAL;
     }
 
+    // A process run by the in-process scheduler gets the signal's default action unless it's ignoring the signal. (Like for host signals, MINIX-side handlers aren't run.)
+
+    minix_process_t *target = MINIXCompat_Processes_Scheduler ? MINIXCompat_Processes_Find(minix_pid) : NULL;
+    if ((target != NULL) && (target->state == minix_process_state_elsewhere)) {
+        // A process that was moved elsewhere can only get a host signal.
+        return (kill(target->host_pid, host_signal) == -1) ? -MINIXCompat_Errors_MINIXErrorForHostError(errno) : 0;
+    }
+    if (target != NULL) {
+        const bool running = (target == MINIXCompat_Processes_Current);
+        const minix_sighandler_t handler = running ? minix_signal_handlers[minix_signal - 1] : target->signal_handlers[minix_signal - 1];
+
+        MINIXCompat_Trace_Signal(minix_signal, minix_pid);
+
+        if (((handler == minix_SIG_DFL) || (minix_signal == minix_SIGKILL))
+            && (target->state != minix_process_state_exiting) && (target->state != minix_process_state_zombie) && !target->kill_pending)
+        {
+            target->stat = minix_signal;
+
+            if (running) {
+                target->state = minix_process_state_exiting;
+                MINIXCompat_exit(128 + minix_signal);
+            } else {
+                target->kill_pending = true;
+                target->state = minix_process_state_runnable;
+            }
+        }
+
+        return 0;
+    }
+
     pid_t host_pid = (minix_pid > 0) ? MINIXCompat_Processes_HostProcessForMINIXProcess(minix_pid) : minix_pid;
     if (host_pid <= 0) {
         return -minix_ESRCH;
@@ -406,6 +916,327 @@ int16_t MINIXCompat_Processes_kill(minix_pid_t minix_pid, minix_signal_t minix_s
     return result;
 }
 
+bool MINIXCompat_Processes_Snapshot_Write(int fd)
+{
+    return MINIXCompat_Host_Write_Bytes(fd, minix_signal_handlers, sizeof(minix_signal_handlers));
+}
+
+bool MINIXCompat_Processes_Snapshot_Read(int fd)
+{
+    minix_sighandler_t signal_handlers[16];
+    if (!MINIXCompat_Host_Read_Bytes(fd, signal_handlers, sizeof(signal_handlers))) {
+        return false;
+    }
+
+    for (minix_signal_t minix_signal = 1; minix_signal <= 16; minix_signal++) {
+        if (signal_handlers[minix_signal - 1] != minix_SIG_DFL) {
+            (void) MINIXCompat_Processes_signal(minix_signal, signal_handlers[minix_signal - 1]);
+        }
+    }
+
+    return true;
+}
+
+/*! Whether any process run by the in-process scheduler other than \a process is still alive here. Processes moved elsewhere don't count, since they have host processes of their own. */
+static bool MINIXCompat_Processes_OthersAlive(minix_process_t *process)
+{
+    for (minix_process_t *other = MINIXCompat_Processes_List; other != NULL; other = other->next) {
+        if ((other != process) && (other->state != minix_process_state_exiting) && (other->state != minix_process_state_zombie) && (other->state != minix_process_state_elsewhere)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool MINIXCompat_Processes_exit(int status)
+{
+    if (!MINIXCompat_Processes_Scheduler) {
+        return false;
+    }
+
+    // A process being killed already has its status.
+
+    minix_process_t *current = MINIXCompat_Processes_Current;
+    if (current->state != minix_process_state_exiting) {
+        current->stat = (int16_t)((status & 0377) << 8);
+        current->state = minix_process_state_exiting;
+    }
+
+    MINIXCompat_CPU_Stop();
+
+    return MINIXCompat_Processes_OthersAlive(current);
+}
+
+bool MINIXCompat_Processes_IsHostProcess(void)
+{
+    return !MINIXCompat_Processes_Scheduler || (MINIXCompat_Processes_Current->pid == MINIXCompat_Processes_HostPID);
+}
+
+int MINIXCompat_Processes_Quantum(void)
+{
+    if (!MINIXCompat_Processes_Scheduler) {
+        return 0;
+    }
+
+    int runnable = 0;
+    for (minix_process_t *process = MINIXCompat_Processes_List; process != NULL; process = process->next) {
+        if (process->state == minix_process_state_runnable) {
+            runnable += 1;
+        }
+    }
+
+    return (runnable > 1) ? MINIXCompat_Processes_Quantum_Cycles : 0;
+}
+
+/*! Switch out the running process, which is still alive, saving its state in its contexts. */
+static void MINIXCompat_Processes_SwitchOut(minix_process_t *process)
+{
+    process->cpu = MINIXCompat_CPU_Context_Save();
+    process->files = MINIXCompat_Filesystem_Context_Save();
+    process->syscalls = MINIXCompat_SysCall_Context_Save();
+    process->native = MINIXCompat_Native_Context_Save();
+    process->profile = MINIXCompat_Profile_Context_Save();
+    process->stats = MINIXCompat_Stats_Context_Save();
+    memcpy(process->signal_handlers, minix_signal_handlers, sizeof(minix_signal_handlers));
+}
+
+/*! Switch in \a process, which becomes the running process. */
+static void MINIXCompat_Processes_SwitchIn(minix_process_t *process)
+{
+    MINIXCompat_CPU_Context_Restore(process->cpu);
+    MINIXCompat_Filesystem_Context_Restore(process->files);
+    MINIXCompat_SysCall_Context_Restore(process->syscalls);
+    MINIXCompat_Native_Context_Restore(process->native);
+    MINIXCompat_Profile_Context_Restore(process->profile);
+    MINIXCompat_Stats_Context_Restore(process->stats);
+    memcpy(minix_signal_handlers, process->signal_handlers, sizeof(minix_signal_handlers));
+
+    process->cpu = NULL;
+    process->files = NULL;
+    process->syscalls = NULL;
+    process->native = NULL;
+    process->profile = NULL;
+    process->stats = NULL;
+
+    minix_self_pid = process->pid;
+    minix_self_ppid = process->ppid;
+    MINIXCompat_Processes_Current = process;
+}
+
+/*!
+ Finish the running process, which has exited: report on it, release everything it was using, and leave it a zombie for its parent.
+ */
+static void MINIXCompat_Processes_Finish(minix_process_t *process)
+{
+    MINIXCompat_Stats_Report();
+    MINIXCompat_Profile_Report();
+
+    // Closing its files right away matters, since other processes may be waiting to see them closed.
+
+    MINIXCompat_Filesystem_Flush();
+    MINIXCompat_CPU_Context_Free(MINIXCompat_CPU_Context_Save());
+    MINIXCompat_Filesystem_Context_Free(MINIXCompat_Filesystem_Context_Save());
+    MINIXCompat_SysCall_Context_Free(MINIXCompat_SysCall_Context_Save());
+    MINIXCompat_Native_Context_Free(MINIXCompat_Native_Context_Save());
+    MINIXCompat_Profile_Context_Free(MINIXCompat_Profile_Context_Save());
+    MINIXCompat_Stats_Context_Free(MINIXCompat_Stats_Context_Save());
+
+    process->state = minix_process_state_zombie;
+
+    // Its children are inherited by init, which collects them as soon as they exit.
+
+    minix_process_t *child = MINIXCompat_Processes_List;
+    while (child != NULL) {
+        minix_process_t *next_child = child->next;
+        if ((child != process) && (child->ppid == process->pid)) {
+            child->ppid = 1;
+            if (child->state == minix_process_state_zombie) {
+                MINIXCompat_Processes_Remove(child);
+            }
+        }
+        child = next_child;
+    }
+
+    // Wake its parent if it's waiting for it.
+
+    minix_process_t *parent = MINIXCompat_Processes_Find(process->ppid);
+    if ((parent != NULL) && (parent->state == minix_process_state_waiting)) {
+        parent->state = minix_process_state_runnable;
+    }
+}
+
+/*!
+ Whether \a process can move to a spare worker: there must be one, and the process must not have children, since they'd be left behind where it can't wait for them.
+ */
+static bool MINIXCompat_Processes_CanMigrate(minix_process_t *process)
+{
+    long workers = 1;
+    for (minix_process_t *other = MINIXCompat_Processes_List; other != NULL; other = other->next) {
+        if (other->ppid == process->pid) {
+            return false;
+        }
+        if (other->state == minix_process_state_elsewhere) {
+            workers += 1;
+        }
+    }
+
+    return workers < MINIXCompat_Processes_Workers;
+}
+
+/*!
+ Move the running \a process to a host process of its own, so it runs on another core while this host process runs the others.
+
+ The new host process starts out with the address space of this one, including the moved process's RAM and files, and releases everything else. Here, the moved process releases everything and is left for its parent to wait for.
+
+ - Returns: `0` in the new host process, which keeps running \a process; the new host process ID here; or `-1` if the host couldn't fork, in which case \a process stays here.
+ */
+static pid_t MINIXCompat_Processes_Migrate(minix_process_t *process)
+{
+    // Write out anything the process has buffered before forking, so that only one host process ever writes it, and stop buffering files whose offsets the two will share.
+
+    MINIXCompat_Filesystem_Fork_Prepare();
+
+    const pid_t host_pid = fork();
+
+    if (host_pid == 0) {
+        minix_process_t *other = MINIXCompat_Processes_List;
+        while (other != NULL) {
+            minix_process_t *next_other = other->next;
+            // The others keep their PIDs, since they're still running in the original host process.
+
+            if (other != process) {
+                MINIXCompat_Processes_Forget(other);
+            }
+            other = next_other;
+        }
+
+        // The moved process is the one this host process runs, and its exit status is the host's. It doesn't spread its own children any further, which keeps the total to the number of workers.
+
+        MINIXCompat_Processes_HostPID = process->pid;
+        atomic_store(&MINIXCompat_ProcessTable->host_pids[process->pid], getpid());
+        MINIXCompat_Trace_Fork_Child();
+
+        MINIXCompat_Processes_Workers = 1;
+    } else if (host_pid > 0) {
+        MINIXCompat_CPU_Context_Free(MINIXCompat_CPU_Context_Save());
+        MINIXCompat_Filesystem_Context_Free(MINIXCompat_Filesystem_Context_Save());
+        MINIXCompat_SysCall_Context_Free(MINIXCompat_SysCall_Context_Save());
+        MINIXCompat_Native_Context_Free(MINIXCompat_Native_Context_Save());
+        MINIXCompat_Profile_Context_Free(MINIXCompat_Profile_Context_Save());
+        MINIXCompat_Stats_Context_Free(MINIXCompat_Stats_Context_Save());
+
+        process->state = minix_process_state_elsewhere;
+        process->host_pid = host_pid;
+
+        // If there's no room to look the process up by its host process ID, it's still waited for by that, so it just can't be signaled that way.
+
+        (void) MINIXCompat_ProcessTable_Insert(host_pid, process->pid);
+    }
+
+    return host_pid;
+}
+
+/*! Find the next process to run after \a process, in turn, with \a process itself last; or `NULL` if none can run. */
+static minix_process_t *MINIXCompat_Processes_NextRunnable(minix_process_t *process)
+{
+    minix_process_t *candidate = process;
+
+    do {
+        candidate = (candidate->next != NULL) ? candidate->next : MINIXCompat_Processes_List;
+        if (candidate->state == minix_process_state_runnable) {
+            return candidate;
+        }
+    } while (candidate != process);
+
+    return NULL;
+}
+
+bool MINIXCompat_Processes_Yield(void)
+{
+    if (!MINIXCompat_Processes_Scheduler) {
+        return false;
+    }
+
+    minix_process_t *current = MINIXCompat_Processes_Current;
+    minix_process_t *next = MINIXCompat_Processes_NextRunnable(current);
+    if ((next == NULL) || (next == current)) {
+        return false;
+    }
+
+    MINIXCompat_CPU_Stop();
+
+    return true;
+}
+
+void MINIXCompat_Processes_Schedule(void)
+{
+    if (!MINIXCompat_Processes_Scheduler) {
+        return;
+    }
+
+    minix_process_t *current = MINIXCompat_Processes_Current;
+
+    for (;;) {
+        if (current->state == minix_process_state_exiting) {
+            MINIXCompat_Processes_Finish(current);
+        }
+
+        minix_process_t *next = MINIXCompat_Processes_NextRunnable(current);
+        if (next == current) {
+            // Nothing else can run, so keep going.
+            break;
+        }
+
+        if (next == NULL) {
+            // Every live process here is waiting on another, so one must be elsewhere; otherwise something is lost.
+            if (!MINIXCompat_Processes_CollectElsewhere(true)) {
+                fprintf(stderr, "MINIXCompat: no MINIX process can run\n");
+                exit(EX_SOFTWARE);
+            }
+            continue;
+        }
+
+        // A process that's still runnable has used up its quantum while others wait to run, so rather than take turns with them, it may be able to move to a spare worker.
+
+        if ((current->state == minix_process_state_runnable) && MINIXCompat_Processes_CanMigrate(current)) {
+            if (MINIXCompat_Processes_Migrate(current) == 0) {
+                break;
+            }
+        }
+
+        if ((current->state != minix_process_state_zombie) && (current->state != minix_process_state_elsewhere)) {
+            MINIXCompat_Processes_SwitchOut(current);
+        }
+
+        MINIXCompat_Processes_SwitchIn(next);
+
+        // A process whose parent is gone has nobody to collect its status.
+
+        if ((current->state == minix_process_state_zombie) && (MINIXCompat_Processes_Find(current->ppid) == NULL)) {
+            MINIXCompat_Processes_Remove(current);
+        }
+
+        current = next;
+
+        // A process killed while switched out exits as soon as it's switched back in, and then something else needs to run.
+
+        if (!current->kill_pending) {
+            break;
+        }
+
+        current->kill_pending = false;
+        current->state = minix_process_state_exiting;
+
+        // If it was the last one alive, the host process exits along with it, just like it would if it had exited itself.
+
+        if (!MINIXCompat_Processes_OthersAlive(current)) {
+            MINIXCompat_exit(128 + (current->stat & 0177));
+            break;
+        }
+    }
+}
+
 static void MINIXCompat_Arguments_Initialize(uint32_t host_argc, char **host_argv, uint32_t host_envc, char **host_envp)
 {
     /*! Round up a value to the next multiple of 4. 0 = 0 but 1..3 = 4, 5..7 = 8, etc. */
@@ -507,6 +1338,19 @@ static void MINIXCompat_Arguments_Initialize(uint32_t host_argc, char **host_arg
 #undef round_up_32
 }
 
+/*!
+ Finish loading the tool at MINIX path \a executable_path and host path \a host_path into emulated RAM, however it was loaded: reset per-executable state, and let anything that works on the loaded image see it. Anything that changes the image must come after it's saved to the image cache.
+ */
+static void MINIXCompat_Processes_ToolLoaded(const char *executable_path, const char *host_path)
+{
+    MINIXCompat_Predecode_Flush();
+    MINIXCompat_SysCall_Reset();
+    MINIXCompat_Profile_Executable_Loaded(executable_path, host_path);
+    MINIXCompat_Snapshot_Executable_Loaded(executable_path, host_path);
+    MINIXCompat_Native_Executable_Loaded(host_path);
+    MINIXCompat_Trace_Exec(executable_path);
+}
+
 static int16_t MINIXCompat_Processes_LoadTool(const char *executable_path)
 {
     // TODO: Support interpreter scripts
@@ -522,32 +1366,54 @@ static int16_t MINIXCompat_Processes_LoadTool(const char *executable_path)
     struct stat executable_host_stat;
     int stat_err = stat(executable_host_path, &executable_host_stat);
     if (stat_err == -1) {
-        return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+        int16_t minix_err = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+        free(executable_host_path);
+        return minix_err;
     }
 
-    // Load the tool into host memory, relocate it, and load the relocated tool into emulator memory.
+    // If there's an already-relocated image of the tool in the cache, that's all that's needed.
 
-    FILE *toolfile = fopen(executable_host_path, "r");
-    if (toolfile == NULL) {
-        return -MINIXCompat_Errors_MINIXErrorForHostError(EIO);
+    if (MINIXCompat_ImageCache_Load(executable_host_path, &executable_host_stat)) {
+        MINIXCompat_Processes_ToolLoaded(executable_path, executable_host_path);
+        free(executable_host_path);
+        return 0;
     }
 
-    struct MINIXCompat_Executable *executable = NULL;
-    uint8_t *executable_text_and_data = NULL;
-    uint32_t executable_text_and_data_len = 0;
+    // Load the tool directly into emulator memory and relocate it there.
 
-    int load_err = MINIXCompat_Executable_Load(toolfile, &executable, &executable_text_and_data, &executable_text_and_data_len);
-    if (load_err != 0) {
-        return load_err;
+    int toolfd = open(executable_host_path, O_RDONLY);
+    if (toolfd == -1) {
+        free(executable_host_path);
+        return -MINIXCompat_Errors_MINIXErrorForHostError(EIO);
     }
 
-    MINIXCompat_RAM_Copy_Block_From_Host(MINIXCompat_Executable_Base, executable_text_and_data, executable_text_and_data_len);
+    uint32_t executable_image_len = 0;
+    uint32_t executable_text_len = 0;
+
+    int load_err = MINIXCompat_Executable_Load(toolfd, &executable_image_len, &executable_text_len);
+    if (load_err == 0) {
+        // Save the relocated image so later execs of the same tool can skip all of this. The cache wants it in Motorola byte order, which RAM only needs to be in while it's being saved.
+
+        uint8_t *executable_image = MINIXCompat_RAM_Host_Address(MINIXCompat_Executable_Base, executable_image_len);
+        assert(executable_image != NULL);
+
+        MINIXCompat_RAM_Swizzle_Range(MINIXCompat_Executable_Base, executable_image_len);
+        MINIXCompat_ImageCache_Store(executable_host_path, &executable_host_stat, executable_image, executable_image_len, executable_text_len);
+        MINIXCompat_RAM_Swizzle_Range(MINIXCompat_Executable_Base, executable_image_len);
 
-    fclose(toolfile);
+        // The text is shared from RAM as it is now, in its usual layout.
 
+        (void) MINIXCompat_ImageCache_ShareText(executable_host_path, &executable_host_stat, executable_text_len);
+
+        MINIXCompat_Processes_ToolLoaded(executable_path, executable_host_path);
+    }
+
+    // Clean up.
+
+    close(toolfd);
     free(executable_host_path);
 
-    return 0;
+    return load_err;
 }
 
 int16_t MINIXCompat_Processes_ExecuteWithStackBlock(const char *executable_path, void *stack_on_host, int16_t stack_size)
@@ -9,6 +9,7 @@
 #ifndef MINIXCompat_Processes_h
 #define MINIXCompat_Processes_h
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "MINIXCompat_Types.h"
@@ -21,7 +22,15 @@ MINIXCOMPAT_HEADER_BEGIN
 typedef int16_t minix_pid_t;
 
 
-/*! Initialize the Processes subsystem. */
+/*!
+ Initialize the Processes subsystem.
+
+ The table mapping between MINIX and host process IDs is set up in memory shared with every host process forked from this one, so MINIX process IDs are unique across all of them and each can look up any other's.
+
+ If `MINIXCOMPAT_SCHEDULER` is set to `1`, MINIX processes created by `fork(2)` are run by an in-process scheduler within this host process instead of each getting a host process of its own. Each still has its own emulated RAM, CPU state, and open files, and the scheduler switches between them when the running process exits, waits, or has run for a while.
+
+ If `MINIXCOMPAT_WORKERS` is also set to a number greater than `1`, or to `all` for one per host CPU core, processes are spread across up to that many host processes: a childless process that has run for a while with others waiting moves to a host process of its own, so they run in parallel.
+ */
 MINIXCOMPAT_EXTERN void MINIXCompat_Processes_Initialize(void);
 
 
@@ -38,11 +47,58 @@ MINIXCOMPAT_EXTERN void MINIXCompat_Processes_GetProcessIDs(minix_pid_t * _Nonnu
  */
 MINIXCOMPAT_EXTERN minix_pid_t MINIXCompat_Processes_fork(void);
 
+/*!
+ The result of ``MINIXCompat_Processes_wait`` when the in-process scheduler has suspended the caller until a child exits, so the call must be made again when it's resumed.
+ */
+#define MINIXCompat_Processes_Blocked ((minix_pid_t) INT16_MIN)
+
 /*!
  Wait for a child process to exit and record its status.
+
+ - Returns: The pid of the child that exited, `-errno` on error, or ``MINIXCompat_Processes_Blocked``.
  */
 MINIXCOMPAT_EXTERN minix_pid_t MINIXCompat_Processes_wait(int16_t * _Nonnull minix_stat_loc);
 
+/*!
+ Note that the running process is exiting with \a status.
+
+ - Returns: `true` if the in-process scheduler has other processes to run, so the host process must keep running, or `false` if the host process should exit.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Processes_exit(int status);
+
+/*!
+ Whether the running process is the one the host process was started to run, whose exit status is the host process's.
+
+ This is only ever `false` under the in-process scheduler.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Processes_IsHostProcess(void);
+
+/*!
+ The number of cycles the running process may run before the in-process scheduler should be given a chance to switch to another, or `0` if there's no other process to switch to.
+ */
+MINIXCOMPAT_EXTERN int MINIXCompat_Processes_Quantum(void);
+
+/*!
+ Let another process run instead of the running one, which stays runnable, such as while it waits for a pipe that another process here may be what drains or fills.
+
+ - Returns: `true` if the CPU was stopped so the in-process scheduler switches to another process, in which case the running one must make its system call again once it's switched back in; `false` if there's no other process here to run, so it must block instead.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Processes_Yield(void);
+
+/*!
+ Switch to the next process to run if the running process has stopped running, such as by exiting or waiting, or has used up its quantum.
+
+ This must only be called between runs of the CPU, and does nothing unless the in-process scheduler is in use.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Processes_Schedule(void);
+
+/*!
+ Handle the host signal that last stopped the CPU, if any, on behalf of the running process.
+
+ The host signal handlers only note the signal and stop the CPU, so this must be called between runs of the CPU.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Processes_HandleSignal(void);
+
 
 /*! The type of a MINIX signal. */
 typedef enum minix_signal: int16_t {
@@ -90,6 +146,12 @@ MINIXCOMPAT_EXTERN minix_sighandler_t MINIXCompat_Processes_signal(minix_signal_
  */
 MINIXCOMPAT_EXTERN int16_t MINIXCompat_Processes_kill(minix_pid_t minix_pid, minix_signal_t minix_signal);
 
+/*! Write the running process's signal handlers to the snapshot \a fd. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Processes_Snapshot_Write(int fd);
+
+/*! Restore the running process's signal handlers from the snapshot \a fd, setting up the host side of each. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Processes_Snapshot_Read(int fd);
+
 
 /*!
  Load and run a compiled MINIX executable or interpreter file the same way `exec(2)` would.
@@ -0,0 +1,484 @@
+//
+//  MINIXCompat_Profile.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Profile.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Executable.h"
+#include "MINIXCompat_Utilities.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The deepest call stack recorded; deeper stacks are truncated at their outermost frames. */
+#define MINIXCOMPAT_PROFILE_MAX_DEPTH 32
+
+/*! The frame recorded for a PC that isn't within any known symbol. */
+#define MINIXCOMPAT_PROFILE_UNKNOWN UINT32_MAX
+
+
+/*! A distinct call stack and the number of times it was sampled. */
+typedef struct minix_profile_stack {
+    uint64_t hash;
+    uint32_t count;
+    uint32_t depth;
+
+    /*! Indexes into the symbol table of each frame, innermost first. */
+    uint32_t frames[MINIXCOMPAT_PROFILE_MAX_DEPTH];
+} minix_profile_stack_t;
+
+
+/*! The directory to which profiles are written, or `NULL` if the profiler isn't enabled. */
+static const char *MINIXCOMPAT_PROFILE = NULL;
+
+/*! The number of emulated cycles between samples. */
+static int MINIXCompat_Profile_Cycles = 0;
+
+/*! The name of the current executable, for naming its profiles. */
+static char MINIXCompat_Profile_Executable_Name[PATH_MAX];
+
+/*! The serial number of the current executable's profiles, so an executable run more than once by a host process gets distinct profiles. */
+static unsigned MINIXCompat_Profile_Executable_Serial = 0;
+
+/*! The number of serial numbers given out by this host process so far. */
+static unsigned MINIXCompat_Profile_Serials = 0;
+
+/*! The text symbols of the current executable, sorted by address. */
+static minix_symbol_t *MINIXCompat_Profile_Symbols = NULL;
+static size_t MINIXCompat_Profile_Symbol_Count = 0;
+
+/*! An open-addressed hash table of the distinct call stacks sampled, whose capacity is always a power of two. */
+static minix_profile_stack_t *MINIXCompat_Profile_Stacks = NULL;
+static size_t MINIXCompat_Profile_Stack_Capacity = 0;
+static size_t MINIXCompat_Profile_Stack_Count = 0;
+
+/*! The total number of samples taken of the current executable. */
+static uint64_t MINIXCompat_Profile_Sample_Count = 0;
+
+
+void MINIXCompat_Profile_Initialize(void)
+{
+    const char *profile_dir = getenv("MINIXCOMPAT_PROFILE");
+    if ((profile_dir == NULL) || (profile_dir[0] == '\0')) {
+        return;
+    }
+
+    if (!MINIXCompat_Host_EnsureDirectory(profile_dir)) {
+        return;
+    }
+
+    int cycles = 1000;
+    const char *interval = getenv("MINIXCOMPAT_PROFILE_INTERVAL");
+    if ((interval != NULL) && (interval[0] != '\0')) {
+        long value = strtol(interval, NULL, 10);
+        if ((value > 0) && (value <= INT_MAX)) {
+            cycles = (int) value;
+        }
+    }
+
+    MINIXCOMPAT_PROFILE = profile_dir;
+    MINIXCompat_Profile_Cycles = cycles;
+}
+
+
+int MINIXCompat_Profile_Interval(void)
+{
+    return MINIXCompat_Profile_Cycles;
+}
+
+
+/*! Find the index of the symbol containing \a pc, or ``MINIXCOMPAT_PROFILE_UNKNOWN``. */
+static uint32_t MINIXCompat_Profile_Symbol_For_PC(m68k_address_t pc)
+{
+    // Find the last symbol at or below pc.
+
+    size_t low = 0;
+    size_t high = MINIXCompat_Profile_Symbol_Count;
+
+    while (low < high) {
+        size_t mid = low + ((high - low) / 2);
+        if (MINIXCompat_Profile_Symbols[mid].address <= pc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return (low > 0) ? (uint32_t)(low - 1) : MINIXCOMPAT_PROFILE_UNKNOWN;
+}
+
+
+/*! The name to use in a profile for the symbol at \a index. */
+static const char *MINIXCompat_Profile_Symbol_Name(uint32_t index)
+{
+    return (index == MINIXCOMPAT_PROFILE_UNKNOWN) ? "[unknown]" : MINIXCompat_Profile_Symbols[index].name;
+}
+
+
+/*! Grow the stack table to twice its size, or to its initial size if it's empty. */
+static bool MINIXCompat_Profile_Grow_Stacks(void)
+{
+    const size_t new_capacity = (MINIXCompat_Profile_Stack_Capacity == 0) ? 1024 : (MINIXCompat_Profile_Stack_Capacity * 2);
+    minix_profile_stack_t *new_stacks = calloc(new_capacity, sizeof(minix_profile_stack_t));
+    if (new_stacks == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < MINIXCompat_Profile_Stack_Capacity; i++) {
+        const minix_profile_stack_t *stack = &MINIXCompat_Profile_Stacks[i];
+        if (stack->count == 0) continue;
+
+        size_t slot = (size_t) stack->hash & (new_capacity - 1);
+        while (new_stacks[slot].count != 0) {
+            slot = (slot + 1) & (new_capacity - 1);
+        }
+        new_stacks[slot] = *stack;
+    }
+
+    free(MINIXCompat_Profile_Stacks);
+    MINIXCompat_Profile_Stacks = new_stacks;
+    MINIXCompat_Profile_Stack_Capacity = new_capacity;
+
+    return true;
+}
+
+
+void MINIXCompat_Profile_Sample(m68k_address_t pc, m68k_address_t a6)
+{
+    if (MINIXCOMPAT_PROFILE == NULL) {
+        return;
+    }
+
+    // Walk the frame chain built by `link a6,#n` in each function: the saved a6 is at 0(a6) and the return address at 4(a6). Stop at anything that doesn't look like a frame further up the stack.
+
+    uint32_t frames[MINIXCOMPAT_PROFILE_MAX_DEPTH];
+    uint32_t depth = 0;
+
+    frames[depth++] = MINIXCompat_Profile_Symbol_For_PC(pc);
+
+    m68k_address_t fp = a6;
+    while ((depth < MINIXCOMPAT_PROFILE_MAX_DEPTH)
+           && (fp >= MINIXCompat_Stack_Limit)
+           && (fp <= (MINIXCompat_RAM_Size - 8))
+           && ((fp & 1) == 0))
+    {
+        m68k_address_t next_fp = MINIXCompat_RAM_Read_32(fp);
+        m68k_address_t return_pc = MINIXCompat_RAM_Read_32(fp + 4);
+
+        if ((return_pc < MINIXCompat_Executable_Base) || (return_pc >= MINIXCompat_Executable_Limit)) break;
+
+        frames[depth++] = MINIXCompat_Profile_Symbol_For_PC(return_pc);
+
+        if (next_fp <= fp) break;
+        fp = next_fp;
+    }
+
+    // Count the stack, adding it to the table if it's new.
+
+    const uint64_t hash = MINIXCompat_Hash_Bytes(MINIXCOMPAT_HASH_BASIS, frames, depth * sizeof(frames[0]));
+
+    if (((MINIXCompat_Profile_Stack_Count + 1) * 2) > MINIXCompat_Profile_Stack_Capacity) {
+        if (!MINIXCompat_Profile_Grow_Stacks()) return;
+    }
+
+    size_t slot = (size_t) hash & (MINIXCompat_Profile_Stack_Capacity - 1);
+    for (;;) {
+        minix_profile_stack_t *stack = &MINIXCompat_Profile_Stacks[slot];
+
+        if (stack->count == 0) {
+            stack->hash = hash;
+            stack->count = 1;
+            stack->depth = depth;
+            memcpy(stack->frames, frames, depth * sizeof(uint32_t));
+            MINIXCompat_Profile_Stack_Count += 1;
+            break;
+        }
+
+        if ((stack->hash == hash) && (stack->depth == depth) && (memcmp(stack->frames, frames, depth * sizeof(uint32_t)) == 0)) {
+            stack->count += 1;
+            break;
+        }
+
+        slot = (slot + 1) & (MINIXCompat_Profile_Stack_Capacity - 1);
+    }
+
+    MINIXCompat_Profile_Sample_Count += 1;
+}
+
+
+void MINIXCompat_Profile_Reset(void)
+{
+    if (MINIXCompat_Profile_Stacks != NULL) {
+        memset(MINIXCompat_Profile_Stacks, 0, MINIXCompat_Profile_Stack_Capacity * sizeof(minix_profile_stack_t));
+    }
+
+    MINIXCompat_Profile_Stack_Count = 0;
+    MINIXCompat_Profile_Sample_Count = 0;
+}
+
+
+/*! Open a profile of the current executable with the given \a extension for writing, or return `NULL`. */
+static FILE *MINIXCompat_Profile_Open(const char * _Nonnull extension)
+{
+    char profile_path[PATH_MAX];
+    int len = snprintf(profile_path, PATH_MAX, "%s/%s.%ld.%u.%s", MINIXCOMPAT_PROFILE, MINIXCompat_Profile_Executable_Name, (long) getpid(), MINIXCompat_Profile_Executable_Serial, extension);
+    if ((len <= 0) || (len >= PATH_MAX)) {
+        return NULL;
+    }
+
+    return fopen(profile_path, "w");
+}
+
+
+/*! A function and the number of samples taken while it was running, for sorting the flat profile. */
+typedef struct minix_profile_flat_entry {
+    uint32_t symbol;
+    uint64_t self;
+    uint64_t total;
+} minix_profile_flat_entry_t;
+
+/*! Order flat profile entries by descending self samples. */
+static int MINIXCompat_Profile_Compare_Flat(const void *a, const void *b)
+{
+    const minix_profile_flat_entry_t *fa = a;
+    const minix_profile_flat_entry_t *fb = b;
+
+    if (fa->self > fb->self) return -1;
+    if (fa->self < fb->self) return 1;
+    if (fa->total > fb->total) return -1;
+    if (fa->total < fb->total) return 1;
+    return 0;
+}
+
+
+void MINIXCompat_Profile_Report(void)
+{
+    if ((MINIXCOMPAT_PROFILE == NULL) || (MINIXCompat_Profile_Sample_Count == 0)) {
+        return;
+    }
+
+    // Write the call stacks in folded format, outermost frame first and rooted at the executable's name.
+
+    FILE *folded = MINIXCompat_Profile_Open("folded");
+    if (folded != NULL) {
+        for (size_t i = 0; i < MINIXCompat_Profile_Stack_Capacity; i++) {
+            const minix_profile_stack_t *stack = &MINIXCompat_Profile_Stacks[i];
+            if (stack->count == 0) continue;
+
+            fputs(MINIXCompat_Profile_Executable_Name, folded);
+            for (uint32_t f = stack->depth; f > 0; f--) {
+                fprintf(folded, ";%s", MINIXCompat_Profile_Symbol_Name(stack->frames[f - 1]));
+            }
+            fprintf(folded, " %u\n", stack->count);
+        }
+        fclose(folded);
+    }
+
+    // Write the flat profile: samples in each function itself and including everything it called, with an extra entry at the end for unknown PCs.
+
+    const size_t entry_count = MINIXCompat_Profile_Symbol_Count + 1;
+    minix_profile_flat_entry_t *entries = calloc(entry_count, sizeof(minix_profile_flat_entry_t));
+    if (entries == NULL) {
+        return;
+    }
+
+    for (size_t e = 0; e < entry_count; e++) {
+        entries[e].symbol = (e < MINIXCompat_Profile_Symbol_Count) ? (uint32_t) e : MINIXCOMPAT_PROFILE_UNKNOWN;
+    }
+
+    for (size_t i = 0; i < MINIXCompat_Profile_Stack_Capacity; i++) {
+        const minix_profile_stack_t *stack = &MINIXCompat_Profile_Stacks[i];
+        if (stack->count == 0) continue;
+
+        for (uint32_t f = 0; f < stack->depth; f++) {
+            const uint32_t symbol = stack->frames[f];
+            const size_t e = (symbol == MINIXCOMPAT_PROFILE_UNKNOWN) ? MINIXCompat_Profile_Symbol_Count : symbol;
+
+            // Only count a recursive function once per stack.
+
+            bool seen = false;
+            for (uint32_t g = 0; g < f; g++) {
+                if (stack->frames[g] == symbol) { seen = true; break; }
+            }
+
+            if (f == 0) entries[e].self += stack->count;
+            if (!seen) entries[e].total += stack->count;
+        }
+    }
+
+    qsort(entries, entry_count, sizeof(minix_profile_flat_entry_t), MINIXCompat_Profile_Compare_Flat);
+
+    FILE *flat = MINIXCompat_Profile_Open("flat");
+    if (flat != NULL) {
+        fprintf(flat, "# %llu samples every %d cycles\n", (unsigned long long) MINIXCompat_Profile_Sample_Count, MINIXCompat_Profile_Cycles);
+        fprintf(flat, "# self self%% total total%% function\n");
+
+        for (size_t e = 0; e < entry_count; e++) {
+            if (entries[e].total == 0) continue;
+
+            fprintf(flat, "%llu %.2f %llu %.2f %s\n",
+                    (unsigned long long) entries[e].self, (100.0 * (double) entries[e].self) / (double) MINIXCompat_Profile_Sample_Count,
+                    (unsigned long long) entries[e].total, (100.0 * (double) entries[e].total) / (double) MINIXCompat_Profile_Sample_Count,
+                    MINIXCompat_Profile_Symbol_Name(entries[e].symbol));
+        }
+        fclose(flat);
+    }
+
+    free(entries);
+}
+
+
+void MINIXCompat_Profile_Executable_Loaded(const char * _Nonnull executable_path, const char * _Nonnull host_path)
+{
+    assert(executable_path != NULL);
+    assert(host_path != NULL);
+
+    if (MINIXCOMPAT_PROFILE == NULL) {
+        return;
+    }
+
+    // Finish with the previous executable, if any.
+
+    MINIXCompat_Profile_Report();
+    MINIXCompat_Profile_Reset();
+
+    free(MINIXCompat_Profile_Symbols);
+    MINIXCompat_Profile_Symbols = NULL;
+    MINIXCompat_Profile_Symbol_Count = 0;
+
+    // Name the profiles for the last component of the executable's path.
+
+    const char *slash = strrchr(executable_path, '/');
+    snprintf(MINIXCompat_Profile_Executable_Name, sizeof(MINIXCompat_Profile_Executable_Name), "%s", (slash != NULL) ? (slash + 1) : executable_path);
+    MINIXCompat_Profile_Executable_Serial = ++MINIXCompat_Profile_Serials;
+
+    // Load its symbols; without any, everything is just attributed to an unknown function.
+
+    int fd = open(host_path, O_RDONLY);
+    if (fd != -1) {
+        (void) MINIXCompat_Executable_Load_Symbols(fd, &MINIXCompat_Profile_Symbols, &MINIXCompat_Profile_Symbol_Count);
+        close(fd);
+    }
+}
+
+
+// MARK: - Process Contexts
+
+struct MINIXCompat_Profile_Context {
+    char executable_name[PATH_MAX];
+    unsigned executable_serial;
+
+    minix_symbol_t *symbols;
+    size_t symbol_count;
+
+    minix_profile_stack_t *stacks;
+    size_t stack_capacity;
+    size_t stack_count;
+
+    uint64_t sample_count;
+};
+
+
+MINIXCompat_Profile_Context_t *MINIXCompat_Profile_Context_Fork(void)
+{
+    MINIXCompat_Profile_Context_t *context = calloc(1, sizeof(MINIXCompat_Profile_Context_t));
+    assert(context != NULL);
+
+    if (MINIXCOMPAT_PROFILE == NULL) {
+        return context;
+    }
+
+    // The child needs its own serial number since it shares the host process ID.
+
+    memcpy(context->executable_name, MINIXCompat_Profile_Executable_Name, sizeof(context->executable_name));
+    context->executable_serial = ++MINIXCompat_Profile_Serials;
+
+    if (MINIXCompat_Profile_Symbol_Count > 0) {
+        context->symbols = malloc(MINIXCompat_Profile_Symbol_Count * sizeof(minix_symbol_t));
+        if (context->symbols != NULL) {
+            memcpy(context->symbols, MINIXCompat_Profile_Symbols, MINIXCompat_Profile_Symbol_Count * sizeof(minix_symbol_t));
+            context->symbol_count = MINIXCompat_Profile_Symbol_Count;
+        }
+    }
+
+    return context;
+}
+
+
+MINIXCompat_Profile_Context_t *MINIXCompat_Profile_Context_Save(void)
+{
+    MINIXCompat_Profile_Context_t *context = calloc(1, sizeof(MINIXCompat_Profile_Context_t));
+    assert(context != NULL);
+
+    memcpy(context->executable_name, MINIXCompat_Profile_Executable_Name, sizeof(context->executable_name));
+    context->executable_serial = MINIXCompat_Profile_Executable_Serial;
+    context->symbols = MINIXCompat_Profile_Symbols;
+    context->symbol_count = MINIXCompat_Profile_Symbol_Count;
+    context->stacks = MINIXCompat_Profile_Stacks;
+    context->stack_capacity = MINIXCompat_Profile_Stack_Capacity;
+    context->stack_count = MINIXCompat_Profile_Stack_Count;
+    context->sample_count = MINIXCompat_Profile_Sample_Count;
+
+    MINIXCompat_Profile_Executable_Name[0] = '\0';
+    MINIXCompat_Profile_Executable_Serial = 0;
+    MINIXCompat_Profile_Symbols = NULL;
+    MINIXCompat_Profile_Symbol_Count = 0;
+    MINIXCompat_Profile_Stacks = NULL;
+    MINIXCompat_Profile_Stack_Capacity = 0;
+    MINIXCompat_Profile_Stack_Count = 0;
+    MINIXCompat_Profile_Sample_Count = 0;
+
+    return context;
+}
+
+
+void MINIXCompat_Profile_Context_Restore(MINIXCompat_Profile_Context_t *context)
+{
+    assert(context != NULL);
+
+    memcpy(MINIXCompat_Profile_Executable_Name, context->executable_name, sizeof(MINIXCompat_Profile_Executable_Name));
+    MINIXCompat_Profile_Executable_Serial = context->executable_serial;
+    MINIXCompat_Profile_Symbols = context->symbols;
+    MINIXCompat_Profile_Symbol_Count = context->symbol_count;
+    MINIXCompat_Profile_Stacks = context->stacks;
+    MINIXCompat_Profile_Stack_Capacity = context->stack_capacity;
+    MINIXCompat_Profile_Stack_Count = context->stack_count;
+    MINIXCompat_Profile_Sample_Count = context->sample_count;
+
+    free(context);
+}
+
+
+void MINIXCompat_Profile_Context_Free(MINIXCompat_Profile_Context_t *context)
+{
+    if (context == NULL) {
+        return;
+    }
+
+    free(context->symbols);
+    free(context->stacks);
+    free(context);
+}
+
+
+MINIXCOMPAT_SOURCE_END
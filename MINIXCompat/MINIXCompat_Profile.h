@@ -0,0 +1,76 @@
+//
+//  MINIXCompat_Profile.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Profile_h
+#define MINIXCompat_Profile_h
+
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Initialize the sampling PC profiler.
+
+ The profiler is only enabled if `MINIXCOMPAT_PROFILE` names a host directory, which is created if necessary. The emulated PC and the `a6` frame chain are sampled every `MINIXCOMPAT_PROFILE_INTERVAL` emulated cycles (default 1000), and each executable run writes two profiles there, named for the executable and host process ID: a `.folded` file of call stacks in the folded format flame graph tools accept, and a `.flat` file of samples per function.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Initialize(void);
+
+/*!
+ The number of emulated cycles between samples, or `0` if the profiler isn't enabled.
+ */
+MINIXCOMPAT_EXTERN int MINIXCompat_Profile_Interval(void);
+
+/*!
+ Note that the executable at MINIX path \a executable_path, whose host path is \a host_path, was just loaded.
+
+ This writes the profiles of any previous executable, and loads the symbols of the new one.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Executable_Loaded(const char * _Nonnull executable_path, const char * _Nonnull host_path);
+
+/*!
+ Take a sample with the emulated CPU at \a pc and with frame pointer \a a6.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Sample(m68k_address_t pc, m68k_address_t a6);
+
+/*!
+ Discard all samples so far, for the child of a `fork(2)` so that it only reports its own work.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Reset(void);
+
+/*!
+ Write the profiles of the current executable, if the profiler is enabled.
+
+ This should be called once the process has finished running, just before it exits.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Report(void);
+
+
+/*! The profile of a MINIX process that isn't running, for the in-process scheduler. */
+typedef struct MINIXCompat_Profile_Context MINIXCompat_Profile_Context_t;
+
+/*! Create a context for the child of a `fork(2)` by the running process, which profiles the same executable but has no samples yet. */
+MINIXCOMPAT_EXTERN MINIXCompat_Profile_Context_t * _Nonnull MINIXCompat_Profile_Context_Fork(void);
+
+/*! Switch the running process out, moving its profile into a new context. */
+MINIXCOMPAT_EXTERN MINIXCompat_Profile_Context_t * _Nonnull MINIXCompat_Profile_Context_Save(void);
+
+/*! Switch in the process whose profile is in \a context, which is consumed. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Context_Restore(MINIXCompat_Profile_Context_t * _Nonnull context);
+
+/*! Release \a context without writing its profile. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Profile_Context_Free(MINIXCompat_Profile_Context_t * _Nullable context);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Profile_h */
@@ -0,0 +1,264 @@
+//
+//  MINIXCompat_Replay.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Replay.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Messages.h"
+#include "MINIXCompat_Processes.h"
+#include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Utilities.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The log being recorded to or replayed from, or `NULL` if neither is happening. */
+static FILE *MINIXCompat_Replay_Log = NULL;
+
+/*! The path of the log, for reporting problems with it. */
+static const char *MINIXCompat_Replay_Path = NULL;
+
+/*! Whether the log is being replayed rather than recorded. */
+static bool MINIXCompat_Replay_Replaying = false;
+
+/*! The number of calls recorded or replayed so far, for reporting where a replay diverged. */
+static uint64_t MINIXCompat_Replay_Calls = 0;
+
+/*! A buffer for what a call wrote to emulated RAM, which only ever grows. */
+static uint8_t *MINIXCompat_Replay_Buffer = NULL;
+static uint32_t MINIXCompat_Replay_Buffer_Size = 0;
+
+
+void MINIXCompat_Replay_Initialize(void)
+{
+    const char *record_path = getenv("MINIXCOMPAT_RECORD");
+    const char *replay_path = getenv("MINIXCOMPAT_REPLAY");
+    const bool recording = (record_path != NULL) && (record_path[0] != '\0');
+    const bool replaying = (replay_path != NULL) && (replay_path[0] != '\0');
+
+    if (!recording && !replaying) {
+        return;
+    }
+
+    if (recording && replaying) {
+        fprintf(stderr, "MINIXCompat: MINIXCOMPAT_RECORD and MINIXCOMPAT_REPLAY can't both be set\n");
+        exit(EX_USAGE);
+    }
+
+    MINIXCompat_Replay_Path = recording ? record_path : replay_path;
+    MINIXCompat_Replay_Replaying = replaying;
+    MINIXCompat_Replay_Log = fopen(MINIXCompat_Replay_Path, recording ? "wb" : "rb");
+    if (MINIXCompat_Replay_Log == NULL) {
+        fprintf(stderr, "MINIXCompat: can't open %s: %s\n", MINIXCompat_Replay_Path, strerror(errno));
+        exit(recording ? EX_CANTCREAT : EX_NOINPUT);
+    }
+
+    minix_replay_header_t header;
+
+    if (recording) {
+        header.magic = MINIXCOMPAT_REPLAY_MAGIC;
+        header.version = MINIXCOMPAT_REPLAY_VERSION;
+        header.record_size = sizeof(minix_replay_record_t);
+        header.message_size = sizeof(minix_message_t);
+
+        if (fwrite(&header, sizeof(header), 1, MINIXCompat_Replay_Log) != 1) {
+            fprintf(stderr, "MINIXCompat: can't write %s: %s\n", MINIXCompat_Replay_Path, strerror(errno));
+            exit(EX_IOERR);
+        }
+    } else {
+        const bool valid = (fread(&header, sizeof(header), 1, MINIXCompat_Replay_Log) == 1)
+            && (header.magic == MINIXCOMPAT_REPLAY_MAGIC)
+            && (header.version == MINIXCOMPAT_REPLAY_VERSION)
+            && (header.record_size == sizeof(minix_replay_record_t))
+            && (header.message_size == sizeof(minix_message_t));
+
+        if (!valid) {
+            fprintf(stderr, "MINIXCompat: %s is not a replay log this version of MINIXCompat can use\n", MINIXCompat_Replay_Path);
+            exit(EX_DATAERR);
+        }
+    }
+}
+
+
+bool MINIXCompat_Replay_IsActive(void)
+{
+    return MINIXCompat_Replay_Log != NULL;
+}
+
+
+bool MINIXCompat_Replay_IsReplaying(void)
+{
+    return MINIXCompat_Replay_Replaying;
+}
+
+
+uint64_t MINIXCompat_Replay_Hash(uint64_t hash, m68k_address_t address, uint32_t len)
+{
+    // This is 64-bit FNV-1a, which is plenty to notice that a replay has gone astray.
+
+    if (hash == 0) {
+        hash = MINIXCOMPAT_HASH_BASIS;
+    }
+
+    if ((address >= MINIXCompat_RAM_Size) || ((MINIXCompat_RAM_Size - address) < len)) {
+        return hash;
+    }
+
+    // RAM may be swizzled, so it has to be read a byte at a time.
+
+    for (uint32_t i = 0; i < len; i++) {
+        hash = MINIXCompat_Hash_Byte(hash, MINIXCompat_RAM_Read_8(address + i));
+    }
+
+    return hash;
+}
+
+
+/*! Make the buffer for what a call wrote to emulated RAM at least \a size bytes. */
+static void MINIXCompat_Replay_Reserve(uint32_t size)
+{
+    if (size <= MINIXCompat_Replay_Buffer_Size) {
+        return;
+    }
+
+    uint8_t *buffer = realloc(MINIXCompat_Replay_Buffer, size);
+    assert(buffer != NULL);
+
+    MINIXCompat_Replay_Buffer = buffer;
+    MINIXCompat_Replay_Buffer_Size = size;
+}
+
+
+void MINIXCompat_Replay_Diverged(const char *reason)
+{
+    fprintf(stderr, "MINIXCompat: replay of %s diverged at call %llu: %s\n", MINIXCompat_Replay_Path, (unsigned long long) MINIXCompat_Replay_Calls, reason);
+    exit(EX_SOFTWARE);
+}
+
+
+/*! Log \a call, whose message is at \a msg. */
+static void MINIXCompat_Replay_Write(const minix_replay_call_t * _Nonnull call, m68k_address_t msg)
+{
+    minix_pid_t minix_pid, minix_ppid;
+    MINIXCompat_Processes_GetProcessIDs(&minix_pid, &minix_ppid);
+
+    minix_replay_record_t record = {
+        .sc = call->sc,
+        .minix_pid = minix_pid,
+        .func = call->func,
+        .result = call->result,
+        .out_result = call->out_result,
+        .output = call->output,
+        .output_len = call->output_len,
+        .live = call->live ? 1 : 0,
+        .input_hash = call->input_hash,
+    };
+
+    // A live call is recorded before it's made, so its message is still the request, which doesn't need to be replayed.
+
+    if (!call->live) {
+        MINIXCompat_RAM_Copy_Block_To_Buffer(msg, record.message, sizeof(record.message));
+    }
+
+    MINIXCompat_Replay_Reserve(record.output_len);
+    if (record.output_len > 0) {
+        MINIXCompat_RAM_Copy_Block_To_Buffer(record.output, MINIXCompat_Replay_Buffer, record.output_len);
+    }
+
+    if ((fwrite(&record, sizeof(record), 1, MINIXCompat_Replay_Log) != 1)
+        || ((record.output_len > 0) && (fwrite(MINIXCompat_Replay_Buffer, record.output_len, 1, MINIXCompat_Replay_Log) != 1)))
+    {
+        fprintf(stderr, "MINIXCompat: can't write %s: %s\n", MINIXCompat_Replay_Path, strerror(errno));
+        exit(EX_IOERR);
+    }
+}
+
+
+/*! Replay \a call, whose message is at \a msg, from the next record in the log. */
+static void MINIXCompat_Replay_Read(minix_replay_call_t * _Nonnull call, m68k_address_t msg)
+{
+    minix_replay_record_t record;
+    if (fread(&record, sizeof(record), 1, MINIXCompat_Replay_Log) != 1) {
+        MINIXCompat_Replay_Diverged("the log has no more calls");
+    }
+
+    minix_pid_t minix_pid, minix_ppid;
+    MINIXCompat_Processes_GetProcessIDs(&minix_pid, &minix_ppid);
+
+    char reason[128];
+    if ((record.sc != call->sc) || (record.func != call->func)) {
+        snprintf(reason, sizeof(reason), "expected %s, got %s", MINIXCompat_SysCall_Name(record.sc), MINIXCompat_SysCall_Name(call->sc));
+        MINIXCompat_Replay_Diverged(reason);
+    }
+    if (record.minix_pid != minix_pid) {
+        snprintf(reason, sizeof(reason), "expected %s from process %d, got it from process %d", MINIXCompat_SysCall_Name(call->sc), record.minix_pid, minix_pid);
+        MINIXCompat_Replay_Diverged(reason);
+    }
+    if (record.input_hash != call->input_hash) {
+        snprintf(reason, sizeof(reason), "%s from process %d was made with different inputs", MINIXCompat_SysCall_Name(call->sc), minix_pid);
+        MINIXCompat_Replay_Diverged(reason);
+    }
+    if ((record.live != 0) != call->live) {
+        MINIXCompat_Replay_Diverged("the log was recorded by a different version of MINIXCompat");
+    }
+
+    if ((record.output_len > 0)
+        && ((record.output >= MINIXCompat_RAM_Size) || ((MINIXCompat_RAM_Size - record.output) < record.output_len)))
+    {
+        MINIXCompat_Replay_Diverged("the log is damaged");
+    }
+
+    MINIXCompat_Replay_Reserve(record.output_len);
+    if ((record.output_len > 0) && (fread(MINIXCompat_Replay_Buffer, record.output_len, 1, MINIXCompat_Replay_Log) != 1)) {
+        MINIXCompat_Replay_Diverged("the log is truncated");
+    }
+
+    if (call->live) {
+        return;
+    }
+
+    // Do what the call did to emulated RAM, and have it return what it returned.
+
+    MINIXCompat_RAM_Copy_Block_From_Host(msg, record.message, sizeof(record.message));
+    if (record.output_len > 0) {
+        MINIXCompat_RAM_Copy_Block_From_Host(record.output, MINIXCompat_Replay_Buffer, record.output_len);
+    }
+
+    call->output = record.output;
+    call->output_len = record.output_len;
+    call->result = record.result;
+    call->out_result = record.out_result;
+}
+
+
+void MINIXCompat_Replay_Call(minix_replay_call_t *call, m68k_address_t msg)
+{
+    assert(MINIXCompat_Replay_Log != NULL);
+
+    MINIXCompat_Replay_Calls += 1;
+
+    if (MINIXCompat_Replay_Replaying) {
+        MINIXCompat_Replay_Read(call, msg);
+    } else {
+        MINIXCompat_Replay_Write(call, msg);
+    }
+}
+
+
+MINIXCOMPAT_SOURCE_END
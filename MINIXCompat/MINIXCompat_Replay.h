@@ -0,0 +1,113 @@
+//
+//  MINIXCompat_Replay.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Replay_h
+#define MINIXCompat_Replay_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Messages.h"
+#include "MINIXCompat_Processes.h"
+#include "MINIXCompat_SysCalls.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+// MARK: - Replay Logs
+
+/*! The magic number identifying a replay log, `MXRP`. */
+#define MINIXCOMPAT_REPLAY_MAGIC 0x4d585250
+
+/*! The version of the replay log format; bump it whenever the format changes. */
+#define MINIXCOMPAT_REPLAY_VERSION 1
+
+/*! The header of a replay log, in host byte order since logs are only replayed on the host that recorded them. */
+typedef struct minix_replay_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t message_size;
+} minix_replay_header_t;
+
+/*!
+ One system call in a replay log, followed by `output_len` bytes that it wrote to emulated RAM at `output`.
+
+ A live call, one that's run again when replaying because it changes the state of the emulator rather than the host, is recorded before it's made, since it may never return; only its inputs are recorded, to check that the replay hasn't diverged.
+ */
+typedef struct minix_replay_record {
+    uint16_t sc;
+    minix_pid_t minix_pid;
+    uint16_t func;
+    uint16_t result;
+    uint32_t out_result;
+    m68k_address_t output;
+    uint32_t output_len;
+    uint32_t live;
+
+    /*! A hash of the message and whatever else the call reads from emulated RAM. */
+    uint64_t input_hash;
+
+    /*! The message in emulated RAM once the call returned. */
+    uint8_t message[sizeof(minix_message_t)];
+} MINIXCOMPAT_PACK_STRUCT minix_replay_record_t;
+
+/*! A system call being recorded or replayed. */
+typedef struct minix_replay_call {
+    minix_syscall_t sc;
+    minix_syscall_func_t func;
+    bool live;
+    uint64_t input_hash;
+
+    /*! What the call wrote to emulated RAM besides its message, filled in when recording. */
+    m68k_address_t output;
+    uint32_t output_len;
+
+    /*! The outcome of the call, filled in when recording and when replaying a call that isn't live. */
+    minix_syscall_result_t result;
+    uint32_t out_result;
+} minix_replay_call_t;
+
+
+// MARK: - Recording and Replaying
+
+/*!
+ Initialize system call recording or replay.
+
+ If `MINIXCOMPAT_RECORD` names a host file, every system call made at the ``MINIXCompat_System_Call`` boundary is logged there with its inputs and results, including whatever it wrote to emulated RAM. If `MINIXCOMPAT_REPLAY` names such a log instead, calls that depend on the host are answered from it without being made, and the others are checked against it, so a run can be repeated exactly without touching the host filesystem.
+
+ Either one makes every MINIX process run under the in-process scheduler in this one host process, so they take turns the same way every time.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Replay_Initialize(void);
+
+/*! Whether system calls are being recorded or replayed. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Replay_IsActive(void);
+
+/*! Whether system calls are being replayed. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Replay_IsReplaying(void);
+
+/*! Continue \a hash, which starts out as `0`, over \a len bytes of emulated RAM at \a address. */
+MINIXCOMPAT_EXTERN uint64_t MINIXCompat_Replay_Hash(uint64_t hash, m68k_address_t address, uint32_t len);
+
+/*!
+ Record or replay \a call, whose message is at \a msg.
+
+ When recording, this logs everything in \a call along with the message. When replaying, this checks that the next call in the log is the same one with the same inputs, and for a call that isn't live, fills in its outcome and writes what it wrote to emulated RAM. A replay that has diverged from its log can't go on, so it reports what differs and exits.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Replay_Call(minix_replay_call_t * _Nonnull call, m68k_address_t msg);
+
+/*! Report that a replay has diverged from its log, because of \a reason, and exit. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Replay_Diverged(const char * _Nonnull reason);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Replay_h */
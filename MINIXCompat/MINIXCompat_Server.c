@@ -0,0 +1,571 @@
+//
+//  MINIXCompat_Server.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1 /* for struct ucred */
+#endif
+
+#include "MINIXCompat_Server.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Filesystem.h"
+#include "MINIXCompat_Utilities.h"
+
+
+extern char **environ;
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The magic number identifying a request, `MXSR`. */
+static const uint32_t minix_server_request_magic = 0x4d585352;
+
+/*! The version of the request format; bump it whenever the format changes, since clients and servers may be built separately. */
+static const uint32_t minix_server_request_version = 1;
+
+/*! The most a request may carry in strings, which is generous for a command line. */
+static const uint32_t minix_server_request_strings_max = 1024 * 1024;
+
+
+/*!
+ The header of a request, in host byte order since clients and servers are always on the same host.
+
+ The header travels along with the client's standard input, output, and error, and is followed by `strings_len` bytes of `NUL`-terminated strings: the host working directory, then `argc` arguments, then `envc` environment variables.
+
+ The server replies with the host process ID handling the request as an `int32_t` right away, and then with its exit status as an `int32_t` once it's done.
+ */
+typedef struct minix_server_request_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t argc;
+    uint32_t envc;
+    uint32_t strings_len;
+} minix_server_request_header_t;
+
+
+/*! The connection to the client whose request this process is handling, or `-1` if none. */
+static int MINIXCompat_Server_Connection = -1;
+
+/*! The host process handling the request, which is the only one that reports back to the client. */
+static pid_t MINIXCompat_Server_Handler = 0;
+
+/*! The host process handling the client's request, to which the client forwards signals. */
+static volatile pid_t MINIXCompat_Server_Client_Handler = 0;
+
+/*! The signals a client forwards, which are those a user might send to stop the tool. */
+static const int MINIXCompat_Server_Forwarded_Signals[] = { SIGHUP, SIGINT, SIGQUIT, SIGTERM };
+
+/*! The number of signals a client forwards. */
+#define MINIXCOMPAT_SERVER_FORWARDED_SIGNALS (sizeof(MINIXCompat_Server_Forwarded_Signals) / sizeof(MINIXCompat_Server_Forwarded_Signals[0]))
+
+/*! The environment variables read by the subsystems the server initializes once, which a client must agree with the server on. */
+static const char * const MINIXCompat_Server_Fixed_Variables[] = {
+    "MINIXCOMPAT_DIR",
+    "MINIXCOMPAT_STAT_CACHE",
+    "MINIXCOMPAT_FD_BUFFER",
+    "MINIXCOMPAT_PREFETCH",
+    "MINIXCOMPAT_OVERLAY_DIR",
+    "MINIXCOMPAT_OVERLAY",
+    "MINIXCOMPAT_CACHE_DIR",
+    "MINIXCOMPAT_RAM_BACKING",
+    "MINIXCOMPAT_NATIVE",
+    "MINIXCOMPAT_NATIVE_VERIFY",
+};
+
+/*! The number of environment variables a client must agree with the server on. */
+#define MINIXCOMPAT_SERVER_FIXED_VARIABLES (sizeof(MINIXCompat_Server_Fixed_Variables) / sizeof(MINIXCompat_Server_Fixed_Variables[0]))
+
+
+// MARK: - Transfer
+
+/*! Fill in \a addr for the socket at \a socket_path, returning whether the path fits. */
+static bool MINIXCompat_Server_SocketAddress(struct sockaddr_un * _Nonnull addr, const char * _Nonnull socket_path)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+
+    if (strlen(socket_path) >= sizeof(addr->sun_path)) {
+        return false;
+    }
+
+    strcpy(addr->sun_path, socket_path);
+    return true;
+}
+
+/*! Whether the environment variable \a entry is passed from clients to the server. */
+static bool MINIXCompat_Server_IsPassedVariable(const char * _Nonnull entry)
+{
+    return (strncmp(entry, "MINIX_", 6) == 0) || (strncmp(entry, "MINIXCOMPAT_", 12) == 0);
+}
+
+
+// MARK: - Client
+
+/*! Forward a terminating signal to the host process handling the request, which the user meant it for. */
+static void MINIXCompat_Server_Client_ForwardSignal(int sig)
+{
+    if (MINIXCompat_Server_Client_Handler > 0) {
+        kill(MINIXCompat_Server_Client_Handler, sig);
+    }
+}
+
+bool MINIXCompat_Server_Client(int argc, char * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull envp, int * _Nonnull out_status)
+{
+    assert(out_status != NULL);
+
+    const char *socket_path = getenv("MINIXCOMPAT_SERVER");
+    if ((socket_path == NULL) || (socket_path[0] == '\0')) {
+        return false;
+    }
+
+    struct sockaddr_un addr;
+    if (!MINIXCompat_Server_SocketAddress(&addr, socket_path)) {
+        return false;
+    }
+
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection == -1) {
+        return false;
+    }
+
+    if (connect(connection, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(connection);
+        return false;
+    }
+
+    // Gather the strings for the request.
+
+    char *cwd = getcwd(NULL, 0);
+    const char *request_cwd = (cwd != NULL) ? cwd : "/";
+
+    minix_server_request_header_t header = {
+        .magic = minix_server_request_magic,
+        .version = minix_server_request_version,
+        .argc = (uint32_t) argc,
+        .envc = 0,
+        .strings_len = (uint32_t) strlen(request_cwd) + 1,
+    };
+
+    for (int i = 0; i < argc; i++) {
+        header.strings_len += (uint32_t) strlen(argv[i]) + 1;
+    }
+
+    for (char **iter_envp = envp; *iter_envp != NULL; iter_envp++) {
+        if (MINIXCompat_Server_IsPassedVariable(*iter_envp)) {
+            header.envc += 1;
+            header.strings_len += (uint32_t) strlen(*iter_envp) + 1;
+        }
+    }
+
+    char *strings = calloc(header.strings_len, sizeof(char));
+    assert(strings != NULL);
+
+    size_t strings_offset = 0;
+    const size_t cwd_len = strlen(request_cwd) + 1;
+    memcpy(&strings[strings_offset], request_cwd, cwd_len);
+    strings_offset += cwd_len;
+
+    for (int i = 0; i < argc; i++) {
+        const size_t arg_len = strlen(argv[i]) + 1;
+        memcpy(&strings[strings_offset], argv[i], arg_len);
+        strings_offset += arg_len;
+    }
+
+    for (char **iter_envp = envp; *iter_envp != NULL; iter_envp++) {
+        if (MINIXCompat_Server_IsPassedVariable(*iter_envp)) {
+            const size_t entry_len = strlen(*iter_envp) + 1;
+            memcpy(&strings[strings_offset], *iter_envp, entry_len);
+            strings_offset += entry_len;
+        }
+    }
+
+    free(cwd);
+
+    // Send the header along with standard input, output, and error, and then the strings.
+
+    int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = { .iov_base = &header, .iov_len = sizeof(header) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(connection, &msg, 0);
+    } while ((sent == -1) && (errno == EINTR));
+
+    bool requested = (sent == (ssize_t) sizeof(header))
+        && MINIXCompat_Host_Write_Bytes(connection, strings, header.strings_len);
+    free(strings);
+
+    // Until the server says which host process is handling the request, nothing has run, so the tool can still be run directly.
+
+    int32_t handler = 0;
+    if (!requested || !MINIXCompat_Host_Read_Bytes(connection, &handler, sizeof(handler))) {
+        close(connection);
+        return false;
+    }
+
+    MINIXCompat_Server_Client_Handler = handler;
+
+    struct sigaction forward;
+    memset(&forward, 0, sizeof(forward));
+    forward.sa_handler = MINIXCompat_Server_Client_ForwardSignal;
+    forward.sa_flags = SA_RESTART;
+    sigemptyset(&forward.sa_mask);
+
+    for (size_t i = 0; i < MINIXCOMPAT_SERVER_FORWARDED_SIGNALS; i++) {
+        sigaction(MINIXCompat_Server_Forwarded_Signals[i], &forward, NULL);
+    }
+
+    // The connection closing without a status means the handler died.
+
+    int32_t status = EX_SOFTWARE;
+    if (!MINIXCompat_Host_Read_Bytes(connection, &status, sizeof(status))) {
+        status = EX_SOFTWARE;
+    }
+
+    close(connection);
+
+    *out_status = status;
+    return true;
+}
+
+
+// MARK: - Server
+
+/*!
+ Receive a request on \a connection: its header, its standard input, output, and error in \a fds, and its strings, which the caller must free.
+
+ - Returns: The strings, or `NULL` if the request was invalid, in which case any descriptors received are closed.
+ */
+static char * _Nullable MINIXCompat_Server_ReceiveRequest(int connection, minix_server_request_header_t * _Nonnull header, int * _Nonnull fds)
+{
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int) * 3)];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = { .iov_base = header, .iov_len = sizeof(minix_server_request_header_t) };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+
+    ssize_t received;
+    do {
+        received = recvmsg(connection, &msg, 0);
+    } while ((received == -1) && (errno == EINTR));
+
+    fds[0] = fds[1] = fds[2] = -1;
+
+    struct cmsghdr *cmsg = (received > 0) ? CMSG_FIRSTHDR(&msg) : NULL;
+    if ((cmsg != NULL) && (cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS) && (cmsg->cmsg_len == CMSG_LEN(sizeof(int) * 3))) {
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * 3);
+    }
+
+    // The rest of a short header may come separately, but the descriptors must have come with its start.
+
+    bool valid = (received > 0) && (fds[0] != -1) && ((msg.msg_flags & MSG_CTRUNC) == 0)
+        && MINIXCompat_Host_Read_Bytes(connection, (uint8_t *)header + received, sizeof(minix_server_request_header_t) - (size_t) received)
+        && (header->magic == minix_server_request_magic)
+        && (header->version == minix_server_request_version)
+        && (header->argc >= 2)
+        && (header->strings_len > 0)
+        && (header->strings_len <= minix_server_request_strings_max);
+
+    char *strings = valid ? calloc(header->strings_len, sizeof(char)) : NULL;
+    valid = valid && (strings != NULL) && MINIXCompat_Host_Read_Bytes(connection, strings, header->strings_len);
+
+    // There must be exactly as many strings as the header says.
+
+    if (valid) {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < header->strings_len; i++) {
+            if (strings[i] == '\0') count += 1;
+        }
+        valid = (strings[header->strings_len - 1] == '\0') && (count == (1 + header->argc + header->envc));
+    }
+
+    if (!valid) {
+        for (int i = 0; i < 3; i++) {
+            if (fds[i] != -1) close(fds[i]);
+        }
+        free(strings);
+        return NULL;
+    }
+
+    return strings;
+}
+
+/*!
+ Whether the client that sent \a header and \a strings was run with the same settings as the server for everything the server initializes once.
+
+ The server's warm state came from its own environment, so a request from a client that wants, say, a different MINIX root or no native routines can only be run by the client itself.
+ */
+static bool MINIXCompat_Server_SettingsMatch(const minix_server_request_header_t * _Nonnull header, const char * _Nonnull strings)
+{
+    // Skip the working directory and the arguments to get to the environment.
+
+    const char *env = strings;
+    for (uint32_t i = 0; i < (1 + header->argc); i++) {
+        env += strlen(env) + 1;
+    }
+
+    for (size_t v = 0; v < MINIXCOMPAT_SERVER_FIXED_VARIABLES; v++) {
+        const char *name = MINIXCompat_Server_Fixed_Variables[v];
+        const size_t name_len = strlen(name);
+
+        const char *client_value = NULL;
+        const char *entry = env;
+        for (uint32_t i = 0; i < header->envc; i++) {
+            if ((strncmp(entry, name, name_len) == 0) && (entry[name_len] == '=')) {
+                client_value = &entry[name_len + 1];
+            }
+            entry += strlen(entry) + 1;
+        }
+
+        // The server set the default MINIX root in its own environment, so a client without one gets the same default.
+
+        if ((client_value == NULL) && (strcmp(name, "MINIXCOMPAT_DIR") == 0)) {
+            client_value = MINIXCOMPAT_DIR_default;
+        }
+
+        const char *server_value = getenv(name);
+        if (strcmp((client_value != NULL) ? client_value : "", (server_value != NULL) ? server_value : "") != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ Set up the host process forked to handle a request, turning it into one that looks just as if the client had run the tool: its standard input, output, and error, its environment, its working directory, and its arguments.
+ */
+static void MINIXCompat_Server_Handle(const minix_server_request_header_t * _Nonnull header, char * _Nonnull strings, const int * _Nonnull fds, int * _Nonnull argc, char * _Nonnull * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull * _Nonnull envp)
+{
+    for (int i = 0; i < 3; i++) {
+        if (fds[i] != i) {
+            dup2(fds[i], i);
+            close(fds[i]);
+        }
+    }
+
+    // Forwarded signals must do what they would to a tool run directly, whatever the server does with them.
+
+    for (size_t i = 0; i < MINIXCOMPAT_SERVER_FORWARDED_SIGNALS; i++) {
+        signal(MINIXCompat_Server_Forwarded_Signals[i], SIG_DFL);
+    }
+
+    // Only the variables the client passed, and those the server was started with that it didn't, apply. Nothing MINIX-side comes from the server's environment, and neither does the MINIX working directory.
+
+    char **cleared = environ;
+    while (*cleared != NULL) {
+        if ((strncmp(*cleared, "MINIX_", 6) == 0) || (strncmp(*cleared, "MINIXCOMPAT_PWD=", 16) == 0)) {
+            char *name = strndup(*cleared, (size_t)(strchr(*cleared, '=') - *cleared));
+            unsetenv(name);
+            free(name);
+            cleared = environ;
+        } else {
+            cleared++;
+        }
+    }
+
+    char *string = strings;
+    const char *cwd = string;
+    string += strlen(string) + 1;
+
+    char **request_argv = calloc(header->argc + 1, sizeof(char *));
+    assert(request_argv != NULL);
+    for (uint32_t i = 0; i < header->argc; i++) {
+        request_argv[i] = string;
+        string += strlen(string) + 1;
+    }
+
+    for (uint32_t i = 0; i < header->envc; i++) {
+        putenv(string);
+        string += strlen(string) + 1;
+    }
+
+    (void) chdir(cwd);
+    MINIXCompat_Filesystem_ResetWorkingDirectory();
+
+    *argc = (int) header->argc;
+    *argv = request_argv;
+    *envp = environ;
+}
+
+/*! Whether the client on \a connection is running as the same user as the server, since the server runs tools with its own access to the host. */
+static bool MINIXCompat_Server_PeerIsOwner(int connection)
+{
+#if defined(__linux__)
+    struct ucred peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &peer, &peer_len) == -1) {
+        return false;
+    }
+    const uid_t peer_uid = peer.uid;
+#else
+    uid_t peer_uid;
+    gid_t peer_gid;
+    if (getpeereid(connection, &peer_uid, &peer_gid) == -1) {
+        return false;
+    }
+#endif
+
+    return peer_uid == geteuid();
+}
+
+void MINIXCompat_Server_Run(const char * _Nonnull socket_path, int * _Nonnull argc, char * _Nonnull * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull * _Nonnull envp)
+{
+    assert(socket_path != NULL);
+
+    *argc = 0;
+
+    struct sockaddr_un addr;
+    if (!MINIXCompat_Server_SocketAddress(&addr, socket_path)) {
+        fprintf(stderr, "MINIXCompat: server socket path too long: %s\n", socket_path);
+        return;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == -1) {
+        fprintf(stderr, "MINIXCompat: can't create server socket: %s\n", strerror(errno));
+        return;
+    }
+
+    (void) unlink(socket_path);
+
+    // Only the server's owner may connect, so the socket is never accessible to anyone else, not even between being bound and being listened on.
+
+    const mode_t old_umask = umask(0077);
+    const int bound = bind(listener, (struct sockaddr *)&addr, sizeof(addr));
+    (void) umask(old_umask);
+
+    if ((bound == -1) || (chmod(socket_path, 0600) == -1) || (listen(listener, SOMAXCONN) == -1)) {
+        fprintf(stderr, "MINIXCompat: can't listen on %s: %s\n", socket_path, strerror(errno));
+        close(listener);
+        return;
+    }
+
+    // The server never waits for the host processes handling requests, so let them be reaped automatically; they put this back before running anything.
+
+    signal(SIGCHLD, SIG_IGN);
+
+    for (;;) {
+        int connection = accept(listener, NULL, NULL);
+        if (connection == -1) {
+            if ((errno == EINTR) || (errno == ECONNABORTED)) continue;
+            fprintf(stderr, "MINIXCompat: can't accept on %s: %s\n", socket_path, strerror(errno));
+            close(listener);
+            return;
+        }
+
+        if (!MINIXCompat_Server_PeerIsOwner(connection)) {
+            close(connection);
+            continue;
+        }
+
+        minix_server_request_header_t header;
+        int fds[3];
+        char *strings = MINIXCompat_Server_ReceiveRequest(connection, &header, fds);
+        if (strings == NULL) {
+            close(connection);
+            continue;
+        }
+
+        // Fork the request's handler from this warm process, just like for a MINIX fork(2), so it gets its own RAM with nothing loaded yet.
+
+        pid_t handler = -1;
+        if (MINIXCompat_Server_SettingsMatch(&header, strings) && (MINIXCompat_RAM_Fork_Prepare() == 0)) {
+            handler = fork();
+
+            if (handler == 0) {
+                MINIXCompat_RAM_Fork_Child();
+                close(listener);
+                signal(SIGCHLD, SIG_DFL);
+
+                MINIXCompat_Server_Connection = connection;
+                MINIXCompat_Server_Handler = getpid();
+
+                MINIXCompat_Server_Handle(&header, strings, fds, argc, argv, envp);
+
+                const int32_t reply = MINIXCompat_Server_Handler;
+                if (!MINIXCompat_Host_Write_Bytes(connection, &reply, sizeof(reply))) {
+                    // The client is gone, so there's nobody to run the tool for.
+                    _exit(EX_IOERR);
+                }
+
+                return;
+            }
+
+            MINIXCompat_RAM_Fork_Parent();
+        }
+
+        // On failure, or for a client whose settings differ, just dropping the connection lets the client run the tool directly.
+
+        for (int i = 0; i < 3; i++) {
+            close(fds[i]);
+        }
+        close(connection);
+        free(strings);
+    }
+}
+
+void MINIXCompat_Server_Finish(int status)
+{
+    if ((MINIXCompat_Server_Connection == -1) || (getpid() != MINIXCompat_Server_Handler)) {
+        return;
+    }
+
+    const int32_t reply = status;
+    (void) MINIXCompat_Host_Write_Bytes(MINIXCompat_Server_Connection, &reply, sizeof(reply));
+
+    close(MINIXCompat_Server_Connection);
+    MINIXCompat_Server_Connection = -1;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,49 @@
+//
+//  MINIXCompat_Server.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Server_h
+#define MINIXCompat_Server_h
+
+#include <stdbool.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Run as a client of a warm server, if `MINIXCOMPAT_SERVER` names the Unix-domain socket of one that's listening.
+
+ The client passes \a argv, every `MINIX_` and `MINIXCOMPAT_` environment variable in \a envp, the host working directory, and its standard input, output, and error to the server, forwards any terminating signal it gets to the server process running the tool, and waits for that to exit.
+
+ - Returns: `true` if the tool was run by the server, with its exit status in \a out_status; `false` if there's no server to use, in which case the tool must be run directly.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Server_Client(int argc, char * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull envp, int * _Nonnull out_status);
+
+/*!
+ Serve requests from clients on the Unix-domain socket at \a socket_path, which is replaced if it exists.
+
+ The subsystems that don't depend on the tool being run, like the filesystem, the image cache, and emulated RAM, must already be initialized, since each request is handled by a host process forked from this one with them already warm. The server only returns in such a process, after replacing \a argc, \a argv, and \a envp with those of the request and setting up its working directory, environment, and standard input, output, and error; the rest of the subsystems must then be initialized and the tool run as usual, with ``MINIXCompat_Server_Finish`` called before exiting.
+
+ The server itself runs until it's killed, and only returns on failure to listen, with \a argc set to `0`.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Server_Run(const char * _Nonnull socket_path, int * _Nonnull argc, char * _Nonnull * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull * _Nonnull envp);
+
+/*!
+ Report \a status back to the client that made the request this process is handling, if any.
+
+ Only the host process that was forked to handle the request reports, not any the tool forked in turn.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Server_Finish(int status);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Server_h */
@@ -0,0 +1,302 @@
+//
+//  MINIXCompat_Snapshot.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Snapshot.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Filesystem.h"
+#include "MINIXCompat_Messages.h"
+#include "MINIXCompat_Native.h"
+#include "MINIXCompat_Processes.h"
+#include "MINIXCompat_Profile.h"
+#include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Utilities.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The file to write a snapshot to, or `NULL` if none is to be taken. */
+static const char *MINIXCOMPAT_SNAPSHOT = NULL;
+
+/*! The file to restore a snapshot from, or `NULL` if none is to be restored. */
+static const char *MINIXCOMPAT_RESTORE = NULL;
+
+/*! The system call, counting from `1`, just before which the snapshot is taken. */
+static uint32_t MINIXCompat_Snapshot_At = 1;
+
+/*! The number of system calls the tool has made. */
+static uint32_t MINIXCompat_Snapshot_System_Calls = 0;
+
+/*! Whether the tool has made a file system call, after which what it's read isn't covered by the key. */
+static bool MINIXCompat_Snapshot_Filesystem_Used = false;
+
+/*! The host process running the tool as invoked, which is the only one that can be snapshotted. */
+static pid_t MINIXCompat_Snapshot_Process = 0;
+
+/*! The key identifying this invocation of the tool, which a snapshot must match to be restored. */
+static uint64_t MINIXCompat_Snapshot_Key = 0;
+
+/*! The MINIX and host paths of the executable the tool is running. */
+static char *MINIXCompat_Snapshot_Executable_Path = NULL;
+static char *MINIXCompat_Snapshot_Executable_Host_Path = NULL;
+
+
+/*! The magic number identifying a snapshot, `MXSS`. */
+static const uint32_t minix_snapshot_magic = 0x4d585353;
+
+/*! The version of the snapshot format; bump it whenever the format or any subsystem's part of it changes. */
+static const uint32_t minix_snapshot_version = 1;
+
+
+/*!
+ The header of a snapshot, in host byte order since snapshots are never shared between hosts.
+
+ The header is followed by the `NUL`-terminated MINIX and host paths of the executable, and then by the state of the filesystem, system calls, processes, native routines, and CPU in turn. The CPU's state ends with emulated RAM, starting on a page boundary so that it can be mapped rather than read.
+ */
+typedef struct minix_snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t ram_size;
+    uint32_t ram_byte_xor;
+    uint32_t path_len;
+    uint32_t host_path_len;
+} minix_snapshot_header_t;
+
+
+// MARK: - Initialization
+
+void MINIXCompat_Snapshot_Initialize(int argc, char * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull envp)
+{
+    const char *snapshot = getenv("MINIXCOMPAT_SNAPSHOT");
+    if ((snapshot != NULL) && (snapshot[0] != '\0')) {
+        MINIXCOMPAT_SNAPSHOT = snapshot;
+    }
+
+    const char *restore = getenv("MINIXCOMPAT_RESTORE");
+    if ((restore != NULL) && (restore[0] != '\0')) {
+        MINIXCOMPAT_RESTORE = restore;
+    }
+
+    const char *at = getenv("MINIXCOMPAT_SNAPSHOT_AT");
+    if (at != NULL) {
+        const long at_value = strtol(at, NULL, 10);
+        MINIXCompat_Snapshot_At = (at_value > 0) ? (uint32_t) at_value : 1;
+    }
+
+    if ((MINIXCOMPAT_SNAPSHOT == NULL) && (MINIXCOMPAT_RESTORE == NULL)) {
+        return;
+    }
+
+    MINIXCompat_Snapshot_Process = getpid();
+
+    // The key covers everything the tool could have seen by the time of the snapshot that a later invocation could change: its arguments (but not the name MINIXCompat was run by), its environment, its working directory, and its executable. Files it reads aren't covered, so a snapshot is only taken before the tool makes any file system call.
+
+    uint64_t key = MINIXCOMPAT_HASH_BASIS;
+
+    for (int i = 1; i < argc; i++) {
+        key = MINIXCompat_Hash_Bytes(key, argv[i], strlen(argv[i]) + 1);
+    }
+
+    for (char **iter_envp = envp; *iter_envp != NULL; iter_envp++) {
+        if (strncmp(*iter_envp, "MINIX_", 6) == 0) {
+            key = MINIXCompat_Hash_Bytes(key, *iter_envp, strlen(*iter_envp) + 1);
+        }
+    }
+
+    const char *pwd = MINIXCompat_Filesystem_CopyWorkingDirectory();
+    key = MINIXCompat_Hash_Bytes(key, pwd, strlen(pwd) + 1);
+    free((void *)pwd);
+
+    if (argc > 1) {
+        char *host_path = MINIXCompat_Filesystem_CopyHostPathForPath(argv[1]);
+        struct stat host_stat;
+        if (stat(host_path, &host_stat) == 0) {
+            const int64_t executable_key[] = {
+                (int64_t) host_stat.st_dev,
+                (int64_t) host_stat.st_ino,
+                (int64_t) host_stat.st_size,
+                (int64_t) host_stat.st_mtime,
+                (int64_t) host_stat.st_ctime,
+            };
+            key = MINIXCompat_Hash_Bytes(key, executable_key, sizeof(executable_key));
+        }
+        free(host_path);
+    }
+
+    MINIXCompat_Snapshot_Key = key;
+}
+
+void MINIXCompat_Snapshot_Executable_Loaded(const char * _Nonnull executable_path, const char * _Nonnull host_path)
+{
+    assert(executable_path != NULL);
+    assert(host_path != NULL);
+
+    free(MINIXCompat_Snapshot_Executable_Path);
+    free(MINIXCompat_Snapshot_Executable_Host_Path);
+
+    MINIXCompat_Snapshot_Executable_Path = strdup(executable_path);
+    MINIXCompat_Snapshot_Executable_Host_Path = strdup(host_path);
+}
+
+
+// MARK: - Snapshots
+
+/*! Write the snapshot of the tool, which is stopped at a system call, to `MINIXCOMPAT_SNAPSHOT`. */
+static void MINIXCompat_Snapshot_Write(void)
+{
+    if (MINIXCompat_Snapshot_Executable_Path == NULL) {
+        return;
+    }
+
+    // Write under a temporary name and rename into place, so a process that has mapped RAM from an older snapshot never sees it change.
+
+    char temp_path[PATH_MAX];
+    int temp_len = snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", MINIXCOMPAT_SNAPSHOT, (long) getpid());
+    if ((temp_len <= 0) || (temp_len >= (int) sizeof(temp_path))) {
+        return;
+    }
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "MINIXCompat: can't write snapshot %s: %s\n", MINIXCOMPAT_SNAPSHOT, strerror(errno));
+        return;
+    }
+
+    const minix_snapshot_header_t header = {
+        .magic = minix_snapshot_magic,
+        .version = minix_snapshot_version,
+        .key = MINIXCompat_Snapshot_Key,
+        .ram_size = MINIXCompat_RAM_Size,
+        .ram_byte_xor = MINIXCOMPAT_RAM_BYTE_XOR,
+        .path_len = (uint32_t) strlen(MINIXCompat_Snapshot_Executable_Path) + 1,
+        .host_path_len = (uint32_t) strlen(MINIXCompat_Snapshot_Executable_Host_Path) + 1,
+    };
+
+    const bool written = MINIXCompat_Host_Write_Bytes(fd, &header, sizeof(header))
+        && MINIXCompat_Host_Write_Bytes(fd, MINIXCompat_Snapshot_Executable_Path, header.path_len)
+        && MINIXCompat_Host_Write_Bytes(fd, MINIXCompat_Snapshot_Executable_Host_Path, header.host_path_len)
+        && MINIXCompat_Filesystem_Snapshot_Write(fd)
+        && MINIXCompat_SysCall_Snapshot_Write(fd)
+        && MINIXCompat_Processes_Snapshot_Write(fd)
+        && MINIXCompat_Native_Snapshot_Write(fd)
+        && MINIXCompat_CPU_Snapshot_Write(fd);
+
+    if ((close(fd) == 0) && written && (rename(temp_path, MINIXCOMPAT_SNAPSHOT) == 0)) {
+        return;
+    }
+
+    fprintf(stderr, "MINIXCompat: can't write snapshot %s, since the tool has more than standard input, output, and error open or the file couldn't be written\n", MINIXCOMPAT_SNAPSHOT);
+    (void) unlink(temp_path);
+}
+
+void MINIXCompat_Snapshot_System_Call(uint16_t src_dest)
+{
+    if (MINIXCOMPAT_SNAPSHOT == NULL) {
+        return;
+    }
+
+    // Only the tool as invoked counts, and not any process it forks.
+
+    if ((getpid() != MINIXCompat_Snapshot_Process) || !MINIXCompat_Processes_IsHostProcess()) {
+        return;
+    }
+
+    MINIXCompat_Snapshot_System_Calls += 1;
+
+    if (MINIXCompat_Snapshot_System_Calls == MINIXCompat_Snapshot_At) {
+        if (MINIXCompat_Snapshot_Filesystem_Used) {
+            fprintf(stderr, "MINIXCompat: can't write snapshot %s, since the tool made a file system call before system call %u\n", MINIXCOMPAT_SNAPSHOT, MINIXCompat_Snapshot_At);
+        } else {
+            MINIXCompat_Snapshot_Write();
+        }
+    }
+
+    if (src_dest == minix_task_fs) {
+        MINIXCompat_Snapshot_Filesystem_Used = true;
+    }
+}
+
+bool MINIXCompat_Snapshot_Restore(void)
+{
+    if (MINIXCOMPAT_RESTORE == NULL) {
+        return false;
+    }
+
+    int fd = open(MINIXCOMPAT_RESTORE, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    // A snapshot of some other invocation, or one that doesn't fit this build, is just ignored.
+
+    minix_snapshot_header_t header;
+    char path[PATH_MAX];
+    char host_path[PATH_MAX];
+
+    const bool matches = MINIXCompat_Host_Read_Bytes(fd, &header, sizeof(header))
+        && (header.magic == minix_snapshot_magic)
+        && (header.version == minix_snapshot_version)
+        && (header.key == MINIXCompat_Snapshot_Key)
+        && (header.ram_size == MINIXCompat_RAM_Size)
+        && (header.ram_byte_xor == MINIXCOMPAT_RAM_BYTE_XOR)
+        && (header.path_len > 0) && (header.path_len <= sizeof(path))
+        && (header.host_path_len > 0) && (header.host_path_len <= sizeof(host_path))
+        && MINIXCompat_Host_Read_Bytes(fd, path, header.path_len)
+        && MINIXCompat_Host_Read_Bytes(fd, host_path, header.host_path_len)
+        && (path[header.path_len - 1] == '\0')
+        && (host_path[header.host_path_len - 1] == '\0');
+
+    if (!matches) {
+        close(fd);
+        return false;
+    }
+
+    // Once state starts being restored, there's no going back to starting the tool normally.
+
+    const bool restored = MINIXCompat_Filesystem_Snapshot_Read(fd)
+        && MINIXCompat_SysCall_Snapshot_Read(fd)
+        && MINIXCompat_Processes_Snapshot_Read(fd)
+        && MINIXCompat_Native_Snapshot_Read(fd)
+        && MINIXCompat_CPU_Snapshot_Read(fd);
+
+    close(fd);
+
+    if (!restored) {
+        fprintf(stderr, "MINIXCompat: snapshot %s is damaged\n", MINIXCOMPAT_RESTORE);
+        exit(EX_DATAERR);
+    }
+
+    MINIXCompat_Snapshot_Executable_Loaded(path, host_path);
+    MINIXCompat_Profile_Executable_Loaded(path, host_path);
+
+    // A restored tool has already passed the point its snapshot was taken at.
+
+    MINIXCOMPAT_SNAPSHOT = NULL;
+
+    return true;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,46 @@
+//
+//  MINIXCompat_Snapshot.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Snapshot_h
+#define MINIXCompat_Snapshot_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Initialize snapshots for the invocation of the tool with \a argc, \a argv, and \a envp.
+
+ If `MINIXCOMPAT_SNAPSHOT` names a file, the state of the tool is written there just before the tool makes system call number `MINIXCOMPAT_SNAPSHOT_AT`, counting from `1` (the default) for its first, as long as none of the calls before it were to the file system. If `MINIXCOMPAT_RESTORE` names a file written that way for the same invocation (the same arguments, `MINIX_` environment, working directory, and executable), the tool resumes from there rather than starting over.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Snapshot_Initialize(int argc, char * _Nonnull * _Nonnull argv, char * _Nonnull * _Nonnull envp);
+
+/*! Note that the executable at MINIX path \a executable_path and host path \a host_path was just loaded, since a snapshot must record what it's of. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Snapshot_Executable_Loaded(const char * _Nonnull executable_path, const char * _Nonnull host_path);
+
+/*! Note that the tool is about to make a system call by sending to \a src_dest, writing the snapshot if this is the call it's to be taken at. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Snapshot_System_Call(uint16_t src_dest);
+
+/*!
+ Restore the snapshot named by `MINIXCOMPAT_RESTORE`, if it was taken for this invocation.
+
+ - Returns: `true` if the tool was restored and is ready to resume running, `false` if it must be started normally.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_Snapshot_Restore(void);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Snapshot_h */
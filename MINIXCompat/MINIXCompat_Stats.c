@@ -0,0 +1,353 @@
+//
+//  MINIXCompat_Stats.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Stats.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Filesystem.h"
+#include "MINIXCompat_ImageCache.h"
+#include "MINIXCompat_Processes.h"
+#include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Utilities.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The number of system calls that can be counted, one per ``minix_syscall_t``. */
+#define MINIXCOMPAT_STATS_SYSCALLS 70
+
+/*! The number of buckets in a histogram; bucket `n` counts values in `[2^n, 2^(n+1))`, with `0` counted in bucket `0`. */
+#define MINIXCOMPAT_STATS_BUCKETS 64
+
+
+/*! A log2 histogram of values, such as latencies in nanoseconds. */
+typedef struct minix_stats_histogram {
+    uint64_t count;
+    uint64_t total;
+    uint32_t buckets[MINIXCOMPAT_STATS_BUCKETS];
+} minix_stats_histogram_t;
+
+
+/*! All the statistics for one process. */
+typedef struct minix_stats {
+    /*! When the process started, or was forked. */
+    uint64_t start_ns;
+
+    /*! The host latency of each system call. */
+    minix_stats_histogram_t syscalls[MINIXCOMPAT_STATS_SYSCALLS];
+
+    /*! The emulated cycles run between one trap and the next. */
+    minix_stats_histogram_t trap_cycles;
+
+    /*! The total emulated cycles run as of the last trap. */
+    uint64_t last_trap_cycles;
+
+    /*! The total emulated cycles run as of the start. */
+    uint64_t start_cycles;
+
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+
+    /*! The image cache counters as of the start, since they persist across `fork(2)`. */
+    uint32_t start_cache_hits;
+    uint32_t start_cache_misses;
+
+    /*! The stat cache counters as of the start, since they persist across `fork(2)` too. */
+    uint32_t start_stat_cache_hits;
+    uint32_t start_stat_cache_misses;
+} minix_stats_t;
+
+
+/*! The directory to which reports are written, or `NULL` if statistics aren't being collected. */
+static const char *MINIXCOMPAT_STATS = NULL;
+
+/*! The statistics for this process. */
+static minix_stats_t MINIXCompat_Stats;
+
+
+/*! The current host time, in nanoseconds since an arbitrary point. */
+static uint64_t MINIXCompat_Stats_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+
+/*! Add \a value to \a histogram. */
+static void MINIXCompat_Stats_Histogram_Add(minix_stats_histogram_t * _Nonnull histogram, uint64_t value)
+{
+    int bucket = 0;
+    while ((bucket < (MINIXCOMPAT_STATS_BUCKETS - 1)) && ((value >> (bucket + 1)) != 0)) {
+        bucket += 1;
+    }
+
+    histogram->count += 1;
+    histogram->total += value;
+    histogram->buckets[bucket] += 1;
+}
+
+
+/*!
+ Get an estimate of the \a percent percentile of \a histogram.
+
+ - Returns: The upper bound of the bucket containing the percentile, so the estimate is within a factor of two; `0` if the histogram is empty.
+ */
+static uint64_t MINIXCompat_Stats_Histogram_Percentile(const minix_stats_histogram_t * _Nonnull histogram, unsigned percent)
+{
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    const uint64_t rank = ((histogram->count * percent) + 99) / 100;
+
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < MINIXCOMPAT_STATS_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) {
+            return (bucket < 63) ? ((UINT64_C(1) << (bucket + 1)) - 1) : UINT64_MAX;
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+
+void MINIXCompat_Stats_Initialize(void)
+{
+    const char *stats_dir = getenv("MINIXCOMPAT_STATS");
+    if ((stats_dir == NULL) || (stats_dir[0] == '\0')) {
+        return;
+    }
+
+    if (!MINIXCompat_Host_EnsureDirectory(stats_dir)) {
+        return;
+    }
+
+    MINIXCOMPAT_STATS = stats_dir;
+    MINIXCompat_Stats_Reset();
+}
+
+
+void MINIXCompat_Stats_Reset(void)
+{
+    if (MINIXCOMPAT_STATS == NULL) {
+        return;
+    }
+
+    memset(&MINIXCompat_Stats, 0, sizeof(minix_stats_t));
+
+    MINIXCompat_Stats.start_ns = MINIXCompat_Stats_Now();
+    MINIXCompat_Stats.start_cycles = MINIXCompat_CPU_Cycles();
+    MINIXCompat_Stats.last_trap_cycles = MINIXCompat_Stats.start_cycles;
+    MINIXCompat_ImageCache_GetCounters(&MINIXCompat_Stats.start_cache_hits, &MINIXCompat_Stats.start_cache_misses);
+    MINIXCompat_Filesystem_GetStatCacheCounters(&MINIXCompat_Stats.start_stat_cache_hits, &MINIXCompat_Stats.start_stat_cache_misses);
+}
+
+
+uint64_t MINIXCompat_Stats_SysCall_Begin(void)
+{
+    if (MINIXCOMPAT_STATS == NULL) {
+        return 0;
+    }
+
+    return MINIXCompat_Stats_Now();
+}
+
+
+void MINIXCompat_Stats_SysCall_End(minix_syscall_t sc, uint64_t start)
+{
+    if ((MINIXCOMPAT_STATS == NULL) || (sc < 0) || (sc >= MINIXCOMPAT_STATS_SYSCALLS)) {
+        return;
+    }
+
+    // A fork(2) child resets its statistics while its own fork call is in progress, so clamp its latency to the reset.
+
+    uint64_t now = MINIXCompat_Stats_Now();
+    if (start < MINIXCompat_Stats.start_ns) {
+        start = MINIXCompat_Stats.start_ns;
+    }
+
+    MINIXCompat_Stats_Histogram_Add(&MINIXCompat_Stats.syscalls[sc], now - start);
+}
+
+
+void MINIXCompat_Stats_Transfer(bool is_write, uint32_t nbytes)
+{
+    if (MINIXCOMPAT_STATS == NULL) {
+        return;
+    }
+
+    if (is_write) {
+        MINIXCompat_Stats.write_bytes += nbytes;
+    } else {
+        MINIXCompat_Stats.read_bytes += nbytes;
+    }
+}
+
+
+void MINIXCompat_Stats_Trap(uint64_t cycles)
+{
+    if (MINIXCOMPAT_STATS == NULL) {
+        return;
+    }
+
+    MINIXCompat_Stats_Histogram_Add(&MINIXCompat_Stats.trap_cycles, cycles - MINIXCompat_Stats.last_trap_cycles);
+    MINIXCompat_Stats.last_trap_cycles = cycles;
+}
+
+
+void MINIXCompat_Stats_Report(void)
+{
+    if (MINIXCOMPAT_STATS == NULL) {
+        return;
+    }
+
+    const uint64_t wall_ns = MINIXCompat_Stats_Now() - MINIXCompat_Stats.start_ns;
+    const uint64_t cycles = MINIXCompat_CPU_Cycles() - MINIXCompat_Stats.start_cycles;
+
+    minix_pid_t minix_pid, minix_ppid;
+    MINIXCompat_Processes_GetProcessIDs(&minix_pid, &minix_ppid);
+    const long host_pid = (long) getpid();
+
+    char report_path[PATH_MAX];
+    int len = snprintf(report_path, PATH_MAX, "%s/%hd.%ld.stats", MINIXCOMPAT_STATS, minix_pid, host_pid);
+    if ((len <= 0) || (len >= PATH_MAX)) {
+        return;
+    }
+
+    FILE *report = fopen(report_path, "w");
+    if (report == NULL) {
+        return;
+    }
+
+    // Everything the process did is either emulation or system calls, so the time not spent in system calls is emulation.
+
+    uint64_t syscall_ns = 0;
+    uint64_t syscall_count = 0;
+    for (int sc = 0; sc < MINIXCOMPAT_STATS_SYSCALLS; sc++) {
+        syscall_ns += MINIXCompat_Stats.syscalls[sc].total;
+        syscall_count += MINIXCompat_Stats.syscalls[sc].count;
+    }
+
+    uint32_t cache_hits, cache_misses;
+    MINIXCompat_ImageCache_GetCounters(&cache_hits, &cache_misses);
+
+    uint32_t stat_cache_hits, stat_cache_misses;
+    MINIXCompat_Filesystem_GetStatCacheCounters(&stat_cache_hits, &stat_cache_misses);
+
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    (void) getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(report, "minix_pid %hd\n", minix_pid);
+    fprintf(report, "minix_ppid %hd\n", minix_ppid);
+    fprintf(report, "host_pid %ld\n", host_pid);
+    fprintf(report, "wall_ns %llu\n", (unsigned long long) wall_ns);
+    fprintf(report, "syscall_ns %llu\n", (unsigned long long) syscall_ns);
+    fprintf(report, "emulation_ns %llu\n", (unsigned long long) ((wall_ns > syscall_ns) ? (wall_ns - syscall_ns) : 0));
+    fprintf(report, "user_us %lld\n", ((long long) usage.ru_utime.tv_sec * 1000000LL) + usage.ru_utime.tv_usec);
+    fprintf(report, "system_us %lld\n", ((long long) usage.ru_stime.tv_sec * 1000000LL) + usage.ru_stime.tv_usec);
+    fprintf(report, "max_rss %ld\n", (long) usage.ru_maxrss);
+    fprintf(report, "cycles %llu\n", (unsigned long long) cycles);
+    fprintf(report, "traps %llu\n", (unsigned long long) MINIXCompat_Stats.trap_cycles.count);
+    fprintf(report, "trap_cycles_p50 %llu\n", (unsigned long long) MINIXCompat_Stats_Histogram_Percentile(&MINIXCompat_Stats.trap_cycles, 50));
+    fprintf(report, "trap_cycles_p99 %llu\n", (unsigned long long) MINIXCompat_Stats_Histogram_Percentile(&MINIXCompat_Stats.trap_cycles, 99));
+    fprintf(report, "read_bytes %llu\n", (unsigned long long) MINIXCompat_Stats.read_bytes);
+    fprintf(report, "write_bytes %llu\n", (unsigned long long) MINIXCompat_Stats.write_bytes);
+    fprintf(report, "image_cache_hits %u\n", cache_hits - MINIXCompat_Stats.start_cache_hits);
+    fprintf(report, "image_cache_misses %u\n", cache_misses - MINIXCompat_Stats.start_cache_misses);
+    fprintf(report, "stat_cache_hits %u\n", stat_cache_hits - MINIXCompat_Stats.start_stat_cache_hits);
+    fprintf(report, "stat_cache_misses %u\n", stat_cache_misses - MINIXCompat_Stats.start_stat_cache_misses);
+    fprintf(report, "syscalls %llu\n", (unsigned long long) syscall_count);
+
+    // Then one line per system call that was used: name, number, count, total, p50, and p99 latency in nanoseconds.
+
+    for (int sc = 0; sc < MINIXCOMPAT_STATS_SYSCALLS; sc++) {
+        const minix_stats_histogram_t *histogram = &MINIXCompat_Stats.syscalls[sc];
+        if (histogram->count == 0) continue;
+
+        fprintf(report, "syscall %s %d %llu %llu %llu %llu\n",
+                MINIXCompat_SysCall_Name((minix_syscall_t) sc), sc,
+                (unsigned long long) histogram->count,
+                (unsigned long long) histogram->total,
+                (unsigned long long) MINIXCompat_Stats_Histogram_Percentile(histogram, 50),
+                (unsigned long long) MINIXCompat_Stats_Histogram_Percentile(histogram, 99));
+    }
+
+    fclose(report);
+}
+
+
+// MARK: - Process Contexts
+
+struct MINIXCompat_Stats_Context {
+    minix_stats_t stats;
+};
+
+
+MINIXCompat_Stats_Context_t *MINIXCompat_Stats_Context_Fork(void)
+{
+    MINIXCompat_Stats_Context_t *context = calloc(1, sizeof(MINIXCompat_Stats_Context_t));
+    assert(context != NULL);
+
+    // Start the child's statistics the same way a host fork(2) child does, without disturbing the parent's.
+
+    const minix_stats_t parent_stats = MINIXCompat_Stats;
+    MINIXCompat_Stats_Reset();
+    context->stats = MINIXCompat_Stats;
+    MINIXCompat_Stats = parent_stats;
+
+    return context;
+}
+
+
+MINIXCompat_Stats_Context_t *MINIXCompat_Stats_Context_Save(void)
+{
+    MINIXCompat_Stats_Context_t *context = calloc(1, sizeof(MINIXCompat_Stats_Context_t));
+    assert(context != NULL);
+
+    context->stats = MINIXCompat_Stats;
+
+    return context;
+}
+
+
+void MINIXCompat_Stats_Context_Restore(MINIXCompat_Stats_Context_t *context)
+{
+    assert(context != NULL);
+
+    MINIXCompat_Stats = context->stats;
+
+    free(context);
+}
+
+
+void MINIXCompat_Stats_Context_Free(MINIXCompat_Stats_Context_t *context)
+{
+    free(context);
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,83 @@
+//
+//  MINIXCompat_Stats.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Stats_h
+#define MINIXCompat_Stats_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_SysCalls.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Initialize runtime statistics collection.
+
+ Statistics are only collected if `MINIXCOMPAT_STATS` names a host directory, which is created if necessary. Each MINIXCompat process writes its own report there when it finishes, named for its MINIX and host process IDs, so a whole build's worth of processes can share the directory.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Initialize(void);
+
+/*!
+ Reset all statistics, for the child of a `fork(2)` so that it only reports its own work.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Reset(void);
+
+/*!
+ Note the start of a system call.
+
+ - Returns: A timestamp to pass to ``MINIXCompat_Stats_SysCall_End``, or `0` if statistics aren't being collected.
+ */
+MINIXCOMPAT_EXTERN uint64_t MINIXCompat_Stats_SysCall_Begin(void);
+
+/*!
+ Note the end of system call \a sc, which started at \a start as returned by ``MINIXCompat_Stats_SysCall_Begin``.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_SysCall_End(minix_syscall_t sc, uint64_t start);
+
+/*!
+ Note that \a nbytes were transferred by a `read(2)` (if \a is_write is `false`) or `write(2)` (if \a is_write is `true`).
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Transfer(bool is_write, uint32_t nbytes);
+
+/*!
+ Note that the emulated CPU trapped after running for a total of \a cycles.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Trap(uint64_t cycles);
+
+/*!
+ Write this process's report, if statistics are being collected.
+
+ This should be called once the process has finished running, just before it exits.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Report(void);
+
+
+/*! The statistics of a MINIX process that isn't running, for the in-process scheduler. */
+typedef struct MINIXCompat_Stats_Context MINIXCompat_Stats_Context_t;
+
+/*! Create a context for the child of a `fork(2)` by the running process, whose statistics start from the fork. */
+MINIXCOMPAT_EXTERN MINIXCompat_Stats_Context_t * _Nonnull MINIXCompat_Stats_Context_Fork(void);
+
+/*! Switch the running process out, moving its statistics into a new context. */
+MINIXCOMPAT_EXTERN MINIXCompat_Stats_Context_t * _Nonnull MINIXCompat_Stats_Context_Save(void);
+
+/*! Switch in the process whose statistics are in \a context, which is consumed. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Context_Restore(MINIXCompat_Stats_Context_t * _Nonnull context);
+
+/*! Release \a context without writing its report. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Stats_Context_Free(MINIXCompat_Stats_Context_t * _Nullable context);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Stats_h */
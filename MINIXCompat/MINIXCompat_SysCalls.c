@@ -11,7 +11,9 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -26,6 +28,10 @@
 #include "MINIXCompat_Filesystem.h"
 #include "MINIXCompat_Messages.h"
 #include "MINIXCompat_Processes.h"
+#include "MINIXCompat_Replay.h"
+#include "MINIXCompat_Stats.h"
+#include "MINIXCompat_Trace.h"
+#include "MINIXCompat_Utilities.h"
 
 
 //#define DEBUG_SYSCALL_MECHANISM 1
@@ -76,8 +82,8 @@ minix_syscall_result_t MINIXCompat_SysCall_kill(minix_syscall_func_t func, uint1
 // minix_syscall_result_t MINIXCompat_SysCall_rename(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
 // minix_syscall_result_t MINIXCompat_SysCall_mkdir(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
 // minix_syscall_result_t MINIXCompat_SysCall_rmdir(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
-// minix_syscall_result_t MINIXCompat_SysCall_dup(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
-// minix_syscall_result_t MINIXCompat_SysCall_pipe(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
+minix_syscall_result_t MINIXCompat_SysCall_dup(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
+minix_syscall_result_t MINIXCompat_SysCall_pipe(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
 // minix_syscall_result_t MINIXCompat_SysCall_times(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
 // minix_syscall_result_t MINIXCompat_SysCall_prof(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
 // unused45
@@ -108,7 +114,7 @@ minix_syscall_result_t MINIXCompat_SysCall_exece(minix_syscall_func_t func, uint
 
 
 // MARK: - System Call Names
-#if DEBUG_SYSCALL_MECHANISM
+
 /*! A table of syscall names so we can more easily trace what's going on.*/
 static const char * _Nonnull const minix_syscall_name[70] = {
     "unused0",
@@ -182,87 +188,105 @@ static const char * _Nonnull const minix_syscall_name[70] = {
     "TASK_REPLY",
     "unused69",
 };
-#endif
+
+const char *MINIXCompat_SysCall_Name(minix_syscall_t sc)
+{
+    return ((sc >= minix_syscall_unused0) && (sc <= minix_syscall_unused69)) ? minix_syscall_name[sc] : "unknown";
+}
 
 
 // MARK: - System Call Table
 
 typedef minix_syscall_result_t (*minix_syscall_impl)(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result);
 
+/*!
+ A MINIX system call descriptor: the implementation, the layout of the request it decodes from the message in emulated RAM, the layout of the reply it encodes back, and whether its outcome depends on the host.
+
+ The dispatcher does all of the decoding and encoding using a single message buffer on the stack, so an implementation only ever sees and fills in host-byte-order fields and nothing is allocated per call. An implementation whose reply depends on the outcome (such as `exece`) uses ``minix_message_layout_none`` and writes its own reply.
+
+ A call whose outcome depends on the host, such as on its filesystem or clock, is answered from the log when replaying rather than being made. Every other call only changes the state of the emulator, so it's made again.
+ */
+typedef struct minix_syscall_descriptor {
+    minix_syscall_impl _Nullable impl;
+    minix_message_layout_t request;
+    minix_message_layout_t reply;
+    bool host;
+} minix_syscall_descriptor_t;
+
 /*!
  MINIX System Call Table, for MM & FS calls.
  */
-minix_syscall_impl _Nullable minix_syscall_table[70] = {
-    NULL, // unused0
-    MINIXCompat_SysCall_exit,
-    MINIXCompat_SysCall_fork,
-    MINIXCompat_SysCall_read,
-    MINIXCompat_SysCall_write,
-    MINIXCompat_SysCall_open,
-    MINIXCompat_SysCall_close,
-    MINIXCompat_SysCall_wait,
-    MINIXCompat_SysCall_creat,
-    NULL, // MINIXCompat_SysCall_link
-    MINIXCompat_SysCall_unlink,
-    NULL, // MINIXCompat_SysCall_exec
-    NULL, // MINIXCompat_SysCall_chdir
-    MINIXCompat_SysCall_time,
-    NULL, // MINIXCompat_SysCall_mknod
-    NULL, // MINIXCompat_SysCall_chmod
-    NULL, // MINIXCompat_SysCall_chown
-    MINIXCompat_SysCall_brk,
-    MINIXCompat_SysCall_stat,
-    MINIXCompat_SysCall_lseek,
-    MINIXCompat_SysCall_getpid,
-    NULL, // MINIXCompat_SysCall_mount
-    NULL, // MINIXCompat_SysCall_umount
-    NULL, // MINIXCompat_SysCall_setuid
-    MINIXCompat_SysCall_getuid,
-    NULL, // MINIXCompat_SysCall_stime
-    NULL, // MINIXCompat_SysCall_ptrace
-    NULL, // MINIXCompat_SysCall_alarm
-    MINIXCompat_SysCall_fstat,
-    NULL, // MINIXCompat_SysCall_pause
-    NULL, // MINIXCompat_SysCall_utime
-    NULL, // MINIXCompat_SysCall_stty
-    NULL, // MINIXCompat_SysCall_gtty
-    MINIXCompat_SysCall_access,
-    NULL, // MINIXCompat_SysCall_nice
-    NULL, // MINIXCompat_SysCall_ftime
-    NULL, // MINIXCompat_SysCall_sync
-    MINIXCompat_SysCall_kill,
-    NULL, // MINIXCompat_SysCall_rename
-    NULL, // MINIXCompat_SysCall_mkdir
-    NULL, // MINIXCompat_SysCall_rmdir
-    NULL, // MINIXCompat_SysCall_dup
-    NULL, // MINIXCompat_SysCall_pipe
-    NULL, // MINIXCompat_SysCall_times
-    NULL, // MINIXCompat_SysCall_prof
-    NULL, // unused45
-    NULL, // MINIXCompat_SysCall_setgid
-    MINIXCompat_SysCall_getgid,
-    MINIXCompat_SysCall_signal,
-    NULL, // unused49
-    NULL, // unused50
-    NULL, // MINIXCompat_SysCall_acct
-    NULL, // MINIXCompat_SysCall_phys
-    NULL, // MINIXCompat_SysCall_lock
-    NULL, // MINIXCompat_SysCall_ioctl
-    NULL, // MINIXCompat_SysCall_fcntl
-    NULL, // MINIXCompat_SysCall_mpx
-    NULL, // unused57
-    NULL, // unused58
-    MINIXCompat_SysCall_exece,
-    NULL, // MINIXCompat_SysCall_umask
-    NULL, // MINIXCompat_SysCall_chroot
-    NULL, // unused62
-    NULL, // unused63
-    NULL, // MINIXCompat_SysCall_KSIG
-    NULL, // MINIXCompat_SysCall_UNPAUSE
-    NULL, // MINIXCompat_SysCall_BRK2
-    NULL, // MINIXCompat_SysCall_REVIVE
-    NULL, // MINIXCompat_SysCall_TASK_REPLY
-    NULL, // unused69
+static const minix_syscall_descriptor_t minix_syscall_table[70] = {
+    { NULL }, // unused0
+    { MINIXCompat_SysCall_exit, minix_message_layout_mess1, minix_message_layout_none },
+    { MINIXCompat_SysCall_fork, minix_message_layout_header, minix_message_layout_mess2 },
+    { MINIXCompat_SysCall_read, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { MINIXCompat_SysCall_write, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { MINIXCompat_SysCall_open, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { MINIXCompat_SysCall_close, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { MINIXCompat_SysCall_wait, minix_message_layout_header, minix_message_layout_mess2 },
+    { MINIXCompat_SysCall_creat, minix_message_layout_mess3, minix_message_layout_mess1, true },
+    { NULL }, // MINIXCompat_SysCall_link
+    { MINIXCompat_SysCall_unlink, minix_message_layout_mess3, minix_message_layout_mess1, true },
+    { NULL }, // MINIXCompat_SysCall_exec
+    { NULL }, // MINIXCompat_SysCall_chdir
+    { MINIXCompat_SysCall_time, minix_message_layout_header, minix_message_layout_mess2, true },
+    { NULL }, // MINIXCompat_SysCall_mknod
+    { NULL }, // MINIXCompat_SysCall_chmod
+    { NULL }, // MINIXCompat_SysCall_chown
+    { MINIXCompat_SysCall_brk, minix_message_layout_mess1, minix_message_layout_mess2 },
+    { MINIXCompat_SysCall_stat, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { MINIXCompat_SysCall_lseek, minix_message_layout_mess2, minix_message_layout_mess2, true },
+    { MINIXCompat_SysCall_getpid, minix_message_layout_header, minix_message_layout_mess1 },
+    { NULL }, // MINIXCompat_SysCall_mount
+    { NULL }, // MINIXCompat_SysCall_umount
+    { NULL }, // MINIXCompat_SysCall_setuid
+    { MINIXCompat_SysCall_getuid, minix_message_layout_header, minix_message_layout_mess2, false },
+    { NULL }, // MINIXCompat_SysCall_stime
+    { NULL }, // MINIXCompat_SysCall_ptrace
+    { NULL }, // MINIXCompat_SysCall_alarm
+    { MINIXCompat_SysCall_fstat, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { NULL }, // MINIXCompat_SysCall_pause
+    { NULL }, // MINIXCompat_SysCall_utime
+    { NULL }, // MINIXCompat_SysCall_stty
+    { NULL }, // MINIXCompat_SysCall_gtty
+    { MINIXCompat_SysCall_access, minix_message_layout_mess3, minix_message_layout_mess1, true },
+    { NULL }, // MINIXCompat_SysCall_nice
+    { NULL }, // MINIXCompat_SysCall_ftime
+    { NULL }, // MINIXCompat_SysCall_sync
+    { MINIXCompat_SysCall_kill, minix_message_layout_mess1, minix_message_layout_mess2 },
+    { NULL }, // MINIXCompat_SysCall_rename
+    { NULL }, // MINIXCompat_SysCall_mkdir
+    { NULL }, // MINIXCompat_SysCall_rmdir
+    { MINIXCompat_SysCall_dup, minix_message_layout_mess1, minix_message_layout_mess1, true },
+    { MINIXCompat_SysCall_pipe, minix_message_layout_header, minix_message_layout_mess1, true },
+    { NULL }, // MINIXCompat_SysCall_times
+    { NULL }, // MINIXCompat_SysCall_prof
+    { NULL }, // unused45
+    { NULL }, // MINIXCompat_SysCall_setgid
+    { MINIXCompat_SysCall_getgid, minix_message_layout_header, minix_message_layout_mess2, false },
+    { MINIXCompat_SysCall_signal, minix_message_layout_mess6, minix_message_layout_mess2 },
+    { NULL }, // unused49
+    { NULL }, // unused50
+    { NULL }, // MINIXCompat_SysCall_acct
+    { NULL }, // MINIXCompat_SysCall_phys
+    { NULL }, // MINIXCompat_SysCall_lock
+    { NULL }, // MINIXCompat_SysCall_ioctl
+    { NULL }, // MINIXCompat_SysCall_fcntl
+    { NULL }, // MINIXCompat_SysCall_mpx
+    { NULL }, // unused57
+    { NULL }, // unused58
+    { MINIXCompat_SysCall_exece, minix_message_layout_mess1, minix_message_layout_none },
+    { NULL }, // MINIXCompat_SysCall_umask
+    { NULL }, // MINIXCompat_SysCall_chroot
+    { NULL }, // unused62
+    { NULL }, // unused63
+    { NULL }, // MINIXCompat_SysCall_KSIG
+    { NULL }, // MINIXCompat_SysCall_UNPAUSE
+    { NULL }, // MINIXCompat_SysCall_BRK2
+    { NULL }, // MINIXCompat_SysCall_REVIVE
+    { NULL }, // MINIXCompat_SysCall_TASK_REPLY
+    { NULL }, // unused69
 };
 
 
@@ -281,12 +305,198 @@ const uint16_t minix_default_euid = 0;
 const uint16_t minix_default_egid = 0;
 
 
+/*! The current break, which is never allowed to be set lower, until an exec(2) starts over. */
+static m68k_address_t minix_current_break = 0;
+
+/*! How much of a write to a pipe is already done, when the writer had to let another process run partway through it and will make the call again. */
+static int16_t minix_pipe_write_done = 0;
+
+
 void MINIXCompat_SysCall_Initialize(void)
 {
     // Nothing yet.
 }
 
 
+void MINIXCompat_SysCall_Reset(void)
+{
+    minix_current_break = 0;
+    minix_pipe_write_done = 0;
+}
+
+
+struct MINIXCompat_SysCall_Context {
+    m68k_address_t current_break;
+    int16_t pipe_write_done;
+};
+
+
+MINIXCompat_SysCall_Context_t *MINIXCompat_SysCall_Context_Fork(void)
+{
+    MINIXCompat_SysCall_Context_t *context = calloc(1, sizeof(MINIXCompat_SysCall_Context_t));
+    assert(context != NULL);
+
+    context->current_break = minix_current_break;
+
+    return context;
+}
+
+
+MINIXCompat_SysCall_Context_t *MINIXCompat_SysCall_Context_Save(void)
+{
+    MINIXCompat_SysCall_Context_t *context = MINIXCompat_SysCall_Context_Fork();
+    context->pipe_write_done = minix_pipe_write_done;
+
+    minix_current_break = 0;
+    minix_pipe_write_done = 0;
+
+    return context;
+}
+
+
+void MINIXCompat_SysCall_Context_Restore(MINIXCompat_SysCall_Context_t *context)
+{
+    assert(context != NULL);
+
+    minix_current_break = context->current_break;
+    minix_pipe_write_done = context->pipe_write_done;
+
+    free(context);
+}
+
+
+void MINIXCompat_SysCall_Context_Free(MINIXCompat_SysCall_Context_t *context)
+{
+    free(context);
+}
+
+bool MINIXCompat_SysCall_Snapshot_Write(int fd)
+{
+    const uint32_t current_break = minix_current_break;
+    return MINIXCompat_Host_Write_Bytes(fd, &current_break, sizeof(current_break));
+}
+
+bool MINIXCompat_SysCall_Snapshot_Read(int fd)
+{
+    uint32_t current_break;
+    if (!MINIXCompat_Host_Read_Bytes(fd, &current_break, sizeof(current_break)) || (current_break > MINIXCompat_Stack_Limit)) {
+        return false;
+    }
+
+    minix_current_break = current_break;
+    return true;
+}
+
+
+/*! The size of the buffer for a path passed to a system call, including its trailing `NUL`; MINIX's own `PATH_MAX` is 255. */
+#define MINIXCOMPAT_SYSCALL_PATH_MAX 256
+
+/*!
+ Copy the \a name_len bytes of the path at \a name, which includes its trailing `NUL`, from emulated RAM into \a path_buf, which must hold ``MINIXCOMPAT_SYSCALL_PATH_MAX`` bytes, without allocating.
+
+ - Returns: `0` on success or `-errno` if the path is too long or isn't within the address space.
+ */
+static int16_t MINIXCompat_SysCall_CopyPath(m68k_address_t name, int16_t name_len, char * _Nonnull path_buf)
+{
+    if (name_len <= 0) {
+        return -minix_EINVAL;
+    }
+    if (name_len > MINIXCOMPAT_SYSCALL_PATH_MAX) {
+        return -minix_ENAMETOOLONG;
+    }
+    if ((name >= MINIXCompat_RAM_Size) || ((MINIXCompat_RAM_Size - name) < (uint32_t) name_len)) {
+        return -minix_EFAULT;
+    }
+
+    MINIXCompat_RAM_Copy_Block_To_Buffer(name, path_buf, name_len);
+    path_buf[name_len - 1] = '\0';
+
+    return 0;
+}
+
+
+/*! Make the call described by \a scdesc with \a message decoded from \a msg, and encode its reply if the sender expects one. */
+static minix_syscall_result_t MINIXCompat_SysCall_Invoke(const minix_syscall_descriptor_t *scdesc, minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
+{
+    minix_syscall_result_t result = scdesc->impl(func, src_dest, msg, message, out_result);
+
+    // If the sender is expecting a response beyond the value of `d0.l`, the implementation will have filled in the reply in host byte order.
+
+    if ((func == minix_syscall_func_both) && (result != minix_syscall_result_retry)) {
+        MINIXCompat_Message_Write(msg, scdesc->reply, message);
+    }
+
+    return result;
+}
+
+/*!
+ Make or replay system call \a sc, described by \a scdesc, while recording or replaying.
+
+ Besides its message, a call is only recorded as reading what it writes to a file, and as writing what it reads from a file or the status it gets of one, since those are the only places the calls implemented here touch emulated RAM.
+ */
+static minix_syscall_result_t MINIXCompat_SysCall_RecordOrReplay(minix_syscall_t sc, const minix_syscall_descriptor_t *scdesc, minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
+{
+    minix_replay_call_t call = {
+        .sc = sc,
+        .func = func,
+        .live = !scdesc->host,
+    };
+
+    call.input_hash = MINIXCompat_Replay_Hash(0, msg, sizeof(minix_message_t));
+    if ((sc == minix_syscall_write) && (message->m1_i2 > 0)) {
+        call.input_hash = MINIXCompat_Replay_Hash(call.input_hash, message->m1_p1, (uint32_t) message->m1_i2);
+    }
+
+    // A call that only changes the state of the emulator is made either way, and recorded before it's made in case it never returns.
+
+    if (call.live) {
+        MINIXCompat_Replay_Call(&call, msg);
+        return MINIXCompat_SysCall_Invoke(scdesc, func, src_dest, msg, message, out_result);
+    }
+
+    if (MINIXCompat_Replay_IsReplaying()) {
+        MINIXCompat_Replay_Call(&call, msg);
+
+        // A call that had to wait for another process has to give it the same turn it got.
+
+        if ((call.result == minix_syscall_result_retry) && !MINIXCompat_Processes_Yield()) {
+            MINIXCompat_Replay_Diverged("a call that waited has no other process to wait for");
+        }
+
+        // The recorded reply was put straight into emulated RAM, so read it back for anything that looks at the reply after the call, such as tracing.
+
+        if ((func == minix_syscall_func_both) && (call.result != minix_syscall_result_retry)) {
+            MINIXCompat_Message_Read(msg, scdesc->reply, message);
+        }
+
+        *out_result = call.out_result;
+        return call.result;
+    }
+
+    const minix_message_t request = *message;
+
+    call.result = MINIXCompat_SysCall_Invoke(scdesc, func, src_dest, msg, message, out_result);
+    call.out_result = *out_result;
+
+    if (call.result != minix_syscall_result_retry) {
+        if ((sc == minix_syscall_read) && (message->m_type > 0)) {
+            call.output = request.m1_p1;
+            call.output_len = (uint32_t) message->m_type;
+        } else if (sc == minix_syscall_stat) {
+            call.output = request.m1_p2;
+            call.output_len = sizeof(minix_stat_t);
+        } else if (sc == minix_syscall_fstat) {
+            call.output = request.m1_p1;
+            call.output_len = sizeof(minix_stat_t);
+        }
+    }
+
+    MINIXCompat_Replay_Call(&call, msg);
+
+    return call.result;
+}
+
+
 minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, uint32_t * _Nonnull out_result)
 {
     assert((func >= minix_syscall_func_send) && (func <= minix_syscall_func_both));
@@ -299,9 +509,9 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
 
     minix_syscall_result_t result = minix_syscall_result_failure;
 
-    // Get the message from emulator to host.
+    // The message is decoded into and replied from this buffer, so nothing is allocated per call.
 
-    minix_message_t *message = MINIXCompat_RAM_Copy_Block_To_Host(msg, sizeof(minix_message_t));
+    minix_message_t message;
 
     if ((func == minix_syscall_func_send) || (func == minix_syscall_func_both)) {
         // Figure out the system call to which the message corresponds, and call the appropriate function.
@@ -318,20 +528,32 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
             // Almost all "system calls" are sent to the MM or FS.
             case minix_task_fs:
             case minix_task_mm: {
-                minix_syscall_t sc = ntohs(message->m_type);
+                minix_syscall_t sc = MINIXCompat_RAM_Read_16(msg + offsetof(minix_message_t, m_type));
                 assert((sc >= minix_syscall_unused0) && (sc <= minix_syscall_unused69));
 #if DEBUG_SYSCALL_MECHANISM
                 const char *scn = minix_syscall_name[sc];
                 fprintf(stderr, "syscall(%d): %s (%hd)\n", getpid(), scn, sc);
 #endif
-                minix_syscall_impl scimpl = minix_syscall_table[sc];
-                if (scimpl == NULL) {
+                const minix_syscall_descriptor_t *scdesc = &minix_syscall_table[sc];
+                if (scdesc->impl == NULL) {
 #if DEBUG_SYSCALL_MECHANISM
                     fprintf(stderr, "unimplemented syscall: %s (%hd)\n", scn, sc);
 #endif
                     result = minix_syscall_result_failure;
                 } else {
-                    result = scimpl(func, src_dest, msg, message, out_result);
+                    const uint64_t sc_start = MINIXCompat_Stats_SysCall_Begin();
+                    MINIXCompat_Trace_SysCall_Enter(sc, msg);
+
+                    MINIXCompat_Message_Read(msg, scdesc->request, &message);
+
+                    if (MINIXCompat_Replay_IsActive()) {
+                        result = MINIXCompat_SysCall_RecordOrReplay(sc, scdesc, func, src_dest, msg, &message, out_result);
+                    } else {
+                        result = MINIXCompat_SysCall_Invoke(scdesc, func, src_dest, msg, &message, out_result);
+                    }
+
+                    MINIXCompat_Trace_SysCall_Exit(sc, result, message.m_type);
+                    MINIXCompat_Stats_SysCall_End(sc, sc_start);
                 }
             } break;
 
@@ -351,12 +573,6 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
                 result = minix_syscall_result_failure;
             } break;
         }
-
-        // If the sender is expecting a response beyond the value of `d0.l`, it should have adjusted the message it was given to contain that response and ensured it's appropriately swapped.
-
-        if (func == minix_syscall_func_both) {
-            MINIXCompat_RAM_Copy_Block_From_Host(msg, message, sizeof(minix_message_t));
-        }
     } else if (func == minix_syscall_func_receive) {
         // Blocking and waiting for a message via receive() isn't actually done by any user processes in the default system, so we aren't supporting it (yet).
 #if DEBUG_SYSCALL_MECHANISM
@@ -368,8 +584,6 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
         assert(false);
     }
 
-    free(message);
-
     return result;
 }
 
@@ -378,13 +592,14 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
 
 /*
  The system call implementations is that they should be thin wrappers that call the relevant subsystem; in other words, they shouldn't do much more than argument/result transcoding, while the appropriate subsystem is called to do the real work.
+
+ Each implementation receives its request already decoded to host byte order according to its descriptor, and fills in its reply in host byte order for the dispatcher to encode.
  */
 
 /*! MINIX `_exit(2)` implementation. */
 minix_syscall_result_t MINIXCompat_SysCall_exit(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
 {
     // exit uses mess1
-    MINIXCompat_Message_Swap(mess1, message);
 
     int16_t value = message->m1_i1;
 
@@ -411,8 +626,6 @@ minix_syscall_result_t MINIXCompat_SysCall_fork(minix_syscall_func_t func, uint1
     MINIXCompat_Message_Clear(message);
     message->m_type = minix_pid;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -424,18 +637,24 @@ minix_syscall_result_t MINIXCompat_SysCall_read(minix_syscall_func_t func, uint1
     // - m1_i2: nbytes
     // - m1_p1: buf
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     minix_fd_t minix_fd = message->m1_i1;
     int16_t minix_nbytes = message->m1_i2;
     m68k_address_t minix_buf = message->m1_p1;
 
-    uint8_t *buf = calloc(minix_nbytes, sizeof(uint8_t));
+    // A read from an empty pipe would block the whole host process, so under the in-process scheduler let the other processes here run in the meantime, since one may be what fills it.
+
+    while (!MINIXCompat_File_PipeIsReady(minix_fd, false, false)) {
+        if (MINIXCompat_Processes_Yield()) {
+            return minix_syscall_result_retry;
+        }
+        (void) MINIXCompat_File_PipeIsReady(minix_fd, false, true);
+    }
 
-    int16_t result = MINIXCompat_File_Read(minix_fd, buf, minix_nbytes);
+    // Read directly into the buffer in emulated RAM.
 
+    int16_t result = MINIXCompat_File_Read(minix_fd, minix_buf, minix_nbytes);
     if (result > 0) {
-        MINIXCompat_RAM_Copy_Block_From_Host(minix_buf, buf, result);
+        MINIXCompat_Stats_Transfer(false, (uint32_t) result);
     }
 
     // raed(2) replies with mess1
@@ -444,8 +663,6 @@ minix_syscall_result_t MINIXCompat_SysCall_read(minix_syscall_func_t func, uint1
     MINIXCompat_Message_Clear(message);
     message->m_type = result;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -457,15 +674,49 @@ minix_syscall_result_t MINIXCompat_SysCall_write(minix_syscall_func_t func, uint
     // - m1_i2: nbytes
     // - m1_p1: buf
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     minix_fd_t minix_fd = message->m1_i1;
     int16_t minix_nbytes = message->m1_i2;
     m68k_address_t minix_buf = message->m1_p1;
 
-    uint8_t *buf = MINIXCompat_RAM_Copy_Block_To_Host(minix_buf, minix_nbytes);
+    // Write directly from the buffer in emulated RAM.
 
-    int16_t result = MINIXCompat_File_Write(minix_fd, buf, minix_nbytes);
+    int16_t result;
+    if (MINIXCompat_File_IsPipe(minix_fd) && (minix_nbytes > 0) && ((MINIXCompat_Processes_Quantum() != 0) || (minix_pipe_write_done != 0))) {
+        // A write to a full pipe would block the whole host process while other processes here may be what drains it, so write it a piece at a time that fits, and let them run whenever none does. Making the call again picks up where it left off.
+
+        int16_t done = minix_pipe_write_done;
+        minix_pipe_write_done = 0;
+
+        result = 0;
+        while (done < minix_nbytes) {
+            if (!MINIXCompat_File_PipeIsReady(minix_fd, true, false)) {
+                if (MINIXCompat_Processes_Yield()) {
+                    minix_pipe_write_done = done;
+                    return minix_syscall_result_retry;
+                }
+                (void) MINIXCompat_File_PipeIsReady(minix_fd, true, true);
+            }
+
+            const int16_t piece = ((minix_nbytes - done) < PIPE_BUF) ? (minix_nbytes - done) : PIPE_BUF;
+            result = MINIXCompat_File_Write(minix_fd, minix_buf + (m68k_address_t) done, piece);
+            if (result < 0) {
+                break;
+            }
+            MINIXCompat_Stats_Transfer(true, (uint32_t) result);
+            done += result;
+        }
+
+        // Whatever was written before any error is still reported, like a short write.
+
+        if (done > 0) {
+            result = done;
+        }
+    } else {
+        result = MINIXCompat_File_Write(minix_fd, minix_buf, minix_nbytes);
+        if (result > 0) {
+            MINIXCompat_Stats_Transfer(true, (uint32_t) result);
+        }
+    }
 
     // write(2) replies with mess1
     // - m_type: result
@@ -473,8 +724,6 @@ minix_syscall_result_t MINIXCompat_SysCall_write(minix_syscall_func_t func, uint
     MINIXCompat_Message_Clear(message);
     message->m_type = result;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -497,18 +746,19 @@ minix_syscall_result_t MINIXCompat_SysCall_open(minix_syscall_func_t func, uint1
     //
     // Thus check flags for O_CREAT being set first, since that indicates which message structure is used.
 
-    int16_t minix_flags = htons(message->m1_i2);
+    // The dispatcher decodes mess1, whose m1_i2 is in the same place as m3_i2.
+
+    int16_t minix_flags = message->m1_i2;
     int16_t minix_mode;
     m68k_address_t minix_name;
     int16_t minix_name_len;
 
     if (minix_flags & minix_O_CREAT) {
-        MINIXCompat_Message_Swap(mess1, message);
         minix_name_len = message->m1_i1;
         minix_name = message->m1_p1;
         minix_mode = message->m1_i3;
     } else {
-        MINIXCompat_Message_Swap(mess3, message);
+        MINIXCompat_Message_Read(msg, minix_message_layout_mess3, message);
         minix_name_len = message->m3_i1;
         minix_name = message->m3_p1;
         minix_mode = 0; // only needed on creation
@@ -517,23 +767,18 @@ minix_syscall_result_t MINIXCompat_SysCall_open(minix_syscall_func_t func, uint1
     // Copy the name (path) to host memory.
     // The name will include any trailing '\0' character. (Use of the pointer from the message rather than the message's inline copy is intentional, since the latter can only handle up to 14 characters.)
 
-    char *minix_name_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_name, minix_name_len);
+    char minix_name_on_host[MINIXCOMPAT_SYSCALL_PATH_MAX];
+    int16_t copy_err = MINIXCompat_SysCall_CopyPath(minix_name, minix_name_len, minix_name_on_host);
 
     // Open the file at that path, relative to MINIXCOMPAT_DIR.
 
-    minix_fd_t fd = MINIXCompat_File_Open(minix_name_on_host, minix_flags, minix_mode);
+    minix_fd_t fd = (copy_err != 0) ? copy_err : MINIXCompat_File_Open(minix_name_on_host, minix_flags, minix_mode);
 
     // Return the result via mess1.m_type containing the error or the emulator-side fd.
 
     MINIXCompat_Message_Clear(message);
     message->m_type = fd;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
-    // Clean up.
-
-    free(minix_name_on_host);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -542,7 +787,6 @@ minix_syscall_result_t MINIXCompat_SysCall_close(minix_syscall_func_t func, uint
 {
     // close(2) sends mess1
     // - m.m1_i1: fd
-    MINIXCompat_Message_Swap(mess1, message);
 
     minix_fd_t minix_fd = message->m1_i1;
 
@@ -554,8 +798,6 @@ minix_syscall_result_t MINIXCompat_SysCall_close(minix_syscall_func_t func, uint
     MINIXCompat_Message_Clear(message);
     message->m_type = result;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -567,6 +809,12 @@ minix_syscall_result_t MINIXCompat_SysCall_wait(minix_syscall_func_t func, uint1
     int16_t minix_stat = 0;
     minix_pid_t minix_pid = MINIXCompat_Processes_wait(&minix_stat);
 
+    // If the in-process scheduler has suspended the caller until a child exits, it will make the call again then.
+
+    if (minix_pid == MINIXCompat_Processes_Blocked) {
+        return minix_syscall_result_retry;
+    }
+
     // wait(2) receives mess2:
     // m_type = pid
     // m2_i1 = stat
@@ -575,8 +823,6 @@ minix_syscall_result_t MINIXCompat_SysCall_wait(minix_syscall_func_t func, uint1
     message->m_type = minix_pid;
     message->m2_i1 = minix_stat;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -589,7 +835,6 @@ minix_syscall_result_t MINIXCompat_SysCall_creat(minix_syscall_func_t func, uint
     // - m3_p1: name
     // - m3_ca1: name (copied into place)
 
-    MINIXCompat_Message_Swap(mess3, message);
     int16_t minix_name_len = message->m3_i1;
     m68k_address_t minix_name = message->m3_p1;
     int16_t minix_mode = message->m3_i2;
@@ -597,23 +842,18 @@ minix_syscall_result_t MINIXCompat_SysCall_creat(minix_syscall_func_t func, uint
     // Copy the name (path) to host memory.
     // The name will include any trailing '\0' character. (Use of the pointer from the message rather than the message's inline copy is intentional, since the latter can only handle up to 14 characters.)
 
-    char *minix_name_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_name, minix_name_len);
+    char minix_name_on_host[MINIXCOMPAT_SYSCALL_PATH_MAX];
+    int16_t copy_err = MINIXCompat_SysCall_CopyPath(minix_name, minix_name_len, minix_name_on_host);
 
     // Create the file at that path, relative to MINIXCOMPAT_DIR.
 
-    minix_fd_t fd = MINIXCompat_File_Create(minix_name_on_host, minix_mode);
+    minix_fd_t fd = (copy_err != 0) ? copy_err : MINIXCompat_File_Create(minix_name_on_host, minix_mode);
 
     // Return the result via mess1.m_type containing the error or the emulator-side fd.
 
     MINIXCompat_Message_Clear(message);
     message->m_type = fd;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
-    // Clean up.
-
-    free(minix_name_on_host);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -625,18 +865,18 @@ minix_syscall_result_t MINIXCompat_SysCall_unlink(minix_syscall_func_t func, uin
     // - m3_p1: name
     // - m3_ca1: name (copied into place)
 
-    MINIXCompat_Message_Swap(mess3, message);
     int16_t minix_name_len = message->m3_i1;
     m68k_address_t minix_name = message->m3_p1;
 
     // Copy the name (path) to host memory.
     // The name will include any trailing '\0' character. (Use of the pointer from the message rather than the message's inline copy is intentional, since the latter can only handle up to 14 characters.)
 
-    char *minix_name_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_name, minix_name_len);
+    char minix_name_on_host[MINIXCOMPAT_SYSCALL_PATH_MAX];
+    int16_t copy_err = MINIXCompat_SysCall_CopyPath(minix_name, minix_name_len, minix_name_on_host);
 
     // Unlink the file at that path, relative to MINIXCOMPAT_DIR.
 
-    int16_t unlink_err = MINIXCompat_File_Unlink(minix_name_on_host);
+    int16_t unlink_err = (copy_err != 0) ? copy_err : MINIXCompat_File_Unlink(minix_name_on_host);
 
     // unlink(2) responds with mess1
     // - mess1.m_type: result
@@ -644,14 +884,8 @@ minix_syscall_result_t MINIXCompat_SysCall_unlink(minix_syscall_func_t func, uin
     MINIXCompat_Message_Clear(message);
     message->m_type = unlink_err;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     *out_result = unlink_err;
 
-    // Clean up.
-
-    free(minix_name_on_host);
-
     return minix_syscall_result_success;
 }
 
@@ -672,8 +906,6 @@ minix_syscall_result_t MINIXCompat_SysCall_time(minix_syscall_func_t func, uint1
     message->m_type = time_result;
     message->m2_l1 = (uint32_t) t;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     *out_result = (uint32_t) t;
 
     return minix_syscall_result_success;
@@ -691,21 +923,18 @@ minix_syscall_result_t MINIXCompat_SysCall_brk(minix_syscall_func_t func, uint16
     // brk(2) sends mess1
     // - m.m1_p1: addr
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     m68k_address_t minix_requested_addr = message->m1_p1;
     m68k_address_t minix_resulting_addr;
     int16_t minix_brk_error = 0;
 
-    // There is only one process and it has full run of the address space up to 0x00FE0000, so just allow any value up to that. Also keep track of the current break since we never allow it to be set lower.
-
-    static m68k_address_t minix_current_break = 0;
+    // There is only one process and it has full run of the address space up to 0x00FE0000, so just allow any value up to that. Also keep track of the current break since we never allow it to be set lower, and note it so the next exec(2) knows how much RAM to reset.
 
     if ((minix_requested_addr < MINIXCompat_Executable_Limit)
         && (minix_requested_addr >= minix_current_break))
     {
         minix_resulting_addr = minix_requested_addr;
         minix_current_break = minix_resulting_addr;
+        MINIXCompat_RAM_Note_High_Water(minix_current_break);
     } else {
         minix_brk_error = -minix_ENOMEM;
         minix_resulting_addr = 0xFFFFFFFF; // MINIX-side ((char *)-1) value
@@ -718,8 +947,6 @@ minix_syscall_result_t MINIXCompat_SysCall_brk(minix_syscall_func_t func, uint16
     message->m_type = minix_brk_error;
     message->m2_p1 = minix_resulting_addr;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -732,8 +959,6 @@ minix_syscall_result_t MINIXCompat_SysCall_stat(minix_syscall_func_t func, uint1
     // - m1_p2: buffer
     // - m1_ca1: name
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     int16_t minix_name_len = message->m1_i1;
     m68k_address_t minix_name = message->m1_p1;
     m68k_address_t minix_stat_buf = message->m1_p2;
@@ -741,12 +966,13 @@ minix_syscall_result_t MINIXCompat_SysCall_stat(minix_syscall_func_t func, uint1
     // Copy the name (path) to host memory.
     // The name will include any trailing '\0' character. (Use of the pointer from the message rather than the message's inline copy is intentional, since the latter can only handle up to 14 characters.)
 
-    char *minix_name_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_name, minix_name_len);
+    char minix_name_on_host[MINIXCOMPAT_SYSCALL_PATH_MAX];
+    int16_t copy_err = MINIXCompat_SysCall_CopyPath(minix_name, minix_name_len, minix_name_on_host);
 
     // Do the stat(2).
 
-    minix_stat_t host_stat_buf;
-    int16_t stat_err = MINIXCompat_File_Stat(minix_name_on_host, &host_stat_buf);
+    minix_stat_t host_stat_buf = {0};
+    int16_t stat_err = (copy_err != 0) ? copy_err : MINIXCompat_File_Stat(minix_name_on_host, &host_stat_buf);
 
     // Send the host-side MINIX stat buf to MINIX. (Even if there's an error, this is OK to do, the caller reserved space.)
 
@@ -758,12 +984,6 @@ minix_syscall_result_t MINIXCompat_SysCall_stat(minix_syscall_func_t func, uint1
     MINIXCompat_Message_Clear(message);
     message->m_type = stat_err;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
-    // Clean up.
-
-    free(minix_name_on_host);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -775,8 +995,6 @@ minix_syscall_result_t MINIXCompat_SysCall_lseek(minix_syscall_func_t func, uint
     // - m2_i2: whence
     // - m2_l1: offset
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     minix_fd_t minix_fd = message->m2_i1;
     int16_t minix_whence = message->m2_i2;
     minix_off_t minix_offset = message->m2_l1;
@@ -792,8 +1010,6 @@ minix_syscall_result_t MINIXCompat_SysCall_lseek(minix_syscall_func_t func, uint
     message->m_type = (seek_err == 0) ? minix_offset : seek_err;
     message->m2_l1 = minix_offset;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     *out_result = (seek_err == 0) ? minix_offset : ((int32_t)seek_err);
     return minix_syscall_result_success;
 }
@@ -816,8 +1032,6 @@ minix_syscall_result_t MINIXCompat_SysCall_getpid(minix_syscall_func_t func, uin
     message->m_type = minix_pid;
     message->m1_i1 = minix_ppid;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -825,15 +1039,12 @@ minix_syscall_result_t MINIXCompat_SysCall_getpid(minix_syscall_func_t func, uin
 minix_syscall_result_t MINIXCompat_SysCall_getuid(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
 {
     // getuid sends mess1
-    MINIXCompat_Message_Swap(mess1, message);
 
     // getuid receives mess2 in response
     MINIXCompat_Message_Clear(message);
     message->m_type = minix_default_uid;
     message->m_u.m_m2.m2i1 = minix_default_euid;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -844,8 +1055,6 @@ minix_syscall_result_t MINIXCompat_SysCall_fstat(minix_syscall_func_t func, uint
     // - m1_i1: fd
     // - m1_p1: buffer
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     minix_fd_t minix_fd = message->m1_i1;
     m68k_address_t minix_stat_buf = message->m1_p1;
 
@@ -864,8 +1073,6 @@ minix_syscall_result_t MINIXCompat_SysCall_fstat(minix_syscall_func_t func, uint
     MINIXCompat_Message_Clear(message);
     message->m_type = stat_err;
 
-    MINIXCompat_Message_Swap(mess1, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -878,7 +1085,6 @@ minix_syscall_result_t MINIXCompat_SysCall_access(minix_syscall_func_t func, uin
     // - m3_p1: name
     // - m3_ca1: name (copied into place)
 
-    MINIXCompat_Message_Swap(mess3, message);
     int16_t minix_name_len = message->m3_i1;
     m68k_address_t minix_name = message->m3_p1;
     minix_mode_t minix_mode = message->m3_i2;
@@ -886,11 +1092,12 @@ minix_syscall_result_t MINIXCompat_SysCall_access(minix_syscall_func_t func, uin
     // Copy the name (path) to host memory.
     // The name will include any trailing '\0' character. (Use of the pointer from the message rather than the message's inline copy is intentional, since the latter can only handle up to 14 characters.)
 
-    char *minix_name_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_name, minix_name_len);
+    char minix_name_on_host[MINIXCOMPAT_SYSCALL_PATH_MAX];
+    int16_t copy_err = MINIXCompat_SysCall_CopyPath(minix_name, minix_name_len, minix_name_on_host);
 
     // Check access on the file at that path, relative to MINIXCOMPAT_DIR.
 
-    int16_t access_err = MINIXCompat_File_Access(minix_name_on_host, minix_mode);
+    int16_t access_err = (copy_err != 0) ? copy_err : MINIXCompat_File_Access(minix_name_on_host, minix_mode);
 
     // access(2) responds with mess1
     // - mess1.m_type: result
@@ -898,11 +1105,53 @@ minix_syscall_result_t MINIXCompat_SysCall_access(minix_syscall_func_t func, uin
     MINIXCompat_Message_Clear(message);
     message->m_type = access_err;
 
-    MINIXCompat_Message_Swap(mess1, message);
+    return minix_syscall_result_success_empty;
+}
+
+/*! MINIX `dup(2)` and `dup2(2)` implementation. */
+minix_syscall_result_t MINIXCompat_SysCall_dup(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
+{
+    // dup(2) sends mess1
+    // - m1_i1: fd, with 0100 added for dup2(2)
+    // - m1_i2: fd2, for dup2(2)
+
+    const int16_t minix_dup2_mask = 0100;
+
+    minix_fd_t minix_fd = message->m1_i1 & ~minix_dup2_mask;
+    minix_fd_t minix_fd2 = (message->m1_i1 & minix_dup2_mask) ? message->m1_i2 : -1;
 
-    // Clean up.
+    // dup2(2) with a negative fd2 is an error, not a request for the lowest available descriptor.
 
-    free(minix_name_on_host);
+    minix_fd_t result = ((minix_fd2 < 0) && (message->m1_i1 & minix_dup2_mask)) ? -minix_EBADF : MINIXCompat_File_Dup(minix_fd, minix_fd2);
+
+    // dup(2) replies with mess1
+    // - m_type: result
+
+    MINIXCompat_Message_Clear(message);
+    message->m_type = result;
+
+    return minix_syscall_result_success_empty;
+}
+
+/*! MINIX `pipe(2)` implementation. */
+minix_syscall_result_t MINIXCompat_SysCall_pipe(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
+{
+    // pipe(2) sends mess1 with no parameters
+
+    minix_fd_t minix_read_fd = -1, minix_write_fd = -1;
+    int16_t result = MINIXCompat_File_Pipe(&minix_read_fd, &minix_write_fd);
+
+    // pipe(2) replies with mess1
+    // - m_type: result
+    // - m1_i1: read fd
+    // - m1_i2: write fd
+
+    MINIXCompat_Message_Clear(message);
+    message->m_type = result;
+    if (result == 0) {
+        message->m1_i1 = minix_read_fd;
+        message->m1_i2 = minix_write_fd;
+    }
 
     return minix_syscall_result_success_empty;
 }
@@ -914,7 +1163,6 @@ minix_syscall_result_t MINIXCompat_SysCall_kill(minix_syscall_func_t func, uint1
     // - m1_i1: pid
     // - m1_i2: signal
 
-    MINIXCompat_Message_Swap(mess1, message);
     minix_pid_t minix_pid = message->m1_i1;
     minix_signal_t minix_signal = message->m1_i2;
 
@@ -926,8 +1174,6 @@ minix_syscall_result_t MINIXCompat_SysCall_kill(minix_syscall_func_t func, uint1
     MINIXCompat_Message_Clear(message);
     message->m_type = kill_result;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -935,15 +1181,12 @@ minix_syscall_result_t MINIXCompat_SysCall_kill(minix_syscall_func_t func, uint1
 minix_syscall_result_t MINIXCompat_SysCall_getgid(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
 {
     // getuid(2) sends mess1
-    MINIXCompat_Message_Swap(mess1, message);
 
     // getuid(2) receives mess2 in response
     MINIXCompat_Message_Clear(message);
     message->m_type = minix_default_gid;
     message->m_u.m_m2.m2i1 = minix_default_egid;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     return minix_syscall_result_success_empty;
 }
 
@@ -951,7 +1194,6 @@ minix_syscall_result_t MINIXCompat_SysCall_getgid(minix_syscall_func_t func, uin
 minix_syscall_result_t MINIXCompat_SysCall_signal(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, minix_message_t *message, uint32_t * _Nonnull out_result)
 {
     // signal(2) sends mess6
-    MINIXCompat_Message_Swap(mess6, message);
 
     minix_signal_t minix_signal = message->m6_i1;
     minix_sighandler_t new_handler = message->m6_f1;
@@ -964,8 +1206,6 @@ minix_syscall_result_t MINIXCompat_SysCall_signal(minix_syscall_func_t func, uin
     MINIXCompat_Message_Clear(message);
     message->m_type = 0;
 
-    MINIXCompat_Message_Swap(mess2, message);
-
     // signal(2) receives the old handler via d0.l
 
     *out_result = old_handler;
@@ -981,7 +1221,6 @@ minix_syscall_result_t MINIXCompat_SysCall_exece(minix_syscall_func_t func, uint
     // - m2_i2: stack size
     // - m1_p1: path
     // - m1_p2: stack pointer
-    MINIXCompat_Message_Swap(mess1, message);
 
     int16_t minix_path_len = message->m1_i1;
     m68k_address_t minix_path = message->m1_p1;
@@ -992,7 +1231,8 @@ minix_syscall_result_t MINIXCompat_SysCall_exece(minix_syscall_func_t func, uint
     // Copy the path to host memory.
     // The path will include any trailing '\0' character.
 
-    char *minix_path_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_path, minix_path_len);
+    char minix_path_on_host[MINIXCOMPAT_SYSCALL_PATH_MAX];
+    int16_t exec_err = MINIXCompat_SysCall_CopyPath(minix_path, minix_path_len, minix_path_on_host);
 
     /*
      Copy the stack snapshot to host memory.
@@ -1004,26 +1244,40 @@ minix_syscall_result_t MINIXCompat_SysCall_exece(minix_syscall_func_t func, uint
      0x04+(4*(argc+1+m): envp[m] (with m from 0 to envc) as offsets from 0
      0x04+(4*(argc+1+envc): NULL to terminate envp
      0x04+(4*(argc+1+envc+1): start of storage for argv and envp values
+
+     The snapshot can be no larger than the `int16_t` size passed for it, so it's copied into a static buffer, which also survives the emulator being reset by the exec(2).
      */
 
-    uint8_t *minix_stack_on_host = MINIXCompat_RAM_Copy_Block_To_Host(minix_stack, minix_stack_size);
+    static uint8_t minix_stack_on_host[INT16_MAX];
+
+    if ((exec_err == 0)
+        && ((minix_stack_size <= 0)
+            || (minix_stack >= MINIXCompat_RAM_Size)
+            || ((MINIXCompat_RAM_Size - minix_stack) < (uint32_t) minix_stack_size)))
+    {
+        exec_err = -minix_EFAULT;
+    }
 
-    // Perform the exec(2) itself. This will do things like reset the emulator and install an adjusted version of the stack snapshot in emulator RAM.
+    if (exec_err == 0) {
+        MINIXCompat_RAM_Copy_Block_To_Buffer(minix_stack, minix_stack_on_host, minix_stack_size);
 
-    int16_t exec_err = MINIXCompat_Processes_ExecuteWithStackBlock(minix_path_on_host, minix_stack_on_host, minix_stack_size);
+        // Perform the exec(2) itself. This will do things like reset the emulator and install an adjusted version of the stack snapshot in emulator RAM.
+        // The new program inherits the open files, but not any buffering done on behalf of the old one.
+
+        MINIXCompat_Filesystem_Flush();
+        exec_err = MINIXCompat_Processes_ExecuteWithStackBlock(minix_path_on_host, minix_stack_on_host, minix_stack_size);
+    }
 
     // exec(2) receives mess2
     // - m_type: result (OK)
 
-    // If the exec(2) failed, reply with a message containing the failure. If the exec(2) succeeds, there's no reply, just the execution starting.
+    // If the exec(2) failed, reply with a message containing the failure. If the exec(2) succeeds, there's no reply, just the execution starting, so the descriptor for exece(2) has no reply layout and this writes it directly.
 
-    MINIXCompat_Message_Clear(message);
-    message->m_type = exec_err;
-    MINIXCompat_Message_Swap(mess2, message);
-
-    // Clean up.
-    
-    free(minix_path_on_host);
+    if ((exec_err != 0) && (func == minix_syscall_func_both)) {
+        MINIXCompat_Message_Clear(message);
+        message->m_type = exec_err;
+        MINIXCompat_Message_Write(msg, minix_message_layout_mess2, message);
+    }
 
     return minix_syscall_result_success;
 }
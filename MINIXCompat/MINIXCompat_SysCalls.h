@@ -9,6 +9,7 @@
 #ifndef MINIXCompat_SysCalls_h
 #define MINIXCompat_SysCalls_h
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "MINIXCompat_Types.h"
@@ -112,6 +113,37 @@ typedef enum minix_syscall_func: uint16_t {
  */
 MINIXCOMPAT_EXTERN void MINIXCompat_SysCall_Initialize(void);
 
+/*!
+ Reset the per-executable System Call state, such as the current break, for a newly loaded executable.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_SysCall_Reset(void);
+
+/*! The System Call state of a MINIX process that isn't running, such as its break, for the in-process scheduler. */
+typedef struct MINIXCompat_SysCall_Context MINIXCompat_SysCall_Context_t;
+
+/*! Create a context for the child of a `fork(2)` by the running process, with a copy of its state. */
+MINIXCOMPAT_EXTERN MINIXCompat_SysCall_Context_t * _Nonnull MINIXCompat_SysCall_Context_Fork(void);
+
+/*! Switch the running process out, moving its state into a new context. */
+MINIXCOMPAT_EXTERN MINIXCompat_SysCall_Context_t * _Nonnull MINIXCompat_SysCall_Context_Save(void);
+
+/*! Switch in the process whose state is in \a context, which is consumed. */
+MINIXCOMPAT_EXTERN void MINIXCompat_SysCall_Context_Restore(MINIXCompat_SysCall_Context_t * _Nonnull context);
+
+/*! Release \a context, such as when its process has exited. */
+MINIXCOMPAT_EXTERN void MINIXCompat_SysCall_Context_Free(MINIXCompat_SysCall_Context_t * _Nullable context);
+
+/*! Write the system call state, like the break, to the snapshot \a fd. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_SysCall_Snapshot_Write(int fd);
+
+/*! Restore the system call state from the snapshot \a fd. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_SysCall_Snapshot_Read(int fd);
+
+/*!
+ Get the name of system call \a sc, for diagnostics.
+ */
+MINIXCOMPAT_EXTERN const char * _Nonnull MINIXCompat_SysCall_Name(minix_syscall_t sc);
+
 
 /*!
  The result of a system call indicates whether/how to pass a value back in `d0.l` in the emulator.
@@ -125,6 +157,9 @@ typedef enum minix_syscall_result: int16_t {
 
     /*! The call completed successfully and has an updated `d0.l` value. */
     minix_syscall_result_success        = 1,
+
+    /*! The call can't complete until another process does something, so the caller is suspended and makes the call again when it's resumed; its message and registers are left untouched. */
+    minix_syscall_result_retry        = 2,
 } minix_syscall_result_t;
 
 /*!
@@ -138,7 +173,7 @@ typedef enum minix_syscall_result: int16_t {
  - On return:
    - `d0.l` *may* contain a result.
 
- MINIX can also save and restore task state, including performing task switches, around system call invocations. However our implementation doesn't since it only runs a single task.
+ MINIX can also save and restore task state, including performing task switches, around system call invocations. Our implementation only does so under the in-process scheduler, and then only between system calls: a call that has to wait returns ``minix_syscall_result_retry`` and is made again once its process is switched back in.
 
  The return value from this function is a tri-state ``minix_syscall_result_t``.
 */
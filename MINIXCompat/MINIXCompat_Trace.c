@@ -0,0 +1,283 @@
+//
+//  MINIXCompat_Trace.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Trace.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Processes.h"
+#include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_Utilities.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The number of records in a trace unless `MINIXCOMPAT_TRACE_RECORDS` says otherwise. */
+static const uint32_t MINIXCompat_Trace_Default_Records = 65536;
+
+/*! The directory to which traces are written, or `NULL` if tracing isn't enabled. */
+static const char *MINIXCOMPAT_TRACE = NULL;
+
+/*! The number of records in each trace. */
+static uint32_t MINIXCompat_Trace_Capacity = 0;
+
+/*! The mapping of this host process's trace file, or `NULL` if there isn't one. */
+static minix_trace_header_t *MINIXCompat_Trace_Header = NULL;
+
+/*! The records following the header in the mapping. */
+static minix_trace_record_t *MINIXCompat_Trace_Records = NULL;
+
+/*! The size of the mapping. */
+static size_t MINIXCompat_Trace_Mapping_Size = 0;
+
+
+_Static_assert(sizeof(minix_trace_header_t) == 64, "trace header must stay the size of a record");
+_Static_assert(sizeof(minix_trace_record_t) == 64, "trace records must stay a fixed size");
+
+
+/*! Create and map the trace file for this host process; if that fails, this host process just isn't traced. */
+static void MINIXCompat_Trace_Open(void)
+{
+    char trace_path[PATH_MAX];
+    int len = snprintf(trace_path, PATH_MAX, "%s/%ld.trace", MINIXCOMPAT_TRACE, (long) getpid());
+    if ((len <= 0) || (len >= PATH_MAX)) {
+        return;
+    }
+
+    int trace_fd = open(trace_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (trace_fd == -1) {
+        return;
+    }
+
+    // The file is sparse until records are written, so an idle process costs next to nothing.
+
+    const size_t mapping_size = sizeof(minix_trace_header_t) + ((size_t) MINIXCompat_Trace_Capacity * sizeof(minix_trace_record_t));
+
+    void *mapping = MAP_FAILED;
+    if (ftruncate(trace_fd, (off_t) mapping_size) == 0) {
+        mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, trace_fd, 0);
+    }
+    close(trace_fd);
+
+    if (mapping == MAP_FAILED) {
+        unlink(trace_path);
+        return;
+    }
+
+    MINIXCompat_Trace_Header = mapping;
+    MINIXCompat_Trace_Records = (minix_trace_record_t *) ((uint8_t *) mapping + sizeof(minix_trace_header_t));
+    MINIXCompat_Trace_Mapping_Size = mapping_size;
+
+    MINIXCompat_Trace_Header->version = MINIXCOMPAT_TRACE_VERSION;
+    MINIXCompat_Trace_Header->record_size = sizeof(minix_trace_record_t);
+    MINIXCompat_Trace_Header->capacity = MINIXCompat_Trace_Capacity;
+    MINIXCompat_Trace_Header->host_pid = (int64_t) getpid();
+    atomic_store(&MINIXCompat_Trace_Header->next, 0);
+
+    // The magic number goes in last, so a dumper never sees a header that's only partly filled in.
+
+    MINIXCompat_Trace_Header->magic = MINIXCOMPAT_TRACE_MAGIC;
+}
+
+
+void MINIXCompat_Trace_Initialize(void)
+{
+    const char *trace_dir = getenv("MINIXCOMPAT_TRACE");
+    if ((trace_dir == NULL) || (trace_dir[0] == '\0')) {
+        return;
+    }
+
+    MINIXCompat_Trace_Capacity = MINIXCompat_Trace_Default_Records;
+
+    const char *records = getenv("MINIXCOMPAT_TRACE_RECORDS");
+    if ((records != NULL) && (records[0] != '\0')) {
+        char *end = NULL;
+        unsigned long count = strtoul(records, &end, 10);
+        if ((*end != '\0') || (count == 0) || (count > (UINT32_MAX / sizeof(minix_trace_record_t)))) {
+            fprintf(stderr, "MINIXCompat: invalid MINIXCOMPAT_TRACE_RECORDS '%s', using %u\n", records, MINIXCompat_Trace_Default_Records);
+        } else {
+            MINIXCompat_Trace_Capacity = (uint32_t) count;
+        }
+    }
+
+    if (!MINIXCompat_Host_EnsureDirectory(trace_dir)) {
+        return;
+    }
+
+    MINIXCOMPAT_TRACE = trace_dir;
+    MINIXCompat_Trace_Open();
+}
+
+
+void MINIXCompat_Trace_Fork_Child(void)
+{
+    if (MINIXCompat_Trace_Header == NULL) {
+        return;
+    }
+
+    // The parent keeps recording into its own trace, which stays mapped in the parent.
+
+    munmap(MINIXCompat_Trace_Header, MINIXCompat_Trace_Mapping_Size);
+    MINIXCompat_Trace_Header = NULL;
+    MINIXCompat_Trace_Records = NULL;
+    MINIXCompat_Trace_Mapping_Size = 0;
+
+    MINIXCompat_Trace_Open();
+}
+
+
+/*!
+ Claim the next record in the ring for an \a event of the running process, with its time and cycle count filled in and everything else zero.
+
+ - Returns: The record to fill in, or `NULL` if tracing isn't enabled.
+ */
+static minix_trace_record_t * _Nullable MINIXCompat_Trace_Record(minix_trace_event_t event)
+{
+    if (MINIXCompat_Trace_Header == NULL) {
+        return NULL;
+    }
+
+    // Only this host process writes its trace, and never from a signal handler, but the ring is a shared mapping of its file, so the record is claimed with an atomic increment that a dumper reading the file meanwhile never sees half done.
+
+    const uint64_t n = atomic_fetch_add(&MINIXCompat_Trace_Header->next, 1);
+    minix_trace_record_t *record = &MINIXCompat_Trace_Records[n % MINIXCompat_Trace_Capacity];
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    minix_pid_t minix_pid, minix_ppid;
+    MINIXCompat_Processes_GetProcessIDs(&minix_pid, &minix_ppid);
+
+    memset(record, 0, sizeof(minix_trace_record_t));
+    record->time_ns = ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+    record->cycles = MINIXCompat_CPU_Cycles();
+    record->event = event;
+    record->minix_pid = minix_pid;
+
+    return record;
+}
+
+
+/*! Copy as much of the end of \a string into the text of \a record as fits, since the end of a path says the most about it. */
+static void MINIXCompat_Trace_Set_Text(minix_trace_record_t * _Nonnull record, const char * _Nonnull string)
+{
+    const size_t len = strlen(string);
+    const size_t capacity = sizeof(record->text) - 1;
+    const char *tail = (len > capacity) ? (string + (len - capacity)) : string;
+
+    memcpy(record->text, tail, strlen(tail));
+}
+
+
+void MINIXCompat_Trace_SysCall_Enter(minix_syscall_t sc, m68k_address_t msg)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_syscall_enter);
+    if (record == NULL) {
+        return;
+    }
+
+    record->code = sc;
+
+    // The message's layout depends on the call, so just record its first few longwords after the header for the dumper to show.
+
+    for (int i = 0; i < 4; i++) {
+        record->values[i] = (int32_t) MINIXCompat_RAM_Read_32(msg + 4 + (4 * i));
+    }
+
+    MINIXCompat_Trace_Set_Text(record, MINIXCompat_SysCall_Name(sc));
+}
+
+
+void MINIXCompat_Trace_SysCall_Exit(minix_syscall_t sc, minix_syscall_result_t result, int32_t reply)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_syscall_exit);
+    if (record == NULL) {
+        return;
+    }
+
+    record->code = sc;
+    record->values[0] = result;
+    record->values[1] = reply;
+}
+
+
+void MINIXCompat_Trace_Exec(const char *executable_path)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_exec);
+    if (record == NULL) {
+        return;
+    }
+
+    MINIXCompat_Trace_Set_Text(record, executable_path);
+}
+
+
+void MINIXCompat_Trace_Fork(minix_pid_t child)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_fork);
+    if (record == NULL) {
+        return;
+    }
+
+    record->code = child;
+}
+
+
+void MINIXCompat_Trace_Wait(minix_pid_t child, int16_t stat)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_wait);
+    if (record == NULL) {
+        return;
+    }
+
+    record->code = child;
+    record->values[0] = stat;
+}
+
+
+void MINIXCompat_Trace_Signal(int signal, minix_pid_t minix_pid)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_signal);
+    if (record == NULL) {
+        return;
+    }
+
+    record->code = signal;
+    record->values[0] = minix_pid;
+}
+
+
+void MINIXCompat_Trace_State(int old_state, int new_state)
+{
+    minix_trace_record_t *record = MINIXCompat_Trace_Record(minix_trace_event_state);
+    if (record == NULL) {
+        return;
+    }
+
+    record->code = new_state;
+    record->values[0] = old_state;
+}
+
+
+MINIXCOMPAT_SOURCE_END
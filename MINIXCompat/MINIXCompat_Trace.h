@@ -0,0 +1,124 @@
+//
+//  MINIXCompat_Trace.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Trace_h
+#define MINIXCompat_Trace_h
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Processes.h"
+#include "MINIXCompat_SysCalls.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+// MARK: - Trace Files
+
+/*! The magic number identifying a trace file, `MXTR`. */
+#define MINIXCOMPAT_TRACE_MAGIC 0x4d585452
+
+/*! The version of the trace file format; bump it whenever the format changes. */
+#define MINIXCOMPAT_TRACE_VERSION 1
+
+/*! The kinds of event recorded in a trace. */
+typedef enum minix_trace_event: uint16_t {
+    /*! A system call was made: `code` is its ``minix_syscall_t``, `values` are the first 16 bytes of its message after `m_type` as host-order longwords, and `text` is its name. */
+    minix_trace_event_syscall_enter = 1,
+
+    /*! A system call returned: `code` is its ``minix_syscall_t``, `values[0]` is its ``minix_syscall_result_t``, and `values[1]` is the `m_type` of its reply. */
+    minix_trace_event_syscall_exit = 2,
+
+    /*! An executable was loaded: `text` is the end of its MINIX path. */
+    minix_trace_event_exec = 3,
+
+    /*! A child was forked: `code` is its MINIX process ID. */
+    minix_trace_event_fork = 4,
+
+    /*! A child was waited for: `code` is its MINIX process ID, and `values[0]` its status. */
+    minix_trace_event_wait = 5,
+
+    /*! A signal was delivered: `code` is the signal, and `values[0]` the MINIX process ID it was delivered to, or `0` for a host signal. */
+    minix_trace_event_signal = 6,
+
+    /*! The execution state changed: `code` is the new ``MINIXCompat_Execution_State``, and `values[0]` the old one. */
+    minix_trace_event_state = 7,
+} minix_trace_event_t;
+
+/*!
+ The header of a trace file, in host byte order since trace files are never shared between hosts.
+
+ The header is followed by `capacity` records of `record_size` bytes, which are a ring: record `n` is at index `n % capacity`, and `next` is the number of records ever written, so only the last `capacity` of them are still there. A record is claimed by atomically incrementing `next`, so something reading the ring while it's written never sees a torn count.
+ */
+typedef struct minix_trace_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    int64_t host_pid;
+    _Atomic uint64_t next;
+    uint8_t reserved[32];
+} minix_trace_header_t;
+
+/*! One event in a trace, as described by ``minix_trace_event_t``. */
+typedef struct minix_trace_record {
+    /*! The host's monotonic clock, in nanoseconds; this is the same for every host process, so traces from a whole process tree can be merged. */
+    uint64_t time_ns;
+
+    /*! The emulated cycles the host process had run. */
+    uint64_t cycles;
+
+    uint16_t event;
+    minix_pid_t minix_pid;
+    int32_t code;
+    int32_t values[4];
+    char text[24];
+} minix_trace_record_t;
+
+
+// MARK: - Tracing
+
+/*!
+ Initialize tracing.
+
+ Tracing is only enabled if `MINIXCOMPAT_TRACE` names a host directory, which is created if necessary. Each host process then records events in a file there named for its host process ID, which holds a ring of the last `MINIXCOMPAT_TRACE_RECORDS` fixed-size records (65536 by default). The file is mapped into memory, so recording an event is just a few stores, and what was recorded survives a crash. `Tools/MINIXCompat_TraceDump` merges the traces of a whole process tree.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_Initialize(void);
+
+/*! Start a trace of its own for the child of a host `fork(2)`, so it doesn't record into its parent's. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_Fork_Child(void);
+
+/*! Record that system call \a sc is being made, with its message at \a msg. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_SysCall_Enter(minix_syscall_t sc, m68k_address_t msg);
+
+/*! Record that system call \a sc returned \a result, with \a reply as the `m_type` of its reply. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_SysCall_Exit(minix_syscall_t sc, minix_syscall_result_t result, int32_t reply);
+
+/*! Record that the executable at MINIX path \a executable_path was loaded. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_Exec(const char * _Nonnull executable_path);
+
+/*! Record that the running process forked \a child. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_Fork(minix_pid_t child);
+
+/*! Record that the running process waited for \a child, which exited with \a stat. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_Wait(minix_pid_t child, int16_t stat);
+
+/*! Record that the MINIX signal \a signal was delivered to \a minix_pid. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_Signal(int signal, minix_pid_t minix_pid);
+
+/*! Record that the execution state changed from \a old_state to \a new_state, both ``MINIXCompat_Execution_State`` values. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Trace_State(int old_state, int new_state);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Trace_h */
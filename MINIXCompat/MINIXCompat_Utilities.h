@@ -0,0 +1,114 @@
+//
+//  MINIXCompat_Utilities.h
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Utilities_h
+#define MINIXCompat_Utilities_h
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+// MARK: - Hashing
+
+/*! The value to start a 64-bit FNV-1a hash from. */
+#define MINIXCOMPAT_HASH_BASIS 0xcbf29ce484222325ULL
+
+/*! The 64-bit FNV-1a prime. */
+#define MINIXCOMPAT_HASH_PRIME 0x00000100000001b3ULL
+
+/*! Mix the byte \a byte into the 64-bit FNV-1a hash \a hash, for data that can only be had a byte at a time. */
+static inline uint64_t MINIXCompat_Hash_Byte(uint64_t hash, uint8_t byte)
+{
+    return (hash ^ byte) * MINIXCOMPAT_HASH_PRIME;
+}
+
+/*!
+ Mix \a len bytes at \a bytes into the 64-bit FNV-1a hash \a hash, which starts out as ``MINIXCOMPAT_HASH_BASIS``.
+
+ This is fast and spreads short keys like paths well, but it's no defense against collisions anyone sets out to make, so anything keyed by it must check the full key or only care about it as a hint.
+ */
+static inline uint64_t MINIXCompat_Hash_Bytes(uint64_t hash, const void * _Nonnull bytes, size_t len)
+{
+    const uint8_t *p = bytes;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = MINIXCompat_Hash_Byte(hash, p[i]);
+    }
+
+    return hash;
+}
+
+
+// MARK: - Host Files
+
+/*! The nanoseconds part of a file's modification time, which different hosts name differently. */
+#if defined(__APPLE__) || defined(__NetBSD__)
+#define MINIXCOMPAT_ST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#else
+#define MINIXCOMPAT_ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#endif
+
+/*! Create the host directory at \a path if needed, such as one that reports or caches are written to, returning whether it's there now; it's fine if another process gets there first. */
+static inline bool MINIXCompat_Host_EnsureDirectory(const char * _Nonnull path)
+{
+    return (mkdir(path, 0755) == 0) || (errno == EEXIST);
+}
+
+
+/*! Write all of \a len bytes at \a bytes to the host file or socket \a fd, retrying short writes and interruptions, returning whether that succeeded. */
+static inline bool MINIXCompat_Host_Write_Bytes(int fd, const void * _Nonnull bytes, size_t len)
+{
+    const uint8_t *p = bytes;
+    while (len > 0) {
+        ssize_t written = write(fd, p, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += written;
+        len -= (size_t) written;
+    }
+
+    return true;
+}
+
+/*! Read all of \a len bytes into \a bytes from the host file or socket \a fd, retrying short reads and interruptions, returning whether that succeeded; reaching end-of-file first is a failure. */
+static inline bool MINIXCompat_Host_Read_Bytes(int fd, void * _Nonnull bytes, size_t len)
+{
+    uint8_t *p = bytes;
+    while (len > 0) {
+        ssize_t got = read(fd, p, len);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (got == 0) {
+            return false;
+        }
+        p += got;
+        len -= (size_t) got;
+    }
+
+    return true;
+}
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Utilities_h */
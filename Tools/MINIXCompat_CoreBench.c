@@ -0,0 +1,336 @@
+//
+//  MINIXCompat_CoreBench.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+/*
+ A microbenchmark of just the emulated CPU: Musashi, the RAM accessors, and the trap callback in MINIXCompat_Emulation.c, without the filesystem or process layers.
+
+ Each kernel is a small synthetic 68000 program assembled straight into emulated RAM at ``MINIXCompat_Executable_Base``. It runs a loop a known number of times and then makes a sentinel system call that stops the CPU. Since every kernel executes a known number of instructions, its speed can be reported in MIPS.
+
+ Usage: MINIXCompat_CoreBench [scale]
+
+ The optional scale multiplies the number of iterations of every kernel, which is sized to take somewhere around a second at 100 MIPS.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Executable.h"
+#include "MINIXCompat_Native.h"
+#include "MINIXCompat_Profile.h"
+#include "MINIXCompat_Snapshot.h"
+#include "MINIXCompat_Stats.h"
+#include "MINIXCompat_SysCalls.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The system call function that ends a kernel, which MINIX never uses. */
+static const uint16_t MINIXCompat_CoreBench_Exit_Func = 0x7fff;
+
+/*! The system call function made by the trap-heavy kernel: `BOTH`, which is what MINIX's library uses for everything. */
+static const uint16_t MINIXCompat_CoreBench_Null_Func = 3;
+
+/*! Where data for the kernels that move data lives, well away from their code. */
+static const m68k_address_t MINIXCompat_CoreBench_Source = 0x00100000;
+static const m68k_address_t MINIXCompat_CoreBench_Destination = 0x00200000;
+
+
+// MARK: - Stand-Ins
+
+// The trap callback reaches a few other subsystems, which a microbenchmark doesn't want, so stand in for them.
+
+minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16_t src_dest, m68k_address_t msg, uint32_t * _Nonnull out_result)
+{
+    (void) src_dest;
+    (void) msg;
+    (void) out_result;
+
+    if ((uint16_t) func == MINIXCompat_CoreBench_Exit_Func) {
+        MINIXCompat_CPU_Stop();
+    }
+
+    return minix_syscall_result_success_empty;
+}
+
+bool MINIXCompat_Native_Trap(void)
+{
+    return false;
+}
+
+int MINIXCompat_Profile_Interval(void)
+{
+    return 0;
+}
+
+void MINIXCompat_Profile_Sample(m68k_address_t pc, m68k_address_t a6)
+{
+    (void) pc;
+    (void) a6;
+}
+
+void MINIXCompat_Snapshot_System_Call(uint16_t src_dest)
+{
+    (void) src_dest;
+}
+
+void MINIXCompat_Stats_Trap(uint64_t cycles)
+{
+    (void) cycles;
+}
+
+
+// MARK: - Assembly
+
+/*! Where the next word of a kernel is assembled. */
+static m68k_address_t MINIXCompat_CoreBench_PC = 0;
+
+/*! Assemble the word \a word. */
+static void MINIXCompat_CoreBench_Emit16(uint16_t word)
+{
+    MINIXCompat_RAM_Write_16(MINIXCompat_CoreBench_PC, word);
+    MINIXCompat_CoreBench_PC += 2;
+}
+
+/*! Assemble the longword \a longword, as the extension of an instruction. */
+static void MINIXCompat_CoreBench_Emit32(uint32_t longword)
+{
+    MINIXCompat_CoreBench_Emit16((uint16_t) (longword >> 16));
+    MINIXCompat_CoreBench_Emit16((uint16_t) longword);
+}
+
+/*! Assemble the short branch instruction \a opcode (`Bcc.S`, `BRA.S`, or `BSR.S`) to \a target. */
+static void MINIXCompat_CoreBench_Emit_Branch(uint16_t opcode, m68k_address_t target)
+{
+    const int32_t displacement = (int32_t) target - (int32_t) (MINIXCompat_CoreBench_PC + 2);
+    assert((displacement != 0) && (displacement >= -128) && (displacement <= 127));
+
+    MINIXCompat_CoreBench_Emit16(opcode | ((uint16_t) displacement & 0x00ff));
+}
+
+/*! Point the short branch instruction already assembled at \a branch to \a target, for branches forward. */
+static void MINIXCompat_CoreBench_Patch_Branch(m68k_address_t branch, m68k_address_t target)
+{
+    const int32_t displacement = (int32_t) target - (int32_t) (branch + 2);
+    assert((displacement > 0) && (displacement <= 127));
+
+    const uint16_t opcode = MINIXCompat_RAM_Read_16(branch) & 0xff00;
+    MINIXCompat_RAM_Write_16(branch, opcode | (uint16_t) displacement);
+}
+
+/*! Assemble `move.l #iterations,d7`, which every kernel starts with to set up its loop counter. */
+static void MINIXCompat_CoreBench_Emit_Prologue(uint32_t iterations)
+{
+    MINIXCompat_CoreBench_Emit16(0x2e3c);           // move.l #iterations,d7
+    MINIXCompat_CoreBench_Emit32(iterations);
+}
+
+/*! Assemble the end of a kernel's loop back to \a loop, and the system call that stops the CPU after it. */
+static void MINIXCompat_CoreBench_Emit_Epilogue(m68k_address_t loop)
+{
+    MINIXCompat_CoreBench_Emit16(0x5387);           // subq.l #1,d7
+    MINIXCompat_CoreBench_Emit_Branch(0x6600, loop); // bne.s loop
+
+    MINIXCompat_CoreBench_Emit16(0x303c);           // move.w #exit,d0
+    MINIXCompat_CoreBench_Emit16(MINIXCompat_CoreBench_Exit_Func);
+    MINIXCompat_CoreBench_Emit16(0x4e40);           // trap #0
+    MINIXCompat_CoreBench_Emit16(0x60fe);           // bra.s *
+}
+
+/*! The instructions executed by a kernel besides those in its loop: the prologue, and the system call in the epilogue. */
+static const uint64_t MINIXCompat_CoreBench_Overhead = 3;
+
+
+// MARK: - Kernels
+
+/*! Assemble a kernel that runs \a iterations times, returning the number of instructions it executes. */
+typedef uint64_t (*minix_core_bench_assembler_t)(uint32_t iterations);
+
+/*! Register-only arithmetic and logic in a tight loop. */
+static uint64_t MINIXCompat_CoreBench_ALU(uint32_t iterations)
+{
+    MINIXCompat_CoreBench_Emit_Prologue(iterations);
+
+    const m68k_address_t loop = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0xd081);           // add.l d1,d0
+    MINIXCompat_CoreBench_Emit16(0xb182);           // eor.l d0,d2
+    MINIXCompat_CoreBench_Emit16(0xe38b);           // lsl.l #1,d3
+    MINIXCompat_CoreBench_Emit16(0x8282);           // or.l d2,d1
+    MINIXCompat_CoreBench_Emit16(0x5281);           // addq.l #1,d1
+    MINIXCompat_CoreBench_Emit_Epilogue(loop);
+
+    return MINIXCompat_CoreBench_Overhead + ((uint64_t) iterations * 7);
+}
+
+/*! Copying 256 bytes a longword at a time, through postincrement addressing. */
+static uint64_t MINIXCompat_CoreBench_Copy(uint32_t iterations)
+{
+    MINIXCompat_CoreBench_Emit_Prologue(iterations);
+
+    const m68k_address_t loop = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x41f9);           // lea source,a0
+    MINIXCompat_CoreBench_Emit32(MINIXCompat_CoreBench_Source);
+    MINIXCompat_CoreBench_Emit16(0x43f9);           // lea destination,a1
+    MINIXCompat_CoreBench_Emit32(MINIXCompat_CoreBench_Destination);
+    MINIXCompat_CoreBench_Emit16(0x7c3f);           // moveq #63,d6
+
+    const m68k_address_t copy = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x22d8);           // move.l (a0)+,(a1)+
+    MINIXCompat_CoreBench_Emit16(0x51ce);           // dbra d6,copy
+    MINIXCompat_CoreBench_Emit16((uint16_t) (copy - MINIXCompat_CoreBench_PC));
+    MINIXCompat_CoreBench_Emit_Epilogue(loop);
+
+    return MINIXCompat_CoreBench_Overhead + ((uint64_t) iterations * (3 + (64 * 2) + 2));
+}
+
+/*! Conditional branches, half of them taken, on the low bits of the loop counter. */
+static uint64_t MINIXCompat_CoreBench_Branch(uint32_t iterations)
+{
+    // The instructions executed depend on the low two bits of the counter, so only whole groups of four iterations are run.
+
+    iterations &= ~UINT32_C(3);
+
+    MINIXCompat_CoreBench_Emit_Prologue(iterations);
+
+    const m68k_address_t loop = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x0807);           // btst #0,d7
+    MINIXCompat_CoreBench_Emit16(0x0000);
+    const m68k_address_t to_even = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x6700);           // beq.s even
+    MINIXCompat_CoreBench_Emit16(0x5281);           // addq.l #1,d1
+    const m68k_address_t to_next = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x6000);           // bra.s next
+
+    MINIXCompat_CoreBench_Patch_Branch(to_even, MINIXCompat_CoreBench_PC);
+    MINIXCompat_CoreBench_Emit16(0x5482);           // even: addq.l #2,d2
+
+    MINIXCompat_CoreBench_Patch_Branch(to_next, MINIXCompat_CoreBench_PC);
+    MINIXCompat_CoreBench_Emit16(0x0807);           // next: btst #1,d7
+    MINIXCompat_CoreBench_Emit16(0x0001);
+    const m68k_address_t to_skip = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x6600);           // bne.s skip
+    MINIXCompat_CoreBench_Emit16(0x5381);           // subq.l #1,d1
+
+    MINIXCompat_CoreBench_Patch_Branch(to_skip, MINIXCompat_CoreBench_PC);
+    MINIXCompat_CoreBench_Emit_Epilogue(loop);      // skip:
+
+    // Every four iterations run 14 instructions testing bit 0, 10 testing bit 1, and 8 ending the loop.
+
+    return MINIXCompat_CoreBench_Overhead + (((uint64_t) iterations / 4) * (14 + 10 + 8));
+}
+
+/*! Calls to a subroutine that saves and restores most registers with `MOVEM`, like a MINIX C function's prologue and epilogue. */
+static uint64_t MINIXCompat_CoreBench_MOVEM(uint32_t iterations)
+{
+    MINIXCompat_CoreBench_Emit_Prologue(iterations);
+
+    const m68k_address_t loop = MINIXCompat_CoreBench_PC;
+    const m68k_address_t to_function = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x6100);           // bsr.s function
+    MINIXCompat_CoreBench_Emit_Epilogue(loop);
+
+    MINIXCompat_CoreBench_Patch_Branch(to_function, MINIXCompat_CoreBench_PC);
+    MINIXCompat_CoreBench_Emit16(0x48e7);           // function: movem.l d0-d6/a0-a5,-(sp)
+    MINIXCompat_CoreBench_Emit16(0xfefc);
+    MINIXCompat_CoreBench_Emit16(0x4cdf);           // movem.l (sp)+,d0-d6/a0-a5
+    MINIXCompat_CoreBench_Emit16(0x3f7f);
+    MINIXCompat_CoreBench_Emit16(0x4e75);           // rts
+
+    return MINIXCompat_CoreBench_Overhead + ((uint64_t) iterations * 6);
+}
+
+/*! Null system calls, each going all the way through ``MINIXCompat_CPU_Trap_Callback``. */
+static uint64_t MINIXCompat_CoreBench_Trap(uint32_t iterations)
+{
+    MINIXCompat_CoreBench_Emit_Prologue(iterations);
+
+    const m68k_address_t loop = MINIXCompat_CoreBench_PC;
+    MINIXCompat_CoreBench_Emit16(0x303c);           // move.w #null,d0
+    MINIXCompat_CoreBench_Emit16(MINIXCompat_CoreBench_Null_Func);
+    MINIXCompat_CoreBench_Emit16(0x4e40);           // trap #0
+    MINIXCompat_CoreBench_Emit_Epilogue(loop);
+
+    return MINIXCompat_CoreBench_Overhead + ((uint64_t) iterations * 4);
+}
+
+
+/*! A kernel to run. */
+typedef struct minix_core_bench_kernel {
+    const char *name;
+    minix_core_bench_assembler_t assemble;
+
+    /*! The number of iterations at a scale of `1`, which is about 100 million instructions. */
+    uint32_t iterations;
+} minix_core_bench_kernel_t;
+
+static const minix_core_bench_kernel_t MINIXCompat_CoreBench_Kernels[] = {
+    { "alu",    MINIXCompat_CoreBench_ALU,      14000000 },
+    { "copy",   MINIXCompat_CoreBench_Copy,     750000 },
+    { "branch", MINIXCompat_CoreBench_Branch,   12500000 },
+    { "movem",  MINIXCompat_CoreBench_MOVEM,    16000000 },
+    { "trap",   MINIXCompat_CoreBench_Trap,     5000000 },
+};
+
+#define MINIXCOMPAT_CORE_BENCH_KERNELS (sizeof(MINIXCompat_CoreBench_Kernels) / sizeof(MINIXCompat_CoreBench_Kernels[0]))
+
+
+/*! The current time in seconds, for timing kernels. */
+static double MINIXCompat_CoreBench_Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1e9);
+}
+
+
+int main(int argc, char **argv)
+{
+    const long scale = (argc > 1) ? strtol(argv[1], NULL, 10) : 1;
+    // Keep the scaled number of iterations of every kernel within the 32 bits of its loop counter.
+
+    if ((argc > 2) || (scale <= 0) || (scale > 250)) {
+        fprintf(stderr, "usage: %s [scale]\n", argv[0]);
+        return 2;
+    }
+
+    MINIXCompat_CPU_Initialize();
+
+    printf("%-8s %14s %10s %10s\n", "kernel", "instructions", "seconds", "MIPS");
+
+    for (size_t i = 0; i < MINIXCOMPAT_CORE_BENCH_KERNELS; i++) {
+        const minix_core_bench_kernel_t *kernel = &MINIXCompat_CoreBench_Kernels[i];
+
+        // Start every kernel from clean RAM, as though it were a new executable.
+
+        MINIXCompat_RAM_Reset();
+        MINIXCompat_RAM_Note_High_Water(MINIXCompat_CoreBench_Destination + 0x100);
+
+        MINIXCompat_CoreBench_PC = MINIXCompat_Executable_Base;
+        const uint64_t instructions = kernel->assemble(kernel->iterations * (uint32_t) scale);
+        MINIXCompat_RAM_Note_High_Water(MINIXCompat_CoreBench_PC);
+
+        MINIXCompat_CPU_Reset();
+
+        const double start = MINIXCompat_CoreBench_Now();
+        MINIXCompat_CPU_Run_Until_Stopped(0);
+        const double seconds = MINIXCompat_CoreBench_Now() - start;
+
+        printf("%-8s %14llu %10.3f %10.2f\n", kernel->name, (unsigned long long) instructions, seconds, (seconds > 0) ? ((double) instructions / seconds / 1e6) : 0.0);
+    }
+
+    return 0;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,323 @@
+//
+//  MINIXCompat_TraceDump.c
+//  MINIXCompat
+//
+//  Created by agent on 10/14/26.
+//  Copyright © 2026 agent. See file LICENSE for details.
+//
+
+/*
+ Merge the traces that MINIXCompat processes wrote to a `MINIXCOMPAT_TRACE` directory into a single trace in Chrome's trace event format, which Perfetto and `chrome://tracing` can show.
+
+ Usage: MINIXCompat_TraceDump [-o output] directory-or-trace...
+
+ Every `.trace` file in a directory is read, as is every file given directly. Each host process shows up as a process, each MINIX process it ran as a thread of it, each system call as a span, and everything else as an instant. The merged trace goes to standard output unless an output file is given.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Trace.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! A record along with the host process that recorded it, and where it was in that process's trace, so records with the same time stay in order. */
+typedef struct minix_trace_dump_entry {
+    minix_trace_record_t record;
+    int64_t host_pid;
+    uint64_t sequence;
+} minix_trace_dump_entry_t;
+
+/*! All of the records read so far. */
+static minix_trace_dump_entry_t *MINIXCompat_TraceDump_Entries = NULL;
+static size_t MINIXCompat_TraceDump_Count = 0;
+static size_t MINIXCompat_TraceDump_Capacity = 0;
+
+/*! The names of the ``MINIXCompat_Execution_State`` values, by value. */
+static const char * const MINIXCompat_TraceDump_State_Names[] = { "started", "ready", "running", "finished", "restored" };
+
+
+// MARK: - Reading Traces
+
+/*! Add the records of \a header, whose ring is at \a records, to the entries. */
+static void MINIXCompat_TraceDump_Add(const minix_trace_header_t * _Nonnull header, const minix_trace_record_t * _Nonnull records)
+{
+    // Only the last `capacity` records written are still in the ring, oldest first starting after the newest. The tool may still be recording, so where the ring ends is read just once.
+
+    const uint64_t next = header->next;
+    const uint64_t count = (next < header->capacity) ? next : header->capacity;
+    const uint64_t first = next - count;
+
+    if ((MINIXCompat_TraceDump_Count + count) > MINIXCompat_TraceDump_Capacity) {
+        size_t new_capacity = (MINIXCompat_TraceDump_Capacity == 0) ? 65536 : MINIXCompat_TraceDump_Capacity;
+        while (new_capacity < (MINIXCompat_TraceDump_Count + count)) {
+            new_capacity *= 2;
+        }
+
+        minix_trace_dump_entry_t *entries = realloc(MINIXCompat_TraceDump_Entries, new_capacity * sizeof(minix_trace_dump_entry_t));
+        if (entries == NULL) {
+            fprintf(stderr, "MINIXCompat_TraceDump: out of memory\n");
+            exit(1);
+        }
+
+        MINIXCompat_TraceDump_Entries = entries;
+        MINIXCompat_TraceDump_Capacity = new_capacity;
+    }
+
+    for (uint64_t n = first; n < next; n++) {
+        minix_trace_dump_entry_t *entry = &MINIXCompat_TraceDump_Entries[MINIXCompat_TraceDump_Count++];
+        entry->record = records[n % header->capacity];
+        entry->record.text[sizeof(entry->record.text) - 1] = '\0';
+        entry->host_pid = header->host_pid;
+        entry->sequence = n;
+    }
+}
+
+/*!
+ Read the trace at \a path.
+
+ - Returns: Whether it was a trace that could be read.
+ */
+static bool MINIXCompat_TraceDump_Read(const char * _Nonnull path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    bool ok = false;
+    minix_trace_header_t header;
+    minix_trace_record_t *records = NULL;
+
+    if (fread(&header, sizeof(header), 1, f) != 1) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: truncated header\n", path);
+    } else if (header.magic != MINIXCOMPAT_TRACE_MAGIC) {
+        // A process that couldn't finish creating its trace leaves it without a magic number.
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: not a trace\n", path);
+    } else if ((header.version != MINIXCOMPAT_TRACE_VERSION) || (header.record_size != sizeof(minix_trace_record_t)) || (header.capacity == 0)) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: unsupported trace version %" PRIu32 "\n", path, header.version);
+    } else if ((records = calloc(header.capacity, sizeof(minix_trace_record_t))) == NULL) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: out of memory\n", path);
+    } else if (fread(records, sizeof(minix_trace_record_t), header.capacity, f) != header.capacity) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: truncated records\n", path);
+    } else {
+        MINIXCompat_TraceDump_Add(&header, records);
+        ok = true;
+    }
+
+    free(records);
+    fclose(f);
+    return ok;
+}
+
+/*! Read every `.trace` file in the directory at \a path. */
+static void MINIXCompat_TraceDump_Read_Directory(const char * _Nonnull path)
+{
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        const size_t len = strlen(dirent->d_name);
+        if ((len <= 6) || (strcmp(dirent->d_name + (len - 6), ".trace") != 0)) continue;
+
+        char trace_path[PATH_MAX];
+        int path_len = snprintf(trace_path, PATH_MAX, "%s/%s", path, dirent->d_name);
+        if ((path_len > 0) && (path_len < PATH_MAX)) {
+            (void) MINIXCompat_TraceDump_Read(trace_path);
+        }
+    }
+
+    closedir(dir);
+}
+
+/*! Order entries by time, then by host process and where they were in its trace. */
+static int MINIXCompat_TraceDump_Compare(const void *a, const void *b)
+{
+    const minix_trace_dump_entry_t *ea = a;
+    const minix_trace_dump_entry_t *eb = b;
+
+    if (ea->record.time_ns != eb->record.time_ns) return (ea->record.time_ns < eb->record.time_ns) ? -1 : 1;
+    if (ea->host_pid != eb->host_pid) return (ea->host_pid < eb->host_pid) ? -1 : 1;
+    if (ea->sequence != eb->sequence) return (ea->sequence < eb->sequence) ? -1 : 1;
+    return 0;
+}
+
+
+// MARK: - Writing Chrome Traces
+
+/*! Write \a string to \a out as a JSON string. */
+static void MINIXCompat_TraceDump_Write_String(FILE * _Nonnull out, const char * _Nonnull string)
+{
+    fputc('"', out);
+    for (const unsigned char *c = (const unsigned char *) string; *c != '\0'; c++) {
+        if ((*c == '"') || (*c == '\\')) {
+            fprintf(out, "\\%c", *c);
+        } else if ((*c < 0x20) || (*c >= 0x7f)) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/*! Whether \a entry is a system call returning that has nothing to return from, because its start fell out of the ring. Chrome's viewers mis-nest everything after an unmatched end. */
+static bool MINIXCompat_TraceDump_Is_Orphan(const minix_trace_dump_entry_t * _Nonnull entry, const minix_trace_dump_entry_t * _Nonnull entries)
+{
+    for (const minix_trace_dump_entry_t *other = entry; other > entries; ) {
+        other--;
+        if ((other->host_pid != entry->host_pid) || (other->record.minix_pid != entry->record.minix_pid)) continue;
+
+        if (other->record.event == minix_trace_event_syscall_enter) return false;
+        if (other->record.event == minix_trace_event_syscall_exit) return true;
+    }
+
+    return true;
+}
+
+/*! Write all of the entries to \a out as a Chrome trace, with times relative to the earliest. */
+static void MINIXCompat_TraceDump_Write(FILE * _Nonnull out)
+{
+    const uint64_t base_ns = (MINIXCompat_TraceDump_Count > 0) ? MINIXCompat_TraceDump_Entries[0].record.time_ns : 0;
+    bool first = true;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    for (size_t i = 0; i < MINIXCompat_TraceDump_Count; i++) {
+        const minix_trace_dump_entry_t *entry = &MINIXCompat_TraceDump_Entries[i];
+        const minix_trace_record_t *record = &entry->record;
+
+        if ((record->event == minix_trace_event_syscall_exit) && MINIXCompat_TraceDump_Is_Orphan(entry, MINIXCompat_TraceDump_Entries)) {
+            continue;
+        }
+
+        if (!first) {
+            fprintf(out, ",\n");
+        }
+        first = false;
+
+        fprintf(out, "{\"pid\":%" PRId64 ",\"tid\":%d,\"ts\":%.3f,", entry->host_pid, (int) record->minix_pid, (double) (record->time_ns - base_ns) / 1000.0);
+
+        switch ((minix_trace_event_t) record->event) {
+            case minix_trace_event_syscall_enter: {
+                fprintf(out, "\"ph\":\"B\",\"cat\":\"syscall\",\"name\":");
+                MINIXCompat_TraceDump_Write_String(out, record->text);
+                fprintf(out, ",\"args\":{\"sc\":%" PRId32 ",\"m\":[%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 "],\"cycles\":%" PRIu64 "}}",
+                        record->code, record->values[0], record->values[1], record->values[2], record->values[3], record->cycles);
+            } break;
+
+            case minix_trace_event_syscall_exit: {
+                fprintf(out, "\"ph\":\"E\",\"cat\":\"syscall\",\"args\":{\"result\":%" PRId32 ",\"reply\":%" PRId32 ",\"cycles\":%" PRIu64 "}}",
+                        record->values[0], record->values[1], record->cycles);
+            } break;
+
+            case minix_trace_event_exec: {
+                fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"process\",\"name\":\"exec\",\"args\":{\"path\":");
+                MINIXCompat_TraceDump_Write_String(out, record->text);
+                fprintf(out, ",\"cycles\":%" PRIu64 "}}", record->cycles);
+            } break;
+
+            case minix_trace_event_fork: {
+                fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"process\",\"name\":\"fork\",\"args\":{\"child\":%" PRId32 ",\"cycles\":%" PRIu64 "}}",
+                        record->code, record->cycles);
+            } break;
+
+            case minix_trace_event_wait: {
+                fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"process\",\"name\":\"wait\",\"args\":{\"child\":%" PRId32 ",\"stat\":%" PRId32 ",\"cycles\":%" PRIu64 "}}",
+                        record->code, record->values[0], record->cycles);
+            } break;
+
+            case minix_trace_event_signal: {
+                fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"signal\",\"name\":\"signal\",\"args\":{\"signal\":%" PRId32 ",\"target\":%" PRId32 ",\"cycles\":%" PRIu64 "}}",
+                        record->code, record->values[0], record->cycles);
+            } break;
+
+            case minix_trace_event_state: {
+                const size_t state_count = sizeof(MINIXCompat_TraceDump_State_Names) / sizeof(MINIXCompat_TraceDump_State_Names[0]);
+                const char *old_name = ((uint32_t) record->values[0] < state_count) ? MINIXCompat_TraceDump_State_Names[record->values[0]] : "unknown";
+                const char *new_name = ((uint32_t) record->code < state_count) ? MINIXCompat_TraceDump_State_Names[record->code] : "unknown";
+                fprintf(out, "\"ph\":\"i\",\"s\":\"p\",\"cat\":\"state\",\"name\":\"%s\",\"args\":{\"from\":\"%s\",\"cycles\":%" PRIu64 "}}",
+                        new_name, old_name, record->cycles);
+            } break;
+
+            default: {
+                fprintf(out, "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"unknown\",\"name\":\"event %u\"}", (unsigned) record->event);
+            } break;
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *output = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:")) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            default: {
+                fprintf(stderr, "usage: %s [-o output] directory-or-trace...\n", argv[0]);
+                return 2;
+            }
+        }
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-o output] directory-or-trace...\n", argv[0]);
+        return 2;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        struct stat path_stat;
+        if ((stat(argv[i], &path_stat) == 0) && S_ISDIR(path_stat.st_mode)) {
+            MINIXCompat_TraceDump_Read_Directory(argv[i]);
+        } else {
+            (void) MINIXCompat_TraceDump_Read(argv[i]);
+        }
+    }
+
+    qsort(MINIXCompat_TraceDump_Entries, MINIXCompat_TraceDump_Count, sizeof(minix_trace_dump_entry_t), MINIXCompat_TraceDump_Compare);
+
+    FILE *out = stdout;
+    if (output != NULL) {
+        out = fopen(output, "w");
+        if (out == NULL) {
+            fprintf(stderr, "MINIXCompat_TraceDump: %s: %s\n", output, strerror(errno));
+            return 1;
+        }
+    }
+
+    MINIXCompat_TraceDump_Write(out);
+
+    if ((out != stdout) && (fclose(out) != 0)) {
+        fprintf(stderr, "MINIXCompat_TraceDump: %s: %s\n", output, strerror(errno));
+        return 1;
+    }
+
+    free(MINIXCompat_TraceDump_Entries);
+    return 0;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,208 @@
+#!/bin/sh
+#
+#  bench.sh
+#  MINIXCompat
+#
+#  Created by agent on 10/14/26.
+#  Copyright © 2026 agent. See file LICENSE for details.
+#
+#  Run a set of canonical workloads against the MINIX installation in
+#  MINIXCOMPAT_DIR and report how each performed as JSON, so upgrades can be
+#  checked for regressions.
+#
+#  Usage: bench.sh [-n runs] [-o output] [minixcompat]
+#
+#  Each workload is run `runs` times (3 by default) and the fastest run is
+#  reported. The report goes to standard output unless an output file is
+#  given. The MINIXCompat binary defaults to MINIXCompat/MINIXCompat.
+#
+#  Every measurement comes from the MINIXCOMPAT_STATS reports of the processes
+#  that make up a run, except for host CPU time, which is what the shell
+#  collects for its children. Since MINIXCompat counts emulated cycles rather
+#  than instructions, emulation speed is reported in cycles per second. Peak
+#  RSS is in whatever units the host's getrusage(2) uses: kilobytes on Linux,
+#  bytes on macOS.
+#
+
+set -u
+
+runs=3
+output=
+while getopts n:o: opt; do
+    case "$opt" in
+        n) runs="$OPTARG" ;;
+        o) output="$OPTARG" ;;
+        *) echo "usage: $0 [-n runs] [-o output] [minixcompat]" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+minixcompat="${1:-MINIXCompat/MINIXCompat}"
+case "$minixcompat" in
+    /*) ;;
+    *) minixcompat="$(pwd)/$minixcompat" ;;
+esac
+
+if [ ! -x "$minixcompat" ]; then
+    echo "$0: $minixcompat is not executable" >&2
+    exit 1
+fi
+
+MINIXCOMPAT_DIR="${MINIXCOMPAT_DIR:-/opt/minix}"
+export MINIXCOMPAT_DIR
+
+if [ ! -x "$MINIXCOMPAT_DIR/usr/bin/cc" ]; then
+    echo "$0: no MINIX installation with /usr/bin/cc in $MINIXCOMPAT_DIR" >&2
+    exit 1
+fi
+
+# The workloads run in a scratch directory of their own within the MINIX
+# installation, outside of /tmp so a /tmp overlay doesn't hide it from them.
+# Their environment is just what MINIX tools need, so the results don't
+# depend on whoever runs this.
+
+minix_work="/usr/tmp/bench.$$"
+host_work="$MINIXCOMPAT_DIR$minix_work"
+host_stats="${TMPDIR:-/tmp}/minixcompat-bench.$$"
+
+cleanup() {
+    rm -rf "$host_work" "$host_stats" "$host_stats.times"
+}
+trap cleanup EXIT
+trap 'exit 1' HUP INT TERM
+
+mkdir -p "$host_work" "$host_stats" || exit 1
+
+MINIX_PATH=/bin:/usr/bin
+MINIX_HOME="$minix_work"
+MINIXCOMPAT_PWD="$minix_work"
+export MINIX_PATH MINIX_HOME MINIXCOMPAT_PWD
+unset MINIXCOMPAT_STATS MINIXCOMPAT_SNAPSHOT MINIXCOMPAT_RESTORE MINIXCOMPAT_PROFILE MINIXCOMPAT_SERVER
+
+# MARK: - Workload Sources
+
+# The MINIX compiler only takes K&R C.
+
+cat > "$host_work/hello.c" <<'EOF'
+main()
+{
+    printf("hello, world\n");
+    return 0;
+}
+EOF
+
+awk 'BEGIN {
+    for (i = 0; i < 400; i++) {
+        printf("int f%d(a, b)\nint a, b;\n{\n    int i, s;\n\n    s = 0;\n", i);
+        printf("    for (i = 0; i < a; i++) {\n        if ((i %% %d) == b) s += i * %d; else s -= b;\n    }\n", (i % 7) + 2, i + 1);
+        printf("    return s;\n}\n\n");
+    }
+    printf("main()\n{\n    int s;\n\n    s = 0;\n");
+    for (i = 0; i < 400; i++) printf("    s += f%d(%d, %d);\n", i, i % 13, i % 3);
+    printf("    return s & 1;\n}\n");
+}' > "$host_work/large.c"
+
+mkdir -p "$host_work/project" "$host_work/link"
+
+for name in alpha beta gamma delta; do
+    printf 'int %s(n)\nint n;\n{\n    return n * %d;\n}\n' "$name" "${#name}" > "$host_work/project/$name.c"
+    cp "$host_work/project/$name.c" "$host_work/link/$name.c"
+done
+
+cat > "$host_work/project/main.c" <<'EOF'
+main()
+{
+    printf("%d\n", alpha(1) + beta(2) + gamma(3) + delta(4));
+    return 0;
+}
+EOF
+cp "$host_work/project/main.c" "$host_work/link/main.c"
+
+printf 'OBJS = main.o alpha.o beta.o gamma.o delta.o\n\nprog: $(OBJS)\n\tcc -o prog $(OBJS)\n' > "$host_work/project/Makefile"
+
+# MARK: - Running Workloads
+
+# Run the MINIX shell command $1, which is run with MINIX's /bin/sh in the
+# scratch directory, with its statistics going to $host_stats.
+
+run_minix() {
+    rm -rf "$host_stats"
+    mkdir -p "$host_stats"
+    MINIXCOMPAT_STATS="$host_stats" "$minixcompat" /bin/sh -c "$1" > /dev/null
+}
+
+# Summarize the statistics in $host_stats and the shell's `times` output on
+# standard input as the fields of a JSON object, given the exit status $1.
+# The process with the longest wall-clock time is the one that ran the rest.
+
+summarize() {
+    times_line="$(sed -n 2p)"
+    cat "$host_stats"/*.stats 2>/dev/null | awk -v status="$1" -v times_line="$times_line" '
+        function seconds(t,    parts) {
+            split(t, parts, "m")
+            sub("s$", "", parts[2])
+            return (parts[1] * 60) + parts[2]
+        }
+        $1 == "wall_ns" && $2 > wall_ns { wall_ns = $2 }
+        $1 == "cycles" { cycles += $2 }
+        $1 == "syscalls" { syscalls += $2 }
+        $1 == "max_rss" && $2 > max_rss { max_rss = $2 }
+        $1 == "minix_pid" { processes += 1 }
+        END {
+            split(times_line, t, " ")
+            cpu = seconds(t[1]) + seconds(t[2])
+            wall = wall_ns / 1e9
+            printf("\"status\": %d, \"processes\": %d, \"wall_s\": %.6f, \"cpu_s\": %.6f, ", status, processes, wall, cpu)
+            printf("\"cycles\": %.0f, \"cycles_per_s\": %.0f, ", cycles, (wall > 0) ? (cycles / wall) : 0)
+            printf("\"syscalls\": %.0f, \"syscalls_per_s\": %.0f, ", syscalls, (wall > 0) ? (syscalls / wall) : 0)
+            printf("\"peak_rss\": %.0f", max_rss)
+        }'
+}
+
+# Run workload $1 with the MINIX shell command $2 $runs times, printing the
+# JSON object for its fastest run.
+
+bench() {
+    best=
+    best_wall=
+
+    i=0
+    while [ "$i" -lt "$runs" ]; do
+        i=$((i + 1))
+
+        # The shell's `times` only sees the children of the shell it runs in,
+        # so it runs in the same one as the workload rather than in a pipeline.
+
+        fields="$( (run_minix "$2"; status=$?; times > "$host_stats.times"; summarize "$status" < "$host_stats.times") )"
+        wall="$(printf '%s\n' "$fields" | sed 's/.*"wall_s": \([0-9.]*\).*/\1/')"
+
+        if [ -z "$best" ] || awk -v a="$wall" -v b="$best_wall" 'BEGIN { exit !(a < b) }'; then
+            best="$fields"
+            best_wall="$wall"
+        fi
+    done
+
+    printf '    { "name": "%s", "runs": %d, %s }' "$1" "$runs" "$best"
+}
+
+# Objects for the link workload are built ahead of time, so it's only the
+# archive and the link being measured.
+
+run_minix "cd link; for f in alpha beta gamma delta main; do cc -c \$f.c || exit 1; done" || {
+    echo "$0: couldn't build the objects for the link workload" >&2
+    exit 1
+}
+
+{
+    printf '{\n  "minixcompat": "%s",\n  "workloads": [\n' "$minixcompat"
+    bench cc_hello "cc -o hello hello.c"
+    printf ',\n'
+    bench cc_large "cc -o large large.c"
+    printf ',\n'
+    bench make_project "cd project; rm -f *.o prog; make"
+    printf ',\n'
+    bench ar_ld_link "cd link; rm -f libbench.a linked; ar r libbench.a alpha.o beta.o gamma.o delta.o && cc -o linked main.o libbench.a"
+    printf ',\n'
+    bench fork_exec_loop "i=0; while test \$i -lt 100; do i=\`expr \$i + 1\`; done"
+    printf '\n  ]\n}\n'
+} > "${output:-/dev/stdout}"